@@ -9,6 +9,8 @@ import math
 import random 
 import os
 
+import telemetry_decoder
+
 
 class Parser:
     """
@@ -37,6 +39,7 @@ class Parser:
         self.__position_r_data = []
         
         self.__correction_data = []
+        self.__sequences = {"log":[], "telemetry":[]}  # each stream is numbered on its own
 
         self.__brakemode = None
         self.__gearset = None
@@ -62,6 +65,39 @@ class Parser:
         }
 
 
+    def __get_stamp(self, line):
+        """
+        returns (time in us, sequence number) from the start of a line written
+        by the logger, None if the line does not start with a stamp
+
+        sample line:
+            5012345 1042 [INFO] Motor 1, ...
+        """
+        fields = line.split(" ", 2)
+        if len(fields) < 3 or not fields[0].isdigit() or not fields[1].isdigit():
+            return None
+        return int(fields[0]), int(fields[1])
+
+
+    def __order_lines(self, lines):
+        """
+        sorts the stamped lines by sequence number since entries from
+        different tasks are not always written in the order they were made,
+        lines without a stamp keep their order after them
+        """
+        stamped = []
+        unstamped = []
+        for line in lines:
+            stamp = self.__get_stamp(line)
+            if stamp is None:
+                unstamped.append(line)
+            else:
+                stamped.append((stamp[1], line))
+                self.__sequences["log"].append(stamp[1])
+        stamped.sort(key=lambda item: item[0])
+        return [line for _, line in stamped] + unstamped
+
+
     def __get_data_point(self, line):
         """
         parses a line from the file and returns the data of voltage,
@@ -70,6 +106,7 @@ class Parser:
         sample line:
             [INFO] Motor 1, Brakemode: xxxx, Actual_Voltage: xxx, ...
         """
+        line_stamp = line
         try:
             line = line.split("[INFO]")[1]
             data = line.split(",")
@@ -117,6 +154,10 @@ class Parser:
                 }
         except:
                 return 0
+
+        stamp = self.__get_stamp(line_stamp)
+        if stamp is not None:  # us from when the entry was made instead of the ms in the content
+            data_dict["time"] = stamp[0] / 1000
         
         try:
             data_dict.update({"vel_setpoint":float(vel_sp[0].strip())})
@@ -135,8 +176,9 @@ class Parser:
         """
         is_first_line = True
         with open(file) as f:
+            lines = self.__order_lines(f)
             #find first valid line
-            for line in f:
+            for line in lines:
                 if is_first_line:
                     data = self.__get_data_point(line)
                     print(data)
@@ -205,6 +247,51 @@ class Parser:
                     self.__correction_data.append(data.get("correction"))
     
 
+    def parse_telemetry(self, file, channel="chassis_pid"):
+        """
+        reads a binary telemetry file instead of text lines, the columns of
+        the channel are used as they are
+        """
+        decoder = telemetry_decoder.TelemetryDecoder()
+        decoder.decode_file(file)
+        telemetry = decoder.get_channel(channel)
+        if telemetry is None:
+            return 0
+        columns = telemetry["data"]
+        samples = len(columns["time"])
+        self.__sequences["telemetry"].extend(decoder.sequences)
+
+        self.__time_data.extend(columns["time"])
+        self.__velocity_data["front_left"].extend(columns.get("velocity_l", []))
+        self.__velocity_data["front_right"].extend(columns.get("velocity_r", []))
+        self.__integral_data.extend(columns.get("integral", []))
+        self.__heading_sp_data.extend(columns.get("heading_sp", []))
+        self.__heading_data.extend(columns.get("relative_heading", []))
+        self.__position_sp.extend(columns.get("position_sp", [0] * samples))
+        self.__position_r_data.extend(columns.get("position_r", []))
+        self.__position_l_data.extend(columns.get("position_l", []))
+        self.__correction_data.extend(columns.get("correction", []))
+
+        if samples > 0:
+            self.__slew = columns["slew"][0]
+            self.__pid["kP"] = columns["kP"][0]
+            self.__pid["kI"] = columns["kI"][0]
+            self.__pid["kD"] = columns["kD"][0]
+            self.__pid["I_max"] = columns["i_max"][0]
+
+        return samples
+    
+
+    def get_gaps(self):
+        """
+        returns {stream: [(first missing sequence number, number missing)]}
+        of the records parsed so far for "log" and "telemetry", the logger and
+        telemetry number their records separately so each is checked on its
+        own
+        """
+        return {stream:telemetry_decoder.find_gaps(sequences) for stream, sequences in self.__sequences.items()}
+
+
     def print_data(self):
         """
         prints data
@@ -18,8 +18,13 @@ file = "./log.txt"
 
 # parser.gen_sample_data()    
 p = data_parser.Parser()
-p.parse_file(file)
+if file.endswith(".bin"):  # binary telemetry from Telemetry.cpp
+    p.parse_telemetry(file)
+else:
+    p.parse_file(file)
 p.print_data()
+for stream, gaps in p.get_gaps().items():
+    print("\n" + stream, "sequence gaps:", len(gaps), "records missing:", sum(count for _, count in gaps))
 g = graph.DebugGraph(
     p.get_data(),
     {
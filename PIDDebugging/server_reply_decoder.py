@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+decodes the binary replies written by Server.cpp
+
+replies look like
+    0xAA 0x55 0xE1 length(u16) return_id(u16) command_id(u16) status values crc8
+where length counts the ids, status, and values and everything is little
+endian. They can be mixed in with text from the logger and telemetry frames,
+anything that is not a valid reply is skipped. See ServerReply in Server.hpp
+for how values are encoded
+
+usage: server_reply_decoder.py <file>
+"""
+import struct
+import sys
+
+from telemetry_decoder import crc8
+
+
+SYNC = b"\xaa\x55\xe1"
+HEADER_SIZE = 5
+MIN_LENGTH = 5
+
+STATUSES = {
+    0: "failed",
+    1: "ok",
+    2: "unknown command",
+    3: "truncated",
+}
+
+TYPES = {
+    1: "i",
+    2: "I",
+    3: "f",
+    4: "d",
+}
+TEXT = 5
+
+
+def decode_values(values):
+    """
+    returns the list of values in the values of a reply, text is returned as
+    a str
+    """
+    decoded = []
+    position = 0
+    while position < len(values):
+        value_type = values[position]
+        position += 1
+        if value_type == TEXT:
+            length = values[position]
+            decoded.append(values[position + 1:position + 1 + length].decode("ascii", "replace"))
+            position += 1 + length
+        else:
+            value_format = "<" + TYPES[value_type]
+            decoded.append(struct.unpack_from(value_format, values, position)[0])
+            position += struct.calcsize(value_format)
+    return decoded
+
+
+class ServerReplyDecoder:
+    """
+    turns reply frames into a dict per reply
+    """
+    def __init__(self):
+        self.__buffer = bytearray()
+        self.replies = []
+        self.bad_frames = 0
+
+
+    def feed(self, data):
+        """
+        decodes every complete reply in data and returns them, a partial
+        reply at the end is kept until the rest is fed
+        """
+        self.__buffer.extend(data)
+        buffer = self.__buffer
+        replies = []
+        position = 0
+        while True:
+            start = buffer.find(SYNC, position)
+            if start < 0:
+                position = max(position, len(buffer) - len(SYNC) + 1)
+                break
+            position = start
+
+            if len(buffer) - position < HEADER_SIZE:
+                break
+            length, = struct.unpack_from("<H", buffer, position + 3)
+            end = position + HEADER_SIZE + length + 1
+            if len(buffer) < end:
+                break
+
+            if length < MIN_LENGTH or crc8(buffer[position + 3:end - 1]) != buffer[end - 1]:
+                self.bad_frames += 1
+                position += 1  # not a reply, look for the next sync
+                continue
+
+            return_id, command_id, status = struct.unpack_from("<HHB", buffer, position + HEADER_SIZE)
+            try:
+                values = decode_values(bytes(buffer[position + HEADER_SIZE + 5:end - 1]))
+            except (KeyError, IndexError, struct.error):
+                self.bad_frames += 1
+                position += 1
+                continue
+
+            replies.append({
+                "return_id":return_id,
+                "command_id":command_id,
+                "status":STATUSES.get(status, status),
+                "values":values
+            })
+            position = end
+
+        del buffer[:max(position, 0)]
+        self.replies.extend(replies)
+        return replies
+
+
+    def decode_file(self, file):
+        with open(file, "rb") as f:
+            self.feed(f.read())
+        return self.replies
+
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("usage: server_reply_decoder.py <file>")
+        sys.exit(1)
+
+    decoder = ServerReplyDecoder()
+    for reply in decoder.decode_file(sys.argv[1]):
+        print(reply["return_id"], hex(reply["command_id"]), reply["status"], *reply["values"])
+    print("bad frames:", decoder.bad_frames)
@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+decodes the binary telemetry stream written by Telemetry.cpp into columns
+
+frames look like
+    0xA5 0x5A kind channel length(u16) payload crc8
+and can be mixed in with text from the logger, anything that is not a valid
+frame is skipped. See Telemetry.hpp for the layout of the payloads
+
+version 2 samples are stamped with the time in us and a sequence number that
+only telemetry samples use, the time column is still in ms but keeps the us
+resolution and a sequence column is added. Samples are ordered by sequence
+number and a gap in the sequence numbers is a sample that was dropped
+
+usage: telemetry_decoder.py <file> [channel]
+"""
+import struct
+import sys
+
+
+SYNC = b"\xa5\x5a"
+HEADER_SIZE = 6
+VERSIONS = (1, 2)
+
+SCHEMA_FRAME = 1
+SAMPLE_FRAME = 2
+
+TYPES = {
+    1: ("int32", "i"),
+    2: ("uint32", "I"),
+    3: ("float", "f"),
+    4: ("double", "d"),
+}
+
+
+def find_gaps(sequences):
+    """
+    returns [(first missing sequence number, number missing)] for the
+    sequence numbers that are not in sequences between its lowest and highest
+    """
+    gaps = []
+    ordered = sorted(set(sequences))
+    for previous, current in zip(ordered, ordered[1:]):
+        if current - previous > 1:
+            gaps.append((previous + 1, current - previous - 1))
+    return gaps
+
+
+def order_columns(columns):
+    """
+    sorts every column of a channel by its sequence column, samples from
+    tasks that raced each other are not always queued in the order they
+    were stamped
+    """
+    sequences = columns.get("sequence")
+    if not sequences or None in sequences:
+        return columns
+    order = sorted(range(len(sequences)), key=sequences.__getitem__)
+    return {name:[values[i] for i in order] for name, values in columns.items()}
+
+
+def crc8(data):
+    """
+    crc-8 with polynomial 0x07, matches crc8() in Telemetry.cpp
+    """
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+class TelemetryDecoder:
+    """
+    turns telemetry frames into a column per field for each channel
+
+    a channel's samples are dropped until its schema has been seen, schemas
+    are repeated by the robot so a stream that starts late still decodes
+    """
+    def __init__(self):
+        self.__buffer = bytearray()
+        self.__schemas = {}  # channel number -> schema dict
+        self.__channels = {}  # channel name -> {"units":{}, "data":{}}
+        self.sequences = []  # of every sample, for gap detection
+        self.bad_frames = 0
+        self.unknown_samples = 0
+        self.skipped_bytes = 0
+
+
+    def __read_string(self, payload, offset):
+        end = payload.index(b"\x00", offset)
+        return payload[offset:end].decode("ascii"), end + 1
+
+
+    def __parse_schema(self, channel, payload):
+        version, sample_size, num_fields = struct.unpack_from("<BHB", payload, 0)
+        if version not in VERSIONS:
+            return
+        name, offset = self.__read_string(payload, 4)
+        fields = []
+        for _ in range(num_fields):
+            field_type = payload[offset]
+            field_name, offset = self.__read_string(payload, offset + 1)
+            unit, offset = self.__read_string(payload, offset)
+            fields.append((field_name, field_type, unit))
+
+        sample_format = "<" + "".join(TYPES[field_type][1] for _, field_type, _ in fields)
+        if struct.calcsize(sample_format) != sample_size:
+            self.bad_frames += 1
+            return
+
+        self.__schemas[channel] = {"name":name, "fields":fields, "format":sample_format, "version":version}
+        if name not in self.__channels:
+            self.__channels[name] = {
+                "units":{field_name:unit for field_name, _, unit in fields},
+                "data":{"time":[], "sequence":[], **{field_name:[] for field_name, _, _ in fields}}
+            }
+
+
+    def __parse_sample(self, channel, payload):
+        schema = self.__schemas.get(channel)
+        if schema is None:
+            self.unknown_samples += 1
+            return
+        try:
+            if schema["version"] == 1:  # time in ms and no sequence number
+                time, = struct.unpack_from("<I", payload, 0)
+                sequence = None
+                values = struct.unpack(schema["format"], payload[4:])
+            else:
+                time_us, sequence = struct.unpack_from("<II", payload, 0)
+                time = time_us / 1000
+                values = struct.unpack(schema["format"], payload[8:])
+        except struct.error:
+            self.bad_frames += 1
+            return
+
+        data = self.__channels[schema["name"]]["data"]
+        data["time"].append(time)
+        data["sequence"].append(sequence)
+        if sequence is not None:
+            self.sequences.append(sequence)
+        for (field_name, _, _), value in zip(schema["fields"], values):
+            data[field_name].append(value)
+
+
+    def feed(self, data):
+        """
+        decodes every complete frame in data, a partial frame at the end is
+        kept until the rest is fed
+        """
+        self.__buffer.extend(data)
+        buffer = self.__buffer
+        position = 0
+        while True:
+            start = buffer.find(SYNC, position)
+            if start < 0:
+                keep = len(buffer) - 1 if buffer.endswith(SYNC[:1]) else len(buffer)
+                self.skipped_bytes += keep - position
+                position = keep
+                break
+            self.skipped_bytes += start - position
+            position = start
+
+            if len(buffer) - position < HEADER_SIZE:
+                break
+            kind, channel, length = struct.unpack_from("<BBH", buffer, position + 2)
+            end = position + HEADER_SIZE + length + 1
+            if len(buffer) < end:
+                break
+
+            if kind not in (SCHEMA_FRAME, SAMPLE_FRAME) or crc8(buffer[position + 2:end - 1]) != buffer[end - 1]:
+                self.bad_frames += 1
+                position += 1  # not a frame, look for the next sync
+                continue
+
+            payload = bytes(buffer[position + HEADER_SIZE:end - 1])
+            if kind == SCHEMA_FRAME:
+                try:
+                    self.__parse_schema(channel, payload)
+                except (ValueError, KeyError, IndexError, struct.error):
+                    self.bad_frames += 1
+            else:
+                self.__parse_sample(channel, payload)
+            position = end
+
+        del buffer[:position]
+
+
+    def decode_file(self, file):
+        with open(file, "rb") as f:
+            self.feed(f.read())
+        return self.get_channels()
+
+
+    def get_channels(self):
+        """
+        returns {channel name: {"units":{field:unit}, "data":{"time":[...], "sequence":[...], field:[...]}}}
+        with the samples of every channel in sequence order
+        """
+        for channel in self.__channels.values():
+            channel["data"] = order_columns(channel["data"])
+        return self.__channels
+
+
+    def get_channel(self, name):
+        return self.get_channels().get(name)
+
+
+    def get_gaps(self):
+        """
+        returns the gaps in the sequence numbers of every sample decoded, see
+        find_gaps()
+        """
+        return find_gaps(self.sequences)
+
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("usage: telemetry_decoder.py <file> [channel]")
+        sys.exit(1)
+
+    decoder = TelemetryDecoder()
+    channels = decoder.decode_file(sys.argv[1])
+    for name, channel in channels.items():
+        if len(sys.argv) > 2 and name != sys.argv[2]:
+            continue
+        columns = channel["data"]
+        print(name, ":", len(columns["time"]), "samples")
+        for field, values in columns.items():
+            unit = channel["units"].get(field, "ms")
+            if values:
+                print("   ", field, "(" + unit + ")", "first", values[0], "last", values[-1])
+    print("bad frames:", decoder.bad_frames, "unknown samples:", decoder.unknown_samples, "skipped bytes:", decoder.skipped_bytes)
+    gaps = decoder.get_gaps()
+    print("sequence gaps:", len(gaps), "records missing:", sum(count for _, count in gaps))
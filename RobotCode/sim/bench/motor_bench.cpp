@@ -0,0 +1,414 @@
+/**
+ * @file: ./RobotCode/sim/bench/motor_bench.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * micro-benchmark of the per tick cost of the motor thread, runs Motor::run
+ * for 8 motors the way MotorThread::run does for every motor_mode and
+ * log_level, and a whole MotorThread tick with telemetry sampling, the power
+ * budget, faults, and the list handoff for every motor_mode, and reports ns,
+ * allocations, instructions, and device calls per tick
+ *
+ * usage: motor_bench [--baseline <file>] [--write-baseline <file>] [--tolerance <fraction>]
+ *   --baseline        fails if a case regressed compared to the file
+ *   --write-baseline  saves the results to compare later runs against
+ *   --tolerance       allowed fraction ns/tick can grow by, default BENCH_TIME_TOLERANCE
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "main.h"
+#include "sim.hpp"
+
+#include "../../src/objects/motors/Motor.hpp"
+#include "../../src/objects/motors/MotorThread.hpp"
+#include "../../src/objects/serial/Logger.hpp"
+
+
+#define BENCH_MOTORS                8
+#define BENCH_WARMUP_BATCHES        8
+#define BENCH_TICKS                 25    // ticks per batch, every entry of a batch fits in the logger queue which is drained between batches
+#define BENCH_BATCHES               101   // the median batch is reported
+#define BENCH_TIME_TOLERANCE        0.5   // ns/tick is noisy on a shared host
+#define BENCH_INSTRUCTION_TOLERANCE 0.1
+
+
+namespace
+{
+    thread_local bool counting = false;  // only the benchmark thread's allocations are counted
+    std::uint64_t allocations = 0;
+}
+
+
+void* operator new(std::size_t size)
+{
+    if ( counting ) {
+        allocations += 1;
+    }
+    void *memory = std::malloc(size == 0 ? 1 : size);
+    if ( memory == NULL ) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+
+
+namespace
+{
+    /**
+     * counts instructions retired in user space by this thread, not
+     * available in every container so callers check available()
+     */
+    class InstructionCounter
+    {
+        private:
+            int fd;
+
+        public:
+            InstructionCounter() : fd(-1) {
+#ifdef __linux__
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.size = sizeof(attr);
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                attr.disabled = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+            }
+
+            ~InstructionCounter() {
+#ifdef __linux__
+                if ( fd >= 0 ) {
+                    close(fd);
+                }
+#endif
+            }
+
+            bool available() {
+                return fd >= 0;
+            }
+
+            void start() {
+#ifdef __linux__
+                if ( fd >= 0 ) {
+                    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+#endif
+            }
+
+            std::uint64_t stop() {
+                std::uint64_t count = 0;
+#ifdef __linux__
+                if ( fd >= 0 ) {
+                    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+                    if ( read(fd, &count, sizeof(count)) != sizeof(count) ) {
+                        count = 0;
+                    }
+                }
+#endif
+                return count;
+            }
+    };
+
+
+    typedef struct
+    {
+        bool full_tick;  // MotorThread::run_tick instead of only Motor::run
+        motor_mode mode;
+        int log_level;
+        double ns_per_tick;
+        double allocations_per_tick;
+        double instructions_per_tick;  // 0 if the counter is not available
+        double device_calls_per_tick;
+    } bench_result;
+
+
+    const char* mode_name(motor_mode mode) {
+        switch ( mode ) {
+            case e_builtin_velocity_pid: return "builtin_pid";
+            case e_voltage: return "voltage";
+            case e_custom_velocity_pid: return "custom_pid";
+            case e_feedforward_velocity: return "feedforward";
+        }
+        return "unknown";
+    }
+
+
+    double median(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        return values.at(values.size() / 2);
+    }
+
+
+    void drain_logger() {
+        Logger logger;
+        while ( Logger::get_count() > 0 ) {
+            logger.dump();  // clog is silenced
+        }
+    }
+
+
+    std::uint32_t thread_ticks = 0;
+
+    /**
+     * one tick is what the motor thread does for each registered motor, or
+     * all of the thread's tick when full_tick is set
+     */
+    void run_tick(Motor **motors, bool full_tick) {
+        if ( full_tick ) {
+            MotorThread::run_tick(thread_ticks, MOTOR_THREAD_PERIOD);
+            thread_ticks += 1;
+            return;
+        }
+
+        for ( int i = 0; i < BENCH_MOTORS; i++ ) {
+            motors[i]->set_output_scale(1);
+            motors[i]->run(MOTOR_THREAD_PERIOD);
+        }
+    }
+
+
+    bench_result run_case(Motor **motors, InstructionCounter &counter, bool full_tick, motor_mode mode, int log_level) {
+        for ( int i = 0; i < BENCH_MOTORS; i++ ) {
+            motors[i]->set_motor_mode(mode);
+            motors[i]->set_log_level(log_level);
+            if ( mode == e_voltage ) {
+                motors[i]->set_voltage(6000);
+            } else {
+                motors[i]->move_velocity(100);
+            }
+        }
+
+        for ( int batch = 0; batch < BENCH_WARMUP_BATCHES; batch++ ) {
+            for ( int i = 0; i < BENCH_TICKS; i++ ) {
+                run_tick(motors, full_tick);
+            }
+            drain_logger();
+        }
+
+        std::vector<double> ns;
+        std::vector<double> allocs;
+        std::vector<double> instructions;
+        std::vector<double> device_calls;
+        for ( int batch = 0; batch < BENCH_BATCHES; batch++ ) {
+            std::uint64_t calls_start = sim::motor_device_calls();
+            allocations = 0;
+            counting = true;
+            counter.start();
+            auto start = std::chrono::steady_clock::now();
+
+            for ( int i = 0; i < BENCH_TICKS; i++ ) {
+                run_tick(motors, full_tick);
+            }
+
+            auto end = std::chrono::steady_clock::now();
+            std::uint64_t instructions_retired = counter.stop();
+            counting = false;
+
+            ns.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / BENCH_TICKS);
+            allocs.push_back((double)allocations / BENCH_TICKS);
+            instructions.push_back((double)instructions_retired / BENCH_TICKS);
+            device_calls.push_back((double)(sim::motor_device_calls() - calls_start) / BENCH_TICKS);
+            drain_logger();
+        }
+
+        return {full_tick, mode, log_level, median(ns), median(allocs), median(instructions), median(device_calls)};
+    }
+
+
+    std::string case_name(const bench_result &result) {
+        return std::string(result.full_tick ? "thread/" : "") + mode_name(result.mode) + "/" + std::to_string(result.log_level);
+    }
+
+
+    int write_baseline(std::string path, const std::vector<bench_result> &results) {
+        std::ofstream file(path);
+        if ( !file ) {
+            std::cerr << "could not write baseline " << path << "\n";
+            return 0;
+        }
+
+        file << "# case ns_per_tick allocations_per_tick instructions_per_tick device_calls_per_tick\n";
+        for ( const bench_result &result : results ) {
+            file << case_name(result) << " " << result.ns_per_tick << " " << result.allocations_per_tick
+                 << " " << result.instructions_per_tick << " " << result.device_calls_per_tick << "\n";
+        }
+
+        return 1;
+    }
+
+
+    /**
+     * allocations and device calls are deterministic so any increase is a
+     * regression, time and instructions are allowed to move by their tolerance
+     */
+    int compare_baseline(std::string path, const std::vector<bench_result> &results, double tolerance) {
+        std::ifstream file(path);
+        if ( !file ) {
+            std::cerr << "could not read baseline " << path << "\n";
+            return 0;
+        }
+
+        int regressions = 0;
+        std::string line;
+        while ( std::getline(file, line) ) {
+            if ( line.empty() || line.at(0) == '#' ) {
+                continue;
+            }
+
+            std::istringstream fields(line);
+            std::string name;
+            bench_result baseline = {};
+            fields >> name >> baseline.ns_per_tick >> baseline.allocations_per_tick >> baseline.instructions_per_tick >> baseline.device_calls_per_tick;
+
+            for ( const bench_result &result : results ) {
+                if ( case_name(result) != name ) {
+                    continue;
+                }
+
+                std::vector<std::string> reasons;
+                if ( result.ns_per_tick > baseline.ns_per_tick * (1 + tolerance) ) {
+                    reasons.push_back("ns/tick " + std::to_string(baseline.ns_per_tick) + " -> " + std::to_string(result.ns_per_tick));
+                }
+                if ( result.allocations_per_tick > baseline.allocations_per_tick ) {
+                    reasons.push_back("allocations/tick " + std::to_string(baseline.allocations_per_tick) + " -> " + std::to_string(result.allocations_per_tick));
+                }
+                if (
+                    result.instructions_per_tick > 0 && baseline.instructions_per_tick > 0
+                    && result.instructions_per_tick > baseline.instructions_per_tick * (1 + BENCH_INSTRUCTION_TOLERANCE)
+                ) {
+                    reasons.push_back("instructions/tick " + std::to_string(baseline.instructions_per_tick) + " -> " + std::to_string(result.instructions_per_tick));
+                }
+                if ( result.device_calls_per_tick > baseline.device_calls_per_tick ) {
+                    reasons.push_back("device calls/tick " + std::to_string(baseline.device_calls_per_tick) + " -> " + std::to_string(result.device_calls_per_tick));
+                }
+
+                for ( const std::string &reason : reasons ) {
+                    std::cout << "[REGRESSION] " << name << " " << reason << "\n";
+                }
+                regressions += reasons.size();
+            }
+        }
+
+        return regressions == 0;
+    }
+}
+
+
+
+int main(int argc, char **argv) {
+    std::string baseline_path;
+    std::string write_path;
+    double tolerance = BENCH_TIME_TOLERANCE;
+    for ( int i = 1; i + 1 < argc; i += 2 ) {
+        if ( std::strcmp(argv[i], "--baseline") == 0 ) {
+            baseline_path = argv[i + 1];
+        } else if ( std::strcmp(argv[i], "--write-baseline") == 0 ) {
+            write_path = argv[i + 1];
+        } else if ( std::strcmp(argv[i], "--tolerance") == 0 ) {
+            tolerance = std::atof(argv[i + 1]);
+        }
+    }
+
+    // registration messages and the entries of the log levels being measured
+    // are written to stderr when the logger is drained
+    std::fflush(stderr);
+    int saved_stderr = dup(STDERR_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDERR_FILENO);
+
+    // run the thread long enough to publish telemetry, the virtual clock
+    // does not move while benchmarking so the snapshot stays fresh
+    Motor *motors[BENCH_MOTORS];
+    MotorThread *motor_thread = MotorThread::get_instance();
+    for ( int i = 0; i < BENCH_MOTORS; i++ ) {
+        motors[i] = new Motor(i + 1, pros::E_MOTOR_GEARSET_18, false);
+        motors[i]->set_pid({10, 0.01, 5, 5000});
+        motor_thread->register_motor(*motors[i]);
+    }
+    motor_thread->start_thread();
+    pros::delay(50);
+    motor_thread->stop_thread();
+    pros::delay(MOTOR_THREAD_PERIOD);
+
+    InstructionCounter counter;
+    std::vector<bench_result> results;
+    for ( motor_mode mode : {e_builtin_velocity_pid, e_voltage, e_custom_velocity_pid, e_feedforward_velocity} ) {
+        for ( int log_level = 0; log_level <= 5; log_level++ ) {
+            results.push_back(run_case(motors, counter, false, mode, log_level));
+        }
+    }
+    for ( motor_mode mode : {e_builtin_velocity_pid, e_voltage, e_custom_velocity_pid, e_feedforward_velocity} ) {
+        results.push_back(run_case(motors, counter, true, mode, 0));
+    }
+
+    std::fflush(stderr);
+    dup2(saved_stderr, STDERR_FILENO);
+    close(null_fd);
+    close(saved_stderr);
+
+    std::cout << std::left << std::setw(24) << "case" << std::right
+              << std::setw(12) << "ns/tick" << std::setw(14) << "allocs/tick"
+              << std::setw(14) << "instr/tick" << std::setw(14) << "calls/tick" << "\n";
+    for ( const bench_result &result : results ) {
+        std::cout << std::left << std::setw(24) << case_name(result) << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << result.ns_per_tick << std::setw(14) << result.allocations_per_tick;
+        if ( counter.available() ) {
+            std::cout << std::setw(14) << result.instructions_per_tick;
+        } else {
+            std::cout << std::setw(14) << "n/a";
+        }
+        std::cout << std::setw(14) << result.device_calls_per_tick << "\n";
+    }
+
+    int status = 1;
+    if ( !write_path.empty() ) {
+        status = write_baseline(write_path, results) && status;
+    }
+    if ( !baseline_path.empty() ) {
+        status = compare_baseline(baseline_path, results, tolerance) && status;
+        std::cout << (status ? "OK\n" : "FAILED\n");
+    }
+
+    sim::shutdown();
+    std::exit(status ? 0 : 1);
+}
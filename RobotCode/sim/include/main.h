@@ -0,0 +1,52 @@
+/**
+ * @file: ./RobotCode/sim/include/main.h
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * host stand-in for ./RobotCode/include/main.h
+ * pulls in the same standard headers as the PROS api.h and the simulated
+ * PROS devices instead of the kernel headers so that the robot code in src/
+ * can be compiled natively
+ */
+
+#ifndef _PROS_MAIN_H_
+#define _PROS_MAIN_H_
+
+#define PROS_USE_SIMPLE_NAMES
+
+#define PROS_VERSION_MAJOR 3
+#define PROS_VERSION_MINOR 3
+#define PROS_VERSION_PATCH 1
+#define PROS_VERSION_STRING "3.3.1"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdbool>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#define PROS_ERR (INT32_MAX)
+#define PROS_ERR_F (INFINITY)
+
+#include "pros/adi.hpp"
+#include "pros/imu.hpp"
+#include "pros/motors.hpp"
+#include "pros/rtos.hpp"
+#include "pros/apix.h"
+
+extern "C" {
+void autonomous(void);
+void initialize(void);
+void disabled(void);
+void competition_initialize(void);
+void opcontrol(void);
+}
+
+#endif  // _PROS_MAIN_H_
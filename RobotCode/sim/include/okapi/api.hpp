@@ -0,0 +1,127 @@
+/**
+ * @file: ./RobotCode/sim/include/okapi/api.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * host stand-in for the parts of okapilib used by the robot code
+ * the position pid follows okapi's IterativePosPIDController: output is
+ * bounded to [-1, 1] and the derivative is taken on the measurement
+ * the kalman filter follows okapi's EKFFilter
+ */
+
+#ifndef _OKAPI_API_HPP_
+#define _OKAPI_API_HPP_
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace okapi
+{
+    class IterativePosPIDController
+    {
+        private:
+            double kP;
+            double kI;
+            double kD;
+            double kBias;
+
+            double target = 0;
+            double error = 0;
+            double last_reading = 0;
+            double integral = 0;
+            double output = 0;
+            bool first_step = true;
+
+        public:
+            IterativePosPIDController(double ikP, double ikI, double ikD, double ikBias = 0)
+                : kP(ikP), kI(ikI), kD(ikD), kBias(ikBias) { }
+
+            void setTarget(double new_target) {
+                target = new_target;
+            }
+
+            double getTarget() {
+                return target;
+            }
+
+            double getError() {
+                return error;
+            }
+
+            double getOutput() {
+                return output;
+            }
+
+            double step(double new_reading) {
+                error = target - new_reading;
+                if(first_step) {
+                    last_reading = new_reading;
+                    first_step = false;
+                }
+
+                integral = std::clamp(integral + (kI * error), -1.0, 1.0);
+                double derivative = new_reading - last_reading;
+                last_reading = new_reading;
+
+                output = std::clamp((kP * error) + integral - (kD * derivative) + kBias, -1.0, 1.0);
+                return output;
+            }
+
+            void reset() {
+                error = 0;
+                integral = 0;
+                output = 0;
+                first_step = true;
+            }
+    };
+
+
+    class IterativeControllerFactory
+    {
+        public:
+            static IterativePosPIDController posPID(double ikP, double ikI, double ikD, double ikBias = 0) {
+                return IterativePosPIDController(ikP, ikI, ikD, ikBias);
+            }
+    };
+
+
+    class EKFFilter
+    {
+        protected:
+            const double Q, R;
+            double xHat = 0;
+            double xHatPrev = 0;
+            double xHatMinus = 0;
+            double P = 0;
+            double Pprev = 1;
+            double Pminus = 0;
+            double K = 0;
+
+        public:
+            explicit EKFFilter(double iQ = 0.0001, double iR = 0.04) : Q(iQ), R(iR) { }
+            virtual ~EKFFilter() = default;
+
+            double filter(double ireading) {
+                return filter(ireading, 0);
+            }
+
+            double filter(double ireading, double icontrol) {
+                xHatMinus = xHatPrev + icontrol;
+                Pminus = Pprev + Q;
+                K = Pminus / (Pminus + R);
+                xHat = xHatMinus + K * (ireading - xHatMinus);
+                P = (1 - K) * Pminus;
+                xHatPrev = xHat;
+                Pprev = P;
+                return xHat;
+            }
+
+            double getOutput() const {
+                return xHat;
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file: ./RobotCode/sim/include/pros/adi.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * host stand-in for the PROS three wire (ADI) devices
+ * inputs read from sources registered with sim::set_adi_source
+ */
+
+#ifndef _PROS_ADI_HPP_
+#define _PROS_ADI_HPP_
+
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+#define INTERNAL_ADI_PORT 22
+
+
+namespace pros
+{
+    using ext_adi_port_pair_t = std::pair<std::uint8_t, std::uint8_t>;
+    using ext_adi_port_tuple_t = std::tuple<std::uint8_t, std::uint8_t, std::uint8_t>;
+
+
+    class ADIPort
+    {
+        protected:
+            std::uint8_t smart_port;
+            std::uint8_t adi_port;
+
+        public:
+            ADIPort(std::uint8_t port);
+            ADIPort(ext_adi_port_pair_t port_pair);
+
+            std::int32_t get_value() const;
+            std::int32_t set_value(std::int32_t value) const;
+    };
+
+
+    class ADIAnalogIn : private ADIPort
+    {
+        private:
+            mutable std::int32_t calibration;
+
+        public:
+            ADIAnalogIn(std::uint8_t port);
+            ADIAnalogIn(ext_adi_port_pair_t port_pair);
+
+            std::int32_t calibrate() const;
+            std::int32_t get_value_calibrated() const;
+            std::int32_t get_value_calibrated_HR() const;
+            using ADIPort::get_value;
+    };
+
+
+    class ADIDigitalIn : private ADIPort
+    {
+        private:
+            mutable bool was_pressed;
+
+        public:
+            ADIDigitalIn(std::uint8_t port);
+            ADIDigitalIn(ext_adi_port_pair_t port_pair);
+
+            std::int32_t get_new_press() const;
+            using ADIPort::get_value;
+    };
+
+
+    class ADIDigitalOut : private ADIPort
+    {
+        public:
+            ADIDigitalOut(std::uint8_t port, bool init_state = false);
+            ADIDigitalOut(ext_adi_port_pair_t port_pair, bool init_state = false);
+
+            using ADIPort::set_value;
+    };
+
+
+    class ADIMotor : private ADIPort
+    {
+        public:
+            ADIMotor(std::uint8_t port);
+            ADIMotor(ext_adi_port_pair_t port_pair);
+
+            std::int32_t stop() const;
+            using ADIPort::get_value;
+            using ADIPort::set_value;
+    };
+
+
+    class ADIEncoder : private ADIPort
+    {
+        private:
+            bool reversed;
+            mutable double zero;
+
+        public:
+            ADIEncoder(std::uint8_t port_top, std::uint8_t port_bottom, bool reversed = false);
+            ADIEncoder(ext_adi_port_tuple_t port_tuple, bool reversed = false);
+
+            std::int32_t reset() const;
+            std::int32_t get_value() const;
+    };
+}
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ * @file: ./RobotCode/sim/include/pros/apix.h
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * host stand-in for the parts of the PROS extended api that the robot code
+ * uses (serial and file control)
+ */
+
+#ifndef _PROS_API_EXTENDED_H_
+#define _PROS_API_EXTENDED_H_
+
+#include <cstdint>
+
+#define SERCTL_ACTIVATE 10
+#define SERCTL_DEACTIVATE 11
+#define SERCTL_BLKWRITE 12
+#define SERCTL_NOBLKWRITE 13
+#define SERCTL_ENABLE_COBS 14
+#define SERCTL_DISABLE_COBS 15
+
+#define DEVCTL_FIONREAD 16
+
+
+namespace pros
+{
+    namespace c
+    {
+        std::int32_t serctl(const std::uint32_t action, void* const extra_arg);
+        std::int32_t fdctl(int file, const std::uint32_t action, void* const extra_arg);
+    }
+}
+
+#endif
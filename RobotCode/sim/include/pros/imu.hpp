@@ -0,0 +1,42 @@
+/**
+ * @file: ./RobotCode/sim/include/pros/imu.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * host stand-in for pros::Imu
+ * rotation is read from a source registered with sim::set_imu_source
+ */
+
+#ifndef _PROS_IMU_HPP_
+#define _PROS_IMU_HPP_
+
+#include <cstdint>
+
+
+namespace pros
+{
+    class Imu
+    {
+        private:
+            std::uint8_t port;
+            mutable std::uint64_t calibrated_at;
+            mutable double rotation_offset;
+
+        public:
+            explicit Imu(const std::uint8_t port);
+
+            std::int32_t reset() const;
+            bool is_calibrating() const;
+
+            double get_rotation() const;
+            double get_heading() const;
+            double get_yaw() const;
+            std::int32_t tare_rotation() const;
+            std::int32_t tare_heading() const;
+
+            std::uint8_t get_port() const;
+    };
+}
+
+#endif
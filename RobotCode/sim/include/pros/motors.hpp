@@ -0,0 +1,89 @@
+/**
+ * @file: ./RobotCode/sim/include/pros/motors.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * host stand-in for pros::Motor
+ * every port is backed by a simulated dc motor plant (see sim.hpp)
+ */
+
+#ifndef _PROS_MOTORS_HPP_
+#define _PROS_MOTORS_HPP_
+
+#include <cstdint>
+
+
+namespace sim
+{
+    class MotorPlant;
+}
+
+
+namespace pros
+{
+    typedef enum {
+        E_MOTOR_BRAKE_COAST = 0,
+        E_MOTOR_BRAKE_BRAKE = 1,
+        E_MOTOR_BRAKE_HOLD = 2,
+        E_MOTOR_BRAKE_INVALID = INT32_MAX
+    } motor_brake_mode_e_t;
+
+    typedef enum {
+        E_MOTOR_ENCODER_DEGREES = 0,
+        E_MOTOR_ENCODER_ROTATIONS = 1,
+        E_MOTOR_ENCODER_COUNTS = 2,
+        E_MOTOR_ENCODER_INVALID = INT32_MAX
+    } motor_encoder_units_e_t;
+
+    typedef enum {
+        E_MOTOR_GEARSET_36 = 0,
+        E_MOTOR_GEARSET_18 = 1,
+        E_MOTOR_GEARSET_06 = 2,
+        E_MOTOR_GEARSET_INVALID = INT32_MAX
+    } motor_gearset_e_t;
+
+
+    class Motor
+    {
+        private:
+            std::uint8_t port;
+            sim::MotorPlant *plant;
+
+        public:
+            Motor(const std::int8_t port, const motor_gearset_e_t gearset, const bool reverse,
+                  const motor_encoder_units_e_t encoder_units);
+            Motor(const std::int8_t port, const motor_gearset_e_t gearset, const bool reverse);
+            Motor(const std::int8_t port, const bool reverse);
+            explicit Motor(const std::int8_t port);
+
+            std::int32_t move(const std::int32_t voltage) const;
+            std::int32_t move_velocity(const std::int32_t velocity) const;
+            std::int32_t move_voltage(const std::int32_t voltage) const;
+
+            double get_actual_velocity() const;
+            std::int32_t get_current_draw() const;
+            std::int32_t get_direction() const;
+            double get_efficiency() const;
+            double get_position() const;
+            double get_power() const;
+            double get_temperature() const;
+            double get_torque() const;
+            std::int32_t get_voltage() const;
+            std::int32_t is_stopped() const;
+            std::int32_t is_over_current() const;
+            std::int32_t is_over_temp() const;
+
+            motor_brake_mode_e_t get_brake_mode() const;
+            motor_gearset_e_t get_gearing() const;
+            std::int32_t is_reversed() const;
+            std::uint8_t get_port() const;
+
+            std::int32_t set_brake_mode(const motor_brake_mode_e_t mode) const;
+            std::int32_t set_gearing(const motor_gearset_e_t gearset) const;
+            std::int32_t set_reversed(const bool reverse) const;
+            std::int32_t tare_position() const;
+    };
+}
+
+#endif
@@ -0,0 +1,85 @@
+/**
+ * @file: ./RobotCode/sim/include/pros/rtos.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * host stand-in for the PROS rtos api
+ * tasks are backed by std::threads and time is kept on a virtual clock that
+ * only moves forward once every task is blocked in a delay
+ */
+
+#ifndef _PROS_RTOS_HPP_
+#define _PROS_RTOS_HPP_
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+
+#define TASK_PRIORITY_MAX 16
+#define TASK_PRIORITY_MIN 1
+#define TASK_PRIORITY_DEFAULT 8
+#define TASK_STACK_DEPTH_DEFAULT 0x2000
+#define TASK_STACK_DEPTH_MIN 0x200
+#define TASK_NAME_MAX_LEN 32
+
+
+namespace sim
+{
+    struct TaskContext;
+}
+
+
+namespace pros
+{
+    typedef void (*task_fn_t)(void*);
+
+    typedef enum {
+        E_TASK_STATE_RUNNING = 0,
+        E_TASK_STATE_READY,
+        E_TASK_STATE_BLOCKED,
+        E_TASK_STATE_SUSPENDED,
+        E_TASK_STATE_DELETED,
+        E_TASK_STATE_INVALID
+    } task_state_e_t;
+
+
+    class Task
+    {
+        private:
+            sim::TaskContext *context;
+
+        public:
+            Task(task_fn_t function, void* parameters = NULL, std::uint32_t prio = TASK_PRIORITY_DEFAULT,
+                 std::uint16_t stack_depth = TASK_STACK_DEPTH_DEFAULT, const char* name = "");
+            Task(task_fn_t function, void* parameters, const char* name);
+
+            void remove();
+            void suspend();
+            void resume();
+
+            std::uint32_t get_priority();
+            void set_priority(std::uint32_t prio);
+            task_state_e_t get_state();
+            const char* get_name();
+
+            static void delay(const std::uint32_t milliseconds);
+            static void delay_until(std::uint32_t* const prev_time, const std::uint32_t delta);
+    };
+
+
+    std::uint32_t millis();
+    void delay(const std::uint32_t milliseconds);
+
+
+    namespace c
+    {
+        std::uint32_t millis();
+        void delay(const std::uint32_t milliseconds);
+        void task_delay(const std::uint32_t milliseconds);
+        void task_delay_until(std::uint32_t* const prev_time, const std::uint32_t delta);
+    }
+}
+
+#endif
@@ -0,0 +1,182 @@
+/**
+ * @file: ./RobotCode/sim/include/sim.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains the hooks into the simulated PROS layer used by host programs
+ * the virtual clock, the dc motor plants behind each smart port, and the
+ * sources that feed the simulated three wire sensors and the imu
+ */
+
+#ifndef __SIM_HPP__
+#define __SIM_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#include "pros/motors.hpp"
+
+
+namespace sim
+{
+    /**
+     * @see: pros::Motor
+     *
+     * first order model of a V5 smart motor
+     * the free speed at 12V is 120% of the cartridge rating (see Motor::to_voltage)
+     * and the current is limited to 2.5A like the V5 firmware does
+     * state is kept in the commanded frame, so reversing a motor only changes
+     * what is reported back and not how the simulated robot moves
+     */
+    class MotorPlant
+    {
+        private:
+            std::mutex mutex;
+
+            pros::motor_gearset_e_t gearset;
+            pros::motor_brake_mode_e_t brake_mode;
+            bool reversed;
+
+            bool velocity_command;
+            double command_voltage;   // mV
+            double command_velocity;  // rpm
+            double velocity_integral;
+
+            double velocity;           // rpm
+            double filtered_velocity;  // rpm, what the firmware reports
+            double position;           // degrees
+            double zero_position;
+            double applied_voltage;    // mV
+            double current;            // mA
+            double temperature;        // degrees C
+
+            double time_constant;      // s, mechanical time constant under load
+            double load_torque;        // Nm, opposes motion
+            bool connected;
+
+            std::atomic<std::uint64_t> device_calls;
+
+        public:
+            MotorPlant();
+
+            /**
+             * @param: double dt -> seconds to advance the model by
+             * @return: None
+             *
+             * integrates the motor model by one step
+             * only called by the scheduler while every task is blocked
+             */
+            void step(double dt);
+
+            void count_call();
+            std::uint64_t get_device_calls();
+
+            void command_move_voltage(double voltage);
+            void command_move_velocity(double velocity);
+
+            double get_free_speed();
+            double get_stall_torque();
+            double get_degrees_per_tick();
+
+            double get_velocity();
+            double get_filtered_velocity();
+            double get_position();
+            double get_applied_voltage();
+            double get_current();
+            double get_temperature();
+            double get_torque();
+
+            pros::motor_gearset_e_t get_gearset();
+            pros::motor_brake_mode_e_t get_brake_mode();
+            bool is_reversed();
+            bool is_connected();
+
+            void set_gearset(pros::motor_gearset_e_t new_gearset);
+            void set_brake_mode(pros::motor_brake_mode_e_t new_brake_mode);
+            void set_reversed(bool reverse);
+            void tare_position();
+
+            void set_time_constant(double seconds);
+            void set_load_torque(double torque);
+            void set_temperature(double degrees);
+            void set_connected(bool is_connected);
+    };
+
+
+    /**
+     * @param: int port -> smart port of the motor, 1-21
+     * @return: MotorPlant* -> the plant backing that port
+     *
+     * plants live for the rest of the program once they are created
+     */
+    MotorPlant* motor_plant(int port);
+
+    /**
+     * @return: std::uint64_t -> number of pros::Motor calls made on every port
+     *
+     * used to measure how much device traffic the robot code generates
+     */
+    std::uint64_t motor_device_calls();
+
+
+    /**
+     * @param: std::uint8_t smart_port -> port of the expander, INTERNAL_ADI_PORT for the brain
+     * @param: std::uint8_t adi_port -> 'A'-'H', 'a'-'h', or 1-8
+     * @param: std::function<double()> source -> called to get the sensor value
+     * @return: None
+     *
+     * sets where a simulated three wire input gets its value
+     * encoders expect degrees, analog inputs expect 12 bit counts
+     */
+    void set_adi_source(std::uint8_t smart_port, std::uint8_t adi_port, std::function<double()> source);
+    double read_adi(std::uint8_t smart_port, std::uint8_t adi_port);
+    void write_adi(std::uint8_t smart_port, std::uint8_t adi_port, std::int32_t value);
+
+    /**
+     * @param: std::uint8_t port -> smart port of the imu
+     * @param: std::function<double()> source -> unbounded rotation in degrees, clockwise positive
+     * @return: None
+     *
+     * sets where the simulated imu gets its rotation
+     */
+    void set_imu_source(std::uint8_t port, std::function<double()> source);
+    double read_imu(std::uint8_t port);
+
+
+    /**
+     * @return: std::uint64_t -> virtual time in microseconds
+     */
+    std::uint64_t micros();
+
+    /**
+     * @param: std::uint32_t step_us -> resolution that plants are integrated at
+     * @return: None
+     *
+     * defaults to 1ms
+     */
+    void set_step_size(std::uint32_t step_us);
+
+    /**
+     * @param: std::function<void(double)> callback -> called with dt in seconds
+     * @return: None
+     *
+     * registers something to be integrated alongside the motor plants
+     * callbacks run while every task is blocked so they do not need to lock
+     * against the robot code
+     */
+    void add_step_callback(std::function<void(double)> callback);
+
+    /**
+     * @return: None
+     *
+     * parks every task at its next delay and waits for them to stop so that
+     * static objects can be destroyed safely when the host program returns
+     */
+    void shutdown();
+}
+
+
+#endif
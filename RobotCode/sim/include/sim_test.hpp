@@ -0,0 +1,49 @@
+/**
+ * @file: ./RobotCode/sim/include/sim_test.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains the checks shared by the programs in sim/tests
+ * each check prints [PASS] or [FAIL] and the program ends with OK or FAILED
+ * so that make sim-test stops at the first failing program
+ */
+
+#ifndef __SIM_TEST_HPP__
+#define __SIM_TEST_HPP__
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+
+inline int failures = 0;
+
+
+/**
+ * @param: bool condition -> if the check passed
+ * @param: std::string name -> what is being checked
+ * @return: None
+ *
+ * prints the result of a check and counts it if it failed
+ */
+inline void check(bool condition, std::string name) {
+    std::cout << (condition ? "[PASS] " : "[FAIL] ") << name << "\n";
+    if ( !condition ) {
+        failures += 1;
+    }
+}
+
+
+/**
+ * @return: None
+ *
+ * prints OK or FAILED and exits with a status make can check
+ */
+inline void finish_tests() {
+    std::cout << (failures ? "FAILED\n" : "OK\n");
+    std::exit(failures ? 1 : 0);
+}
+
+
+#endif
@@ -0,0 +1,153 @@
+/**
+ * @file: ./RobotCode/sim/main.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * host program that runs the motor thread, position tracker, chassis, and
+ * lift against the simulated devices so that changes to the control code
+ * can be checked without a robot
+ *
+ * usage: robot_sim [seconds of virtual time to hold after the routine] [motor log level] [motor trace file]
+ *                  [chassis telemetry file]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "main.h"
+#include "sim.hpp"
+
+#include "../src/Configuration.hpp"
+#include "../src/objects/motors/Motors.hpp"
+#include "../src/objects/motors/MotorThread.hpp"
+#include "../src/objects/motors/MotorTrace.hpp"
+#include "../src/objects/position_tracking/PositionTracker.hpp"
+#include "../src/objects/sensors/Sensors.hpp"
+#include "../src/objects/serial/Logger.hpp"
+#include "../src/objects/serial/Telemetry.hpp"
+#include "../src/objects/subsystems/chassis.hpp"
+#include "../src/objects/subsystems/LiftController.hpp"
+
+
+namespace
+{
+    const double drive_ratio = 3.0 / 5.0;   // motor to wheel
+    const double wheel_diameter = 3.25;     // in
+    const double track_width = WHEEL_TRACK_L + WHEEL_TRACK_R;  // in, between tracking wheels
+
+    double side_position(std::initializer_list<int> ports) {
+        double total = 0;
+        for(int port : ports) {
+            total += sim::motor_plant(port)->get_position();
+        }
+        return (total / ports.size()) * drive_ratio;  // degrees of the wheel
+    }
+
+    double left_position() {
+        return side_position({FL_MOTOR, ML_MOTOR, BL_MOTOR});
+    }
+
+    double right_position() {
+        return side_position({FR_MOTOR, MR_MOTOR, BR_MOTOR});
+    }
+
+    /**
+     * binds the tracking wheels, imu, and lift potentiometer to the motor plants
+     */
+    void bind_sensors() {
+        sim::set_adi_source(INTERNAL_ADI_PORT, LEFT_ENC_TOP_PORT, []() {
+            return -left_position();  // left encoder is mounted reversed
+        });
+        sim::set_adi_source(INTERNAL_ADI_PORT, RIGHT_ENC_TOP_PORT, []() {
+            return right_position();
+        });
+        sim::set_imu_source(IMU_PORT, []() {
+            double difference = ((left_position() - right_position()) / 360) * wheel_diameter * M_PI;
+            return (difference / track_width) * (180 / M_PI);
+        });
+        sim::set_adi_source(EXPANDER_PORT, LIFT_POTENTIOMETER_PORT, []() {
+            return 1000 + (2 * sim::motor_plant(LIFT1_MOTOR)->get_position());
+        });
+
+        for(int port : {FL_MOTOR, ML_MOTOR, BL_MOTOR, FR_MOTOR, MR_MOTOR, BR_MOTOR}) {
+            sim::motor_plant(port)->set_load_torque(0.05);  // rolling resistance of the drive
+        }
+        for(int port : {LIFT1_MOTOR, LIFT2_MOTOR}) {
+            sim::motor_plant(port)->set_load_torque(0.6);  // weight of the lift
+        }
+    }
+}
+
+
+
+int main(int argc, char** argv) {
+    int hold_time = argc > 1 ? std::atoi(argv[1]) : 1;
+    int motor_log_level = argc > 2 ? std::atoi(argv[2]) : 0;
+    const char *trace_path = argc > 3 && argv[3][0] != '\0' ? argv[3] : NULL;
+    const char *telemetry_path = argc > 4 ? argv[4] : NULL;
+    auto wall_start = std::chrono::steady_clock::now();
+
+    bind_sensors();
+
+    Logger::stop_queueing();
+    Motors::register_motors();
+    Motors::set_log_level(motor_log_level);
+    if(trace_path != NULL) {
+        for(Motor *motor : Motors::motor_array) {
+            MotorTrace::get_instance()->enable(motor->get_port());
+        }
+    }
+    if(telemetry_path != NULL) {
+        Telemetry::get_instance()->open(telemetry_path);
+        Telemetry::get_instance()->start_flush_task();
+    }
+    MotorThread::get_instance()->start_thread();
+    Sensors::calibrate_imu();
+
+    PositionTracker* tracker = PositionTracker::get_instance();
+    tracker->start_thread();
+
+    Chassis chassis(Motors::front_left, Motors::front_right, Motors::back_left, Motors::back_right, Motors::mid_left, Motors::mid_right, Sensors::left_encoder, Sensors::right_encoder, 16, drive_ratio);
+    LiftController lift(Motors::lift1, Motors::lift2);
+
+    std::uint32_t routine_start = pros::millis();
+    std::uint64_t calls_start = sim::motor_device_calls();
+
+    bool log_chassis = telemetry_path != NULL;
+    chassis.pid_straight_drive(1000, 0, 450, 3000, false, true, 0.2, log_chassis);
+    chassis.turn_right(90, 450, 2000, false, log_chassis);
+    lift.move_to(1800, false, 2000);
+    pros::delay(hold_time * 1000);
+
+    std::uint32_t routine_time = pros::millis() - routine_start;
+    std::uint64_t calls = sim::motor_device_calls() - calls_start;
+    position pos = tracker->get_position();
+    double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    std::cout << "[SIM] routine: " << routine_time << "ms virtual, " << wall_time << "s wall\n";
+    std::cout << "[SIM] position: x " << (double)pos.x_pos << " y " << (double)pos.y_pos << " theta " << (double)pos.theta << "\n";
+    std::cout << "[SIM] lift potentiometer: " << Sensors::lift_potentiometer.get_raw_value() << "\n";
+    std::cout << "[SIM] motor device calls: " << calls << " (" << ((double)calls / routine_time) << " per ms)\n";
+
+    motor_thread_timing timing = MotorThread::get_instance()->get_timing();
+    std::cout << "[SIM] motor thread: " << timing.ticks << " ticks, " << timing.overruns << " overruns, wcet " << timing.wcet << "ms, periods";
+    for(int i=0; i<PERIOD_HISTOGRAM_BINS; i++) {
+        std::cout << " " << timing.period_histogram[i];
+    }
+    std::cout << "\n";
+
+    if(trace_path != NULL) {
+        MotorTrace::get_instance()->save(trace_path);
+        std::cout << "[SIM] motor trace: " << MotorTrace::get_instance()->snapshot().size() << " records written to " << trace_path << "\n";
+    }
+
+    if(telemetry_path != NULL) {
+        Telemetry::get_instance()->close();
+        std::cout << "[SIM] chassis telemetry: written to " << telemetry_path << ", " << Telemetry::get_instance()->get_dropped() << " samples dropped\n";
+    }
+
+    sim::shutdown();
+    std::exit(0);  // tasks are parked, not joined, so skip static destructors
+}
@@ -0,0 +1,102 @@
+################################################################################
+# host simulation build
+#
+# compiles the robot code in src/ natively against the simulated PROS layer in
+# sim/include so that control code can be run without a brain
+#   make sim       builds bin/sim/robot_sim
+#   make run-sim   builds and runs it
+#   make sim-test  builds and runs every program in sim/tests
+#   make sim-tools builds the host tools in sim/tools, ie. bin/sim/sysid_fit and bin/sim/motor_replay
+#   make sim-bench builds and runs every benchmark in sim/bench and fails if it
+#                  regressed from the baseline checked in next to its source,
+#                  make sim-bench-baseline replaces the baseline
+################################################################################
+
+SIM_CXX ?= g++
+SIM_BINDIR = $(BINDIR)/sim
+SIM_CXXFLAGS = -std=gnu++17 -O2 -g -pthread -Isim/include -DLOG_LEVEL_MAX=$(LOG_LEVEL_MAX) $(SIM_EXTRA_CXXFLAGS)
+SIM_LDFLAGS = -pthread
+
+SIM_ROBOT_SOURCES = \
+	src/objects/motors/Motor.cpp \
+	src/objects/motors/MotorFaults.cpp \
+	src/objects/motors/MotorGroup.cpp \
+	src/objects/motors/PowerBudget.cpp \
+	src/objects/motors/RelayTuner.cpp \
+	src/objects/motors/SystemId.cpp \
+	src/objects/motors/VelocityEstimator.cpp \
+	src/objects/motors/MotorThread.cpp \
+	src/objects/motors/MotorTrace.cpp \
+	src/objects/motors/Motors.cpp \
+	src/objects/position_tracking/PositionTracker.cpp \
+	src/objects/sensors/AnalogInSensor.cpp \
+	src/objects/sensors/Encoder.cpp \
+	src/objects/sensors/RGBLed.cpp \
+	src/objects/sensors/Sensors.cpp \
+	src/objects/serial/FrameReader.cpp \
+	src/objects/serial/Logger.cpp \
+	src/objects/serial/Server.cpp \
+	src/objects/serial/Telemetry.cpp \
+	src/objects/serial/Timestamp.cpp \
+	src/objects/subsystems/LiftController.cpp \
+	src/objects/subsystems/chassis.cpp \
+	src/objects/subsystems/pto_chassis.cpp
+
+SIM_SOURCES = $(wildcard sim/src/*.cpp)
+
+SIM_OBJECTS = $(addprefix $(SIM_BINDIR)/,$(SIM_ROBOT_SOURCES:.cpp=.o) $(SIM_SOURCES:.cpp=.o))
+
+SIM_TESTS = $(patsubst sim/tests/%.cpp,$(SIM_BINDIR)/tests/%,$(wildcard sim/tests/*.cpp))
+
+SIM_TOOLS = $(patsubst sim/tools/%.cpp,$(SIM_BINDIR)/%,$(wildcard sim/tools/*.cpp))
+
+SIM_BENCHES = $(patsubst sim/bench/%.cpp,$(SIM_BINDIR)/bench/%,$(wildcard sim/bench/*.cpp))
+
+SIM_PROGRAM_OBJECTS = $(patsubst %.cpp,$(SIM_BINDIR)/%.o,$(wildcard sim/tests/*.cpp sim/tools/*.cpp sim/bench/*.cpp))
+
+.PHONY: sim run-sim sim-test sim-tools sim-bench sim-bench-baseline clean-sim
+.SECONDARY: $(SIM_PROGRAM_OBJECTS)
+
+sim: $(SIM_BINDIR)/robot_sim
+
+sim-tools: $(SIM_TOOLS)
+
+run-sim: sim
+	$(SIM_BINDIR)/robot_sim
+
+sim-test: $(SIM_TESTS)
+	@for test in $(SIM_TESTS); do echo "$$test"; $$test || exit 1; done
+
+sim-bench: $(SIM_BENCHES)
+	@for bench in $(SIM_BENCHES); do \
+		echo "$$bench"; \
+		baseline=sim/bench/$$(basename $$bench).baseline; \
+		if [ -f $$baseline ]; then $$bench --baseline $$baseline || exit 1; \
+		else $$bench --write-baseline $$baseline || exit 1; fi; \
+	done
+
+sim-bench-baseline: $(SIM_BENCHES)
+	@for bench in $(SIM_BENCHES); do echo "$$bench"; $$bench --write-baseline sim/bench/$$(basename $$bench).baseline || exit 1; done
+
+clean-sim:
+	-rm -rf $(SIM_BINDIR)
+
+$(SIM_BINDIR)/robot_sim: $(SIM_OBJECTS) $(SIM_BINDIR)/sim/main.o
+	$(SIM_CXX) -o $@ $^ $(SIM_LDFLAGS)
+
+$(SIM_BINDIR)/tests/%: $(SIM_OBJECTS) $(SIM_BINDIR)/sim/tests/%.o
+	@mkdir -p $(dir $@)
+	$(SIM_CXX) -o $@ $^ $(SIM_LDFLAGS)
+
+$(SIM_BINDIR)/bench/%: $(SIM_OBJECTS) $(SIM_BINDIR)/sim/bench/%.o
+	@mkdir -p $(dir $@)
+	$(SIM_CXX) -o $@ $^ $(SIM_LDFLAGS)
+
+$(SIM_TOOLS): $(SIM_BINDIR)/%: $(SIM_OBJECTS) $(SIM_BINDIR)/sim/tools/%.o
+	$(SIM_CXX) -o $@ $^ $(SIM_LDFLAGS)
+
+$(SIM_BINDIR)/%.o: %.cpp
+	@mkdir -p $(dir $@)
+	$(SIM_CXX) $(SIM_CXXFLAGS) -MMD -MP -c $< -o $@
+
+-include $(SIM_OBJECTS:.o=.d) $(SIM_BINDIR)/sim/main.d $(SIM_PROGRAM_OBJECTS:.o=.d)
@@ -0,0 +1,170 @@
+/**
+ * @file: ./RobotCode/sim/src/adi.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains the simulated three wire ports
+ * inputs with no source read as 0, outputs are stored so they can be read back
+ */
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "main.h"
+#include "sim.hpp"
+
+
+namespace sim
+{
+    namespace
+    {
+        std::mutex adi_mutex;
+
+        /**
+         * function statics because the robot code writes outputs from its
+         * own static constructors (pistons in Motors.cpp)
+         */
+        std::map<std::pair<int, int>, std::function<double()>>& adi_sources() {
+            static std::map<std::pair<int, int>, std::function<double()>> sources;
+            return sources;
+        }
+
+        std::map<std::pair<int, int>, std::int32_t>& adi_outputs() {
+            static std::map<std::pair<int, int>, std::int32_t> outputs;
+            return outputs;
+        }
+
+        /**
+         * ports can be given as 'A'-'H', 'a'-'h', or 1-8
+         */
+        std::pair<int, int> adi_key(std::uint8_t smart_port, std::uint8_t adi_port) {
+            int port = adi_port;
+            if(port >= 'a' && port <= 'h') {
+                port = port - 'a' + 1;
+            } else if(port >= 'A' && port <= 'H') {
+                port = port - 'A' + 1;
+            }
+            return {smart_port, port};
+        }
+    }
+
+
+    void set_adi_source(std::uint8_t smart_port, std::uint8_t adi_port, std::function<double()> source) {
+        std::lock_guard<std::mutex> guard(adi_mutex);
+        adi_sources()[adi_key(smart_port, adi_port)] = source;
+    }
+
+
+    double read_adi(std::uint8_t smart_port, std::uint8_t adi_port) {
+        std::function<double()> source;
+        {
+            std::lock_guard<std::mutex> guard(adi_mutex);
+            std::pair<int, int> key = adi_key(smart_port, adi_port);
+            if(adi_sources().count(key)) {
+                source = adi_sources()[key];
+            } else if(adi_outputs().count(key)) {
+                return adi_outputs()[key];
+            }
+        }
+
+        return source ? source() : 0;  // source may read plants so call it unlocked
+    }
+
+
+    void write_adi(std::uint8_t smart_port, std::uint8_t adi_port, std::int32_t value) {
+        std::lock_guard<std::mutex> guard(adi_mutex);
+        adi_outputs()[adi_key(smart_port, adi_port)] = value;
+    }
+}
+
+
+
+
+namespace pros
+{
+    ADIPort::ADIPort(std::uint8_t port) : smart_port(INTERNAL_ADI_PORT), adi_port(port) { }
+
+    ADIPort::ADIPort(ext_adi_port_pair_t port_pair) : smart_port(port_pair.first), adi_port(port_pair.second) { }
+
+    std::int32_t ADIPort::get_value() const {
+        return sim::read_adi(smart_port, adi_port);
+    }
+
+    std::int32_t ADIPort::set_value(std::int32_t value) const {
+        sim::write_adi(smart_port, adi_port, value);
+        return 1;
+    }
+
+
+
+    ADIAnalogIn::ADIAnalogIn(std::uint8_t port) : ADIPort(port), calibration(0) { }
+
+    ADIAnalogIn::ADIAnalogIn(ext_adi_port_pair_t port_pair) : ADIPort(port_pair), calibration(0) { }
+
+    std::int32_t ADIAnalogIn::calibrate() const {
+        calibration = get_value();
+        return calibration;
+    }
+
+    std::int32_t ADIAnalogIn::get_value_calibrated() const {
+        return get_value() - calibration;
+    }
+
+    std::int32_t ADIAnalogIn::get_value_calibrated_HR() const {
+        return (get_value() - calibration) * 16;
+    }
+
+
+
+    ADIDigitalIn::ADIDigitalIn(std::uint8_t port) : ADIPort(port), was_pressed(false) { }
+
+    ADIDigitalIn::ADIDigitalIn(ext_adi_port_pair_t port_pair) : ADIPort(port_pair), was_pressed(false) { }
+
+    std::int32_t ADIDigitalIn::get_new_press() const {
+        bool pressed = get_value();
+        bool new_press = pressed && !was_pressed;
+        was_pressed = pressed;
+        return new_press;
+    }
+
+
+
+    ADIDigitalOut::ADIDigitalOut(std::uint8_t port, bool init_state) : ADIPort(port) {
+        set_value(init_state);
+    }
+
+    ADIDigitalOut::ADIDigitalOut(ext_adi_port_pair_t port_pair, bool init_state) : ADIPort(port_pair) {
+        set_value(init_state);
+    }
+
+
+
+    ADIMotor::ADIMotor(std::uint8_t port) : ADIPort(port) { }
+
+    ADIMotor::ADIMotor(ext_adi_port_pair_t port_pair) : ADIPort(port_pair) { }
+
+    std::int32_t ADIMotor::stop() const {
+        return set_value(0);
+    }
+
+
+
+    ADIEncoder::ADIEncoder(std::uint8_t port_top, std::uint8_t port_bottom, bool reversed)
+        : ADIPort(port_top), reversed(reversed), zero(0) { }
+
+    ADIEncoder::ADIEncoder(ext_adi_port_tuple_t port_tuple, bool reversed)
+        : ADIPort(ext_adi_port_pair_t(std::get<0>(port_tuple), std::get<1>(port_tuple))), reversed(reversed), zero(0) { }
+
+    std::int32_t ADIEncoder::reset() const {
+        zero = sim::read_adi(smart_port, adi_port);
+        return 1;
+    }
+
+    std::int32_t ADIEncoder::get_value() const {
+        double value = sim::read_adi(smart_port, adi_port) - zero;
+        return reversed ? -value : value;
+    }
+}
@@ -0,0 +1,105 @@
+/**
+ * @file: ./RobotCode/sim/src/imu.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains the simulated imu, which calibrates for two seconds after a reset
+ */
+
+#include <cmath>
+#include <functional>
+#include <map>
+#include <mutex>
+
+#include "main.h"
+#include "sim.hpp"
+
+
+namespace sim
+{
+    namespace
+    {
+        const std::uint64_t calibration_time = 2000000;  // us
+
+        std::mutex imu_mutex;
+
+        std::map<int, std::function<double()>>& imu_sources() {
+            static std::map<int, std::function<double()>> sources;
+            return sources;
+        }
+    }
+
+
+    void set_imu_source(std::uint8_t port, std::function<double()> source) {
+        std::lock_guard<std::mutex> guard(imu_mutex);
+        imu_sources()[port] = source;
+    }
+
+
+    double read_imu(std::uint8_t port) {
+        std::function<double()> source;
+        {
+            std::lock_guard<std::mutex> guard(imu_mutex);
+            if(imu_sources().count(port)) {
+                source = imu_sources()[port];
+            }
+        }
+
+        return source ? source() : 0;
+    }
+}
+
+
+
+
+namespace pros
+{
+    Imu::Imu(const std::uint8_t port) : port(port), calibrated_at(0), rotation_offset(0) { }
+
+    std::int32_t Imu::reset() const {
+        calibrated_at = sim::micros() + sim::calibration_time;
+        rotation_offset = sim::read_imu(port);
+        return 1;
+    }
+
+    bool Imu::is_calibrating() const {
+        return sim::micros() < calibrated_at;
+    }
+
+    double Imu::get_rotation() const {
+        if(is_calibrating()) {
+            return PROS_ERR_F;
+        }
+        return sim::read_imu(port) - rotation_offset;
+    }
+
+    double Imu::get_heading() const {
+        if(is_calibrating()) {
+            return PROS_ERR_F;
+        }
+        double heading = std::fmod(get_rotation(), 360);
+        return heading < 0 ? heading + 360 : heading;
+    }
+
+    double Imu::get_yaw() const {
+        if(is_calibrating()) {
+            return PROS_ERR_F;
+        }
+        double heading = get_heading();
+        return heading > 180 ? heading - 360 : heading;
+    }
+
+    std::int32_t Imu::tare_rotation() const {
+        rotation_offset = sim::read_imu(port);
+        return 1;
+    }
+
+    std::int32_t Imu::tare_heading() const {
+        return tare_rotation();
+    }
+
+    std::uint8_t Imu::get_port() const {
+        return port;
+    }
+}
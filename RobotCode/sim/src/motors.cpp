@@ -0,0 +1,467 @@
+/**
+ * @file: ./RobotCode/sim/src/motors.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains the dc motor plant and the simulated pros::Motor that drives it
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+#include "main.h"
+#include "sim.hpp"
+
+
+namespace sim
+{
+    namespace
+    {
+        const double stall_current = 2500;   // mA, V5 firmware current limit
+        const double ambient_temperature = 25;
+        const double thermal_time_constant = 300;  // s
+        const double stall_temperature_rise = 55;  // degrees C above ambient at constant stall
+        const double velocity_filter_time = 0.02;  // s, lag of the velocity the firmware reports
+        const double builtin_kP = 1.5;             // builtin velocity pid, in 12V per free speed
+        const double builtin_kI = 6;
+
+        std::array<std::atomic<MotorPlant*>, 22> plants {};
+        std::once_flag step_registration;
+    }
+
+
+
+    MotorPlant::MotorPlant() {
+        gearset = pros::E_MOTOR_GEARSET_18;
+        brake_mode = pros::E_MOTOR_BRAKE_COAST;
+        reversed = false;
+
+        velocity_command = false;
+        command_voltage = 0;
+        command_velocity = 0;
+        velocity_integral = 0;
+
+        velocity = 0;
+        filtered_velocity = 0;
+        position = 0;
+        zero_position = 0;
+        applied_voltage = 0;
+        current = 0;
+        temperature = ambient_temperature;
+
+        time_constant = 0.08;
+        load_torque = 0;
+        connected = true;
+
+        device_calls = 0;
+    }
+
+
+    /**
+     * integrates the velocity as a first order system toward the speed the
+     * applied voltage would give with no load, with the torque (and current)
+     * limited to the stall values
+     */
+    void MotorPlant::step(double dt) {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        double free_speed = get_free_speed();
+        double stall_torque = get_stall_torque();
+
+        if(!connected) {
+            applied_voltage = 0;
+        } else if(velocity_command) {  // firmware velocity pid
+            double error = (command_velocity - velocity) / free_speed;
+            velocity_integral = std::clamp(velocity_integral + (builtin_kI * error * dt), -1.0, 1.0);
+            double output = (command_velocity / free_speed) + (builtin_kP * error) + velocity_integral;
+            applied_voltage = 12000 * std::clamp(output, -1.0, 1.0);
+        } else {
+            applied_voltage = std::clamp(command_voltage, -12000.0, 12000.0);
+        }
+
+        double normalized_current;
+        if(applied_voltage == 0 && (brake_mode == pros::E_MOTOR_BRAKE_COAST || !connected)) {
+            normalized_current = 0;  // windings are left open so only friction slows the motor
+            velocity -= velocity * std::min(1.0, dt / (5 * time_constant));
+        } else {
+            normalized_current = std::clamp((applied_voltage / 12000) - (velocity / free_speed), -1.0, 1.0);
+        }
+
+        double load = load_torque / stall_torque;  // normalized to the stall torque
+        if(std::abs(velocity) < 1e-3 && std::abs(normalized_current) <= load) {
+            velocity = 0;  // not enough torque to break away from the load
+        } else {
+            double direction = velocity != 0 ? (velocity > 0 ? 1 : -1) : (normalized_current > 0 ? 1 : -1);
+            double acceleration = (free_speed * (normalized_current - (direction * load))) / time_constant;
+            double new_velocity = velocity + (acceleration * dt);
+            if(load > 0 && std::signbit(new_velocity) != std::signbit(velocity) && velocity != 0) {
+                new_velocity = 0;  // load can stop the motor but can not drive it backwards
+            }
+            velocity = new_velocity;
+        }
+
+        current = normalized_current * stall_current;
+        position += velocity * 6 * dt;  // rpm to degrees per second
+        filtered_velocity += (velocity - filtered_velocity) * std::min(1.0, dt / velocity_filter_time);
+
+        double heating = stall_temperature_rise * std::pow(normalized_current, 2);
+        temperature += ((ambient_temperature + heating) - temperature) * (dt / thermal_time_constant);
+    }
+
+
+    void MotorPlant::count_call() {
+        device_calls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t MotorPlant::get_device_calls() {
+        return device_calls.load(std::memory_order_relaxed);
+    }
+
+
+    void MotorPlant::command_move_voltage(double voltage) {
+        std::lock_guard<std::mutex> guard(mutex);
+        velocity_command = false;
+        command_voltage = voltage;
+    }
+
+    void MotorPlant::command_move_velocity(double new_velocity) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if(!velocity_command) {
+            velocity_integral = 0;
+        }
+        velocity_command = true;
+        command_velocity = new_velocity;
+    }
+
+
+    double MotorPlant::get_free_speed() {
+        switch(gearset) {
+            case pros::E_MOTOR_GEARSET_36:
+                return 120;
+            case pros::E_MOTOR_GEARSET_06:
+                return 720;
+            default:
+                return 240;
+        }
+    }
+
+    double MotorPlant::get_degrees_per_tick() {
+        switch(gearset) {  // the encoder counts 1800, 900, or 300 ticks per output revolution
+            case pros::E_MOTOR_GEARSET_36:
+                return 360.0 / 1800;
+            case pros::E_MOTOR_GEARSET_06:
+                return 360.0 / 300;
+            default:
+                return 360.0 / 900;
+        }
+    }
+
+    double MotorPlant::get_stall_torque() {
+        switch(gearset) {
+            case pros::E_MOTOR_GEARSET_36:
+                return 2.1;
+            case pros::E_MOTOR_GEARSET_06:
+                return 0.35;
+            default:
+                return 1.05;
+        }
+    }
+
+
+    double MotorPlant::get_velocity() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return velocity;
+    }
+
+    double MotorPlant::get_filtered_velocity() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return filtered_velocity;
+    }
+
+    double MotorPlant::get_position() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return std::round((position - zero_position) / get_degrees_per_tick()) * get_degrees_per_tick();
+    }
+
+    double MotorPlant::get_applied_voltage() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return applied_voltage;
+    }
+
+    double MotorPlant::get_current() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return current;
+    }
+
+    double MotorPlant::get_temperature() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return temperature;
+    }
+
+    double MotorPlant::get_torque() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return get_stall_torque() * (current / stall_current);
+    }
+
+
+    pros::motor_gearset_e_t MotorPlant::get_gearset() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return gearset;
+    }
+
+    pros::motor_brake_mode_e_t MotorPlant::get_brake_mode() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return brake_mode;
+    }
+
+    bool MotorPlant::is_reversed() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return reversed;
+    }
+
+    bool MotorPlant::is_connected() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return connected;
+    }
+
+
+    void MotorPlant::set_gearset(pros::motor_gearset_e_t new_gearset) {
+        std::lock_guard<std::mutex> guard(mutex);
+        gearset = new_gearset;
+    }
+
+    void MotorPlant::set_brake_mode(pros::motor_brake_mode_e_t new_brake_mode) {
+        std::lock_guard<std::mutex> guard(mutex);
+        brake_mode = new_brake_mode;
+    }
+
+    void MotorPlant::set_reversed(bool reverse) {
+        std::lock_guard<std::mutex> guard(mutex);
+        reversed = reverse;
+    }
+
+    void MotorPlant::tare_position() {
+        std::lock_guard<std::mutex> guard(mutex);
+        zero_position = position;
+    }
+
+    void MotorPlant::set_time_constant(double seconds) {
+        std::lock_guard<std::mutex> guard(mutex);
+        time_constant = seconds;
+    }
+
+    void MotorPlant::set_load_torque(double torque) {
+        std::lock_guard<std::mutex> guard(mutex);
+        load_torque = torque;
+    }
+
+    void MotorPlant::set_temperature(double degrees) {
+        std::lock_guard<std::mutex> guard(mutex);
+        temperature = degrees;
+    }
+
+    void MotorPlant::set_connected(bool is_connected) {
+        std::lock_guard<std::mutex> guard(mutex);
+        connected = is_connected;
+    }
+
+
+
+
+    MotorPlant* motor_plant(int port) {
+        port = std::clamp(std::abs(port), 0, 21);
+
+        std::call_once(step_registration, []() {
+            add_step_callback([](double dt) {
+                for(std::atomic<MotorPlant*>& plant : plants) {
+                    MotorPlant *p = plant.load();
+                    if(p != NULL) {
+                        p->step(dt);
+                    }
+                }
+            });
+        });
+
+        MotorPlant *plant = plants[port].load();
+        if(plant == NULL) {
+            MotorPlant *new_plant = new MotorPlant;
+            if(plants[port].compare_exchange_strong(plant, new_plant)) {
+                plant = new_plant;
+            } else {
+                delete new_plant;  // another thread created it first
+            }
+        }
+
+        return plant;
+    }
+
+
+    std::uint64_t motor_device_calls() {
+        std::uint64_t calls = 0;
+        for(std::atomic<MotorPlant*>& plant : plants) {
+            MotorPlant *p = plant.load();
+            if(p != NULL) {
+                calls += p->get_device_calls();
+            }
+        }
+        return calls;
+    }
+}
+
+
+
+
+namespace pros
+{
+    Motor::Motor(const std::int8_t port, const motor_gearset_e_t gearset, const bool reverse, const motor_encoder_units_e_t encoder_units)
+        : port(std::abs(port)), plant(sim::motor_plant(port))
+    {
+        plant->set_gearset(gearset);
+        plant->set_reversed(reverse);
+    }
+
+    Motor::Motor(const std::int8_t port, const motor_gearset_e_t gearset, const bool reverse)
+        : Motor(port, gearset, reverse, E_MOTOR_ENCODER_DEGREES) { }
+
+    Motor::Motor(const std::int8_t port, const bool reverse)
+        : port(std::abs(port)), plant(sim::motor_plant(port))
+    {
+        plant->set_reversed(reverse);
+    }
+
+    Motor::Motor(const std::int8_t port)
+        : port(std::abs(port)), plant(sim::motor_plant(port)) { }
+
+
+
+    std::int32_t Motor::move(const std::int32_t voltage) const {
+        return move_voltage((voltage * 12000) / 127);
+    }
+
+    std::int32_t Motor::move_velocity(const std::int32_t velocity) const {
+        plant->count_call();
+        plant->command_move_velocity(velocity);
+        return 1;
+    }
+
+    std::int32_t Motor::move_voltage(const std::int32_t voltage) const {
+        plant->count_call();
+        plant->command_move_voltage(voltage);
+        return 1;
+    }
+
+
+
+    double Motor::get_actual_velocity() const {
+        plant->count_call();
+        return plant->is_connected() ? plant->get_filtered_velocity() : PROS_ERR_F;
+    }
+
+    std::int32_t Motor::get_current_draw() const {
+        plant->count_call();
+        return plant->is_connected() ? std::abs(plant->get_current()) : PROS_ERR;
+    }
+
+    std::int32_t Motor::get_direction() const {
+        plant->count_call();
+        return plant->get_velocity() < 0 ? -1 : 1;
+    }
+
+    double Motor::get_efficiency() const {
+        plant->count_call();
+        double power_in = std::abs(plant->get_applied_voltage() * plant->get_current()) / 1e6;
+        double power_out = std::abs(plant->get_torque() * plant->get_velocity() * (2 * M_PI / 60));
+        return power_in > 0 ? std::min(100.0, 100 * power_out / power_in) : 0;
+    }
+
+    double Motor::get_position() const {
+        plant->count_call();
+        return plant->is_connected() ? plant->get_position() : PROS_ERR_F;
+    }
+
+    double Motor::get_power() const {
+        plant->count_call();
+        return std::abs(plant->get_applied_voltage() * plant->get_current()) / 1e6;
+    }
+
+    double Motor::get_temperature() const {
+        plant->count_call();
+        return plant->is_connected() ? plant->get_temperature() : PROS_ERR_F;
+    }
+
+    double Motor::get_torque() const {
+        plant->count_call();
+        return plant->get_torque();
+    }
+
+    std::int32_t Motor::get_voltage() const {
+        plant->count_call();
+        return plant->is_connected() ? plant->get_applied_voltage() : PROS_ERR;
+    }
+
+    std::int32_t Motor::is_stopped() const {
+        plant->count_call();
+        return std::abs(plant->get_velocity()) < 1 ? 1 : 0;
+    }
+
+    std::int32_t Motor::is_over_current() const {
+        plant->count_call();
+        return std::abs(plant->get_current()) >= 2500 ? 1 : 0;
+    }
+
+    std::int32_t Motor::is_over_temp() const {
+        plant->count_call();
+        return plant->get_temperature() >= 55 ? 1 : 0;
+    }
+
+
+
+    motor_brake_mode_e_t Motor::get_brake_mode() const {
+        plant->count_call();
+        return plant->get_brake_mode();
+    }
+
+    motor_gearset_e_t Motor::get_gearing() const {
+        plant->count_call();
+        return plant->get_gearset();
+    }
+
+    std::int32_t Motor::is_reversed() const {
+        plant->count_call();
+        return plant->is_reversed();
+    }
+
+    std::uint8_t Motor::get_port() const {
+        return port;
+    }
+
+
+
+    std::int32_t Motor::set_brake_mode(const motor_brake_mode_e_t mode) const {
+        plant->count_call();
+        plant->set_brake_mode(mode);
+        return 1;
+    }
+
+    std::int32_t Motor::set_gearing(const motor_gearset_e_t gearset) const {
+        plant->count_call();
+        plant->set_gearset(gearset);
+        return 1;
+    }
+
+    std::int32_t Motor::set_reversed(const bool reverse) const {
+        plant->count_call();
+        plant->set_reversed(reverse);
+        return 1;
+    }
+
+    std::int32_t Motor::tare_position() const {
+        plant->count_call();
+        plant->tare_position();
+        return 1;
+    }
+}
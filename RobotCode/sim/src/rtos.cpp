@@ -0,0 +1,328 @@
+/**
+ * @file: ./RobotCode/sim/src/rtos.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains the virtual clock and the scheduler behind the simulated pros::Task
+ *
+ * every task (and the main thread) is either running or blocked in a delay
+ * once nothing is running the clock jumps to the earliest wake up time, the
+ * plants are integrated over that interval, and the tasks that are due are
+ * released. This makes runs independent of how fast the host is, so a 5ms
+ * loop on the host is a 5ms loop on the brain
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "main.h"
+#include "sim.hpp"
+
+
+namespace sim
+{
+    struct TaskContext
+    {
+        std::string name;
+        std::uint32_t priority = TASK_PRIORITY_DEFAULT;
+        std::uint64_t wake_time = 0;
+        bool sleeping = false;
+        bool suspended = false;
+        bool removed = false;
+    };
+
+
+    class Scheduler
+    {
+        private:
+            std::mutex mutex;
+            std::condition_variable wake;
+            std::vector<TaskContext*> contexts;
+            std::vector<std::function<void(double)>> step_callbacks;
+            std::atomic<std::uint64_t> clock;
+            std::uint32_t step_us;
+            int running;
+            bool frozen;
+
+            TaskContext main_context;
+
+            Scheduler() {
+                clock = 0;
+                step_us = 1000;
+                running = 1;  // the main thread
+                frozen = false;
+                main_context.name = "main";
+                contexts.push_back(&main_context);
+            }
+
+            /**
+             * moves the clock forward while nothing is running
+             * must be called with the mutex held
+             */
+            void advance() {
+                while(running == 0 && !frozen) {
+                    std::uint64_t next = UINT64_MAX;
+                    for(TaskContext* context : contexts) {
+                        if(context->sleeping && !context->suspended && !context->removed) {
+                            next = std::min(next, context->wake_time);
+                        }
+                    }
+
+                    if(next == UINT64_MAX) {  // every task is suspended, nothing can wake them
+                        return;
+                    }
+
+                    std::uint64_t time = clock;
+                    while(time < next) {
+                        std::uint64_t dt = std::min<std::uint64_t>(step_us, next - time);
+                        for(auto& callback : step_callbacks) {
+                            callback(dt / 1000000.0);
+                        }
+                        time += dt;
+                    }
+                    clock = next;
+
+                    for(TaskContext* context : contexts) {
+                        if(context->sleeping && !context->suspended && !context->removed && context->wake_time <= next) {
+                            context->sleeping = false;
+                            running += 1;
+                        }
+                    }
+                    wake.notify_all();
+                }
+            }
+
+        public:
+            static thread_local TaskContext *current;
+
+            static Scheduler& get_instance() {
+                static Scheduler *instance = new Scheduler;  // never destroyed so parked tasks outlive statics
+                return *instance;
+            }
+
+            std::uint64_t now() {
+                return clock;
+            }
+
+            TaskContext* spawn(pros::task_fn_t function, void* parameters, std::uint32_t prio, const char* name) {
+                TaskContext *context = new TaskContext;
+                context->name = name;
+                context->priority = prio;
+
+                {
+                    std::lock_guard<std::mutex> guard(mutex);
+                    contexts.push_back(context);
+                    running += 1;
+                }
+
+                std::thread([this, context, function, parameters]() {
+                    current = context;
+                    function(parameters);
+
+                    std::unique_lock<std::mutex> guard(mutex);
+                    context->removed = true;
+                    running -= 1;
+                    wake.notify_all();
+                    advance();
+                }).detach();
+
+                return context;
+            }
+
+            void sleep_until(std::uint64_t wake_time) {
+                TaskContext *context = current != NULL ? current : &main_context;
+
+                std::unique_lock<std::mutex> guard(mutex);
+                context->wake_time = wake_time;
+                context->sleeping = true;
+                running -= 1;
+                wake.notify_all();
+                advance();
+                wake.wait(guard, [context]() { return !context->sleeping; });
+            }
+
+            void suspend(TaskContext *context) {
+                std::unique_lock<std::mutex> guard(mutex);
+                context->suspended = true;
+                if(context == current) {  // a task suspending itself blocks right away
+                    context->wake_time = clock;
+                    context->sleeping = true;
+                    running -= 1;
+                    wake.notify_all();
+                    advance();
+                    wake.wait(guard, [context]() { return !context->sleeping; });
+                }
+            }
+
+            void resume(TaskContext *context) {
+                std::lock_guard<std::mutex> guard(mutex);
+                context->suspended = false;
+                if(context->sleeping && !context->removed && context->wake_time <= clock && !frozen) {
+                    context->sleeping = false;
+                    running += 1;
+                    wake.notify_all();
+                }
+            }
+
+            void remove(TaskContext *context) {
+                std::unique_lock<std::mutex> guard(mutex);
+                context->removed = true;
+            }
+
+            pros::task_state_e_t get_state(TaskContext *context) {
+                std::lock_guard<std::mutex> guard(mutex);
+                if(context->removed) {
+                    return pros::E_TASK_STATE_DELETED;
+                } else if(context->suspended) {
+                    return pros::E_TASK_STATE_SUSPENDED;
+                } else if(context->sleeping) {
+                    return pros::E_TASK_STATE_BLOCKED;
+                }
+                return context == current ? pros::E_TASK_STATE_RUNNING : pros::E_TASK_STATE_READY;
+            }
+
+            void set_step_size(std::uint32_t new_step_us) {
+                std::lock_guard<std::mutex> guard(mutex);
+                step_us = std::max<std::uint32_t>(1, new_step_us);
+            }
+
+            void add_step_callback(std::function<void(double)> callback) {
+                std::lock_guard<std::mutex> guard(mutex);
+                step_callbacks.push_back(callback);
+            }
+
+            void shutdown() {
+                std::unique_lock<std::mutex> guard(mutex);
+                frozen = true;
+                wake.wait(guard, [this]() { return running <= 1; });
+            }
+    };
+
+    thread_local TaskContext *Scheduler::current = NULL;
+
+
+
+    std::uint64_t micros() {
+        return Scheduler::get_instance().now();
+    }
+
+    void set_step_size(std::uint32_t step_us) {
+        Scheduler::get_instance().set_step_size(step_us);
+    }
+
+    void add_step_callback(std::function<void(double)> callback) {
+        Scheduler::get_instance().add_step_callback(callback);
+    }
+
+    void shutdown() {
+        Scheduler::get_instance().shutdown();
+    }
+}
+
+
+
+
+namespace pros
+{
+    Task::Task(task_fn_t function, void* parameters, std::uint32_t prio, std::uint16_t stack_depth, const char* name) {
+        context = sim::Scheduler::get_instance().spawn(function, parameters, prio, name);
+    }
+
+    Task::Task(task_fn_t function, void* parameters, const char* name)
+        : Task(function, parameters, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, name) { }
+
+
+    void Task::remove() {
+        sim::Scheduler::get_instance().remove(context);
+    }
+
+    void Task::suspend() {
+        sim::Scheduler::get_instance().suspend(context);
+    }
+
+    void Task::resume() {
+        sim::Scheduler::get_instance().resume(context);
+    }
+
+    std::uint32_t Task::get_priority() {
+        return context->priority;
+    }
+
+    void Task::set_priority(std::uint32_t prio) {
+        context->priority = prio;
+    }
+
+    task_state_e_t Task::get_state() {
+        return sim::Scheduler::get_instance().get_state(context);
+    }
+
+    const char* Task::get_name() {
+        return context->name.c_str();
+    }
+
+    void Task::delay(const std::uint32_t milliseconds) {
+        pros::delay(milliseconds);
+    }
+
+    void Task::delay_until(std::uint32_t* const prev_time, const std::uint32_t delta) {
+        pros::c::task_delay_until(prev_time, delta);
+    }
+
+
+
+    std::uint32_t millis() {
+        return sim::micros() / 1000;
+    }
+
+    void delay(const std::uint32_t milliseconds) {
+        sim::Scheduler& scheduler = sim::Scheduler::get_instance();
+        scheduler.sleep_until(scheduler.now() + (std::uint64_t)milliseconds * 1000);
+    }
+
+
+    namespace c
+    {
+        std::uint32_t millis() {
+            return pros::millis();
+        }
+
+        void delay(const std::uint32_t milliseconds) {
+            pros::delay(milliseconds);
+        }
+
+        void task_delay(const std::uint32_t milliseconds) {
+            pros::delay(milliseconds);
+        }
+
+        /**
+         * same semantics as FreeRTOS vTaskDelayUntil, wakes at *prev_time + delta
+         * and advances *prev_time by delta even if that time has already passed
+         * in which case it returns right away
+         */
+        void task_delay_until(std::uint32_t* const prev_time, const std::uint32_t delta) {
+            std::uint64_t wake_time = ((std::uint64_t)*prev_time + delta) * 1000;
+            *prev_time += delta;
+
+            sim::Scheduler& scheduler = sim::Scheduler::get_instance();
+            if(wake_time > scheduler.now()) {
+                scheduler.sleep_until(wake_time);
+            }
+        }
+    }
+}
+
+
+
+/**
+ * stand in for the vex sdk clock that Timestamp reads
+ */
+extern "C" std::uint64_t vexSystemHighResTimeGet( void ) {
+    return sim::micros();
+}
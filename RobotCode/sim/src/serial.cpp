@@ -0,0 +1,49 @@
+/**
+ * @file: ./RobotCode/sim/src/serial.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains the simulated serial control, stdin and stdout are already raw
+ * on the host so there is nothing to toggle
+ */
+
+#include <cerrno>
+#include <sys/ioctl.h>
+
+#include "main.h"
+
+
+namespace pros
+{
+    namespace c
+    {
+        std::int32_t serctl(const std::uint32_t action, void* const extra_arg) {
+            switch(action) {
+                case SERCTL_ACTIVATE:
+                case SERCTL_DEACTIVATE:
+                case SERCTL_BLKWRITE:
+                case SERCTL_NOBLKWRITE:
+                case SERCTL_ENABLE_COBS:
+                case SERCTL_DISABLE_COBS:
+                    return 0;
+                default:
+                    errno = EINVAL;
+                    return PROS_ERR;
+            }
+        }
+
+
+        /**
+         * only DEVCTL_FIONREAD is used, it is answered by the host
+         */
+        std::int32_t fdctl(int file, const std::uint32_t action, void* const extra_arg) {
+            int available = 0;
+            if(action != DEVCTL_FIONREAD || ioctl(file, FIONREAD, &available) != 0) {
+                errno = EINVAL;
+                return PROS_ERR;
+            }
+            return available;
+        }
+    }
+}
@@ -0,0 +1,242 @@
+/**
+ * @file: ./RobotCode/sim/tests/frame_reader_fuzz.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * fuzz test for the server request parser
+ * feeds the FrameReader valid requests cut into random reads, mixed with
+ * garbage, with corrupted bytes, and as pure noise, and checks that every
+ * request that arrived intact comes out, nothing it returns is malformed,
+ * and the buffer never holds more than it can
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "main.h"
+#include "sim_test.hpp"
+
+#include "../../src/objects/serial/FrameReader.hpp"
+
+
+namespace
+{
+    std::mt19937 generator(1234);  // fixed so a failure can be repeated
+
+    int random_int(int low, int high) {
+        return std::uniform_int_distribution<int>(low, high)(generator);
+    }
+
+    server_request_record random_request() {
+        server_request_record request = {};
+        request.return_id = random_int(0, 0xFFFF);
+        request.command_id = random_int(0, 0xFFFF);
+        request.length = random_int(0, SERVER_MAX_MSG);
+        for ( int i = 0; i < request.length; i++ ) {
+            request.msg[i] = random_int(0, 255);
+        }
+        return request;
+    }
+
+    std::vector<std::uint8_t> encode(const server_request_record &request) {
+        std::vector<std::uint8_t> frame = {
+            SERVER_PREAMBLE1, SERVER_PREAMBLE2, SERVER_PREAMBLE3, (std::uint8_t)(request.length + 4),
+            (std::uint8_t)(request.return_id >> 8), (std::uint8_t)(request.return_id & 0xFF),
+            (std::uint8_t)(request.command_id >> 8), (std::uint8_t)(request.command_id & 0xFF)
+        };
+        for ( int i = 0; i < request.length; i++ ) {
+            frame.push_back(request.msg[i]);
+        }
+        frame.push_back(SERVER_CHECKSUM);
+        return frame;
+    }
+
+    bool same(const server_request_record &a, const server_request_record &b) {
+        return a.return_id == b.return_id && a.command_id == b.command_id && a.length == b.length && std::memcmp(a.msg, b.msg, a.length) == 0;
+    }
+
+    /**
+     * writes the stream in reads of 1 to max_read bytes, parsing after every
+     * read like the server does
+     */
+    std::vector<server_request_record> feed(FrameReader &reader, const std::vector<std::uint8_t> &stream, int max_read, bool &bounded) {
+        std::vector<server_request_record> parsed;
+        server_request_record request;
+        std::size_t position = 0;
+        bounded = true;
+        while ( position < stream.size() ) {
+            int count = std::min<int>(random_int(1, max_read), stream.size() - position);
+            count = std::min(count, reader.space());
+            reader.write(stream.data() + position, count);
+            position += count;
+            bounded = bounded && reader.size() <= SERVER_RX_BUFFER_SIZE;
+
+            while ( reader.next_frame(request) ) {
+                bounded = bounded && request.length <= SERVER_MAX_MSG;
+                parsed.push_back(request);
+            }
+        }
+        return parsed;
+    }
+
+
+
+    void split_frames() {
+        std::vector<server_request_record> sent;
+        std::vector<std::uint8_t> stream;
+        for ( int i = 0; i < 2000; i++ ) {
+            sent.push_back(random_request());
+            std::vector<std::uint8_t> frame = encode(sent.back());
+            stream.insert(stream.end(), frame.begin(), frame.end());
+        }
+
+        FrameReader reader;
+        bool bounded;
+        std::vector<server_request_record> parsed = feed(reader, stream, SERVER_READ_BLOCK, bounded);
+
+        bool all_same = parsed.size() == sent.size();
+        for ( std::size_t i = 0; all_same && i < sent.size(); i++ ) {
+            all_same = same(parsed.at(i), sent.at(i));
+        }
+        check(all_same, "requests split across random reads all come out in order");
+        check(reader.get_stats().skipped_bytes == 0 && reader.get_stats().bad_frames == 0, "nothing is skipped in a clean stream");
+    }
+
+
+    void garbage_between_frames() {
+        std::vector<server_request_record> sent;
+        std::vector<std::uint8_t> stream;
+        for ( int i = 0; i < 2000; i++ ) {
+            int garbage = random_int(0, 40);
+            for ( int j = 0; j < garbage; j++ ) {
+                int byte = random_int(0, 255);
+                stream.push_back(byte == SERVER_PREAMBLE1 ? 0 : byte);  // a real preamble in the garbage could start a false frame
+            }
+            if ( random_int(0, 3) == 0 ) {  // a lone preamble that goes nowhere
+                stream.push_back(SERVER_PREAMBLE1);
+                stream.push_back(SERVER_PREAMBLE2);
+            }
+
+            sent.push_back(random_request());
+            std::vector<std::uint8_t> frame = encode(sent.back());
+            stream.insert(stream.end(), frame.begin(), frame.end());
+        }
+
+        FrameReader reader;
+        bool bounded;
+        std::vector<server_request_record> parsed = feed(reader, stream, SERVER_READ_BLOCK, bounded);
+
+        bool all_same = parsed.size() == sent.size();
+        for ( std::size_t i = 0; all_same && i < sent.size(); i++ ) {
+            all_same = same(parsed.at(i), sent.at(i));
+        }
+        check(all_same, "requests between garbage and broken preambles all come out in order");
+    }
+
+
+    /**
+     * a corrupted byte can only hide a later request if a false frame that
+     * starts at the corruption happens to end on a 0xC6, which is rare
+     */
+    void corrupted_frames() {
+        std::vector<server_request_record> sent;
+        std::vector<bool> intact;
+        std::vector<std::uint8_t> stream;
+        for ( int i = 0; i < 5000; i++ ) {
+            sent.push_back(random_request());
+            std::vector<std::uint8_t> frame = encode(sent.back());
+            bool corrupt = random_int(0, 9) == 0;
+            if ( corrupt ) {
+                frame.at(random_int(0, frame.size() - 1)) ^= random_int(1, 255);
+            }
+            intact.push_back(!corrupt);
+            stream.insert(stream.end(), frame.begin(), frame.end());
+        }
+
+        FrameReader reader;
+        bool bounded;
+        std::vector<server_request_record> parsed = feed(reader, stream, SERVER_READ_BLOCK, bounded);
+
+        int num_intact = 0;
+        int recovered = 0;
+        std::size_t next = 0;
+        for ( std::size_t i = 0; i < sent.size(); i++ ) {
+            if ( !intact.at(i) ) {
+                continue;
+            }
+            num_intact += 1;
+            for ( std::size_t j = next; j < parsed.size() && j < next + 8; j++ ) {
+                if ( same(parsed.at(j), sent.at(i)) ) {
+                    recovered += 1;
+                    next = j + 1;
+                    break;
+                }
+            }
+        }
+
+        std::cout << "corrupted: " << recovered << " of " << num_intact << " intact requests recovered, "
+                  << reader.get_stats().bad_frames << " bad frames\n";
+        check(recovered >= num_intact * 98 / 100, "the parser resyncs after corrupted requests");
+        check(bounded, "buffer stays bounded with corrupted requests");
+    }
+
+
+    void noise() {
+        std::vector<std::uint8_t> stream;
+        for ( int i = 0; i < 1000000; i++ ) {
+            stream.push_back(random_int(0, 255));
+        }
+        for ( int i = 0; i < 1000; i++ ) {  // make false preambles common
+            int index = random_int(0, stream.size() - 3);
+            stream.at(index) = SERVER_PREAMBLE1;
+            stream.at(index + 1) = SERVER_PREAMBLE2;
+            stream.at(index + 2) = SERVER_PREAMBLE3;
+        }
+
+        FrameReader reader;
+        bool bounded;
+        feed(reader, stream, 4 * SERVER_READ_BLOCK, bounded);
+
+        frame_reader_stats stats = reader.get_stats();
+        std::cout << "noise: " << stats.frames << " frames, " << stats.bad_frames << " bad frames, " << stats.skipped_bytes << " skipped bytes\n";
+        check(bounded, "noise never overfills the buffer or makes a malformed request");
+        check(reader.size() < SERVER_MAX_FRAME, "noise is consumed as it arrives");
+    }
+
+
+    void overflow() {
+        FrameReader reader;
+        std::vector<std::uint8_t> frame = encode(random_request());
+        int written = 0;
+        for ( int i = 0; i < 20; i++ ) {
+            written += reader.write(frame.data(), frame.size());
+        }
+        check(written == SERVER_RX_BUFFER_SIZE && reader.space() == 0, "writes stop when the buffer is full");
+        check(reader.get_stats().overflowed_bytes == 20 * frame.size() - SERVER_RX_BUFFER_SIZE, "bytes that did not fit are counted");
+
+        server_request_record request;
+        int parsed = 0;
+        while ( reader.next_frame(request) ) {
+            parsed += 1;
+        }
+        check(parsed == SERVER_RX_BUFFER_SIZE / (int)frame.size(), "whole requests in a full buffer are parsed");
+    }
+}
+
+
+
+int main() {
+    split_frames();
+    garbage_between_frames();
+    corrupted_frames();
+    noise();
+    overflow();
+
+    finish_tests();
+}
@@ -0,0 +1,122 @@
+/**
+ * @file: ./RobotCode/sim/tests/gearset_conversion.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * unit tests for the voltage and velocity conversions of each cartridge
+ * and for the Motor commands that use them
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "main.h"
+#include "sim.hpp"
+#include "sim_test.hpp"
+
+#include "../../src/objects/motors/Motor.hpp"
+#include "../../src/objects/motors/MotorThread.hpp"
+#include "../../src/objects/serial/Logger.hpp"
+
+
+namespace
+{
+    typedef struct
+    {
+        pros::motor_gearset_e_t gearset;
+        std::string name;
+        int max_velocity;
+    } cartridge;
+
+    const cartridge cartridges[] = {
+        {pros::E_MOTOR_GEARSET_36, "100 RPM", 120},
+        {pros::E_MOTOR_GEARSET_18, "200 RPM", 240},
+        {pros::E_MOTOR_GEARSET_06, "600 RPM", 720}
+    };
+
+
+    void conversion_tests() {
+        for ( const cartridge &c : cartridges ) {
+            int max = Motor::get_max_velocity(c.gearset);
+            check(max == c.max_velocity, c.name + " velocity range is " + std::to_string(c.max_velocity));
+
+            check(Motor::to_voltage(max, max) == 12000, c.name + " full forward velocity is 12000mv");
+            check(Motor::to_voltage(-max, max) == -12000, c.name + " full reverse velocity is -12000mv");
+            check(Motor::to_voltage(0, max) == 0, c.name + " stopped is 0mv");
+            check(Motor::to_voltage(max / 2, max) == 6000, c.name + " half velocity is 6000mv");
+
+            check(Motor::to_velocity(12000, max) == max, c.name + " 12000mv is full forward velocity");
+            check(Motor::to_velocity(-12000, max) == -max, c.name + " -12000mv is full reverse velocity");
+            check(Motor::to_velocity(0, max) == 0, c.name + " 0mv is stopped");
+            check(Motor::to_velocity(6000, max) == max / 2, c.name + " 6000mv is half velocity");
+
+            bool monotonic = true;
+            bool round_trip = true;
+            for ( int velocity = -max; velocity <= max; velocity++ ) {
+                int voltage = Motor::to_voltage(velocity, max);
+                if ( velocity > -max && voltage < Motor::to_voltage(velocity - 1, max) ) {
+                    monotonic = false;
+                }
+                if ( std::abs(Motor::to_velocity(voltage, max) - velocity) > 1 || voltage < -12000 || voltage > 12000 ) {
+                    round_trip = false;
+                }
+            }
+            check(monotonic, c.name + " voltage increases with velocity");
+            check(round_trip, c.name + " velocity survives a round trip through voltage");
+        }
+
+        check(Motor::get_max_velocity(pros::E_MOTOR_GEARSET_INVALID) == 240, "unknown gearset uses the 200 RPM range");
+    }
+
+
+    void motor_tests() {
+        Motor *motors[3];
+        MotorThread *motor_thread = MotorThread::get_instance();
+        for ( int i = 0; i < 3; i++ ) {
+            motors[i] = new Motor(i + 1, cartridges[i].gearset, false);
+            motor_thread->register_motor(*motors[i]);
+        }
+        motor_thread->start_thread();
+        pros::delay(20);
+
+        // rated speed of each cartridge is 5/6 of the range
+        for ( int i = 0; i < 3; i++ ) {
+            motors[i]->move_velocity(cartridges[i].max_velocity * 5 / 6);
+        }
+        pros::delay(20);
+        for ( int i = 0; i < 3; i++ ) {
+            check(sim::motor_plant(i + 1)->get_applied_voltage() == 10000, cartridges[i].name + " motor at rated velocity is sent 10000mv");
+        }
+
+        // commands only publish setpoints, converting must not go out to the device
+        motor_thread->stop_thread();
+        pros::delay(20);
+        std::uint64_t calls = sim::motor_device_calls();
+        for ( int i = 0; i < 1000; i++ ) {
+            motors[i % 3]->move_velocity(i % 100);
+            motors[i % 3]->set_voltage(i * 10);
+        }
+        check(sim::motor_device_calls() == calls, "commanding a motor does not query the device");
+
+        motors[1]->set_gearing(pros::E_MOTOR_GEARSET_06);
+        motor_thread->start_thread();
+        motors[1]->move_velocity(600);
+        pros::delay(20);
+        check(sim::motor_plant(2)->get_applied_voltage() == 10000, "changing the gearing changes the velocity range");
+    }
+}
+
+
+
+int main() {
+    Logger::stop_queueing();
+    std::clog.setstate(std::ios::failbit);  // registration messages
+
+    conversion_tests();
+    motor_tests();
+
+    sim::shutdown();
+    finish_tests();
+}
@@ -0,0 +1,369 @@
+/**
+ * @file: ./RobotCode/sim/tests/logger_ring.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * unit tests for the record ring under the logger and for what the logger
+ * writes when it is dumped: every entry once and in order per task, source
+ * policies, entries that are too long, the warning for a full queue, and
+ * that only the drain task writes the log file
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "sim.hpp"
+#include "sim_test.hpp"
+
+#include "../../src/objects/serial/Logger.hpp"
+#include "../../src/objects/serial/RecordRing.hpp"
+
+
+namespace
+{
+    typedef struct
+    {
+        int producer;
+        int index;
+    } ring_entry;
+
+
+    void ring_tests() {
+        RecordRing<ring_entry, 8> ring;
+        std::uint32_t position;
+        for ( int i = 0; i < 8; i++ ) {
+            ring_entry *entry = ring.claim(position);
+            entry->index = i;
+            ring.publish(position);
+        }
+        check(ring.size() == 8 && ring.claim(position) == NULL && ring.get_dropped() == 1, "a full ring drops and counts the record");
+
+        bool in_order = true;
+        for ( int i = 0; i < 8; i++ ) {
+            ring_entry *entry = ring.peek();
+            in_order = in_order && entry != NULL && entry->index == i;
+            ring.pop();
+        }
+        check(in_order && ring.size() == 0 && ring.peek() == NULL, "records are taken in the order they were claimed");
+
+        std::uint32_t unpublished;
+        ring.claim(unpublished)->index = 100;
+        ring_entry *after = ring.claim(position);
+        after->index = 101;
+        ring.publish(position);
+        check(ring.peek() == NULL && ring.size() == 2, "a claimed record that is not published holds back the ones after it");
+        ring.publish(unpublished);
+        ring_entry *first = ring.peek();
+        check(first != NULL && first->index == 100, "the held back record is taken once it is published");
+        ring.pop();
+        ring.pop();
+
+        // several host threads produce while this one takes, each producer's
+        // records have to come out in order with none lost except the dropped ones
+        const int num_producers = 4;
+        const int per_producer = 50000;
+        RecordRing<ring_entry, 64> shared;
+        std::atomic<int> finished(0);
+        std::vector<std::thread> producers;
+        for ( int p = 0; p < num_producers; p++ ) {
+            producers.emplace_back([&shared, &finished, p]() {
+                for ( int i = 0; i < per_producer; i++ ) {
+                    std::uint32_t claimed;
+                    ring_entry *entry = shared.claim(claimed);
+                    if ( entry == NULL ) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    entry->producer = p;
+                    entry->index = i;
+                    shared.publish(claimed);
+                }
+                finished += 1;
+            });
+        }
+
+        int last[num_producers];
+        std::fill(std::begin(last), std::end(last), -1);
+        long taken = 0;
+        bool ordered = true;
+        while ( finished < num_producers || shared.size() > 0 ) {
+            ring_entry *entry = shared.peek();
+            if ( entry == NULL ) {
+                std::this_thread::yield();
+                continue;
+            }
+            ordered = ordered && entry->index > last[entry->producer];
+            last[entry->producer] = entry->index;
+            shared.pop();
+            taken += 1;
+        }
+        for ( std::thread &producer : producers ) {
+            producer.join();
+        }
+
+        std::cout << "ring: " << taken << " taken, " << shared.get_dropped() << " dropped\n";
+        check(ordered, "each producer's records are taken in order");
+        check(taken + shared.get_dropped() == (long)num_producers * per_producer, "every record is either taken or counted as dropped");
+    }
+
+
+
+    /**
+     * dumps until the queue is empty with stderr and stdout sent to a file
+     * and returns the lines that were written
+     */
+    std::vector<std::string> dump_lines() {
+        std::fflush(stdout);
+        std::fflush(stderr);
+        std::FILE *capture = std::tmpfile();
+        int saved_stdout = dup(STDOUT_FILENO);
+        int saved_stderr = dup(STDERR_FILENO);
+        dup2(fileno(capture), STDOUT_FILENO);
+        dup2(fileno(capture), STDERR_FILENO);
+
+        Logger logger;
+        for ( int i = 0; i < (LOGGER_RECORDS / LOGGER_DUMP_ENTRIES) + 2 && Logger::get_count() > 0; i++ ) {
+            if ( logger.dump() == 0 ) {
+                break;
+            }
+        }
+        logger.dump();  // a warning for dropped entries is written even when the queue is empty
+
+        std::fflush(stdout);
+        std::fflush(stderr);
+        dup2(saved_stdout, STDOUT_FILENO);
+        dup2(saved_stderr, STDERR_FILENO);
+        close(saved_stdout);
+        close(saved_stderr);
+
+        std::vector<std::string> lines;
+        std::rewind(capture);
+        char line[LOGGER_RECORD_SIZE + 64];
+        while ( std::fgets(line, sizeof(line), capture) != NULL ) {
+            lines.push_back(std::string(line, std::strcspn(line, "\n")));
+        }
+        std::fclose(capture);
+
+        return lines;
+    }
+
+
+    /**
+     * content of a "<time> <sequence> <content>" line
+     */
+    std::string content_of(const std::string &line) {
+        std::size_t first = line.find(' ');
+        std::size_t second = line.find(' ', first + 1);
+        return second == std::string::npos ? "" : line.substr(second + 1);
+    }
+
+
+    std::uint32_t sequence_of(const std::string &line) {
+        std::istringstream fields(line);
+        std::uint32_t time;
+        std::uint32_t sequence = 0;
+        fields >> time >> sequence;
+        return sequence;
+    }
+
+
+    std::atomic<int> tasks_running(0);
+
+    void logging_task(void *param) {
+        long id = (long)param;
+        Logger logger;
+        for ( int i = 0; i < 40; i++ ) {
+            logger.add(e_log_clog, "task %ld entry %d", id, i);
+            if ( i % 10 == 0 ) {
+                pros::delay(1);
+            }
+        }
+        tasks_running -= 1;
+    }
+
+
+    void logger_tests() {
+        Logger logger;
+
+        const int num_tasks = 4;
+        tasks_running = num_tasks;
+        for ( long t = 0; t < num_tasks; t++ ) {
+            new pros::Task(logging_task, (void*)t, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, "logging");
+        }
+        while ( tasks_running > 0 ) {
+            pros::delay(1);
+        }
+
+        std::vector<std::string> lines = dump_lines();
+        int next[num_tasks] = {};
+        std::uint32_t last_sequence[num_tasks] = {};
+        bool ordered = true;
+        bool stamped = true;
+        for ( const std::string &line : lines ) {
+            long id;
+            int index;
+            if ( std::sscanf(content_of(line).c_str(), "task %ld entry %d", &id, &index) == 2 && id >= 0 && id < num_tasks ) {
+                ordered = ordered && index == next[id];
+                next[id] = index + 1;
+                stamped = stamped && (index == 0 || sequence_of(line) > last_sequence[id]);
+                last_sequence[id] = sequence_of(line);
+            }
+        }
+        bool complete = true;
+        for ( int t = 0; t < num_tasks; t++ ) {
+            complete = complete && next[t] == 40;
+        }
+        check(complete && ordered, "entries from several tasks are all written once and in order per task");
+        check(stamped, "each task's entries are written with increasing sequence numbers");
+        check(Logger::get_count() == 0, "the queue is empty after dumping");
+
+        Logger::set_policy(e_log_source_motor, e_log_drop_newest, 4);
+        for ( int i = 0; i < 10; i++ ) {
+            logger.add(e_log_source_motor, e_log_clog, "newest %d", i);
+        }
+        log_source_stats stats = Logger::get_source_stats(e_log_source_motor);
+        lines = dump_lines();
+        check(
+            stats.accepted == 4 && stats.dropped == 6 && lines.size() == 4 && content_of(lines.front()) == "newest 0" && content_of(lines.back()) == "newest 3",
+            "drop newest keeps the first entries up to capacity"
+        );
+
+        Logger::set_policy(e_log_source_motor, e_log_drop_oldest, 4);
+        for ( int i = 0; i < 10; i++ ) {
+            logger.add(e_log_source_motor, e_log_clog, "oldest %d", i);
+        }
+        lines = dump_lines();
+        check(
+            lines.size() == 4 && content_of(lines.front()) == "oldest 6" && content_of(lines.back()) == "oldest 9",
+            "drop oldest writes the newest entries up to capacity"
+        );
+        check(Logger::get_count(e_log_source_motor) == 0, "drop oldest leaves nothing of the source queued");
+
+        Logger::set_policy(e_log_source_motor, e_log_sample, LOGGER_RECORDS, 3);
+        for ( int i = 0; i < 9; i++ ) {
+            logger.add(e_log_source_motor, e_log_clog, "sample %d", i);
+        }
+        lines = dump_lines();
+        check(
+            lines.size() == 3 && content_of(lines.at(0)) == "sample 0" && content_of(lines.at(1)) == "sample 3" && content_of(lines.at(2)) == "sample 6",
+            "sampling writes every n'th entry"
+        );
+        Logger::set_policy(e_log_source_motor, e_log_drop_newest, LOGGER_MOTOR_CAPACITY);
+
+        logger.add({"clog", std::string(LOGGER_RECORD_SIZE + 100, 'x')});
+        lines = dump_lines();
+        check(lines.size() == 1 && content_of(lines.front()) == std::string(LOGGER_RECORD_SIZE - 1, 'x'), "an entry that is too long is cut off");
+
+        // motors can only take part of the ring so the rest is filled by another source
+        std::uint32_t dropped_before = Logger::get_dropped();
+        for ( int i = 0; i < LOGGER_MOTOR_CAPACITY; i++ ) {
+            logger.add(e_log_source_motor, e_log_clog, "fill %d", i);
+        }
+        for ( int i = LOGGER_MOTOR_CAPACITY; i < LOGGER_RECORDS + 5; i++ ) {
+            logger.add(e_log_clog, "fill %d", i);
+        }
+        check(Logger::get_dropped() - dropped_before == 5, "entries past a full queue are dropped and counted");
+        lines = dump_lines();
+        int filled = 0;
+        bool warned = false;
+        for ( const std::string &line : lines ) {
+            filled += content_of(line).rfind("fill ", 0) == 0;
+            warned = warned || line.find(" 5 log entries dropped") != std::string::npos;
+        }
+        check(filled == LOGGER_RECORDS && warned, "a full queue is written and the dropped entries are reported");
+    }
+
+
+
+    /**
+     * only the drain task writes the log file, an entry dumped by another
+     * task goes to the console and not the card
+     */
+    void file_tests() {
+        char directory[] = "/tmp/logger_ringXXXXXX";
+        if ( mkdtemp(directory) == NULL ) {
+            check(false, "temporary directory for the log file");
+            return;
+        }
+        std::string prefix = std::string(directory) + "/match_";
+
+        Logger logger;
+        Logger::start_drain_task();
+        Logger::open_file(prefix);
+        for ( int i = 0; i < 100 && Logger::get_stats().file_number < 0; i++ ) {
+            pros::delay(5);
+        }
+        check(Logger::get_stats().file_number == 0, "drain task opens the log file");
+
+        logger.add(e_log_clog, "dumped by another task");
+        std::vector<std::string> lines = dump_lines();  // the virtual clock does not move so the drain task can not run first
+        check(lines.size() == 1 && content_of(lines.front()) == "dumped by another task", "dump() writes to the console");
+
+        for ( int i = 0; i < 20; i++ ) {
+            logger.add(e_log_clog, "drained %d", i);
+        }
+        std::fflush(stderr);
+        int saved_stderr = dup(STDERR_FILENO);
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDERR_FILENO);
+        pros::delay(LOGGER_DRAIN_PERIOD_MAX * 2);
+        Logger::close_file();
+        pros::delay(LOGGER_DRAIN_PERIOD_MAX * 2);
+        std::fflush(stderr);
+        dup2(saved_stderr, STDERR_FILENO);
+        close(null_fd);
+        close(saved_stderr);
+
+        std::string path = prefix + "0000.log";
+        std::FILE *log_file = std::fopen(path.c_str(), "r");
+        std::string contents;
+        if ( log_file != NULL ) {
+            char buffer[1024];
+            std::size_t length;
+            while ( (length = std::fread(buffer, 1, sizeof(buffer), log_file)) > 0 ) {
+                contents.append(buffer, length);
+            }
+            std::fclose(log_file);
+        }
+
+        unsigned int committed = 0;
+        std::sscanf(contents.c_str(), "# match log v1, file %*d, opened at %*u ms, committed %u bytes", &committed);
+        check(contents.find("drained 19") != std::string::npos, "entries taken by the drain task are in the log file");
+        check(contents.find("dumped by another task") == std::string::npos, "entries dumped by another task are not in the log file");
+        check(
+            contents.size() > LOGGER_FILE_HEADER_SIZE && committed == contents.size() - LOGGER_FILE_HEADER_SIZE,
+            "the header counts every byte after it"
+        );
+        check(Logger::get_stats().file_errors == 0, "the file is written and closed without errors");
+
+        std::remove(path.c_str());
+        rmdir(directory);
+    }
+}
+
+
+
+int main() {
+    std::clog.setstate(std::ios::failbit);  // registration messages
+
+    ring_tests();
+    logger_tests();
+    file_tests();
+
+    Logger::stop_queueing();
+    sim::shutdown();
+    finish_tests();
+}
@@ -0,0 +1,264 @@
+/**
+ * @file: ./RobotCode/sim/tests/mailbox_stress.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contention test for the motor command mailbox
+ * first hammers a Mailbox from several host threads and checks that no read
+ * is ever torn, then has several tasks command the same Motor while the motor
+ * thread runs and checks that commanding never waits and the thread never stalls,
+ * and last has several tasks register and unregister motors at the motor
+ * thread's priority and checks that none of them stalls the others
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "main.h"
+#include "sim.hpp"
+#include "sim_test.hpp"
+
+#include "../../src/objects/motors/Mailbox.hpp"
+#include "../../src/objects/motors/Motor.hpp"
+#include "../../src/objects/motors/MotorThread.hpp"
+#include "../../src/objects/serial/Logger.hpp"
+
+
+namespace
+{
+    bool consistent(const pid &gains) {  // motor_slew is not checked because Motor::set_pid does not set it
+        return gains.kI == 2 * gains.kP && gains.kD == 3 * gains.kP && gains.i_max == 4 * gains.kP;
+    }
+
+    pid make_gains(double k) {
+        return {k, 2 * k, 3 * k, 4 * k, 5 * k};
+    }
+
+
+
+    /**
+     * payload that gives up the cpu halfway through every copy so that on a
+     * single core host writers and the reader are forced to interleave inside
+     * the mailbox's copy, which is where a torn read would come from
+     */
+    struct InterleavedGains
+    {
+        double kP = 0;
+        double kI = 0;
+        double kD = 0;
+        double i_max = 0;
+
+        InterleavedGains() { }
+        InterleavedGains(double k) : kP(k), kI(2 * k), kD(3 * k), i_max(4 * k) { }
+        InterleavedGains(const InterleavedGains &other) {
+            *this = other;
+        }
+        InterleavedGains& operator=(const InterleavedGains &other) {
+            kP = other.kP;
+            kI = other.kI;
+            std::this_thread::yield();
+            kD = other.kD;
+            i_max = other.i_max;
+            return *this;
+        }
+
+        bool consistent() const {
+            return kI == 2 * kP && kD == 3 * kP && i_max == 4 * kP;
+        }
+    };
+
+
+    /**
+     * writers publish gains where every field is a multiple of kP, so a read
+     * that mixes two writes breaks the relation
+     */
+    void raw_thread_stress() {
+        const int num_writers = 3;
+        const int writes_per_writer = 20000;
+
+        Mailbox<InterleavedGains> mailbox(InterleavedGains(0));
+        std::atomic<bool> done(false);
+        std::atomic<long> collisions(0);
+
+        std::vector<std::thread> writers;
+        for ( int w = 0; w < num_writers; w++ ) {
+            writers.emplace_back([&, w]() {
+                for ( int i = 1; i <= writes_per_writer; i++ ) {
+                    while ( !mailbox.try_publish(InterleavedGains((w * writes_per_writer) + i)) ) {
+                        collisions += 1;
+                        std::this_thread::yield();
+                    }
+                    std::this_thread::sleep_for(std::chrono::microseconds(10));  // gains are not rewritten back to back on the robot
+                }
+            });
+        }
+
+        long reads = 0;
+        long missed = 0;
+        long torn = 0;
+        std::thread reader([&]() {
+            InterleavedGains value;
+            while ( !done ) {
+                if ( mailbox.try_read(value) ) {
+                    reads += 1;
+                    if ( !value.consistent() ) {
+                        torn += 1;
+                    }
+                } else {
+                    missed += 1;
+                    std::this_thread::yield();  // motor thread would keep its last copy and move on
+                }
+            }
+        });
+
+        for ( std::thread &writer : writers ) {
+            writer.join();
+        }
+        done = true;
+        reader.join();
+
+        std::cout << "mailbox: " << reads << " reads, " << missed << " skipped mid write, " << collisions << " writer collisions\n";
+        check(torn == 0, "mailbox reads are never torn");
+        check(reads > 0 && missed > 0 && collisions > 0, "mailbox was read and written under contention");
+        check(mailbox.get_sequence() == 2u * num_writers * writes_per_writer, "every mailbox write is published");
+    }
+
+
+
+    Motor *motor;
+    std::atomic<int> writers_running(0);
+    std::atomic<long> commands(0);
+    std::atomic<long> slowest_command_ns(0);
+    std::atomic<long> torn_gains(0);
+
+    void commanding_task(void *param) {
+        long id = (long)param;
+        for ( int burst = 0; burst < 200; burst++ ) {
+            for ( int i = 0; i < 500; i++ ) {
+                auto start = std::chrono::steady_clock::now();
+                if ( i % 2 ) {
+                    motor->set_voltage(((id * 1000) + i) % 12000);
+                } else {
+                    motor->move_velocity(((id * 100) + i) % 200);
+                }
+                if ( i % 50 == 0 ) {
+                    motor->set_pid(make_gains(id + i));
+                    if ( !consistent(motor->get_pid()) ) {
+                        torn_gains += 1;
+                    }
+                }
+                long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+                long slowest = slowest_command_ns;
+                while ( elapsed > slowest && !slowest_command_ns.compare_exchange_weak(slowest, elapsed) );
+                commands += 1;
+            }
+            pros::delay(1);  // let virtual time move so the motor thread runs alongside the next burst
+        }
+        writers_running -= 1;
+    }
+
+
+    void motor_stress() {
+        const int num_writers = 3;
+
+        motor = new Motor(1, pros::E_MOTOR_GEARSET_18, false);
+        MotorThread *motor_thread = MotorThread::get_instance();
+        motor_thread->register_motor(*motor);
+        motor_thread->start_thread();
+        pros::delay(20);
+        motor_thread->reset_timing();
+        std::uint32_t start_time = pros::millis();
+
+        writers_running = num_writers;
+        for ( long w = 0; w < num_writers; w++ ) {
+            new pros::Task(commanding_task, (void*)w, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, "writer");
+        }
+        while ( writers_running > 0 ) {
+            pros::delay(5);
+        }
+
+        motor_thread_timing timing = motor_thread->get_timing();
+        std::uint32_t elapsed = pros::millis() - start_time;
+
+        motor->set_motor_mode(e_voltage);
+        motor->set_voltage(4321);
+        pros::delay(20);
+
+        std::cout << "motor: " << commands << " commands, slowest " << slowest_command_ns << "ns, " << timing.ticks << " motor thread ticks in " << elapsed << "ms, " << timing.overruns << " overruns\n";
+        check(torn_gains == 0, "gains read back from the motor are never torn");
+        check(timing.ticks + 1 >= elapsed / MOTOR_THREAD_PERIOD && timing.overruns == 0, "motor thread keeps ticking while commands are sent");
+        check(sim::motor_plant(1)->get_applied_voltage() == 4321, "motor thread applies the last command");
+    }
+
+
+
+    std::atomic<int> registering_running(0);
+    std::atomic<long> wrong_registrations(0);
+
+    /**
+     * is_registered() is checked against what this task just did while the
+     * other tasks change the list, a writer waiting on the lock while the
+     * holder waits on the motor thread in publish() has to give up the cpu
+     * or virtual time stops
+     */
+    void registering_task(void *param) {
+        Motor *own = (Motor*)param;
+        MotorThread *motor_thread = MotorThread::get_instance();
+        for ( int i = 0; i < 200; i++ ) {
+            motor_thread->register_motor(*own);
+            wrong_registrations += !motor_thread->is_registered(*own);
+            motor_thread->unregister_motor(*own);
+            wrong_registrations += motor_thread->is_registered(*own);
+            pros::delay(1);  // wake with the motor thread so publish() waits on its tick
+        }
+        registering_running -= 1;
+    }
+
+
+    void registration_stress() {
+        const int num_writers = 4;
+
+        MotorThread *motor_thread = MotorThread::get_instance();
+        motor_thread->reset_timing();
+        std::uint32_t start_time = pros::millis();
+
+        registering_running = num_writers;
+        for ( int w = 0; w < num_writers; w++ ) {
+            Motor *own = new Motor(w + 2, pros::E_MOTOR_GEARSET_18, false);
+            new pros::Task(registering_task, (void*)own, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, "registering");
+        }
+        while ( registering_running > 0 && pros::millis() - start_time < 10000 ) {
+            pros::delay(5);
+        }
+
+        motor_thread_timing timing = motor_thread->get_timing();
+        std::uint32_t elapsed = pros::millis() - start_time;
+
+        std::cout << "registration: " << num_writers << " tasks in " << elapsed << "ms, " << timing.ticks << " motor thread ticks\n";
+        check(registering_running == 0, "tasks registering at the motor thread's priority all finish");
+        check(wrong_registrations == 0, "is_registered agrees with what each task registered");
+        check(motor_thread->is_registered(*motor), "motors registered before are still registered");
+        check(timing.ticks > 0 && timing.overruns == 0, "motor thread keeps ticking while motors are registered");
+    }
+}
+
+
+
+int main() {
+    Logger::stop_queueing();
+    std::clog.setstate(std::ios::failbit);  // registration messages
+
+    raw_thread_stress();
+    motor_stress();
+    registration_stress();
+
+    sim::shutdown();
+    finish_tests();
+}
@@ -0,0 +1,248 @@
+/**
+ * @file: ./RobotCode/sim/tests/motor_trace_replay.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * runs the robot_sim routine with every motor traced, then checks that
+ * replaying the trace through the velocity controller gives the same output
+ * for every tick, including a feedforward profile that keeps its integral
+ * while the setpoint ramps
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "main.h"
+#include "sim.hpp"
+#include "sim_test.hpp"
+
+#include "../../src/Configuration.hpp"
+#include "../../src/objects/motors/Motors.hpp"
+#include "../../src/objects/motors/MotorThread.hpp"
+#include "../../src/objects/motors/MotorTrace.hpp"
+#include "../../src/objects/position_tracking/PositionTracker.hpp"
+#include "../../src/objects/sensors/Sensors.hpp"
+#include "../../src/objects/serial/Logger.hpp"
+#include "../../src/objects/subsystems/chassis.hpp"
+#include "../../src/objects/subsystems/LiftController.hpp"
+
+
+namespace
+{
+    const double drive_ratio = 3.0 / 5.0;   // motor to wheel
+    const double wheel_diameter = 3.25;     // in
+    const double track_width = WHEEL_TRACK_L + WHEEL_TRACK_R;  // in, between tracking wheels
+
+    double side_position(std::initializer_list<int> ports) {
+        double total = 0;
+        for(int port : ports) {
+            total += sim::motor_plant(port)->get_position();
+        }
+        return (total / ports.size()) * drive_ratio;  // degrees of the wheel
+    }
+
+    double left_position() {
+        return side_position({FL_MOTOR, ML_MOTOR, BL_MOTOR});
+    }
+
+    double right_position() {
+        return side_position({FR_MOTOR, MR_MOTOR, BR_MOTOR});
+    }
+
+    /**
+     * binds the sensors the same way robot_sim does so the routine runs the
+     * same way
+     */
+    void bind_sensors() {
+        sim::set_adi_source(INTERNAL_ADI_PORT, LEFT_ENC_TOP_PORT, []() {
+            return -left_position();  // left encoder is mounted reversed
+        });
+        sim::set_adi_source(INTERNAL_ADI_PORT, RIGHT_ENC_TOP_PORT, []() {
+            return right_position();
+        });
+        sim::set_imu_source(IMU_PORT, []() {
+            double difference = ((left_position() - right_position()) / 360) * wheel_diameter * M_PI;
+            return (difference / track_width) * (180 / M_PI);
+        });
+        sim::set_adi_source(EXPANDER_PORT, LIFT_POTENTIOMETER_PORT, []() {
+            return 1000 + (2 * sim::motor_plant(LIFT1_MOTOR)->get_position());
+        });
+
+        for(int port : {FL_MOTOR, ML_MOTOR, BL_MOTOR, FR_MOTOR, MR_MOTOR, BR_MOTOR}) {
+            sim::motor_plant(port)->set_load_torque(0.05);  // rolling resistance of the drive
+        }
+        for(int port : {LIFT1_MOTOR, LIFT2_MOTOR}) {
+            sim::motor_plant(port)->set_load_torque(0.6);  // weight of the lift
+        }
+    }
+
+
+    /**
+     * ramps one drive motor up in feedforward mode, holds, and steps it back
+     * to zero so the trace has ticks where the integral is kept and ticks
+     * where it is reset
+     */
+    void run_feedforward_profile(Motor &motor) {
+        feedforward ff;
+        ff.kS = 600;
+        ff.kV = 50;
+        ff.kA = 4;
+        motor.set_feedforward(ff);
+        motor.set_motor_mode(e_feedforward_velocity);
+
+        for ( int velocity = 0; velocity <= 150; velocity += 5 ) {
+            motor.move_velocity(velocity);
+            pros::delay(10);
+        }
+        pros::delay(300);
+        motor.move_velocity(0);
+        pros::delay(300);
+        motor.set_motor_mode(e_voltage);
+        motor.move(0);
+    }
+
+
+    /**
+     * a host thread stands in for the motor thread and writes ticks as fast
+     * as it can, wrapping the ring many times, while snapshots are taken.
+     * Every field a tick is checked by is its count so a record copied while
+     * it was written shows up as fields that differ
+     */
+    void live_snapshot_tests() {
+        MotorTrace *trace = MotorTrace::get_instance();
+        trace->clear();
+        std::atomic<bool> writing = ATOMIC_VAR_INIT(true);
+        std::atomic<bool> wrapped = ATOMIC_VAR_INIT(false);
+        std::thread writer([&writing, &wrapped, trace]() {
+            motor_trace_gains gains = {};
+            for ( std::int32_t count = 0; writing; count++ ) {
+                if ( count == 2 * MOTOR_TRACE_RECORDS ) {
+                    wrapped = true;
+                }
+                motor_trace_tick tick = {};
+                tick.delta_t = count;
+                tick.output = count;
+                tick.output_scale = count;
+                trace->record(1, tick, gains);
+            }
+        });
+
+        while ( !wrapped ) {
+            std::this_thread::yield();
+        }
+
+        int snapshots = 0;
+        int records = 0;
+        bool in_order = true;
+        bool whole = true;
+        bool ticks_follow = true;
+        while ( snapshots < 200 ) {
+            std::vector<motor_trace_record> snapshot = trace->snapshot();
+            std::int32_t previous_count = -1;
+            for ( int i = 0; i < snapshot.size(); i++ ) {
+                const motor_trace_record &record = snapshot.at(i);
+                in_order = in_order && (i == 0 || record.sequence == snapshot.at(i - 1).sequence + 1);
+                if ( record.kind == e_trace_tick ) {
+                    const motor_trace_tick &tick = record.tick;
+                    whole = whole && tick.output == tick.delta_t && tick.output_scale == tick.delta_t;
+                    ticks_follow = ticks_follow && (previous_count < 0 || tick.delta_t == previous_count + 1);
+                    previous_count = tick.delta_t;
+                }
+            }
+            records += snapshot.size();
+            snapshots += 1;
+        }
+        writing = false;
+        writer.join();
+
+        std::cout << "live snapshots: " << snapshots << " with " << records << " records\n";
+        check(records > 0, "snapshots taken while tracing have records");
+        check(in_order, "snapshots taken while tracing have no gaps and are oldest first");
+        check(whole, "no record in a snapshot was copied while it was written");
+        check(ticks_follow, "ticks in a snapshot follow each other");
+        trace->clear();
+    }
+}
+
+
+
+int main() {
+    Logger::stop_queueing();
+    std::clog.setstate(std::ios::failbit);  // registration messages
+
+    bind_sensors();
+    Motors::register_motors();
+    for ( Motor *motor : Motors::motor_array ) {
+        MotorTrace::get_instance()->enable(motor->get_port());
+    }
+    MotorThread::get_instance()->start_thread();
+    Sensors::calibrate_imu();
+    PositionTracker::get_instance()->start_thread();
+
+    Chassis chassis(Motors::front_left, Motors::front_right, Motors::back_left, Motors::back_right, Motors::mid_left, Motors::mid_right, Sensors::left_encoder, Sensors::right_encoder, 16, drive_ratio);
+    LiftController lift(Motors::lift1, Motors::lift2);
+    chassis.pid_straight_drive(1000, 0, 450, 3000, false, true, 0.2, false);
+    chassis.turn_right(90, 450, 2000, false, false);
+    lift.move_to(1800, false, 2000);
+    run_feedforward_profile(Motors::front_left);
+    for ( Motor *motor : Motors::motor_array ) {  // trace stays the same while it is saved and loaded
+        MotorTrace::get_instance()->disable(motor->get_port());
+    }
+    pros::delay(20);  // let a tick that already checked is_enabled finish writing
+
+    std::vector<motor_trace_record> trace = MotorTrace::get_instance()->snapshot();
+    int feedforward_ticks = 0;
+    for ( const motor_trace_record &record : trace ) {
+        feedforward_ticks += record.kind == e_trace_tick && record.tick.mode == e_feedforward_velocity;
+    }
+    check(feedforward_ticks > 0, "trace has feedforward ticks");
+    motor_trace_replay result = MotorTrace::replay(trace);
+    std::cout << "replayed " << result.replayed << " of " << result.ticks << " ticks\n";
+    check(result.replayed > 0, "trace has ticks to replay");
+    check(result.mismatches == 0, "replay matches every traced tick");
+
+    char path_template[] = "/tmp/motor_trace_replayXXXXXX";
+    close(mkstemp(path_template));
+    std::string path = path_template;
+    std::vector<motor_trace_record> loaded;
+    check(
+        MotorTrace::get_instance()->save(path) && MotorTrace::load(path, loaded) && loaded.size() == trace.size(),
+        "saved trace is loaded back"
+    );
+    motor_trace_replay loaded_result = MotorTrace::replay(loaded);
+    check(
+        loaded_result.replayed == result.replayed && loaded_result.mismatches == 0,
+        "loaded trace replays the same"
+    );
+    std::remove(path.c_str());
+
+    std::vector<motor_trace_record> tampered = trace;
+    std::uint32_t tampered_sequence = 0;
+    for ( int i = tampered.size() - 1; i >= 0; i-- ) {
+        motor_trace_record &record = tampered.at(i);
+        if ( record.kind == e_trace_tick && record.tick.mode == e_feedforward_velocity ) {
+            record.tick.output += 1;
+            tampered_sequence = record.sequence;
+            break;
+        }
+    }
+    motor_trace_replay tampered_result = MotorTrace::replay(tampered);
+    check(
+        tampered_sequence != 0 && tampered_result.mismatches >= 1 && tampered_result.first_mismatch == tampered_sequence,
+        "a changed output is found by the replay"
+    );
+
+    MotorThread::get_instance()->stop_thread();  // the test's writer is the only one tracing
+    live_snapshot_tests();
+
+    sim::shutdown();
+    finish_tests();
+}
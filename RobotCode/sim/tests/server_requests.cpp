@@ -0,0 +1,212 @@
+/**
+ * @file: ./RobotCode/sim/tests/server_requests.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * writes a burst of requests to the server's stdin with the read task above
+ * the sender task, like it is once the server is initialized, and checks
+ * that every request is answered once and in order on stdout
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "main.h"
+#include "sim.hpp"
+#include "sim_test.hpp"
+
+#include "../../src/objects/serial/Logger.hpp"
+#include "../../src/objects/serial/Server.hpp"
+
+
+#define TEST_COMMAND   0x7001
+#define TEST_REQUESTS  100     // more than the request ring and the reader's buffer hold at once
+
+
+namespace
+{
+    std::atomic<int> calls = ATOMIC_VAR_INIT(0);
+
+
+    /**
+     * replies with the number of bytes in the request and their sum
+     */
+    int sum_bytes(PayloadView &payload, ServerReply &reply) {
+        std::uint32_t count = 0;
+        std::uint32_t sum = 0;
+        int byte;
+        while ( (byte = payload.read_byte()) >= 0 ) {
+            count += 1;
+            sum += byte;
+        }
+        calls += 1;
+        reply.add(count);
+        reply.add(sum);
+        return 1;
+    }
+
+
+    std::vector<std::uint8_t> encode(std::uint16_t return_id, const std::vector<std::uint8_t> &msg) {
+        std::vector<std::uint8_t> frame = {
+            SERVER_PREAMBLE1, SERVER_PREAMBLE2, SERVER_PREAMBLE3, (std::uint8_t)(msg.size() + 4),
+            (std::uint8_t)(return_id >> 8), (std::uint8_t)(return_id & 0xFF),
+            (std::uint8_t)(TEST_COMMAND >> 8), (std::uint8_t)(TEST_COMMAND & 0xFF)
+        };
+        frame.insert(frame.end(), msg.begin(), msg.end());
+        frame.push_back(SERVER_CHECKSUM);
+        return frame;
+    }
+
+
+    /**
+     * crc-8 with polynomial 0x07 like the server and the python decoder
+     */
+    std::uint8_t crc8(const std::uint8_t *data, int length) {
+        std::uint8_t crc = 0;
+        for ( int i = 0; i < length; i++ ) {
+            crc ^= data[i];
+            for ( int bit = 0; bit < 8; bit++ ) {
+                crc = (crc & 0x80) ? (std::uint8_t)((crc << 1) ^ 0x07) : (std::uint8_t)(crc << 1);
+            }
+        }
+        return crc;
+    }
+
+
+    typedef struct
+    {
+        std::uint16_t return_id;
+        std::uint16_t command_id;
+        int status;
+        std::uint32_t count;
+        std::uint32_t sum;
+    } decoded_reply;
+
+
+    /**
+     * decodes the replies written like PIDDebugging/server_reply_decoder.py,
+     * bad_frames is set to the number of preambles that did not start a valid
+     * reply
+     */
+    std::vector<decoded_reply> decode(const std::vector<std::uint8_t> &data, int &bad_frames) {
+        std::vector<decoded_reply> decoded;
+        std::size_t position = 0;
+        bad_frames = 0;
+        while ( position + SERVER_REPLY_OVERHEAD <= data.size() ) {
+            if ( data.at(position) != SERVER_PREAMBLE1 || data.at(position + 1) != SERVER_PREAMBLE2 || data.at(position + 2) != SERVER_REPLY_PREAMBLE3 ) {
+                position += 1;
+                continue;
+            }
+
+            int length = data.at(position + 3) | (data.at(position + 4) << 8);
+            std::size_t end = position + 5 + length + 1;
+            if ( end > data.size() || length != 5 + 10 || crc8(data.data() + position + 3, length + 2) != data.at(end - 1) ) {
+                bad_frames += 1;
+                position += 1;
+                continue;
+            }
+
+            const std::uint8_t *frame = data.data() + position;
+            decoded_reply reply;
+            reply.return_id = frame[5] | (frame[6] << 8);
+            reply.command_id = frame[7] | (frame[8] << 8);
+            reply.status = frame[9];
+            std::memcpy(&reply.count, frame + 11, 4);  // each value is after its type byte
+            std::memcpy(&reply.sum, frame + 16, 4);
+            decoded.push_back(reply);
+            position = end;
+        }
+
+        return decoded;
+    }
+}
+
+
+
+int main() {
+    Logger::stop_queueing();
+    std::clog.setstate(std::ios::failbit);  // registration messages
+
+    int requests_pipe[2];
+    check(pipe(requests_pipe) == 0 && dup2(requests_pipe[0], STDIN_FILENO) >= 0, "stdin is read from a pipe");
+
+    char path[] = "/tmp/server_requestsXXXXXX";
+    int replies_file = mkstemp(path);
+    std::fflush(stdout);
+    int console = dup(STDOUT_FILENO);
+    dup2(replies_file, STDOUT_FILENO);
+
+    Server::register_command(TEST_COMMAND, sum_bytes);
+    Server server;
+    server.start_server();
+    Server::set_server_task_priority(TASK_PRIORITY_DEFAULT);  // what initializing the server does
+
+    std::vector<std::uint8_t> burst;
+    std::uint32_t expected_sums[TEST_REQUESTS];
+    for ( int i = 0; i < TEST_REQUESTS; i++ ) {
+        std::vector<std::uint8_t> msg;
+        expected_sums[i] = 0;
+        for ( int j = 0; j < (i % 40) + 1; j++ ) {
+            msg.push_back((i * 7 + j) & 0xFF);
+            expected_sums[i] += msg.back();
+        }
+        std::vector<std::uint8_t> frame = encode(i, msg);
+        burst.insert(burst.end(), frame.begin(), frame.end());
+    }
+    bool written = write(requests_pipe[1], burst.data(), burst.size()) == (ssize_t)burst.size();
+
+    for ( int waited = 0; waited < 2000 && calls < TEST_REQUESTS; waited += 10 ) {
+        pros::delay(10);
+    }
+    pros::delay(20);  // let the sender write the last replies
+    server.stop_server();
+
+    std::fflush(stdout);
+    dup2(console, STDOUT_FILENO);
+    close(console);
+
+    std::vector<std::uint8_t> data;
+    std::FILE *file = std::fopen(path, "rb");
+    if ( file != NULL ) {
+        std::uint8_t buffer[4096];
+        std::size_t length;
+        while ( (length = std::fread(buffer, 1, sizeof(buffer), file)) > 0 ) {
+            data.insert(data.end(), buffer, buffer + length);
+        }
+        std::fclose(file);
+    }
+    close(replies_file);
+    std::remove(path);
+
+    int bad_frames;
+    std::vector<decoded_reply> replies = decode(data, bad_frames);
+    std::cout << "server: " << burst.size() << " bytes of requests, " << replies.size() << " replies\n";
+
+    check(written, "requests are written in one burst");
+    check(calls == TEST_REQUESTS, "every request is handled once");
+    check(replies.size() == TEST_REQUESTS && bad_frames == 0, "every request is answered with a valid reply");
+
+    bool in_order = replies.size() == TEST_REQUESTS;
+    bool values_match = replies.size() == TEST_REQUESTS;
+    for ( int i = 0; i < replies.size() && i < TEST_REQUESTS; i++ ) {
+        const decoded_reply &reply = replies.at(i);
+        in_order = in_order && reply.return_id == i;
+        values_match = values_match && reply.command_id == TEST_COMMAND && reply.status == e_server_ok
+            && reply.count == (std::uint32_t)(i % 40) + 1 && reply.sum == expected_sums[i];
+    }
+    check(in_order, "replies come back in the order the requests were written");
+    check(values_match, "replies hold what the handler added");
+    check(Server::get_reply_stats().dropped == 0, "no replies are dropped");
+
+    sim::shutdown();
+    finish_tests();
+}
@@ -0,0 +1,150 @@
+/**
+ * @file: ./RobotCode/sim/tests/sysid_fit.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * unit tests for the system identification fit against samples from a known
+ * model, and a short identification run on a simulated motor that checks the
+ * motor is given back the way it was found
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "main.h"
+#include "sim.hpp"
+#include "sim_test.hpp"
+
+#include "../../src/objects/motors/Motor.hpp"
+#include "../../src/objects/motors/MotorThread.hpp"
+#include "../../src/objects/motors/SystemId.hpp"
+#include "../../src/objects/serial/Logger.hpp"
+
+
+namespace
+{
+    bool near(double value, double expected, double tolerance) {
+        return std::abs(value - expected) <= tolerance;
+    }
+
+
+    const double kS = 600;  // mV
+    const double kV = 50;   // mV/rpm
+    const double kA = 4;    // mV/(rpm/s)
+
+
+    /**
+     * ramp and step in each direction like SystemId::run() does, the voltage
+     * of each sample is what the model says plus noise of up to noise mV
+     */
+    std::vector<sysid_sample> make_samples(double noise) {
+        std::vector<sysid_sample> samples;
+        std::uint32_t time = 0;
+        for ( int direction : {1, -1} ) {
+            for ( int i = 0; i < 200; i++ ) {  // ramp, slow enough that acceleration is small
+                double velocity = direction * i * 0.8;
+                double acceleration = direction * 80;
+                samples.push_back({time, 0, velocity, acceleration});
+                time += SYSID_SAMPLE_PERIOD;
+            }
+            for ( int i = 0; i < 100; i++ ) {  // step, first order approach to 150 rpm
+                double velocity = direction * 150 * (1 - std::exp(-i / 12.0));
+                double acceleration = direction * 150 * std::exp(-i / 12.0) * 100 / 12.0;
+                samples.push_back({time, 0, velocity, acceleration});
+                time += SYSID_SAMPLE_PERIOD;
+            }
+        }
+
+        for ( int i = 0; i < samples.size(); i++ ) {
+            sysid_sample &sample = samples.at(i);
+            int sign = (sample.velocity > 0) - (sample.velocity < 0);
+            sample.voltage = (kS * sign) + (kV * sample.velocity) + (kA * sample.acceleration) + noise * std::sin(i * 1.7);
+        }
+
+        return samples;
+    }
+
+
+    void fit_tests() {
+        std::vector<sysid_sample> exact = make_samples(0);
+        motor_model model = SystemId::fit(exact);
+        check(near(model.ff.kS, kS, 1e-6) && near(model.ff.kV, kV, 1e-6) && near(model.ff.kA, kA, 1e-6), "exact samples recover kS, kV, and kA");
+        check(near(model.time_constant, kA / kV, 1e-9), "time constant is kA / kV");
+        check(near(model.r_squared, 1, 1e-9), "exact samples have an r squared of 1");
+
+        int moving = 0;
+        for ( const sysid_sample &sample : exact ) {
+            moving += std::abs(sample.velocity) >= SYSID_MIN_VELOCITY;
+        }
+        check(model.samples == moving, "samples slower than SYSID_MIN_VELOCITY are left out");
+
+        motor_model noisy = SystemId::fit(make_samples(200));
+        check(
+            near(noisy.ff.kS, kS, kS * 0.05) && near(noisy.ff.kV, kV, kV * 0.05) && near(noisy.ff.kA, kA, kA * 0.05),
+            "noisy samples are fit within 5%"
+        );
+        check(noisy.r_squared > 0.9 && noisy.r_squared < 1, "noise lowers r squared");
+
+        std::vector<sysid_sample> no_acceleration = make_samples(0);
+        for ( sysid_sample &sample : no_acceleration ) {
+            sample.acceleration = 0;
+        }
+        check(SystemId::fit(no_acceleration).samples == 0, "samples without acceleration can not be fit");
+        check(SystemId::fit({}).samples == 0, "no samples can not be fit");
+
+        sysid_sample sample = {1234, -5678.5, -123.25, 45.5};
+        sysid_sample parsed = {};
+        int found = SystemId::parse_sample(SystemId::format_sample(sample), parsed);
+        check(
+            found && parsed.time == sample.time && near(parsed.voltage, sample.voltage, 1e-3)
+            && near(parsed.velocity, sample.velocity, 1e-3) && near(parsed.acceleration, sample.acceleration, 1e-3),
+            "a formatted sample is parsed back"
+        );
+        check(!SystemId::parse_sample("[INFO], 0, motor added", parsed), "other log lines are not samples");
+    }
+
+
+    void run_tests() {
+        MotorThread *motor_thread = MotorThread::get_instance();
+        Motor motor(1, pros::E_MOTOR_GEARSET_18, false);
+        motor_thread->register_motor(motor);
+        motor_thread->start_thread();
+
+        motor.set_slew(50);
+        motor.enable_slew();
+        motor.set_motor_mode(e_custom_velocity_pid);
+        pros::delay(20);
+
+        sysid_params params;
+        params.ramp_voltage = 3000;
+        params.ramp_rate = 6000;
+        params.step_voltage = 3000;
+        params.step_duration = 300;
+        params.log_data = false;
+        params.save = false;
+        SystemId::get_instance()->run({&motor}, params);
+
+        check(motor.is_slew_enabled() && motor.get_slew_rate() == 50, "slew is enabled again after identification");
+        check(motor.get_motor_mode() == e_custom_velocity_pid, "mode is set back after identification");
+        check(motor.driver_control_allowed(), "driver control is allowed again after identification");
+
+        motor_thread->unregister_motor(motor);
+    }
+}
+
+
+
+int main() {
+    Logger::stop_queueing();
+    std::clog.setstate(std::ios::failbit);  // registration messages
+
+    fit_tests();
+    run_tests();
+
+    sim::shutdown();
+    finish_tests();
+}
@@ -0,0 +1,288 @@
+/**
+ * @file: ./RobotCode/sim/tests/telemetry_round_trip.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * drives the PTO chassis in the simulator with data logging on, then decodes
+ * the telemetry file the way PIDDebugging/telemetry_decoder.py does and
+ * checks that the chassis schemas and samples come back as they were pushed
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "main.h"
+#include "sim.hpp"
+#include "sim_test.hpp"
+
+#include "../../src/Configuration.hpp"
+#include "../../src/objects/motors/Motors.hpp"
+#include "../../src/objects/motors/MotorThread.hpp"
+#include "../../src/objects/position_tracking/PositionTracker.hpp"
+#include "../../src/objects/sensors/Sensors.hpp"
+#include "../../src/objects/serial/Logger.hpp"
+#include "../../src/objects/serial/Telemetry.hpp"
+#include "../../src/objects/subsystems/chassis.hpp"
+#include "../../src/objects/subsystems/pto_chassis.hpp"
+
+
+namespace
+{
+    const double drive_ratio = 3.0 / 5.0;   // motor to wheel
+    const double wheel_diameter = 3.25;     // in
+    const double track_width = WHEEL_TRACK_L + WHEEL_TRACK_R;  // in, between tracking wheels
+
+    double side_position(std::initializer_list<int> ports) {
+        double total = 0;
+        for(int port : ports) {
+            total += sim::motor_plant(port)->get_position();
+        }
+        return (total / ports.size()) * drive_ratio;  // degrees of the wheel
+    }
+
+    double left_position() {
+        return side_position({FL_MOTOR, ML_MOTOR, BL_MOTOR});
+    }
+
+    double right_position() {
+        return side_position({FR_MOTOR, MR_MOTOR, BR_MOTOR});
+    }
+
+    /**
+     * binds the tracking wheels and imu to the drive the same way robot_sim does
+     */
+    void bind_sensors() {
+        sim::set_adi_source(INTERNAL_ADI_PORT, LEFT_ENC_TOP_PORT, []() {
+            return -left_position();  // left encoder is mounted reversed
+        });
+        sim::set_adi_source(INTERNAL_ADI_PORT, RIGHT_ENC_TOP_PORT, []() {
+            return right_position();
+        });
+        sim::set_imu_source(IMU_PORT, []() {
+            double difference = ((left_position() - right_position()) / 360) * wheel_diameter * M_PI;
+            return (difference / track_width) * (180 / M_PI);
+        });
+
+        for(int port : {FL_MOTOR, ML_MOTOR, BL_MOTOR, FR_MOTOR, MR_MOTOR, BR_MOTOR}) {
+            sim::motor_plant(port)->set_load_torque(0.05);  // rolling resistance of the drive
+        }
+    }
+
+
+
+    /**
+     * crc-8 with polynomial 0x07 like the writer and the python decoder
+     */
+    std::uint8_t crc8(const std::uint8_t *data, int length) {
+        std::uint8_t crc = 0;
+        for ( int i = 0; i < length; i++ ) {
+            crc ^= data[i];
+            for ( int bit = 0; bit < 8; bit++ ) {
+                crc = (crc & 0x80) ? (std::uint8_t)((crc << 1) ^ 0x07) : (std::uint8_t)(crc << 1);
+            }
+        }
+        return crc;
+    }
+
+
+    typedef struct
+    {
+        std::string name;
+        int sample_size;
+        std::vector<int> types;
+        std::vector<std::string> fields;
+        std::vector<std::string> units;
+    } decoded_schema;
+
+
+    typedef struct
+    {
+        int channel;
+        std::uint32_t time;
+        std::uint32_t sequence;
+        std::vector<std::uint8_t> sample;
+    } decoded_sample;
+
+
+    typedef struct
+    {
+        std::map<int, decoded_schema> schemas;
+        std::vector<decoded_sample> samples;
+        int bad_frames;
+        int unknown_samples;  // samples that came before their channel's schema
+    } decoded_stream;
+
+
+    std::string take_string(const std::vector<std::uint8_t> &payload, std::size_t &position) {
+        std::string value;
+        while ( position < payload.size() && payload.at(position) != 0 ) {
+            value += (char)payload.at(position);
+            position += 1;
+        }
+        position += 1;
+        return value;
+    }
+
+
+    decoded_stream decode(const std::vector<std::uint8_t> &data) {
+        decoded_stream stream = {};
+        std::size_t position = 0;
+        while ( position + TELEMETRY_FRAME_OVERHEAD <= data.size() ) {
+            if ( data.at(position) != TELEMETRY_SYNC1 || data.at(position + 1) != TELEMETRY_SYNC2 ) {
+                position += 1;
+                continue;
+            }
+
+            int kind = data.at(position + 2);
+            int channel = data.at(position + 3);
+            int length = data.at(position + 4) | (data.at(position + 5) << 8);
+            std::size_t end = position + 6 + length + 1;
+            if ( end > data.size() || crc8(data.data() + position + 2, length + 4) != data.at(end - 1) ) {
+                stream.bad_frames += 1;
+                position += 1;
+                continue;
+            }
+
+            std::vector<std::uint8_t> payload(data.begin() + position + 6, data.begin() + position + 6 + length);
+            if ( kind == e_telemetry_schema_frame ) {
+                decoded_schema schema;
+                std::size_t at = 4;
+                schema.sample_size = payload.at(1) | (payload.at(2) << 8);
+                int num_fields = payload.at(3);
+                schema.name = take_string(payload, at);
+                for ( int i = 0; i < num_fields; i++ ) {
+                    schema.types.push_back(payload.at(at));
+                    at += 1;
+                    schema.fields.push_back(take_string(payload, at));
+                    schema.units.push_back(take_string(payload, at));
+                }
+                stream.schemas[channel] = schema;
+            } else if ( kind == e_telemetry_sample_frame ) {
+                if ( stream.schemas.count(channel) == 0 ) {
+                    stream.unknown_samples += 1;
+                } else {
+                    decoded_sample sample;
+                    sample.channel = channel;
+                    std::memcpy(&sample.time, payload.data(), 4);
+                    std::memcpy(&sample.sequence, payload.data() + 4, 4);
+                    sample.sample.assign(payload.begin() + TELEMETRY_STAMP_SIZE, payload.end());
+                    stream.samples.push_back(sample);
+                }
+            }
+            position = end;
+        }
+
+        return stream;
+    }
+}
+
+
+
+int main() {
+    Logger::stop_queueing();
+    std::clog.setstate(std::ios::failbit);  // registration messages
+
+    char path[] = "/tmp/telemetry_round_tripXXXXXX";
+    close(mkstemp(path));
+    Telemetry *telemetry = Telemetry::get_instance();
+    check(telemetry->open(path), "telemetry file is opened");
+    telemetry->start_flush_task();
+
+    bind_sensors();
+    Motors::register_motors();
+    MotorThread::get_instance()->start_thread();
+    Sensors::calibrate_imu();
+    PositionTracker::get_instance()->start_thread();
+
+    pros::ADIDigitalOut pto_piston('B');
+    PTOChassis chassis(Motors::front_left, Motors::front_right, Motors::back_left, Motors::back_right, Motors::mid_left, Motors::mid_right, pto_piston, Sensors::left_encoder, Sensors::right_encoder, 16, drive_ratio);
+    chassis.pid_straight_drive(600, 0, 300, 1500, false, true, 0.2, true);
+    Logger logger;
+    for ( int i = 0; i < 10; i++ ) {  // log entries are numbered on their own so they leave no gap in the samples
+        logger.add(e_log_source_other, e_log_clog, "[INFO], %u, between moves %d", (unsigned int)pros::millis(), i);
+    }
+    chassis.turn_right(45, 300, 1500, false, true);
+    telemetry->close();
+    check(telemetry->get_dropped() == 0, "no samples are dropped");
+
+    std::vector<std::uint8_t> data;
+    std::FILE *file = std::fopen(path, "rb");
+    if ( file != NULL ) {
+        std::uint8_t buffer[4096];
+        std::size_t length;
+        while ( (length = std::fread(buffer, 1, sizeof(buffer), file)) > 0 ) {
+            data.insert(data.end(), buffer, buffer + length);
+        }
+        std::fclose(file);
+    }
+    std::remove(path);
+
+    decoded_stream stream = decode(data);
+    check(stream.bad_frames == 0 && stream.unknown_samples == 0, "every frame passes its crc and follows its schema");
+
+    int pid_channel = chassis_pid_telemetry_channel();
+    int turn_channel = chassis_turn_telemetry_channel();
+    check(
+        stream.schemas.count(pid_channel) && stream.schemas[pid_channel].name == "chassis_pid"
+        && stream.schemas[pid_channel].sample_size == sizeof(chassis_pid_sample)
+        && stream.schemas[pid_channel].fields.size() == sizeof(chassis_pid_sample) / sizeof(float)
+        && stream.schemas[pid_channel].fields.front() == "position_sp" && stream.schemas[pid_channel].units.front() == "deg",
+        "chassis_pid schema is decoded"
+    );
+    check(
+        stream.schemas.count(turn_channel) && stream.schemas[turn_channel].name == "chassis_turn"
+        && stream.schemas[turn_channel].sample_size == sizeof(chassis_turn_sample)
+        && stream.schemas[turn_channel].types.at(9) == e_telemetry_int32,
+        "chassis_turn schema is decoded"
+    );
+
+    int pid_samples = 0;
+    int turn_samples = 0;
+    bool sizes_match = true;
+    bool in_order = true;
+    bool contiguous = true;
+    bool setpoints_match = true;
+    float last_position = 0;
+    float last_heading = 0;
+    std::uint32_t last_sequence = 0;
+    for ( const decoded_sample &sample : stream.samples ) {
+        in_order = in_order && (&sample == &stream.samples.front() || sample.sequence > last_sequence);
+        contiguous = contiguous && (&sample == &stream.samples.front() || sample.sequence == last_sequence + 1);
+        last_sequence = sample.sequence;
+        if ( sample.channel == pid_channel ) {
+            chassis_pid_sample pid;
+            sizes_match = sizes_match && sample.sample.size() == sizeof(pid);
+            std::memcpy(&pid, sample.sample.data(), std::min(sample.sample.size(), sizeof(pid)));
+            setpoints_match = setpoints_match && pid.position_sp == 600 && std::isfinite(pid.position_l);
+            last_position = (pid.position_l + pid.position_r) / 2;
+            pid_samples += 1;
+        } else if ( sample.channel == turn_channel ) {
+            chassis_turn_sample turn;
+            sizes_match = sizes_match && sample.sample.size() == sizeof(turn);
+            std::memcpy(&turn, sample.sample.data(), std::min(sample.sample.size(), sizeof(turn)));
+            setpoints_match = setpoints_match && turn.heading_sp == 45 && (turn.over_slew == 0 || turn.over_slew == 1);
+            last_heading = turn.relative_heading;
+            turn_samples += 1;
+        }
+    }
+
+    std::cout << "telemetry: " << data.size() << " bytes, " << pid_samples << " chassis_pid and " << turn_samples << " chassis_turn samples\n";
+    check(pid_samples > 10 && turn_samples > 10, "PTOChassis pushes samples from its drive and turn loops");
+    check(sizes_match && setpoints_match, "samples decode to the values that were pushed");
+    check(in_order, "samples are written in sequence order");
+    check(contiguous, "sample sequence numbers have no gaps from log entries");
+    check(std::abs(last_position - 600) < 60 && std::abs(last_heading - 45) < 5, "last samples are near the setpoints");
+
+    sim::shutdown();
+    finish_tests();
+}
@@ -0,0 +1,59 @@
+/**
+ * @file: ./RobotCode/sim/tools/motor_replay.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * replays a binary motor trace saved by MotorTrace::save() through
+ * Motor::get_target_voltage() and reports any tick that does not come out
+ * the same, optionally printing every tick as csv
+ *
+ * usage: motor_replay <trace file> [--csv]
+ */
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "main.h"
+
+#include "../../src/objects/motors/MotorTrace.hpp"
+
+
+int main(int argc, char **argv)
+{
+    if(argc < 2) {
+        std::cerr << "usage: motor_replay <trace file> [--csv]\n";
+        return 1;
+    }
+
+    std::vector<motor_trace_record> trace;
+    if(!MotorTrace::load(argv[1], trace)) {
+        std::cerr << "could not read a motor trace from " << argv[1] << "\n";
+        return 1;
+    }
+
+    if(argc > 2 && std::strcmp(argv[2], "--csv") == 0) {
+        std::cout << "sequence,time,port,mode,voltage_sp,velocity_sp,output,measured_velocity,actual_voltage,current,integral\n";
+        for(const motor_trace_record &record : trace) {
+            if(record.kind != e_trace_tick) {
+                continue;
+            }
+            std::cout << record.sequence << "," << record.time << "," << (int)record.port << "," << (int)record.tick.mode
+                      << "," << record.tick.voltage_setpoint << "," << record.tick.velocity_setpoint << "," << record.tick.output
+                      << "," << record.tick.measured_velocity << "," << record.tick.actual_voltage << "," << record.tick.current
+                      << "," << record.tick.integral << "\n";
+        }
+    }
+
+    motor_trace_replay result = MotorTrace::replay(trace);
+    std::cerr << "records: " << trace.size() << "\n";
+    std::cerr << "ticks: " << result.ticks << ", replayed: " << result.replayed << ", mismatches: " << result.mismatches << "\n";
+    if(result.mismatches > 0) {
+        std::cerr << "first mismatch at sequence " << result.first_mismatch << "\n";
+        return 1;
+    }
+
+    return 0;
+}
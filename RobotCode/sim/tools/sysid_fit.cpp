@@ -0,0 +1,59 @@
+/**
+ * @file: ./RobotCode/sim/tools/sysid_fit.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * refits a motor model from the samples SystemId logged on the robot, using
+ * the same fit as the robot so the results can be compared or redone after
+ * bad samples are removed from the log
+ *
+ * usage: sysid_fit [log file], reads stdin if no file is given
+ */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "main.h"
+
+#include "../../src/objects/motors/SystemId.hpp"
+
+
+int main(int argc, char **argv)
+{
+    std::ifstream file;
+    if(argc > 1) {
+        file.open(argv[1]);
+        if(!file.is_open()) {
+            std::cerr << "could not open " << argv[1] << "\n";
+            return 1;
+        }
+    }
+    std::istream &input = argc > 1 ? file : std::cin;
+
+    std::vector<sysid_sample> samples;
+    std::string line;
+    while(std::getline(input, line)) {
+        sysid_sample sample;
+        if(SystemId::parse_sample(line, sample)) {
+            samples.push_back(sample);
+        }
+    }
+
+    motor_model model = SystemId::fit(samples);
+    if(model.samples == 0) {
+        std::cerr << "could not fit a model to " << samples.size() << " samples\n";
+        return 1;
+    }
+
+    std::cout << "samples: " << model.samples << " of " << samples.size() << "\n";
+    std::cout << "kS: " << model.ff.kS << " mV\n";
+    std::cout << "kV: " << model.ff.kV << " mV/rpm\n";
+    std::cout << "kA: " << model.ff.kA << " mV/(rpm/s)\n";
+    std::cout << "time constant: " << model.time_constant << " s\n";
+    std::cout << "r squared: " << model.r_squared << "\n";
+
+    return 0;
+}
@@ -110,6 +110,18 @@ typedef struct
     };
 } pid;
 
+typedef struct
+{
+    double kS = 0;  // mv to overcome static friction, applied in the direction of motion
+    double kV = 0;  // mv per rpm
+    double kA = 0;  // mv per rpm/s
+    void print() {
+        std::cout << "kS: " << this->kS << "\n";
+        std::cout << "kV: " << this->kV << "\n";
+        std::cout << "kA: " << this->kA << "\n";
+    };
+} feedforward;
+
 
 class Configuration {
     public:
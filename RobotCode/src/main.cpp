@@ -15,6 +15,7 @@
 #include "objects/position_tracking/PositionTracker.hpp"
 #include "objects/serial/Logger.hpp"
 #include "objects/serial/Server.hpp"
+#include "objects/serial/Telemetry.hpp"
 #include "objects/subsystems/chassis.hpp"
 #include "objects/sensors/RGBLed.hpp"
 
@@ -29,6 +30,8 @@
  void initialize()
  {
     pros::c::serctl(SERCTL_ACTIVATE, 0);  // I think this enables stdin (necessary to start server)
+    Logger::start_drain_task();
+    Telemetry::get_instance()->start_flush_task();
 
     Motors::register_motors();
     MotorThread::get_instance()->start_thread();
@@ -93,6 +96,8 @@ void competition_initialize() {}
  * from where it left off.
  */
 void autonomous() {
+    Logger::rotate_file();  // every match starts a new file on the sd card
+
     Autons auton;
     auton.run_autonomous();
 }
@@ -183,6 +188,8 @@ void autonomous() {
  * task, not resume it from where it left off.
  */
 void opcontrol() {
+    Logger::open_file();  // keeps logging to the autonomous file if there is one
+
     Server server;
     server.clear_stdin();
     server.start_server();
@@ -20,12 +20,14 @@
 #include "../../../Configuration.hpp"
 #include "../../motors/Motor.hpp"
 #include "../../motors/MotorThread.hpp"
+#include "../../motors/SystemId.hpp"
 #include "../../serial/Logger.hpp"
 
 
 
 bool InternalMotorDebug::cont = true;
 bool InternalMotorDebug::run = false;
+bool InternalMotorDebug::run_sysid = false;
 pros::motor_gearset_e_t InternalMotorDebug::current_gearset = pros::E_MOTOR_GEARSET_18;
 pros::motor_brake_mode_e_t InternalMotorDebug::current_brake_mode = pros::E_MOTOR_BRAKE_COAST;
 
@@ -39,6 +41,7 @@ InternalMotorDebug::InternalMotorDebug() :
         
     cont = true;
     run = false; 
+    run_sysid = false;
     
 //screen
     main_screen = lv_obj_create(NULL, NULL);
@@ -251,6 +254,21 @@ InternalMotorDebug::InternalMotorDebug() :
     lv_label_set_text(btn_run_label, "Run Unit Test");
 
 
+//init system identification button
+    //button
+    btn_sysid = lv_btn_create(main_screen, NULL);
+    lv_btn_set_style(btn_sysid, LV_BTN_STYLE_REL, &toggle_btn_released);
+    lv_btn_set_style(btn_sysid, LV_BTN_STYLE_PR, &toggle_btn_pressed);
+    lv_btn_set_action(btn_sysid, LV_BTN_ACTION_CLICK, btn_sysid_action);
+    lv_obj_set_width(btn_sysid, 150);
+    lv_obj_set_height(btn_sysid, 25);
+
+    //label
+    btn_sysid_label = lv_label_create(btn_sysid, NULL);
+    lv_obj_set_style(btn_sysid_label, &heading_text);
+    lv_label_set_text(btn_sysid_label, "Identify");
+
+
 //set up keyboard
     keyboard = lv_kb_create(main_screen, NULL);
     // lv_kb_set_ta(keyboard, kp_text_area);
@@ -267,6 +285,7 @@ InternalMotorDebug::InternalMotorDebug() :
     
 //bottom buttons
     lv_obj_set_pos(btn_back, 30, 210);
+    lv_obj_set_pos(btn_sysid, 120, 210);
     lv_obj_set_pos(btn_run, 300, 210);
 
 //parameters side 1
@@ -327,6 +346,13 @@ lv_res_t InternalMotorDebug::btn_run_action(lv_obj_t *btn)
     return LV_RES_OK;
 }
 
+lv_res_t InternalMotorDebug::btn_sysid_action(lv_obj_t *btn)
+{
+    lv_btn_set_state(btn, LV_BTN_STATE_INA);
+    run_sysid = true;
+    return LV_RES_OK;
+}
+
 
 
 /**
@@ -547,21 +573,11 @@ int InternalMotorDebug::run_unit_test()
         info_str += "Error: " + std::to_string(setpoint - motor.get_actual_velocity());
         
         lv_label_set_text(information_label, info_str.c_str());
-        logger.dump();
         pros::delay(50);
     }
     
     motor.set_voltage(0);
-    pros::delay(2000);
-    logger.dump();
-    logger.dump();
-    logger.dump();
-    logger.dump();
-    logger.dump();
-    logger.dump();
-    logger.dump();
-    logger.dump();
-    logger.dump();
+    pros::delay(2000);  // the drain task writes what the test logged
     motor.set_log_level(0);
 
     return 1;
@@ -570,6 +586,75 @@ int InternalMotorDebug::run_unit_test()
 
 
 
+/**
+ * the test runs in its own task so the gui can be updated while waiting,
+ * the model is also saved to the sd card and logged by SystemId
+ */
+int InternalMotorDebug::run_system_id()
+{
+    Logger logger;
+    int motor_port = 0;
+
+    try
+    {
+        motor_port = std::stoi(lv_ta_get_text(port_text_area));
+    }
+    catch ( const std::invalid_argument& )
+    {
+        log_entry entry;
+        entry.content = "[ERROR] " + std::to_string(pros::millis()) + " invalid motor port given to system identification";
+        entry.stream = "cerr";
+        logger.add(entry);
+
+        return 0;
+    }
+
+    motor.set_port(motor_port);
+    motor.set_gearing(current_gearset);
+    motor.set_brake_mode(current_brake_mode);
+
+    MotorThread * motor_thread = MotorThread::get_instance();
+    motor_thread->start_thread();
+
+    SystemId *sysid = SystemId::get_instance();
+    if ( !sysid->start({&motor}) )
+    {
+        return 0;
+    }
+
+    pros::delay(50);  // let the test start before checking if it is running
+    while ( sysid->is_running() && cont )
+    {
+        std::string info_str;
+        info_str = "Identifying...\n";
+        info_str += "Voltage: " + std::to_string(motor.get_actual_voltage()) + "\n";
+        info_str += "Velocity: " + std::to_string(motor.get_estimated_velocity());
+
+        lv_label_set_text(information_label, info_str.c_str());
+        pros::delay(50);
+    }
+
+    if ( sysid->is_running() )  // user left the screen
+    {
+        sysid->stop();
+        return 0;
+    }
+
+    motor_model model = sysid->get_model();
+    std::string info_str;
+    info_str = "kS: " + std::to_string(model.ff.kS) + "\n";
+    info_str += "kV: " + std::to_string(model.ff.kV) + "\n";
+    info_str += "kA: " + std::to_string(model.ff.kA) + "\n";
+    info_str += "Tau: " + std::to_string(model.time_constant) + "\n";
+    info_str += "R^2: " + std::to_string(model.r_squared);
+    lv_label_set_text(information_label, info_str.c_str());
+
+    return model.samples > 0;
+}
+
+
+
+
 /**
  * waits for cont to be false which occurs when the user hits the back button
  */
@@ -578,26 +663,40 @@ void InternalMotorDebug::debug()
     std::string error_str = "-";
     cont = true;
     run = false; 
+    run_sysid = false;
     
 
     lv_scr_load(main_screen);
 
+    bool showing_model = false;  // the fitted model stays up until the next test
+
     while ( cont )
     {
         //update information label 
-        std::string info_str;
-        info_str = "Voltage: " + std::to_string(motor.get_actual_voltage()) + "\n";
-        info_str += "Velocity: " + std::to_string(motor.get_actual_velocity()) + "\n";
-        info_str += "Error: -";
-        lv_label_set_text(information_label, info_str.c_str());
+        if ( !showing_model )
+        {
+            std::string info_str;
+            info_str = "Voltage: " + std::to_string(motor.get_actual_voltage()) + "\n";
+            info_str += "Velocity: " + std::to_string(motor.get_actual_velocity()) + "\n";
+            info_str += "Error: -";
+            lv_label_set_text(information_label, info_str.c_str());
+        }
         
         if ( run )
         {
+            showing_model = false;
             run_unit_test();
             run = false;
             lv_btn_set_state(btn_run, LV_BTN_STYLE_REL);
 
         }
+
+        else if ( run_sysid )
+        {
+            showing_model = run_system_id();
+            run_sysid = false;
+            lv_btn_set_state(btn_sysid, LV_BTN_STYLE_REL);
+        }
         
         
         pros::delay(100);
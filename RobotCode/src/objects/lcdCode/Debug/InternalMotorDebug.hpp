@@ -16,6 +16,7 @@
 #include "../Styles.hpp"
 #include "../../../Configuration.hpp"
 #include "../../motors/Motor.hpp"
+#include "../../motors/SystemId.hpp"
 
 
 /**
@@ -29,6 +30,7 @@ class InternalMotorDebug : private Styles
     private:
         static bool cont;
         static bool run;
+        static bool run_sysid;
         
         Motor motor;
         
@@ -122,6 +124,18 @@ class InternalMotorDebug : private Styles
          */
         static lv_res_t btn_run_action(lv_obj_t *btn);
         
+    //system identification button
+        lv_obj_t *btn_sysid;
+        lv_obj_t *btn_sysid_label;
+
+        /**
+         * @param: lv_obj_t* btn -> button that called the funtion
+         * @return: lv_res_t -> LV_RES_OK on successfull completion because object still exists
+         *
+         * button to identify the motor on the given port and show its model
+         */
+        static lv_res_t btn_sysid_action(lv_obj_t *btn);
+
     //actual unit test function   
         /**
          * @return: int -> 1 if motor was successfully tested, 0 otherwise
@@ -130,6 +144,14 @@ class InternalMotorDebug : private Styles
          * given parameters
          */
         int run_unit_test( ); 
+
+        /**
+         * @return: int -> 1 if a model was fit, 0 otherwise
+         *
+         * runs system identification on the motor with the port, gearset,
+         * and brakemode from the screen and shows the fitted model
+         */
+        int run_system_id( );
         
 
     public:
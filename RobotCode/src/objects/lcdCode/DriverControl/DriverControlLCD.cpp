@@ -177,9 +177,16 @@ lv_res_t DriverControlLCD::btn_toggle_logging_action(lv_obj_t *btn)
 lv_res_t DriverControlLCD::btn_flush_queue_action(lv_obj_t *btn)
 {
     Logger logger;
-    while(logger.get_count() > 0)
+    //dump() writes nothing while the drain task is dumping or while the
+    //oldest entry is claimed but not published, the drain task gets to
+    //those so stop instead of waiting on it from the gui
+    for(int i = 0; i < (LOGGER_RECORDS / LOGGER_DUMP_ENTRIES) + 1 && logger.get_count() > 0; i++)
     {
-        logger.dump();
+        if(logger.dump() == 0)
+        {
+            break;
+        }
+        pros::delay(1);
     }
     return LV_RES_OK;
 }
@@ -0,0 +1,116 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/Mailbox.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains a sequence counter mailbox for handing a struct from the tasks that
+ * command a motor to the motor thread without either side spinning on a lock
+ */
+
+#ifndef __MAILBOX_HPP__
+#define __MAILBOX_HPP__
+
+#include <atomic>
+#include <cstdint>
+
+#include "main.h"
+
+
+/**
+ * single slot mailbox guarded by a sequence counter that is odd while a write
+ * is in progress
+ *
+ * the reader never waits, if it catches a write in progress try_read fails
+ * and the reader keeps what it had. A writer claims the slot by making the
+ * sequence odd, if another writer already has it (only possible if that writer
+ * was preempted in the middle of a copy) publish gives up the cpu instead of
+ * spinning so the other writer can finish
+ *
+ * T must be trivially copyable
+ */
+template <typename T>
+class Mailbox
+{
+    private:
+        std::atomic<std::uint32_t> sequence;
+        T contents;
+
+    public:
+        Mailbox() : sequence(0), contents() { }
+        Mailbox(const T &initial) : sequence(0), contents(initial) { }
+
+        /**
+         * @param: const T &new_contents -> the value to publish
+         * @return: bool -> true if it was published, false if another writer had the slot
+         */
+        bool try_publish(const T &new_contents) {
+            std::uint32_t start = sequence.load(std::memory_order_relaxed);
+            if ( (start & 1) || !sequence.compare_exchange_strong(start, start + 1, std::memory_order_acquire) ) {
+                return false;
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+
+            contents = new_contents;
+
+            sequence.store(start + 2, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @param: const T &new_contents -> the value to publish
+         * @return: None
+         *
+         * waits a ms at a time while another writer has the slot
+         */
+        void publish(const T &new_contents) {
+            while ( !try_publish(new_contents) ) {
+                pros::delay(1);
+            }
+        }
+
+        /**
+         * @param: T &value -> set to the contents if the read was consistent
+         * @return: bool -> false if a write was in progress, value is unchanged
+         */
+        bool try_read(T &value) const {
+            std::uint32_t start = sequence.load(std::memory_order_acquire);
+            if ( start & 1 ) {
+                return false;
+            }
+
+            T copy = contents;
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ( sequence.load(std::memory_order_relaxed) != start ) {
+                return false;
+            }
+
+            value = copy;
+            return true;
+        }
+
+        /**
+         * @return: T -> the contents
+         *
+         * waits a ms at a time while a write is in progress, used by callers
+         * other than the motor thread
+         */
+        T read() const {
+            T value;
+            while ( !try_read(value) ) {
+                pros::delay(1);
+            }
+            return value;
+        }
+
+        /**
+         * @return: std::uint32_t -> number of writes that have been published times 2
+         */
+        std::uint32_t get_sequence() const {
+            return sequence.load(std::memory_order_acquire);
+        }
+};
+
+
+#endif
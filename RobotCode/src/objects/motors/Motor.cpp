@@ -8,6 +8,7 @@
  * contains a implementation for wrapper class for a pros::Motor
  */
 
+#include <algorithm>
 #include <atomic>
 
 #include "main.h"
@@ -15,19 +16,22 @@
 #include "../../Configuration.hpp"
 #include "../serial/Logger.hpp"
 #include "Motor.hpp"
+#include "MotorThread.hpp"
+#include "MotorTrace.hpp"
 
 
 
 Motor::Motor( int port, pros::motor_gearset_e_t gearset, bool reversed )
 {
-    lock = ATOMIC_VAR_INIT(false);
     allow_driver_control = true;
-
-    while ( lock.exchange( true ) ); //aquire motor lock
+    tared_at = 0;
+    reconfiguring = false;
 
     motor_port = port;
 
     motor = new pros::Motor(port, gearset, reversed, pros::E_MOTOR_ENCODER_DEGREES);
+    max_velocity = get_max_velocity(gearset);
+    estimator_filter = e_kalman_filter;
 
     prev_velocity = 0;
 
@@ -35,10 +39,15 @@ Motor::Motor( int port, pros::motor_gearset_e_t gearset, bool reversed )
 
     slew_enabled = false;  // default slew rate to false
     slew_rate = 30;  //approx. 5% voltage per 20ms == 400ms to reach full voltage
+    mode = e_voltage;
 
     prev_voltage_setpoint = 0;
     voltage_setpoint = 0;
     velocity_setpoint = 0;
+    prev_velocity_setpoint = 0;
+    velocity_setpoint_changed_at = 0;
+    output_scale = 1;
+    setpoint_acceleration = 0;
 
     internal_motor_pid.kP = Configuration::internal_motor_pid.kP;
     internal_motor_pid.kI = Configuration::internal_motor_pid.kI;
@@ -47,20 +56,28 @@ Motor::Motor( int port, pros::motor_gearset_e_t gearset, bool reversed )
     integral = 0;
     prev_error = 0;
 
-    lock.exchange(false);
+    commanded_setpoints = 0;
+    commanded_mode = mode;
+    commanded_slew_enabled = slew_enabled;
+    commanded_slew_rate = slew_rate;
+    commanded_gains.publish(internal_motor_pid);
+
+    feedforward_consts.kV = 12000.0 / max_velocity;  // ideal motor until the motor is characterized
+    commanded_feedforward.publish(feedforward_consts);
 }
 
 
 Motor::Motor(int port, pros::motor_gearset_e_t gearset, bool reversed, pid pid_consts)
 {
-    lock = ATOMIC_VAR_INIT(false);
     allow_driver_control = true;
-
-    while ( lock.exchange( true ) ); //aquire motor lock
+    tared_at = 0;
+    reconfiguring = false;
 
     motor_port = port;
 
     motor = new pros::Motor(port, gearset, reversed, pros::E_MOTOR_ENCODER_DEGREES);
+    max_velocity = get_max_velocity(gearset);
+    estimator_filter = e_kalman_filter;
 
     prev_velocity = 0;
 
@@ -68,10 +85,15 @@ Motor::Motor(int port, pros::motor_gearset_e_t gearset, bool reversed, pid pid_c
 
     slew_enabled = false;
     slew_rate = 30;  //approx. 5% voltage per 20ms == 400ms to reach full voltage
+    mode = e_voltage;
 
     prev_voltage_setpoint = 0;
     voltage_setpoint = 0;
     velocity_setpoint = 0;
+    prev_velocity_setpoint = 0;
+    velocity_setpoint_changed_at = 0;
+    output_scale = 1;
+    setpoint_acceleration = 0;
 
     internal_motor_pid.kP = pid_consts.kP;
     internal_motor_pid.kI = pid_consts.kI;
@@ -80,75 +102,60 @@ Motor::Motor(int port, pros::motor_gearset_e_t gearset, bool reversed, pid pid_c
     integral = 0;
     prev_error = 0;
 
-    lock.exchange(false);
+    commanded_setpoints = 0;
+    commanded_mode = mode;
+    commanded_slew_enabled = slew_enabled;
+    commanded_slew_rate = slew_rate;
+    commanded_gains.publish(internal_motor_pid);
+
+    feedforward_consts.kV = 12000.0 / max_velocity;  // ideal motor until the motor is characterized
+    commanded_feedforward.publish(feedforward_consts);
 }
 
 
 Motor::~Motor( )
 {
-    delete motor;
+    delete motor.load();
 }
 
 
 
-int Motor::to_voltage(int velocity) {
-    pros::motor_gearset_e_t gearset = motor->get_gearing();
-
-    int prev_max;
-    int prev_min;
-
-    if ( gearset == pros::E_MOTOR_GEARSET_36 )  //100 RPM Motor
-    {
-        prev_max = 120;
-        prev_min = -120;
-    }
-    if ( gearset == pros::E_MOTOR_GEARSET_06 ) //600 RPM Motor
-    {
-        prev_max = 720;
-        prev_min = -720;
-    }
-    else //default to 200 RPM motor because that is most commonly used
+/**
+ * looks up the velocity range of the cartridge, this is only done when the
+ * gearing is set so that conversions do not have to ask the motor for it
+ */
+int Motor::get_max_velocity( pros::motor_gearset_e_t gearset )
+{
+    switch ( gearset )
     {
-        prev_max = 240;
-        prev_min = -240;
+        case pros::E_MOTOR_GEARSET_36:  //100 RPM Motor
+            return 120;
+        case pros::E_MOTOR_GEARSET_06:  //600 RPM Motor
+            return 720;
+        case pros::E_MOTOR_GEARSET_18:  //200 RPM Motor
+        default:  //default to 200 RPM motor because that is most commonly used
+            return 240;
     }
+}
 
-    int new_max = 12000;
-    int new_min = -12000;
 
-    int voltage = (((velocity - prev_min) * (new_max - new_min)) / (prev_max - prev_min)) + new_min;
+/**
+ * scales a velocity on [-max_velocity, max_velocity] to a voltage on [-12000, 12000]
+ */
+int Motor::to_voltage( int velocity, int max_velocity )
+{
+    int voltage = (((velocity + max_velocity) * 24000) / (2 * max_velocity)) - 12000;
 
     return voltage;
 }
 
 
-int Motor::to_velocity(int voltage) {
-    int prev_max = 12000;
-    int prev_min = -12000;
-
-    pros::motor_gearset_e_t gearset = motor->get_gearing();
-
-    int new_max;
-    int new_min;
-
-    if ( gearset == pros::E_MOTOR_GEARSET_36 )  //100 RPM Motor
-    {
-        new_max = 120;
-        new_min = -120;
-    }
-    if ( gearset == pros::E_MOTOR_GEARSET_06 ) //600 RPM Motor
-    {
-        new_max = 720;
-        new_min = -720;
-    }
-    else //default to 200 RPM motor because that is most commonly used
-    {
-        new_max = 240;
-        new_min = -240;
-    }
-
-    int velocity = (((voltage - prev_min) * (new_max - new_min)) / (prev_max - prev_min)) + new_min;
-
+/**
+ * scales a voltage on [-12000, 12000] to a velocity on [-max_velocity, max_velocity]
+ */
+int Motor::to_velocity( int voltage, int max_velocity )
+{
+    int velocity = (((voltage + 12000) * (2 * max_velocity)) / 24000) - max_velocity;
 
     return velocity;
 }
@@ -184,20 +191,20 @@ int Motor::calc_target_rate( int target, int previous, int delta_t)
  * returns the target voltage set to the motor after performing PID and slew rate
  * calculations on it
  */
-int Motor::get_target_voltage( int delta_t )
+int Motor::get_target_voltage( int delta_t, double measured_velocity, double actual_voltage )
 {
     double kP = internal_motor_pid.kP;
     double kI = internal_motor_pid.kI;
     double kD = internal_motor_pid.kD;
     double i_max = internal_motor_pid.i_max;
 
-    int voltage;
+    int voltage = 0;
     int calculated_target_voltage = voltage_setpoint;
 
     //velocity pid is enabled when the target voltage does not change
     if ( mode == e_custom_velocity_pid && voltage_setpoint == prev_voltage_setpoint )
     {
-        int error =  to_velocity(voltage_setpoint) - get_actual_velocity();
+        int error =  to_velocity(voltage_setpoint, max_velocity) - measured_velocity;
         if ( std::abs(integral) > i_max )
         {
             integral = 0;
@@ -212,9 +219,13 @@ int Motor::get_target_voltage( int delta_t )
 
         calculated_target_voltage = (kP * error) + (kI * integral) + (kD * derivative);
     }
+    else if ( mode == e_feedforward_velocity )
+    {
+        calculated_target_voltage = get_feedforward_voltage(measured_velocity);
+    }
 
     //ensure that voltage range is allowed by the slew rate set
-    int rate = calc_target_rate(calculated_target_voltage, get_actual_voltage(), delta_t);
+    int rate = calc_target_rate(calculated_target_voltage, actual_voltage, delta_t);
     if ( slew_enabled && std::abs(rate) > slew_rate )
     {
         int max_delta_v = slew_rate * delta_t;
@@ -224,7 +235,7 @@ int Motor::get_target_voltage( int delta_t )
             polarity = -1;               // in the correct direction so that the motor's velocity
         }                                // will increase in the correct direction
 
-        voltage = get_actual_voltage() + (polarity * max_delta_v);
+        voltage = actual_voltage + (polarity * max_delta_v);
     }
     else if ( voltage_setpoint == 0 )
     {
@@ -244,41 +255,158 @@ int Motor::get_target_voltage( int delta_t )
 
 
 
+/**
+ * feedforward from the model of the motor does most of the work so the
+ * velocity is reached without waiting for error to build up, the pid only
+ * corrects what the model gets wrong
+ */
+int Motor::get_feedforward_voltage( double measured_velocity )
+{
+    double velocity = velocity_setpoint;
+    int sign = (velocity > 0) - (velocity < 0);
+    double feedforward_voltage = (
+        (feedforward_consts.kS * sign)
+        + (feedforward_consts.kV * velocity)
+        + (feedforward_consts.kA * setpoint_acceleration)
+    );
+
+    double error = velocity - measured_velocity;
+    if ( std::abs(integral) > internal_motor_pid.i_max )
+    {
+        integral = 0;
+    }
+    else
+    {
+        integral = integral + error;
+    }
+    double derivative = error - prev_error;
+    prev_error = error;
+
+    double feedback_voltage = (
+        (internal_motor_pid.kP * error)
+        + (internal_motor_pid.kI * integral)
+        + (internal_motor_pid.kD * derivative)
+    );
+
+    return std::clamp((int)(feedforward_voltage + feedback_voltage), -12000, 12000);
+}
+
+
+
+
+/**
+ * copies the field from the motor thread's latest snapshot if it can be used
+ * in place of reading the device
+ */
+template <typename T>
+bool Motor::read_snapshot( T (motor_telemetry::*field)[NUM_MOTOR_PORTS], T &value, bool fresh_read, bool slow_field )
+{
+    if ( fresh_read || motor_port <= 0 || motor_port >= NUM_MOTOR_PORTS )
+    {
+        return false;
+    }
+
+    return MotorThread::read_telemetry(field, motor_port, slow_field, tared_at, value);
+}
+
+
+
+
 //accessor functions
 
 /**
  * returns velocity of motor
  */
-double Motor::get_actual_velocity( )
+double Motor::get_actual_velocity( bool fresh_read )
 {
-    return motor->get_actual_velocity();
+    double value;
+    if ( read_snapshot(&motor_telemetry::actual_velocity, value, fresh_read) )
+    {
+        return value;
+    }
+
+    return motor.load()->get_actual_velocity();
 }
 
 
 /**
  * returns voltage of motor
  */
-double Motor::get_actual_voltage( )
+double Motor::get_actual_voltage( bool fresh_read )
 {
-    return motor->get_voltage();
+    double value;
+    if ( read_snapshot(&motor_telemetry::actual_voltage, value, fresh_read) )
+    {
+        return value;
+    }
+
+    return motor.load()->get_voltage();
+}
+
+
+double Motor::get_estimated_velocity( )
+{
+    double value;
+    if ( read_snapshot(&motor_telemetry::estimated_velocity, value, false) )
+    {
+        return value;
+    }
+
+    return get_actual_velocity();
+}
+
+
+double Motor::get_estimated_acceleration( )
+{
+    double value;
+    if ( read_snapshot(&motor_telemetry::estimated_acceleration, value, false) )
+    {
+        return value;
+    }
+
+    return 0;
+}
+
+
+velocity_filter Motor::get_velocity_filter( )
+{
+    return estimator_filter;
+}
+
+
+std::uint32_t Motor::get_tared_at( )
+{
+    return tared_at;
 }
 
 
 /**
  * returns current drawn by motor in mA
  */
-int Motor::get_current_draw( )
+int Motor::get_current_draw( bool fresh_read )
 {
-    return motor->get_current_draw();
+    int value;
+    if ( read_snapshot(&motor_telemetry::current_draw, value, fresh_read) )
+    {
+        return value;
+    }
+
+    return motor.load()->get_current_draw();
 }
 
 
 /**
  * returns encoder position of motor in degrees
  */
-double Motor::get_encoder_position( )
+double Motor::get_encoder_position( bool fresh_read )
 {
-    return motor->get_position();
+    double value;
+    if ( read_snapshot(&motor_telemetry::encoder_position, value, fresh_read) )
+    {
+        return value;
+    }
+
+    return motor.load()->get_position();
 }
 
 
@@ -287,7 +415,7 @@ double Motor::get_encoder_position( )
  */
 pros::motor_gearset_e_t Motor::get_gearset( )
 {
-    return motor->get_gearing();
+    return motor.load()->get_gearing();
 }
 
 
@@ -296,7 +424,7 @@ pros::motor_gearset_e_t Motor::get_gearset( )
  */
 pros::motor_brake_mode_e_t Motor::get_brake_mode( )
 {
-    return motor->get_brake_mode();
+    return motor.load()->get_brake_mode();
 }
 
 
@@ -314,7 +442,16 @@ int Motor::get_port( )
  */
 pid Motor::get_pid( )
 {
-    return internal_motor_pid;
+    return commanded_gains.read();
+}
+
+
+/**
+ * returns feedforward constants used by motor
+ */
+feedforward Motor::get_feedforward( )
+{
+    return commanded_feedforward.read();
 }
 
 
@@ -323,52 +460,88 @@ pid Motor::get_pid( )
  */
 int Motor::get_slew_rate( )
 {
-    return slew_rate;
+    return commanded_slew_rate;
+}
+
+
+bool Motor::is_slew_enabled( )
+{
+    return commanded_slew_enabled;
 }
 
 
 /**
  * returns power of motor in watts
  */
-double Motor::get_power( )
+double Motor::get_power( bool fresh_read )
 {
-    return motor->get_power();
+    double value;
+    if ( read_snapshot(&motor_telemetry::power, value, fresh_read, true) )
+    {
+        return value;
+    }
+
+    return motor.load()->get_power();
 }
 
 
 /**
  * returns temperature of motor in degrees C
  */
-double Motor::get_temperature( )
+double Motor::get_temperature( bool fresh_read )
 {
-    return motor->get_temperature();
+    double value;
+    if ( read_snapshot(&motor_telemetry::temperature, value, fresh_read, true) )
+    {
+        return value;
+    }
+
+    return motor.load()->get_temperature();
 }
 
 
 /**
  * returns torque of motor in Nm
  */
-double Motor::get_torque( )
+double Motor::get_torque( bool fresh_read )
 {
-    return motor->get_torque();
+    double value;
+    if ( read_snapshot(&motor_telemetry::torque, value, fresh_read, true) )
+    {
+        return value;
+    }
+
+    return motor.load()->get_torque();
 }
 
 
 /**
  * returns direction motor is spinning
  */
-int Motor::get_direction( )
+int Motor::get_direction( bool fresh_read )
 {
-    return motor->get_direction();
+    int value;
+    if ( read_snapshot(&motor_telemetry::direction, value, fresh_read) )
+    {
+        return value;
+    }
+
+    return motor.load()->get_direction();
 }
 
 
 /**
  * returns efficiency of motor as a percent
  */
-int Motor::get_efficiency( )
+int Motor::get_efficiency( bool fresh_read )
 {
-    return motor->get_efficiency();
+    int value;
+    if ( read_snapshot(&motor_telemetry::efficiency, value, fresh_read, true) )
+    {
+        return value;
+    }
+
+    return motor.load()->get_efficiency();
 }
 
 
@@ -377,7 +550,7 @@ int Motor::get_efficiency( )
  */
 int Motor::is_stopped( )
 {
-    return motor->is_stopped();
+    return motor.load()->is_stopped();  // not in the snapshot because V5 motors do not report it yet
 }
 
 
@@ -386,7 +559,7 @@ int Motor::is_stopped( )
  */
 int Motor::is_reversed( )
 {
-    return motor->is_reversed();
+    return motor.load()->is_reversed();
 }
 
 
@@ -396,187 +569,169 @@ int Motor::is_reversed( )
 //setter functions
 
 /**
- * aquires lock and creates a new motor on a different port
- * exception safe to always release lock
+ * creates a new motor on a different port, the old one is deleted once the
+ * motor thread has finished the tick that could have been using it
  */
 int Motor::set_port( int port )
 {
-    pros::motor_gearset_e_t gearset = motor->get_gearing();
-    bool reversed = motor->is_reversed();
+    if ( reconfiguring.exchange( true ) )  // another task is already changing the port
+    {
+        Logger logger;
+        log_entry entry;
+        entry.content = "[WARNING], " + std::to_string(pros::millis()) + ", could not set port on motor port " + std::to_string(motor_port) + ", port is already being changed";
+        entry.stream = "cerr";
+        logger.add(entry, e_log_source_motor);
 
-    while ( lock.exchange( true ) );
+        return 0;
+    }
 
     try
     {
-        delete motor;
-        motor = new pros::Motor(port, gearset, reversed, pros::E_MOTOR_ENCODER_DEGREES);
+        pros::Motor *old_motor = motor.load();
+        pros::Motor *new_motor = new pros::Motor(port, old_motor->get_gearing(), old_motor->is_reversed(), pros::E_MOTOR_ENCODER_DEGREES);
+
+        motor.store(new_motor);
         motor_port = port;
+        MotorThread::wait_for_tick();
+        delete old_motor;
     }
-    catch(...) //ensure lock will be released
+    catch(...) //ensure flag will be cleared
     {
         Logger logger;
         log_entry entry;
         entry.content = "[ERROR], " + std::to_string(pros::millis()) + ", could not set port on motor port " + std::to_string(motor_port);
         entry.stream = "cerr";
-        logger.add(entry);
+        logger.add(entry, e_log_source_motor);
 
-        lock.exchange(false);
+        reconfiguring.exchange(false);
         return 0;
     }
 
-    lock.exchange(false);
+    reconfiguring.exchange(false);
     return 1;
 }
 
 
 /**
- * aquires lock and sets zero position of motor
- * exception safe to always release lock
+ * sets zero position of motor
  */
 int Motor::tare_encoder( )
 {
-    while ( lock.exchange( true ) );
-
     try
     {
-        motor->tare_position();
+        motor.load()->tare_position();
+        tared_at = pros::millis() + 1;  // a snapshot taken this ms could still be from before the tare
     }
-    catch(...) //ensure lock will be released
+    catch(...)
     {
         Logger logger;
         log_entry entry;
         entry.content = "[ERROR], " + std::to_string(pros::millis()) + ", could not tare encoder on motor port " + std::to_string(motor_port);
         entry.stream = "cerr";
-        logger.add(entry);
+        logger.add(entry, e_log_source_motor);
 
-        lock.exchange(false);
         return 0;
     }
 
-    lock.exchange(false);
-
     return 1;
 }
 
 
 /**
- * aquires lock and sets new brake mode for motor
- * exception safe to always release lock
+ * sets new brake mode for motor
  */
 int Motor::set_brake_mode( pros::motor_brake_mode_e_t brake_mode )
 {
-    while ( lock.exchange( true ) );
-
     try
     {
-        motor->set_brake_mode(brake_mode);
+        motor.load()->set_brake_mode(brake_mode);
     }
-    catch(...) //ensure lock will be released
+    catch(...)
     {
         Logger logger;
         log_entry entry;
         entry.content = "[ERROR], " + std::to_string(pros::millis()) + ", could not set brakemode on motor port " + std::to_string(motor_port);
         entry.stream = "cerr";
-        logger.add(entry);
+        logger.add(entry, e_log_source_motor);
 
-        lock.exchange(false);
         return 0;
     }
 
-    lock.exchange(false);
-
     return 1;
 }
 
 
 /**
- * aquires lock and sets new gearing for motor
- * exception safe to always release lock
+ * sets new gearing for motor
  */
 int Motor::set_gearing( pros::motor_gearset_e_t gearset )
 {
-    while ( lock.exchange( true ) );
-
     try
     {
-        motor->set_gearing(gearset);
+        motor.load()->set_gearing(gearset);
+        max_velocity = get_max_velocity(gearset);
     }
-    catch(...) //ensure lock will be released
+    catch(...)
     {
         Logger logger;
         log_entry entry;
         entry.content = "[ERROR], " + std::to_string(pros::millis()) + ", could not set gearing on motor port " + std::to_string(motor_port);
         entry.stream = "cerr";
-        logger.add(entry);
+        logger.add(entry, e_log_source_motor);
 
-        lock.exchange(false);
         return 0;
     }
 
-    lock.exchange(false);
-
     return 1;
 }
 
 
 /**
- * aquires lock and internally reverses motor
- * exception safe to always release lock
+ * internally reverses motor
  */
 int Motor::reverse_motor( )
 {
-    while ( lock.exchange( true ) );
-
     try
     {
-        motor->set_reversed(!motor->is_reversed());
+        motor.load()->set_reversed(!motor.load()->is_reversed());
     }
-    catch(...) //ensure lock will be released
+    catch(...)
     {
         Logger logger;
         log_entry entry;
         entry.content = "[ERROR], " + std::to_string(pros::millis()) + ", could not reverse motor on port " + std::to_string(motor_port);
         entry.stream = "cerr";
-        logger.add(entry);
+        logger.add(entry, e_log_source_motor);
 
-        lock.exchange(false);
         return 0;
     }
 
-    lock.exchange(false);
-
     return 1;
 }
 
 
 /**
- * aquires lock and sets new PID constants for the motor
- * exception safe to always release lock
+ * publishes new PID constants for the motor thread to pick up on its next tick
  */
 int Motor::set_pid( pid pid_consts )
 {
-    while ( lock.exchange( true ) );
+    pid new_gains = commanded_gains.read();
+    new_gains.kP = pid_consts.kP;
+    new_gains.kI = pid_consts.kI;
+    new_gains.kD = pid_consts.kD;
+    new_gains.i_max = pid_consts.i_max;
+    commanded_gains.publish(new_gains);
 
-    try
-    {
-        internal_motor_pid.kP = pid_consts.kP;
-        internal_motor_pid.kI = pid_consts.kI;
-        internal_motor_pid.kD = pid_consts.kD;
-        internal_motor_pid.i_max = pid_consts.i_max;
-    }
-    catch(...) //ensure lock will be released
-    {
-        Logger logger;
-        log_entry entry;
-        entry.content = "[ERROR], " + std::to_string(pros::millis()) + ", could not set motor pid on motor port " + std::to_string(motor_port);
-        entry.stream = "cerr";
-        logger.add(entry);
+    return 1;
+}
 
-        lock.exchange(false);
-        return 0;
-    }
 
-    lock.exchange(false);
+/**
+ * publishes new feedforward constants for the motor thread to pick up on its next tick
+ */
+int Motor::set_feedforward( feedforward feedforward_consts )
+{
+    commanded_feedforward.publish(feedforward_consts);
 
     return 1;
 }
@@ -602,6 +757,12 @@ void Motor::set_log_level( int logging )
 }
 
 
+void Motor::set_velocity_filter( velocity_filter new_filter )
+{
+    estimator_filter = new_filter;
+}
+
+
 
 
 //movement functions
@@ -617,8 +778,7 @@ int Motor::move( int voltage )
     int new_min = -12000;
 
     int scaled_voltage = (((voltage - prev_min) * (new_max - new_min)) / (prev_max - prev_min)) + new_min;
-    set_voltage_setpoint(scaled_voltage); //dont aquire lock because it will be acquired in this function
-    set_velocity_setpoint(to_velocity(scaled_voltage));
+    publish_setpoints(scaled_voltage, to_velocity(scaled_voltage, max_velocity));
 
     return 1;
 }
@@ -639,45 +799,83 @@ int Motor::user_move( int voltage ) {
  */
 int Motor::move_velocity( int velocity )
 {
-    set_velocity_setpoint(velocity);
-    set_voltage_setpoint(to_voltage(velocity));
+    publish_setpoints(to_voltage(velocity, max_velocity), velocity);
 
     return 1;
 }
 
 
 int Motor::set_voltage(int voltage) {
-    set_voltage_setpoint(voltage);
-    set_velocity_setpoint(to_velocity(voltage));
+    publish_setpoints(voltage, to_velocity(voltage, max_velocity));
 
     return 1;
 }
 
 
 /**
- * aquires lock and sets new voltage setpoint for the motor
- * exception safe to always release lock
+ * packs both setpoints into one word so they are published with a single store
  */
-int Motor::set_voltage_setpoint( int voltage )
+void Motor::publish_setpoints( int voltage, int velocity )
 {
-    while ( lock.exchange( true ) );
-    voltage_setpoint = voltage;
-    if ( voltage_setpoint != prev_voltage_setpoint )  //reset integral for new setpoint
-    {
-        integral = 0;
-    }
-    lock.exchange(false);
-
-    return 1;
+    std::uint64_t packed = ((std::uint64_t)(std::uint32_t)voltage << 32) | (std::uint32_t)velocity;
+    commanded_setpoints.store(packed);
 }
 
 
-int Motor::set_velocity_setpoint(int new_velocity) {
-    while ( lock.exchange( true ) );
-    velocity_setpoint = new_velocity;
-    lock.exchange(false);
+/**
+ * called by the motor thread at the start of each tick so that one tick
+ * uses a single consistent set of commands
+ */
+void Motor::take_commands( )
+{
+    std::uint64_t packed = commanded_setpoints.load();
+    voltage_setpoint = (std::int32_t)(std::uint32_t)(packed >> 32);
+    velocity_setpoint = (std::int32_t)(std::uint32_t)(packed & 0xFFFFFFFF);
+
+    motor_mode previous_mode = mode;
+    mode = commanded_mode;
+    slew_enabled = commanded_slew_enabled;
+    slew_rate = commanded_slew_rate;
+    commanded_gains.try_read(internal_motor_pid);  // keep last tick's gains if a write is in progress
+    commanded_feedforward.try_read(feedforward_consts);
+
+    //acceleration of the profile being followed from the change in velocity setpoint
+    //since it last changed, a change after a long hold is a step and has no acceleration
+    std::uint32_t now = pros::millis();
+    std::uint32_t since_change = now - velocity_setpoint_changed_at;
+    bool velocity_step = false;
+    if ( velocity_setpoint != prev_velocity_setpoint )
+    {
+        if ( since_change > 0 && since_change <= FEEDFORWARD_ACCEL_WINDOW )
+        {
+            setpoint_acceleration = (velocity_setpoint - prev_velocity_setpoint) * 1000.0 / since_change;
+        }
+        else
+        {
+            setpoint_acceleration = 0;
+            velocity_step = true;
+        }
+        prev_velocity_setpoint = velocity_setpoint;
+        velocity_setpoint_changed_at = now;
+    }
+    else if ( since_change > FEEDFORWARD_ACCEL_WINDOW )
+    {
+        setpoint_acceleration = 0;
+    }
 
-    return 1;
+    //reset integral for new setpoint, a profile changes the setpoint every tick
+    //in feedforward mode so there it is only reset for a step or a new mode
+    if ( mode == e_feedforward_velocity )
+    {
+        if ( mode != previous_mode || velocity_step )
+        {
+            integral = 0;
+        }
+    }
+    else if ( voltage_setpoint != prev_voltage_setpoint )
+    {
+        integral = 0;
+    }
 }
 
 
@@ -686,13 +884,17 @@ int Motor::set_velocity_setpoint(int new_velocity) {
 //velocity pid control functions
 
 /**
- * aquires lock and sets flag for using velocity PID
+ * sets the mode for the motor to follow starting next tick
  */
 void Motor::set_motor_mode(motor_mode new_mode)
 {
-    while ( lock.exchange( true ) );
-    mode = new_mode;
-    lock.exchange(false);
+    commanded_mode = new_mode;
+}
+
+
+motor_mode Motor::get_motor_mode( )
+{
+    return commanded_mode;
 }
 
 
@@ -700,37 +902,31 @@ void Motor::set_motor_mode(motor_mode new_mode)
 //slew control functions
 
 /**
- * aquires lock and sets new slew rate to be used in calculations
+ * sets new slew rate to be used in calculations
  */
 int Motor::set_slew( int rate )
 {
-    while ( lock.exchange( true ) );
-    slew_rate = rate;
-    lock.exchange(false);
+    commanded_slew_rate = rate;
 
     return 1;
 }
 
 
 /**
- * aquires lock and sets flag for using slew rate
+ * sets flag for using slew rate
  */
 void Motor::enable_slew( )
 {
-    while ( lock.exchange( true ) );
-    slew_enabled = true;
-    lock.exchange(false);
+    commanded_slew_enabled = true;
 }
 
 
 /**
- * aquires lock and clears flag for using slew rate
+ * clears flag for using slew rate
  */
 void Motor::disable_slew( )
 {
-    while ( lock.exchange( true ) );
-    slew_enabled = false;
-    lock.exchange(false);
+    commanded_slew_enabled = false;
 }
 
 
@@ -739,24 +935,20 @@ void Motor::disable_slew( )
 //driver control lock setting and clearing functions
 
 /**
- * aquires lock and sets flag for allowing driver control
+ * sets flag for allowing driver control
  */
 void Motor::enable_driver_control()
 {
-    while ( lock.exchange( true ) );
     allow_driver_control = true;
-    lock.exchange(false);
 }
 
 
 /**
- * aquires lock and clears flag for allowing driver control
+ * clears flag for allowing driver control
  */
 void Motor::disable_driver_control()
 {
-    while ( lock.exchange( true ) );
     allow_driver_control = false;
-    lock.exchange(false);
 }
 
 
@@ -778,6 +970,12 @@ int Motor::driver_control_allowed()
 
 
 
+void Motor::set_output_scale( double scale )
+{
+    output_scale = std::clamp(scale, 0.0, 1.0);
+}
+
+
 /**
  * gets the voltage to set the motor to based on pid and slew rate calculations
  * and internally sets motor voltage
@@ -786,144 +984,120 @@ int Motor::driver_control_allowed()
  */
 int Motor::run( int delta_t )
 {
+    take_commands();
+
+    MotorTrace *trace = MotorTrace::get_instance();
+    bool traced = trace->is_enabled(motor_port);
+    double measured_velocity = 0;
+    double actual_voltage = 0;
+    if ( traced || mode == e_custom_velocity_pid || mode == e_feedforward_velocity )
+    {
+        measured_velocity = get_estimated_velocity();
+        actual_voltage = get_actual_voltage();
+    }
+
+    motor_trace_tick tick;
+    if ( traced )  // state before this tick's calculation
+    {
+        tick.delta_t = delta_t;
+        tick.mode = mode;
+        tick.slew_enabled = slew_enabled;
+        tick.slew_rate = slew_rate;
+        tick.max_velocity = max_velocity;
+        tick.voltage_setpoint = voltage_setpoint;
+        tick.prev_voltage_setpoint = prev_voltage_setpoint;
+        tick.velocity_setpoint = velocity_setpoint;
+        tick.current = get_current_draw();
+        tick.integral = integral;
+        tick.prev_error = prev_error;
+        tick.setpoint_acceleration = setpoint_acceleration;
+        tick.measured_velocity = measured_velocity;
+        tick.actual_voltage = actual_voltage;
+        tick.output_scale = output_scale;
+    }
+
+    int output = 0;
     switch(mode) {
         case e_builtin_velocity_pid: {
-            motor->move_velocity(velocity_setpoint);
+            output = velocity_setpoint;
+            motor.load()->move_velocity(velocity_setpoint * output_scale);
             break;
         } case e_voltage: {
-            motor->move_voltage(voltage_setpoint);
+            output = voltage_setpoint;
+            motor.load()->move_voltage(voltage_setpoint * output_scale);
             break;
-        } case e_custom_velocity_pid: {
-            int voltage = get_target_voltage( delta_t );
-            motor->move_voltage(voltage);
+        } case e_custom_velocity_pid:
+          case e_feedforward_velocity: {
+            output = get_target_voltage( delta_t, measured_velocity, actual_voltage );
+            motor.load()->move_voltage(output * output_scale);
             break;
         }
     }
 
-
-
-    std::string log_msg;
-    switch ( log_level )
+    if ( traced )
     {
-        case 0:
-            log_msg = "";
-            break;
-
-        case 1:
-            log_msg = (
-                "[INFO]," + std::string(" Motor ") + std::to_string(motor_port)
-                + ", Actual_Vol: " + std::to_string(get_actual_voltage())
-                + ", Brake: " + std::to_string(get_brake_mode())
-                + ", Gear: " + std::to_string(get_gearset())
-                + ", i_max: " + std::to_string(internal_motor_pid.i_max)
-                + ", I: " + std::to_string(integral)
-                + ", kD: " + std::to_string(internal_motor_pid.kD)
-                + ", kI: " + std::to_string(internal_motor_pid.kI)
-                + ", kP: " + std::to_string(internal_motor_pid.kP)
-                + ", Slew: " + std::to_string(get_slew_rate())
-                + ", Time: " + std::to_string(pros::millis())
-                + ", Vel_Sp: " + std::to_string(to_velocity(voltage_setpoint))
-                + ", Vel: " + std::to_string(get_actual_velocity())
-            );
-            break;
-
-        case 2:
-            log_msg = (
-                "[INFO]," + std::string(" Motor ") + std::to_string(motor_port)
-                + ", Actual_Vol: " + std::to_string(get_actual_voltage())
-                + ", Brake: " + std::to_string(get_brake_mode())
-                // + ", Calc_Target_Vol: " + std::to_string(voltage)
-                + ", Gear: " + std::to_string(get_gearset())
-                + ", i_max: " + std::to_string(internal_motor_pid.i_max)
-                + ", I: " + std::to_string(integral)
-                + ", kD: " + std::to_string(internal_motor_pid.kD)
-                + ", kI: " + std::to_string(internal_motor_pid.kI)
-                + ", kP: " + std::to_string(internal_motor_pid.kP)
-                + ", Slew: " + std::to_string(get_slew_rate())
-                + ", Target_Vol: " + std::to_string(voltage_setpoint)
-                + ", Time: " + std::to_string(pros::millis())
-                + ", Vel_Sp: " + std::to_string(to_velocity(voltage_setpoint))
-                + ", Vel: " + std::to_string(get_actual_velocity())
-            );
-            break;
-
-        case 3:
-            log_msg = (
-                "[INFO]," + std::string(" Motor ") + std::to_string(motor_port)
-                + ", Actual_Vol: " + std::to_string(get_actual_voltage())
-                + ", Brake: " + std::to_string(get_brake_mode())
-                // + ", Calc_Target_Vol: " + std::to_string(voltage)
-                + ", Gear: " + std::to_string(get_gearset())
-                + ", i_max: " + std::to_string(internal_motor_pid.i_max)
-                + ", I: " + std::to_string(integral)
-                + ", IME: " + std::to_string(get_encoder_position())
-                + ", kD: " + std::to_string(internal_motor_pid.kD)
-                + ", kI: " + std::to_string(internal_motor_pid.kI)
-                + ", kP: " + std::to_string(internal_motor_pid.kP)
-                + ", Slew: " + std::to_string(get_slew_rate())
-                + ", Target_Vol: " + std::to_string(voltage_setpoint)
-                + ", Time: " + std::to_string(pros::millis())
-                + ", Vel_Sp: " + std::to_string(to_velocity(voltage_setpoint))
-                + ", Vel: " + std::to_string(get_actual_velocity())
-            );
-            break;
-
-        case 4:
-            log_msg = (
-                "[INFO]," + std::string(" Motor ") + std::to_string(motor_port)
-                + ", Actual_Vol: " + std::to_string(get_actual_voltage())
-                + ", Brake: " + std::to_string(get_brake_mode())
-                // + ", Calc_Target_Vol: " + std::to_string(voltage)
-                + ", Dir: " + std::to_string(get_direction())
-                + ", Gear: " + std::to_string(get_gearset())
-                + ", i_max: " + std::to_string(internal_motor_pid.i_max)
-                + ", I: " + std::to_string(integral)
-                + ", IME: " + std::to_string(get_encoder_position())
-                + ", kD: " + std::to_string(internal_motor_pid.kD)
-                + ", kI: " + std::to_string(internal_motor_pid.kI)
-                + ", kP: " + std::to_string(internal_motor_pid.kP)
-                + ", Reversed: " + std::to_string(is_reversed())
-                + ", Slew: " + std::to_string(get_slew_rate())
-                + ", Target_Vol: " + std::to_string(voltage_setpoint)
-                + ", Time: " + std::to_string(pros::millis())
-                + ", Vel_Sp: " + std::to_string(to_velocity(voltage_setpoint))
-                + ", Vel: " + std::to_string(get_actual_velocity())
-            );
-            break;
+        tick.output = output;
+        motor_trace_gains gains = {
+            internal_motor_pid.kP, internal_motor_pid.kI, internal_motor_pid.kD, internal_motor_pid.i_max,
+            feedforward_consts.kS, feedforward_consts.kV, feedforward_consts.kA
+        };
+        trace->record(motor_port, tick, gains);
+    }
 
-        case 5:
-            log_msg = (
-                "[INFO]," + std::string(" Motor ") + std::to_string(motor_port)
-                + ", Actual_Vol: " + std::to_string(get_actual_voltage())
-                + ", Brake: " + std::to_string(get_brake_mode())
-                // + ", Calc_Target_Vol: " + std::to_string(voltage)
-                + ", Current: " + std::to_string(get_current_draw())
-                + ", Dir: " + std::to_string(get_direction())
-                + ", Gear: " + std::to_string(get_gearset())
-                + ", i_max: " + std::to_string(internal_motor_pid.i_max)
-                + ", I: " + std::to_string(integral)
-                + ", IME: " + std::to_string(get_encoder_position())
-                + ", kD: " + std::to_string(internal_motor_pid.kD)
-                + ", kI: " + std::to_string(internal_motor_pid.kI)
-                + ", kP: " + std::to_string(internal_motor_pid.kP)
-                + ", Reversed: " + std::to_string(is_reversed())
-                + ", Slew: " + std::to_string(get_slew_rate())
-                + ", Target_Vol: " + std::to_string(voltage_setpoint)
-                + ", Temp: " + std::to_string(get_temperature())
-                + ", Time: " + std::to_string(pros::millis())
-                + ", Torque: " + std::to_string(get_torque())
-                + ", Vel_Sp: " + std::to_string(to_velocity(voltage_setpoint))
-                + ", Vel: " + std::to_string(get_actual_velocity())
-            );
-            break;
 
-    }
 
-    Logger logger;
-    log_entry entry;
-    entry.content = log_msg;
-    entry.stream = "clog";
-    logger.add(entry);
+    // one entry per tick with more fields at higher levels, levels above LOG_LEVEL_MAX are not compiled in
+    LOG_IF(
+        1, log_level == 1,
+        e_log_source_motor, e_log_clog,
+        "[INFO], Motor %d, Actual_Vol: %f, Brake: %d, Gear: %d, i_max: %f, I: %f, kD: %f, kI: %f, kP: %f"
+        ", Slew: %d, Time: %u, Vel_Sp: %d, Vel: %f",
+        motor_port, get_actual_voltage(), get_brake_mode(), get_gearset(), internal_motor_pid.i_max, integral,
+        internal_motor_pid.kD, internal_motor_pid.kI, internal_motor_pid.kP,
+        get_slew_rate(), (unsigned int)pros::millis(), to_velocity(voltage_setpoint, max_velocity), get_actual_velocity()
+    );
+    LOG_IF(
+        2, log_level == 2,
+        e_log_source_motor, e_log_clog,
+        "[INFO], Motor %d, Actual_Vol: %f, Brake: %d, Gear: %d, i_max: %f, I: %f, kD: %f, kI: %f, kP: %f"
+        ", Slew: %d, Target_Vol: %d, Time: %u, Vel_Sp: %d, Vel: %f",
+        motor_port, get_actual_voltage(), get_brake_mode(), get_gearset(), internal_motor_pid.i_max, integral,
+        internal_motor_pid.kD, internal_motor_pid.kI, internal_motor_pid.kP,
+        get_slew_rate(), voltage_setpoint, (unsigned int)pros::millis(), to_velocity(voltage_setpoint, max_velocity),
+        get_actual_velocity()
+    );
+    LOG_IF(
+        3, log_level == 3,
+        e_log_source_motor, e_log_clog,
+        "[INFO], Motor %d, Actual_Vol: %f, Brake: %d, Gear: %d, i_max: %f, I: %f, IME: %f, kD: %f, kI: %f, kP: %f"
+        ", Slew: %d, Target_Vol: %d, Time: %u, Vel_Sp: %d, Vel: %f",
+        motor_port, get_actual_voltage(), get_brake_mode(), get_gearset(), internal_motor_pid.i_max, integral,
+        get_encoder_position(), internal_motor_pid.kD, internal_motor_pid.kI, internal_motor_pid.kP,
+        get_slew_rate(), voltage_setpoint, (unsigned int)pros::millis(), to_velocity(voltage_setpoint, max_velocity),
+        get_actual_velocity()
+    );
+    LOG_IF(
+        4, log_level == 4,
+        e_log_source_motor, e_log_clog,
+        "[INFO], Motor %d, Actual_Vol: %f, Brake: %d, Dir: %d, Gear: %d, i_max: %f, I: %f, IME: %f, kD: %f, kI: %f"
+        ", kP: %f, Reversed: %d, Slew: %d, Target_Vol: %d, Time: %u, Vel_Sp: %d, Vel: %f",
+        motor_port, get_actual_voltage(), get_brake_mode(), get_direction(), get_gearset(), internal_motor_pid.i_max,
+        integral, get_encoder_position(), internal_motor_pid.kD, internal_motor_pid.kI,
+        internal_motor_pid.kP, is_reversed(), get_slew_rate(), voltage_setpoint, (unsigned int)pros::millis(),
+        to_velocity(voltage_setpoint, max_velocity), get_actual_velocity()
+    );
+    LOG_IF(
+        5, log_level == 5,
+        e_log_source_motor, e_log_clog,
+        "[INFO], Motor %d, Actual_Vol: %f, Brake: %d, Current: %d, Dir: %d, Gear: %d, i_max: %f, I: %f, IME: %f"
+        ", kD: %f, kI: %f, kP: %f, Reversed: %d, Slew: %d, Target_Vol: %d, Temp: %f, Time: %u, Torque: %f"
+        ", Vel_Sp: %d, Vel: %f",
+        motor_port, get_actual_voltage(), get_brake_mode(), get_current_draw(), get_direction(), get_gearset(),
+        internal_motor_pid.i_max, integral, get_encoder_position(),
+        internal_motor_pid.kD, internal_motor_pid.kI, internal_motor_pid.kP, is_reversed(), get_slew_rate(),
+        voltage_setpoint, get_temperature(), (unsigned int)pros::millis(), get_torque(),
+        to_velocity(voltage_setpoint, max_velocity), get_actual_velocity()
+    );
 
     return 1;
 }
@@ -12,16 +12,24 @@
 #define __MOTOR_HPP__
 
 #include <atomic>
+#include <cstdint>
 
 #include "main.h"
 
 #include "../../Configuration.hpp"
+#include "Mailbox.hpp"
+#include "MotorTelemetry.hpp"
+#include "VelocityEstimator.hpp"
+
+
+#define FEEDFORWARD_ACCEL_WINDOW 50  // ms, velocity setpoints further apart than this are steps, not a profile
 
 
 typedef enum {
     e_builtin_velocity_pid,
     e_voltage,
-    e_custom_velocity_pid
+    e_custom_velocity_pid,
+    e_feedforward_velocity
 } motor_mode;
 
 /**
@@ -38,40 +46,59 @@ class Motor
     private:
         int motor_port;
         
-        pros::Motor *motor;
+        std::atomic<pros::Motor*> motor;  // swapped by set_port while the motor thread is running
+        std::atomic<bool> reconfiguring;
+        std::atomic<int> max_velocity;  // velocity range of the cartridge, looked up when the gearing is set
+        std::atomic<velocity_filter> estimator_filter;
 
         int log_level;
-        
+
+        // commanded state, written by any task without waiting and taken by
+        // the motor thread at the start of each run()
+        std::atomic<std::uint64_t> commanded_setpoints;  // voltage in the upper 32 bits, velocity in the lower
+        std::atomic<motor_mode> commanded_mode;
+        std::atomic<bool> commanded_slew_enabled;
+        std::atomic<int> commanded_slew_rate;
+        Mailbox<pid> commanded_gains;
+        Mailbox<feedforward> commanded_feedforward;
+
+        // copies of the commanded state only used by the motor thread
         bool slew_enabled;
         int slew_rate;
         
-        bool velocity_pid_enabled;
         int prev_velocity;
         pid internal_motor_pid;
+        feedforward feedforward_consts;
         double integral;
         double prev_error;
         
-        motor_mode mode = e_voltage;
+        motor_mode mode;
         int voltage_setpoint;
         int prev_voltage_setpoint;
         int velocity_setpoint;
+        int prev_velocity_setpoint;
+        std::uint32_t velocity_setpoint_changed_at;
+        double setpoint_acceleration;  // rpm/s, estimated from how fast the velocity setpoint is changing
+        double output_scale;  // set by the power budget, only used by the motor thread
         
         
-        int to_voltage(int velocity);
-        int to_velocity(int voltage);
-        
         /**
-         * @param: int voltage -> the voltage to set the motor to
-         * @return: int -> if setting motor voltage was successful or not
-         *
-         * @see: pros::Motor
+         * @param: int voltage -> the voltage setpoint on interval [-12000,12000]
+         * @param: int velocity -> the velocity setpoint
+         * @return: None
          *
-         * sets voltage of motor on interval [-12000,12000]
+         * publishes both setpoints in one store so the motor thread never
+         * sees a voltage from one command and a velocity from another
          */       
-        int set_voltage_setpoint( int voltage );
-    
-    
-        int set_velocity_setpoint(int new_velocity);
+        void publish_setpoints( int voltage, int velocity );
+
+        /**
+         * @return: None
+         *
+         * copies the commanded state into the motor thread's working copies
+         * gains are left as they were if a write was in progress
+         */
+        void take_commands( );
         
         
         /**
@@ -101,6 +128,9 @@ class Motor
         int calc_target_velocity( int voltage );
         
         /**
+         * @param: int delta_t -> ms since the last run
+         * @param: double measured_velocity -> estimated velocity of the motor
+         * @param: double actual_voltage -> voltage the motor is at
          * @return: int -> the voltage that the motor will be set at
          *
          * @see: slew rate functions contained in this class
@@ -109,32 +139,124 @@ class Motor
          * but that is either increased or decreased by the velocity pid if that
          * is enabled, or the slew rate code which limits the rate that the 
          * voltage can increase
+         * measurements are passed in so that a trace can be replayed through it
+         */
+        int get_target_voltage( int delta_t, double measured_velocity, double actual_voltage );
+
+        /**
+         * @param: double measured_velocity -> estimated velocity of the motor
+         * @return: int -> the voltage for the velocity setpoint on interval [-12000,12000]
+         *
+         * @see: set_feedforward()
+         *
+         * sums the feedforward terms kS*sign(v) + kV*v + kA*a for the velocity
+         * setpoint and its acceleration, then adds a pid correction on the
+         * velocity error using the internal motor pid constants
          */
-        int get_target_voltage( int delta_t );
+        int get_feedforward_voltage( double measured_velocity );
+
+        friend class MotorTrace;  // replays traces through get_target_voltage()
         
 
-        std::atomic<bool> lock;  //protect motor functions from concurrent access
-        bool allow_driver_control;
+        std::atomic<bool> allow_driver_control;
+
+        std::uint32_t tared_at;  // snapshots from before this time have the old encoder zero
+
+        /**
+         * @param: T (motor_telemetry::*field)[NUM_MOTOR_PORTS] -> field to read, ie. &motor_telemetry::actual_velocity
+         * @param: T &value -> set to the field for this motor's port
+         * @param: bool fresh_read -> skip the snapshot
+         * @param: bool slow_field -> the field is one that is sampled less often
+         * @return: bool -> true if value was set, false if the device should be read
+         *
+         * @see: MotorThread::read_telemetry()
+         *
+         * the snapshot is not used if it is stale, does not have this port,
+         * or was taken before the encoder was tared
+         */
+        template <typename T>
+        bool read_snapshot( T (motor_telemetry::*field)[NUM_MOTOR_PORTS], T &value, bool fresh_read, bool slow_field=false );
         
 
     public:
         Motor(int port, pros::motor_gearset_e_t gearset, bool reversed);
         Motor(int port, pros::motor_gearset_e_t gearset, bool reversed, pid pid_consts);
         ~Motor();
-    
+
+    //gearset conversions
+
+        /**
+         * @param: pros::motor_gearset_e_t gearset -> the cartridge in the motor
+         * @return: int -> the velocity the motor reaches when supplied 12V
+         *
+         * velocity ranges are ~20% higher than what they are rated for
+         * because motors can achieve this velocity when supplied 12V
+         * unknown gearsets get the 200 RPM range
+         */
+        static int get_max_velocity( pros::motor_gearset_e_t gearset );
+
+        /**
+         * @param: int velocity -> a velocity on [-max_velocity, max_velocity]
+         * @param: int max_velocity -> the velocity range of the cartridge
+         * @return: int -> the corresponding voltage in mv on interval [-12000,12000]
+         *
+         * @see: get_max_velocity()
+         */
+        static int to_voltage( int velocity, int max_velocity );
+
+        /**
+         * @param: int voltage -> a voltage in mv on interval [-12000,12000]
+         * @param: int max_velocity -> the velocity range of the cartridge
+         * @return: int -> the corresponding velocity on [-max_velocity, max_velocity]
+         *
+         * @see: get_max_velocity()
+         */
+        static int to_velocity( int voltage, int max_velocity );
+
     //accessor functions
     
         /**
+         * @param: bool fresh_read -> read the device instead of the latest snapshot
          * @return: double -> the actual velocity of the motor
          *
          * @see: pros::Motor
          *
          * returns the actual velocity of the motor as calculated internally by
          * the pros::Motor
+         * accessors that read the device return the value from the motor
+         * thread's last snapshot unless fresh_read is set
+         */
+        double get_actual_velocity( bool fresh_read=false );
+
+        /**
+         * @return: double -> the velocity of the motor in rpm estimated from the encoder
+         *
+         * @see: VelocityEstimator
+         *
+         * responds faster than get_actual_velocity(), falls back to it if the
+         * motor thread does not have a recent snapshot
          */
-        double get_actual_velocity( );
+        double get_estimated_velocity( );
+
+        /**
+         * @return: double -> the acceleration of the motor in rpm/s estimated from the encoder
+         *
+         * 0 if the motor thread does not have a recent snapshot
+         */
+        double get_estimated_acceleration( );
+
+        /**
+         * @return: velocity_filter -> the filter used to estimate velocity
+         */
+        velocity_filter get_velocity_filter( );
+
+        /**
+         * @return: std::uint32_t -> when the encoder was last tared, 0 if it has not been
+         */
+        std::uint32_t get_tared_at( );
         
         /**
+         * @param: bool fresh_read -> read the device instead of the latest snapshot
          * @return: double -> the actual voltage of the motor
          *
          * @see: pros::Motor
@@ -142,9 +264,10 @@ class Motor
          * returns the actual voltage of the motor as calculated internally by
          * the pros::Motor
          */
-        double get_actual_voltage( );
+        double get_actual_voltage( bool fresh_read=false );
         
         /**
+         * @param: bool fresh_read -> read the device instead of the latest snapshot
          * @return: int -> the actual current being supplied to the motor
          *
          * @see: pros::Motor
@@ -152,9 +275,10 @@ class Motor
          * returns the actual current being supplied to the motor as calculated internally by
          * the pros::Motor
          */
-        int get_current_draw( );
+        int get_current_draw( bool fresh_read=false );
         
         /**
+         * @param: bool fresh_read -> read the device instead of the latest snapshot
          * @return: double -> the encoder value of the motor
          *
          * @see: pros::Motor
@@ -162,7 +286,7 @@ class Motor
          * returns the encoder position of the motor in degrees as calculated internally by
          * the pros::Motor
          */
-        double get_encoder_position( );
+        double get_encoder_position( bool fresh_read=false );
         
         /**
          * @return: pros::motor_gearset_e_t -> the gearing of the motor
@@ -195,6 +319,13 @@ class Motor
          * returns the pid constants in use by the motor
          */
         pid get_pid( );
+
+        /**
+         * @return: feedforward -> struct of feedforward constants
+         *
+         * returns the feedforward constants used in e_feedforward_velocity mode
+         */
+        feedforward get_feedforward( );
         
         /**
          * @return: int -> the slew rate in use by the motor
@@ -202,35 +333,44 @@ class Motor
          * returns the slew rate in mV/ms in use by the motor
          */
         int get_slew_rate( );
+
+        /**
+         * @return: bool -> true if the slew rate limits voltage changes
+         */
+        bool is_slew_enabled( );
         
         /**
+         * @param: bool fresh_read -> read the device instead of the latest snapshot
          * @return: double -> the power drawn by the motor
          *
          * @see: pros::Motor
          *
          * returns the power that the motor is drawing in Watts
          */
-        double get_power( );
+        double get_power( bool fresh_read=false );
         
         /**
+         * @param: bool fresh_read -> read the device instead of the latest snapshot
          * @return: double -> the temperature of the motor
          *
          * @see: pros::Motor
          *
          * returns the temperature of the motor in degrees C
          */
-        double get_temperature( );
+        double get_temperature( bool fresh_read=false );
         
         /**
+         * @param: bool fresh_read -> read the device instead of the latest snapshot
          * @return: double -> the torque output of the motor
          *
          * @see: pros::Motor
          *
          * returns the torque output of the motor in Nm
          */
-        double get_torque( );
+        double get_torque( bool fresh_read=false );
         
         /**
+         * @param: bool fresh_read -> read the device instead of the latest snapshot
          * @return: int -> the direction the motor is spinning
          *
          * @see: pros::Motor
@@ -239,16 +379,17 @@ class Motor
          * 1 for moving in the positive direction
          * -1 for moving in the negative direction
          */    
-        int get_direction( );
+        int get_direction( bool fresh_read=false );
         
         /**
+         * @param: bool fresh_read -> read the device instead of the latest snapshot
          * @return: int -> the efficiency of the motor
          *
          * @see: pros::Motor
          *
          * returns the efficiency of the motor as a percentage
          */
-        int get_efficiency( );
+        int get_efficiency( bool fresh_read=false );
         
         /**
          * @return: int -> if the motor is a rest
@@ -329,6 +470,18 @@ class Motor
          * returns 1 on success
          */
         int set_pid( pid pid_consts );
+
+        /**
+         * @param: feedforward feedforward_consts -> the new feedforward constants for the motor
+         * @return: int -> if the change was successful or not
+         *
+         * @see: e_feedforward_velocity
+         *
+         * kS is in mv, kV is in mv per rpm, and kA is in mv per rpm/s
+         * defaults to kV of 12000 / the velocity range of the cartridge
+         * returns 1 on success
+         */
+        int set_feedforward( feedforward feedforward_consts );
         
         /**
          * @param: int logging -> the new log level, 0-5, 5 is most verbose
@@ -337,9 +490,19 @@ class Motor
          * @see: pros::Motor
          *
          * updates how verbose the logging is, 0 is no logging, 5 is very
-         * verbose
+         * verbose, levels above LOG_LEVEL_MAX are not compiled in and log nothing
          */
         void set_log_level( int logging );
+
+        /**
+         * @param: velocity_filter new_filter -> the filter used to estimate velocity
+         * @return: None
+         *
+         * @see: VelocityEstimator
+         *
+         * the estimate restarts from zero when the filter changes
+         */
+        void set_velocity_filter( velocity_filter new_filter );
         
 
 
@@ -432,6 +595,11 @@ class Motor
          */      
         void set_motor_mode(motor_mode new_mode);
 
+        /**
+         * @return: motor_mode -> the mode the motor was last set to
+         */
+        motor_mode get_motor_mode( );
+
 
 
     //driver control lock setting and clearing functions
@@ -466,6 +634,16 @@ class Motor
         
         
     //function to run on thread     
+        /**
+         * @param: double scale -> what the output is multiplied by on [0, 1]
+         * @return: None
+         *
+         * @see: PowerBudget
+         *
+         * only called by the motor thread before run()
+         */
+        void set_output_scale( double scale );
+
         /**
          * @param: int delta_t -> the amount of time elapsed since the last time the function was called
          * @return: int -> the voltage to set the motor to
@@ -0,0 +1,229 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/MotorFaults.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains implementation for the motor fault detector
+ */
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "main.h"
+
+#include "../serial/Logger.hpp"
+#include "Motor.hpp"
+#include "MotorFaults.hpp"
+#include "MotorTelemetry.hpp"
+
+
+MotorFaults *MotorFaults::faults_obj = NULL;
+
+
+MotorFaults::MotorFaults()
+{
+    stall_current = STALL_CURRENT;
+    stall_velocity = STALL_VELOCITY;
+    stall_time = STALL_TIME;
+    over_temperature = OVER_TEMPERATURE;
+
+    for ( int port = 0; port < NUM_MOTOR_PORTS; port++ )
+    {
+        active[port] = e_fault_none;
+        for ( int fault = 0; fault < NUM_MOTOR_FAULTS; fault++ )
+        {
+            raised[port][fault] = 0;
+        }
+        stall_started[port] = 0;
+        was_valid[port] = false;
+    }
+}
+
+
+/**
+ * inits object if object is not already initialized based on a static bool
+ * sets bool if it is not set
+ */
+MotorFaults* MotorFaults::get_instance()
+{
+    if ( faults_obj == NULL )
+    {
+        faults_obj = new MotorFaults;
+    }
+    return faults_obj;
+}
+
+
+
+void MotorFaults::set_fault( int port, motor_fault fault, bool condition )
+{
+    if ( !condition )
+    {
+        active[port] &= ~fault;
+        return;
+    }
+
+    if ( active[port].fetch_or(fault) & fault )
+    {
+        return;  // already raised
+    }
+
+    int index = fault == e_fault_stall ? 0 : (fault == e_fault_disconnected ? 1 : 2);
+    raised[port][index] += 1;
+
+    std::string description = fault == e_fault_stall ? "stalled" : (fault == e_fault_disconnected ? "disconnected" : "over temperature");
+    Logger logger;
+    log_entry entry;
+    entry.content = "[WARNING], " + std::to_string(pros::millis()) + ", motor on port " + std::to_string(port) + " " + description;
+    entry.stream = "cerr";
+    logger.add(entry);
+}
+
+
+/**
+ * stall timing uses the snapshot timestamp so it does not depend on how
+ * often telemetry is sampled
+ */
+void MotorFaults::update( const motor_telemetry &telemetry )
+{
+    int current_limit = stall_current;
+    int velocity_limit = stall_velocity;
+    int time_limit = stall_time;
+    int temperature_limit = over_temperature;
+
+    for ( int port = 1; port < NUM_MOTOR_PORTS; port++ )
+    {
+        if ( !telemetry.valid[port] )
+        {
+            if ( was_valid[port] )  // no longer registered, not a fault
+            {
+                active[port] = e_fault_none;
+                stall_started[port] = 0;
+                was_valid[port] = false;
+            }
+            continue;
+        }
+        was_valid[port] = true;
+
+        bool disconnected = telemetry.current_draw[port] == PROS_ERR || std::isinf(telemetry.actual_velocity[port]);
+        set_fault(port, e_fault_disconnected, disconnected);
+        if ( disconnected )
+        {
+            stall_started[port] = 0;
+            set_fault(port, e_fault_stall, false);
+            continue;
+        }
+
+        bool stuck = (
+            std::abs(telemetry.current_draw[port]) > current_limit
+            && std::abs(telemetry.actual_velocity[port]) < velocity_limit
+            && std::abs(telemetry.actual_voltage[port]) > STALL_VOLTAGE
+        );
+        if ( !stuck )
+        {
+            stall_started[port] = 0;
+        }
+        else if ( stall_started[port] == 0 )
+        {
+            stall_started[port] = telemetry.timestamp == 0 ? 1 : telemetry.timestamp;
+        }
+        set_fault(port, e_fault_stall, stuck && telemetry.timestamp - stall_started[port] >= time_limit);
+
+        if ( telemetry.slow_valid[port] && !std::isinf(telemetry.temperature[port]) )  // slow fields can still be from while it was disconnected
+        {
+            if ( telemetry.temperature[port] >= temperature_limit )
+            {
+                set_fault(port, e_fault_over_temperature, true);
+            }
+            else if ( telemetry.temperature[port] < temperature_limit - OVER_TEMPERATURE_RECOVERY )
+            {
+                set_fault(port, e_fault_over_temperature, false);
+            }
+        }
+    }
+}
+
+
+int MotorFaults::get_faults( int port )
+{
+    if ( port <= 0 || port >= NUM_MOTOR_PORTS )
+    {
+        return e_fault_none;
+    }
+
+    return active[port];
+}
+
+
+
+motor_fault_subscription MotorFaults::subscribe( std::vector<Motor*> motors, int faults )
+{
+    motor_fault_subscription subscription = {};
+    subscription.faults = faults;
+    for ( Motor *motor : motors )
+    {
+        int port = motor->get_port();
+        if ( port > 0 && port < NUM_MOTOR_PORTS )
+        {
+            subscription.ports |= (std::uint32_t)1 << port;
+        }
+    }
+
+    for ( int port = 0; port < NUM_MOTOR_PORTS; port++ )
+    {
+        for ( int fault = 0; fault < NUM_MOTOR_FAULTS; fault++ )
+        {
+            subscription.raised[port][fault] = raised[port][fault];
+        }
+    }
+
+    return subscription;
+}
+
+
+int MotorFaults::check( const motor_fault_subscription &subscription )
+{
+    int faults = e_fault_none;
+    for ( int port = 1; port < NUM_MOTOR_PORTS; port++ )
+    {
+        if ( !(subscription.ports & ((std::uint32_t)1 << port)) )
+        {
+            continue;
+        }
+
+        for ( int fault = 0; fault < NUM_MOTOR_FAULTS; fault++ )
+        {
+            if ( (subscription.faults & (1 << fault)) && raised[port][fault] != subscription.raised[port][fault] )
+            {
+                faults |= 1 << fault;
+            }
+        }
+    }
+
+    return faults;
+}
+
+
+
+int MotorFaults::set_stall_limits( int current, int velocity, int time )
+{
+    if ( current <= 0 || velocity < 0 || time <= 0 )
+    {
+        return 0;
+    }
+
+    stall_current = current;
+    stall_velocity = velocity;
+    stall_time = time;
+
+    return 1;
+}
+
+
+void MotorFaults::set_temperature_limit( int temperature )
+{
+    over_temperature = temperature;
+}
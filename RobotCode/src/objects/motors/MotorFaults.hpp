@@ -0,0 +1,155 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/MotorFaults.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains a class that watches every registered motor for stalls,
+ * disconnections, and overheating
+ */
+
+#ifndef __MOTORFAULTS_HPP__
+#define __MOTORFAULTS_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "main.h"
+
+#include "Motor.hpp"
+#include "MotorTelemetry.hpp"
+
+
+#define NUM_MOTOR_FAULTS          3
+#define STALL_CURRENT             1800  // mA, draw above this with no movement is a stall
+#define STALL_VELOCITY            5     // rpm, slower than this is not moving
+#define STALL_VOLTAGE             1000  // mV, a motor has to be trying to move to be stalled
+#define STALL_TIME                250   // ms, how long the motor has to be stuck before a stall is raised
+#define OVER_TEMPERATURE          55    // degrees C, firmware starts limiting motor power here
+#define OVER_TEMPERATURE_RECOVERY 5     // degrees C, has to cool this much below the limit to clear the fault
+
+
+typedef enum {
+    e_fault_none = 0,
+    e_fault_stall = 1,
+    e_fault_disconnected = 2,
+    e_fault_over_temperature = 4,
+    e_fault_all = 7
+} motor_fault;
+
+
+/**
+ * @see: MotorFaults::subscribe()
+ *
+ * what a command is watching for and how many times each fault had been
+ * raised on each port when it subscribed
+ */
+typedef struct
+{
+    std::uint32_t ports;  // bit i is set if port i is watched
+    int faults;           // motor_fault bits that are watched
+    std::uint32_t raised[NUM_MOTOR_PORTS][NUM_MOTOR_FAULTS];
+} motor_fault_subscription;
+
+
+/**
+ * @see: MotorThread.hpp
+ *
+ * singleton updated by the motor thread every time it samples telemetry
+ *
+ * a stall is raised when a motor draws more than the stall current while
+ * being given voltage and not moving for STALL_TIME. A disconnection is raised
+ * when the device returns errors, and overheating when the motor passes
+ * OVER_TEMPERATURE. Faults clear on their own when the condition goes away
+ *
+ * every time a fault is raised a counter for that port and fault is
+ * incremented. Commands subscribe to the motors they use before starting and
+ * check the subscription each loop so they can stop early instead of waiting
+ * for their timeout
+ */
+class MotorFaults
+{
+    private:
+        MotorFaults();
+        static MotorFaults *faults_obj;
+
+        std::atomic<int> active[NUM_MOTOR_PORTS];  // motor_fault bits currently raised
+        std::atomic<std::uint32_t> raised[NUM_MOTOR_PORTS][NUM_MOTOR_FAULTS];
+
+        std::atomic<int> stall_current;
+        std::atomic<int> stall_velocity;
+        std::atomic<int> stall_time;
+        std::atomic<int> over_temperature;
+
+        std::uint32_t stall_started[NUM_MOTOR_PORTS];  // only used by the motor thread, 0 if not stuck
+        bool was_valid[NUM_MOTOR_PORTS];
+
+        /**
+         * @param: int port -> the port of the motor
+         * @param: motor_fault fault -> the fault to raise or clear
+         * @param: bool condition -> if the fault is present
+         * @return: None
+         *
+         * updates the active faults and counts the fault if it was not
+         * already raised
+         */
+        void set_fault( int port, motor_fault fault, bool condition );
+
+
+    public:
+        /**
+         * @return: MotorFaults -> instance of class to be used throughout program
+         *
+         * give the instance of the singleton class or creates it if it does
+         * not yet exist
+         */
+        static MotorFaults* get_instance();
+
+        /**
+         * @param: const motor_telemetry &telemetry -> the snapshot the motor thread just took
+         * @return: None
+         *
+         * checks every motor in the snapshot for faults
+         * only called by the motor thread
+         */
+        void update( const motor_telemetry &telemetry );
+
+        /**
+         * @param: int port -> the port of the motor
+         * @return: int -> motor_fault bits that are currently raised
+         */
+        int get_faults( int port );
+
+        /**
+         * @param: std::vector<Motor*> motors -> the motors to watch
+         * @param: int faults -> motor_fault bits to watch for
+         * @return: motor_fault_subscription -> passed to check()
+         *
+         * faults raised before subscribing are ignored
+         */
+        motor_fault_subscription subscribe( std::vector<Motor*> motors, int faults=e_fault_all );
+
+        /**
+         * @param: const motor_fault_subscription &subscription -> from subscribe()
+         * @return: int -> motor_fault bits raised on a watched motor since subscribing, 0 if none
+         */
+        int check( const motor_fault_subscription &subscription );
+
+        /**
+         * @param: int current -> mA, draw above this with no movement is a stall
+         * @param: int velocity -> rpm, slower than this is not moving
+         * @param: int time -> ms, how long the motor has to be stuck
+         * @return: int -> 1 if the limits were set, 0 if they are invalid
+         */
+        int set_stall_limits( int current, int velocity, int time );
+
+        /**
+         * @param: int temperature -> degrees C that raises the over temperature fault
+         * @return: None
+         */
+        void set_temperature_limit( int temperature );
+};
+
+
+#endif
@@ -0,0 +1,446 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/MotorGroup.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains implementation for a group of motors commanded together
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "main.h"
+
+#include "../serial/Logger.hpp"
+#include "Motor.hpp"
+#include "MotorGroup.hpp"
+
+
+namespace
+{
+    const int setpoint_max = (1 << 23) - 1;
+
+    /**
+     * sign extends a 24 bit setpoint from a packed command
+     */
+    int unpack_setpoint( std::uint64_t packed, int shift )
+    {
+        std::uint32_t bits = (std::uint32_t)((packed >> shift) & 0xFFFFFF);
+        return (std::int32_t)(bits << 8) >> 8;
+    }
+}
+
+
+
+MotorGroup::MotorGroup( std::vector<Motor*> left_motors, std::vector<Motor*> right_motors )
+{
+    num_motors = 0;
+    side_motors[e_left_side] = 0;
+    side_motors[e_right_side] = 0;
+    for ( motor_group_side side : {e_left_side, e_right_side} )
+    {
+        for ( Motor *motor : side == e_left_side ? left_motors : right_motors )
+        {
+            if ( num_motors >= MOTOR_GROUP_MAX_MOTORS )
+            {
+                break;
+            }
+            side_motors[side] |= (std::uint32_t)1 << num_motors;
+            motors[num_motors] = motor;
+            num_motors += 1;
+        }
+    }
+
+    if ( left_motors.size() + right_motors.size() > MOTOR_GROUP_MAX_MOTORS )
+    {
+        Logger logger;
+        log_entry entry;
+        entry.content = "[WARNING], " + std::to_string(pros::millis()) + ", motor group has more than " + std::to_string(MOTOR_GROUP_MAX_MOTORS) + " motors, the rest are ignored";
+        entry.stream = "cerr";
+        logger.add(entry);
+    }
+
+    enabled_motors = num_motors == 32 ? UINT32_MAX : ((std::uint32_t)1 << num_motors) - 1;
+    commanded = pack_command(0, 0, e_group_no_command, 0);
+    command_sequence = 0;
+    applied_sequence = 0;
+}
+
+
+MotorGroup::MotorGroup( std::vector<Motor*> group_motors ) : MotorGroup(group_motors, {}) { }
+
+
+MotorGroup::~MotorGroup( ) { }
+
+
+
+std::uint64_t MotorGroup::pack_command( int left, int right, motor_group_command command, int mode )
+{
+    left = std::clamp(left, -setpoint_max, setpoint_max);
+    right = std::clamp(right, -setpoint_max, setpoint_max);
+
+    return (
+        ((std::uint64_t)((std::uint32_t)left & 0xFFFFFF))
+        | ((std::uint64_t)((std::uint32_t)right & 0xFFFFFF) << 24)
+        | ((std::uint64_t)(command & 0xF) << 48)
+        | ((std::uint64_t)(mode & 0xF) << 52)
+    );
+}
+
+
+/**
+ * swaps in the new setpoints with a compare exchange so that a mode set by
+ * another task at the same time is not lost
+ */
+void MotorGroup::publish_command( int left, int right, motor_group_command command )
+{
+    std::uint64_t previous = commanded.load();
+    std::uint64_t next;
+    do {
+        int mode = (previous >> 52) & 0xF;
+        next = pack_command(left, right, command, mode);
+    } while ( !commanded.compare_exchange_weak(previous, next) );
+
+    command_sequence += 1;
+}
+
+
+/**
+ * the sequence is read before the command so a command published while this
+ * runs is applied again next tick instead of being lost
+ */
+void MotorGroup::apply_commands( )
+{
+    std::uint32_t sequence = command_sequence.load();
+    if ( sequence == applied_sequence )
+    {
+        return;
+    }
+    applied_sequence = sequence;
+
+    std::uint64_t packed = commanded.load();
+    int setpoints[2] = {unpack_setpoint(packed, 0), unpack_setpoint(packed, 24)};
+    motor_group_command command = (motor_group_command)((packed >> 48) & 0xF);
+    int mode = (packed >> 52) & 0xF;
+    std::uint32_t enabled = enabled_motors.load();
+
+    for ( int i = 0; i < num_motors; i++ )
+    {
+        if ( !(enabled & ((std::uint32_t)1 << i)) )
+        {
+            continue;
+        }
+
+        if ( mode != 0 )
+        {
+            motors[i]->set_motor_mode((motor_mode)(mode - 1));
+        }
+
+        int setpoint = setpoints[(side_motors[e_right_side] >> i) & 1];
+        switch ( command )
+        {
+            case e_group_voltage:
+                motors[i]->set_voltage(setpoint);
+                break;
+            case e_group_velocity:
+                motors[i]->move_velocity(setpoint);
+                break;
+            case e_group_move:
+                motors[i]->move(setpoint);
+                break;
+            case e_group_no_command:
+                break;
+        }
+    }
+}
+
+
+
+
+//membership functions
+
+int MotorGroup::enable_motor( Motor &motor )
+{
+    Motor **element = std::find(motors, motors + num_motors, &motor);
+    if ( element == motors + num_motors )
+    {
+        return 0;
+    }
+
+    enabled_motors |= (std::uint32_t)1 << (element - motors);
+    return 1;
+}
+
+
+int MotorGroup::disable_motor( Motor &motor )
+{
+    Motor **element = std::find(motors, motors + num_motors, &motor);
+    if ( element == motors + num_motors )
+    {
+        return 0;
+    }
+
+    enabled_motors &= ~((std::uint32_t)1 << (element - motors));
+    return 1;
+}
+
+
+std::uint32_t MotorGroup::select( motor_group_side side )
+{
+    std::uint32_t enabled = enabled_motors.load();
+    if ( side == e_both_sides )
+    {
+        return enabled;
+    }
+
+    return enabled & side_motors[side];
+}
+
+
+std::vector<Motor*> MotorGroup::get_motors( motor_group_side side )
+{
+    std::vector<Motor*> selected_motors;
+    std::uint32_t selected = select(side);
+    for ( int i = 0; i < num_motors; i++ )
+    {
+        if ( selected & ((std::uint32_t)1 << i) )
+        {
+            selected_motors.push_back(motors[i]);
+        }
+    }
+
+    return selected_motors;
+}
+
+
+
+
+//accessor functions, members read from the motor thread's snapshot
+
+double MotorGroup::get_actual_velocity( motor_group_side side )
+{
+    std::uint32_t selected = select(side);
+    double total = 0;
+    int count = 0;
+    for ( int i = 0; i < num_motors; i++ )
+    {
+        if ( selected & ((std::uint32_t)1 << i) )
+        {
+            total += motors[i]->get_actual_velocity();
+            count += 1;
+        }
+    }
+
+    return count == 0 ? 0 : total / count;
+}
+
+
+double MotorGroup::get_current_draw( motor_group_side side )
+{
+    std::uint32_t selected = select(side);
+    double total = 0;
+    int count = 0;
+    for ( int i = 0; i < num_motors; i++ )
+    {
+        if ( selected & ((std::uint32_t)1 << i) )
+        {
+            total += motors[i]->get_current_draw();
+            count += 1;
+        }
+    }
+
+    return count == 0 ? 0 : total / count;
+}
+
+
+double MotorGroup::get_temperature( motor_group_side side )
+{
+    std::uint32_t selected = select(side);
+    double total = 0;
+    int count = 0;
+    for ( int i = 0; i < num_motors; i++ )
+    {
+        if ( selected & ((std::uint32_t)1 << i) )
+        {
+            total += motors[i]->get_temperature();
+            count += 1;
+        }
+    }
+
+    return count == 0 ? 0 : total / count;
+}
+
+
+
+
+//movement functions
+
+int MotorGroup::move( int voltage )
+{
+    return move(voltage, voltage);
+}
+
+int MotorGroup::move( int left_voltage, int right_voltage )
+{
+    publish_command(left_voltage, right_voltage, e_group_move);
+
+    return 1;
+}
+
+
+int MotorGroup::user_move( int voltage )
+{
+    return user_move(voltage, voltage);
+}
+
+int MotorGroup::user_move( int left_voltage, int right_voltage )
+{
+    if ( driver_control_allowed() )
+    {
+        return move(left_voltage, right_voltage);
+    }
+
+    return 0;
+}
+
+
+int MotorGroup::move_velocity( int velocity )
+{
+    return move_velocity(velocity, velocity);
+}
+
+int MotorGroup::move_velocity( int left_velocity, int right_velocity )
+{
+    publish_command(left_velocity, right_velocity, e_group_velocity);
+
+    return 1;
+}
+
+
+int MotorGroup::set_voltage( int voltage )
+{
+    return set_voltage(voltage, voltage);
+}
+
+int MotorGroup::set_voltage( int left_voltage, int right_voltage )
+{
+    publish_command(left_voltage, right_voltage, e_group_voltage);
+
+    return 1;
+}
+
+
+void MotorGroup::set_motor_mode( motor_mode new_mode )
+{
+    std::uint64_t previous = commanded.load();
+    std::uint64_t next;
+    do {
+        if ( ((previous >> 52) & 0xF) == new_mode + 1 )  // already set, keep from reapplying the setpoints
+        {
+            return;
+        }
+        next = (previous & ~((std::uint64_t)0xF << 52)) | ((std::uint64_t)(new_mode + 1) << 52);
+    } while ( !commanded.compare_exchange_weak(previous, next) );
+
+    command_sequence += 1;
+}
+
+
+
+
+//configuration functions
+
+void MotorGroup::set_brake_mode( pros::motor_brake_mode_e_t new_brake_mode )
+{
+    std::uint32_t selected = select(e_both_sides);
+    for ( int i = 0; i < num_motors; i++ )
+    {
+        if ( selected & ((std::uint32_t)1 << i) )
+        {
+            motors[i]->set_brake_mode(new_brake_mode);
+        }
+    }
+}
+
+
+void MotorGroup::set_slew( int rate )
+{
+    std::uint32_t selected = select(e_both_sides);
+    for ( int i = 0; i < num_motors; i++ )
+    {
+        if ( selected & ((std::uint32_t)1 << i) )
+        {
+            motors[i]->set_slew(rate);
+        }
+    }
+}
+
+
+void MotorGroup::enable_slew( )
+{
+    std::uint32_t selected = select(e_both_sides);
+    for ( int i = 0; i < num_motors; i++ )
+    {
+        if ( selected & ((std::uint32_t)1 << i) )
+        {
+            motors[i]->enable_slew();
+        }
+    }
+}
+
+
+void MotorGroup::disable_slew( )
+{
+    std::uint32_t selected = select(e_both_sides);
+    for ( int i = 0; i < num_motors; i++ )
+    {
+        if ( selected & ((std::uint32_t)1 << i) )
+        {
+            motors[i]->disable_slew();
+        }
+    }
+}
+
+
+void MotorGroup::enable_driver_control( )
+{
+    std::uint32_t selected = select(e_both_sides);
+    for ( int i = 0; i < num_motors; i++ )
+    {
+        if ( selected & ((std::uint32_t)1 << i) )
+        {
+            motors[i]->enable_driver_control();
+        }
+    }
+}
+
+
+void MotorGroup::disable_driver_control( )
+{
+    std::uint32_t selected = select(e_both_sides);
+    for ( int i = 0; i < num_motors; i++ )
+    {
+        if ( selected & ((std::uint32_t)1 << i) )
+        {
+            motors[i]->disable_driver_control();
+        }
+    }
+}
+
+
+int MotorGroup::driver_control_allowed( )
+{
+    std::uint32_t selected = select(e_both_sides);
+    for ( int i = 0; i < num_motors; i++ )
+    {
+        if ( (selected & ((std::uint32_t)1 << i)) && !motors[i]->driver_control_allowed() )
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
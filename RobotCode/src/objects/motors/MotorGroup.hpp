@@ -0,0 +1,231 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/MotorGroup.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains a class for commanding several motors, such as a side of the
+ * chassis, with one write
+ */
+
+#ifndef __MOTORGROUP_HPP__
+#define __MOTORGROUP_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "main.h"
+
+#include "Motor.hpp"
+
+
+#define MOTOR_GROUP_MAX_MOTORS 32  // members are enabled by one bit each
+
+
+typedef enum {
+    e_both_sides = -1,
+    e_left_side = 0,
+    e_right_side = 1
+} motor_group_side;
+
+typedef enum {
+    e_group_no_command,
+    e_group_voltage,
+    e_group_velocity,
+    e_group_move
+} motor_group_command;
+
+
+/**
+ * @see: Motor.hpp
+ * @see: MotorThread.hpp
+ *
+ * group of motors split into a left and right side that are commanded together
+ * a command for both sides is published with a single store and the motor
+ * thread hands it to every member at the start of the tick before any motor
+ * runs, so all members change on the same tick
+ *
+ * members can be disabled so that a motor can be used for something else
+ * without rebuilding the group, ie. the extra chassis motors on the pto
+ */
+class MotorGroup
+{
+    private:
+        Motor *motors[MOTOR_GROUP_MAX_MOTORS];
+        int num_motors;
+        std::uint32_t side_motors[2];  // bit i is set if motors[i] is on the side, indexed by motor_group_side
+        std::atomic<std::uint32_t> enabled_motors;  // bit i is set if motors[i] follows group commands
+
+        std::atomic<std::uint64_t> commanded;  // see pack_command()
+        std::atomic<std::uint32_t> command_sequence;
+        std::uint32_t applied_sequence;  // only used by the motor thread
+
+        /**
+         * @param: int left -> setpoint for the left side
+         * @param: int right -> setpoint for the right side
+         * @param: motor_group_command command -> what the setpoints are
+         * @param: int mode -> motor_mode + 1, 0 if the mode has not been set
+         * @return: std::uint64_t -> the packed command
+         *
+         * setpoints are stored in 24 bits each which holds any voltage or velocity
+         * bits 0-23 are the left setpoint, 24-47 the right, 48-51 the command,
+         * and 52-55 the mode
+         */
+        static std::uint64_t pack_command( int left, int right, motor_group_command command, int mode );
+
+        /**
+         * @param: int left -> setpoint for the left side
+         * @param: int right -> setpoint for the right side
+         * @param: motor_group_command command -> what the setpoints are
+         * @return: None
+         *
+         * replaces the setpoints but keeps the mode that was last set
+         */
+        void publish_command( int left, int right, motor_group_command command );
+
+        /**
+         * @param: motor_group_side side -> the side to select
+         * @return: std::uint32_t -> bit i is set if motors[i] is enabled and on the side
+         *
+         * used to iterate the members without building a list of them
+         */
+        std::uint32_t select( motor_group_side side );
+
+
+    public:
+        MotorGroup( std::vector<Motor*> left_motors, std::vector<Motor*> right_motors );
+        MotorGroup( std::vector<Motor*> group_motors );
+        ~MotorGroup();
+
+        /**
+         * @return: None
+         *
+         * @see: MotorThread::run()
+         *
+         * called by the motor thread at the start of each tick, if a command
+         * has been published since the last tick it is passed to each enabled
+         * member
+         */
+        void apply_commands( );
+
+    //membership functions
+
+        /**
+         * @param: Motor &motor -> the member to enable
+         * @return: int -> 1 if the motor is a member, 0 otherwise
+         *
+         * the motor follows group commands starting with the next command
+         */
+        int enable_motor( Motor &motor );
+
+        /**
+         * @param: Motor &motor -> the member to disable
+         * @return: int -> 1 if the motor is a member, 0 otherwise
+         *
+         * the motor keeps its last command and is left alone by the group
+         */
+        int disable_motor( Motor &motor );
+
+        /**
+         * @param: motor_group_side side -> the side to get the motors of
+         * @return: std::vector<Motor*> -> the enabled members on that side
+         *
+         * makes a new list, only for setting up a routine and not in a loop
+         */
+        std::vector<Motor*> get_motors( motor_group_side side=e_both_sides );
+
+    //accessor functions
+
+        /**
+         * @param: motor_group_side side -> the side to average
+         * @return: double -> the average velocity of the enabled members
+         */
+        double get_actual_velocity( motor_group_side side=e_both_sides );
+
+        /**
+         * @param: motor_group_side side -> the side to average
+         * @return: double -> the average current drawn by the enabled members in mA
+         */
+        double get_current_draw( motor_group_side side=e_both_sides );
+
+        /**
+         * @param: motor_group_side side -> the side to average
+         * @return: double -> the average temperature of the enabled members in degrees C
+         */
+        double get_temperature( motor_group_side side=e_both_sides );
+
+    //movement functions
+
+        /**
+         * @param: int voltage -> the voltage on interval [-127, 127] for both sides
+         * @return: int -> 1
+         *
+         * @see: Motor::move()
+         */
+        int move( int voltage );
+        int move( int left_voltage, int right_voltage );
+
+        /**
+         * @param: int voltage -> the voltage on interval [-127, 127] for both sides
+         * @return: int -> 1 if driver control is allowed on every enabled member, 0 otherwise
+         *
+         * @see: Motor::user_move()
+         */
+        int user_move( int voltage );
+        int user_move( int left_voltage, int right_voltage );
+
+        /**
+         * @param: int velocity -> the velocity for both sides
+         * @return: int -> 1
+         *
+         * @see: Motor::move_velocity()
+         */
+        int move_velocity( int velocity );
+        int move_velocity( int left_velocity, int right_velocity );
+
+        /**
+         * @param: int voltage -> the voltage in mv on interval [-12000, 12000] for both sides
+         * @return: int -> 1
+         *
+         * @see: Motor::set_voltage()
+         */
+        int set_voltage( int voltage );
+        int set_voltage( int left_voltage, int right_voltage );
+
+        /**
+         * @param: motor_mode new_mode -> the mode for every enabled member
+         * @return: None
+         *
+         * published with the setpoints so it takes effect on the same tick
+         * as them, does nothing if the mode is already set
+         */
+        void set_motor_mode( motor_mode new_mode );
+
+    //configuration functions, these go to each enabled member right away
+
+        /**
+         * @param: pros::motor_brake_mode_e_t new_brake_mode -> the new brakemode for every enabled member
+         * @return: None
+         */
+        void set_brake_mode( pros::motor_brake_mode_e_t new_brake_mode );
+
+        /**
+         * @param: int rate -> the slew rate in mV/ms for every enabled member
+         * @return: None
+         */
+        void set_slew( int rate );
+        void enable_slew( );
+        void disable_slew( );
+
+        void enable_driver_control( );
+        void disable_driver_control( );
+
+        /**
+         * @return: int -> 1 if driver control is allowed on every enabled member, 0 otherwise
+         */
+        int driver_control_allowed( );
+};
+
+
+#endif
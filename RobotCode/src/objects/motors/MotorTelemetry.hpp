@@ -0,0 +1,56 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/MotorTelemetry.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains the snapshot of motor readings that the motor thread takes every
+ * few ticks so that accessors do not each go out to the device
+ */
+
+#ifndef __MOTORTELEMETRY_HPP__
+#define __MOTORTELEMETRY_HPP__
+
+#include <cstdint>
+
+
+#define NUM_MOTOR_PORTS        22  // snapshot is indexed by smart port, 0 is unused
+#define TELEMETRY_FAST_DIVIDER 2   // motor thread ticks between samples of the fast fields, motors report every 10ms
+#define TELEMETRY_SLOW_DIVIDER 20  // motor thread ticks between samples of the slow fields
+#define TELEMETRY_MAX_AGE      50  // ms, older snapshots are ignored and accessors read the device
+
+
+/**
+ * @see: MotorThread::get_telemetry()
+ *
+ * readings of every registered motor from one tick of the motor thread
+ * each field is an array indexed by port so a consumer looking at one field
+ * across all motors, or the thread filling them, walks contiguous memory
+ *
+ * power, temperature, torque, and efficiency change slowly and are sampled
+ * less often, slow_timestamp is when they were last read
+ */
+typedef struct
+{
+    std::uint32_t timestamp;
+    std::uint32_t slow_timestamp;
+
+    bool valid[NUM_MOTOR_PORTS];
+    bool slow_valid[NUM_MOTOR_PORTS];
+
+    double actual_velocity[NUM_MOTOR_PORTS];
+    double actual_voltage[NUM_MOTOR_PORTS];
+    int current_draw[NUM_MOTOR_PORTS];
+    double encoder_position[NUM_MOTOR_PORTS];
+    int direction[NUM_MOTOR_PORTS];  // from the sign of the velocity, not read from the device
+    double estimated_velocity[NUM_MOTOR_PORTS];      // rpm, from the encoder, see VelocityEstimator
+    double estimated_acceleration[NUM_MOTOR_PORTS];  // rpm/s
+
+    double power[NUM_MOTOR_PORTS];
+    double temperature[NUM_MOTOR_PORTS];
+    double torque[NUM_MOTOR_PORTS];
+    int efficiency[NUM_MOTOR_PORTS];
+} motor_telemetry;
+
+
+#endif
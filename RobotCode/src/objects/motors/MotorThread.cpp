@@ -7,20 +7,41 @@
  * contains implementation for functions that handle motor functions
  */
 
+#include <algorithm>
 #include <atomic>
+#include <cmath>
+#include <iterator>
 #include <stdio.h>
-#include <vector>
 
 #include "main.h"
 
 #include "../serial/Logger.hpp"
 #include "Motor.hpp"
+#include "MotorFaults.hpp"
 #include "MotorThread.hpp"
+#include "PowerBudget.hpp"
+#include "VelocityEstimator.hpp"
 
 
 MotorThread *MotorThread::thread_obj = NULL;
-std::vector<Motor*> MotorThread::motors;
+motor_list MotorThread::lists[2] = {};
+std::atomic<motor_list*> MotorThread::published = ATOMIC_VAR_INIT(&MotorThread::lists[0]);
+std::atomic<motor_list*> MotorThread::in_use = ATOMIC_VAR_INIT(NULL);
+std::atomic<std::uint32_t> MotorThread::ticks_finished = ATOMIC_VAR_INIT(0);
+std::atomic<std::uint32_t> MotorThread::publishes = ATOMIC_VAR_INIT(0);
 std::atomic<bool> MotorThread::lock = ATOMIC_VAR_INIT(false);
+std::atomic<bool> MotorThread::running = ATOMIC_VAR_INIT(false);
+std::atomic<bool> MotorThread::stopping = ATOMIC_VAR_INIT(false);
+std::atomic<bool> MotorThread::parked = ATOMIC_VAR_INIT(false);
+std::atomic<bool> MotorThread::fixed_rate = ATOMIC_VAR_INIT(true);
+std::atomic<bool> MotorThread::wake_reset = ATOMIC_VAR_INIT(false);
+motor_thread_timing MotorThread::timing = {};
+std::atomic<std::uint32_t> MotorThread::timing_sequence = ATOMIC_VAR_INIT(0);
+std::atomic<bool> MotorThread::timing_reset = ATOMIC_VAR_INIT(false);
+motor_telemetry MotorThread::telemetry[2] = {};
+std::atomic<std::uint32_t> MotorThread::telemetry_sequence = ATOMIC_VAR_INIT(0);
+VelocityEstimator MotorThread::estimators[NUM_MOTOR_PORTS];
+std::uint32_t MotorThread::estimator_tared_at[NUM_MOTOR_PORTS] = {};
 
 
 MotorThread::MotorThread()
@@ -39,15 +60,216 @@ MotorThread::~MotorThread()
 
 void MotorThread::run(void*)
 {
-    int start = pros::millis();
+    std::uint32_t prev_tick_start = pros::millis();
+    std::uint32_t wake_time = prev_tick_start;
+    bool first_tick = true;
+    std::uint32_t tick = 0;
     while (1) {
-        while ( lock.exchange( true ) );
-        for ( int i = 0; i < motors.size(); i++ ) {
-            motors.at(i)->run( pros::millis() - start );
+        if ( stopping.load() ) {  // suspended here by stop_thread(), in_use is NULL
+            parked.store(true);
+            while ( stopping.load() ) {
+                pros::delay(1);
+            }
+            parked.store(false);
+            prev_tick_start = pros::millis();
+            wake_time = prev_tick_start;
+            first_tick = true;  // time spent stopped is not a period
         }
-        start = pros::millis();
-        lock.exchange(false);
-        pros::delay(5);
+
+        std::uint32_t tick_start = pros::millis();
+        std::uint32_t period = tick_start - prev_tick_start;
+        prev_tick_start = tick_start;
+
+        run_tick(tick, period);
+        if ( !first_tick ) {
+            record_tick(period, pros::millis() - tick_start);
+        }
+        first_tick = false;
+        tick += 1;
+
+        if ( fixed_rate.load() ) {
+            if ( wake_reset.exchange(false) || pros::millis() >= wake_time + MOTOR_THREAD_PERIOD ) {
+                wake_time = pros::millis();  // already missed the next tick, skip it instead of running a burst to catch up
+            }
+            pros::Task::delay_until(&wake_time, MOTOR_THREAD_PERIOD);
+        } else {
+            pros::delay(MOTOR_THREAD_PERIOD);
+            wake_time = pros::millis();
+        }
+    }
+}
+
+
+/**
+ * the sequence is odd while the stats are changed so a reader can tell its
+ * copy was torn
+ */
+void MotorThread::record_tick(std::uint32_t period, std::uint32_t execution_time)
+{
+    timing_sequence.fetch_add(1);
+    if ( timing_reset.exchange(false) ) {
+        timing = {};
+    }
+
+    timing.ticks += 1;
+    timing.last_period = period;
+    if ( period > MOTOR_THREAD_PERIOD ) {
+        timing.overruns += 1;
+    }
+    if ( execution_time > timing.wcet ) {
+        timing.wcet = execution_time;
+    }
+    timing.period_histogram[std::min<std::uint32_t>(period, PERIOD_HISTOGRAM_BINS - 1)] += 1;
+    timing_sequence.fetch_add(1);
+}
+
+
+
+void MotorThread::sample_telemetry(std::uint32_t tick, const motor_list &list)
+{
+    std::uint32_t sequence = telemetry_sequence.load();
+    const motor_telemetry &front = telemetry[sequence % 2];
+    motor_telemetry &back = telemetry[(sequence + 1) % 2];
+    bool sample_slow = (tick % TELEMETRY_SLOW_DIVIDER) == 0;
+
+    back = front;  // carries over slow fields
+    back.timestamp = pros::millis();
+    if ( sample_slow ) {
+        back.slow_timestamp = back.timestamp;
+    }
+    std::fill(std::begin(back.valid), std::end(back.valid), false);
+    std::fill(std::begin(back.slow_valid), std::end(back.slow_valid), false);
+
+    for ( int i = 0; i < list.num_motors; i++ ) {
+        Motor *motor = list.motors[i];
+        int port = motor->get_port();
+        if ( port <= 0 || port >= NUM_MOTOR_PORTS ) {
+            continue;
+        }
+
+        back.actual_velocity[port] = motor->get_actual_velocity(true);
+        back.actual_voltage[port] = motor->get_actual_voltage(true);
+        back.current_draw[port] = motor->get_current_draw(true);
+        back.encoder_position[port] = motor->get_encoder_position(true);
+        back.direction[port] = back.actual_velocity[port] < 0 ? -1 : 1;
+        back.valid[port] = true;
+
+        VelocityEstimator &estimator = estimators[port];
+        estimator.set_filter(motor->get_velocity_filter());
+        if ( !front.valid[port] || std::isinf(back.encoder_position[port]) )  // newly registered or disconnected
+        {
+            estimator.reset();
+        }
+        else if ( motor->get_tared_at() != estimator_tared_at[port] )
+        {
+            estimator.rezero();
+        }
+        estimator_tared_at[port] = motor->get_tared_at();
+        if ( !std::isinf(back.encoder_position[port]) )
+        {
+            estimator.update(back.encoder_position[port], back.timestamp);
+        }
+        back.estimated_velocity[port] = estimator.get_velocity();
+        back.estimated_acceleration[port] = estimator.get_acceleration();
+
+        if ( sample_slow || !front.slow_valid[port] ) {
+            back.power[port] = motor->get_power(true);
+            back.temperature[port] = motor->get_temperature(true);
+            back.torque[port] = motor->get_torque(true);
+            back.efficiency[port] = motor->get_efficiency(true);
+        }
+        back.slow_valid[port] = true;
+    }
+
+    telemetry_sequence.store(sequence + 1);  // publish
+}
+
+
+
+/**
+ * a writer stores the new list and then checks in_use, this stores in_use and
+ * then checks the list again, so either the writer sees the old list in use
+ * and waits or this sees the new list and takes it instead
+ */
+void MotorThread::run_tick(std::uint32_t tick, std::uint32_t period)
+{
+    motor_list *list = acquire_list();
+    if ( tick % TELEMETRY_FAST_DIVIDER == 0 ) {
+        sample_telemetry(tick, *list);
+        PowerBudget::get_instance()->update(telemetry[telemetry_sequence.load() % 2]);
+        MotorFaults::get_instance()->update(telemetry[telemetry_sequence.load() % 2]);
+    }
+    for ( int i = 0; i < list->num_groups; i++ ) {
+        list->groups[i]->apply_commands();
+    }
+    for ( int i = 0; i < list->num_motors; i++ ) {
+        Motor *motor = list->motors[i];
+        motor->set_output_scale(PowerBudget::get_instance()->get_scale(motor->get_port()));
+        motor->run( period );
+    }
+    in_use.store(NULL);
+    ticks_finished.fetch_add(1);
+}
+
+
+motor_list* MotorThread::acquire_list()
+{
+    motor_list *list;
+    do {
+        list = published.load();
+        in_use.store(list);
+    } while ( list != published.load() );
+
+    return list;
+}
+
+
+motor_list* MotorThread::begin_update()
+{
+    while ( lock.exchange( true ) ) {  // the holder can be waiting on the thread in publish()
+        pros::delay(1);
+    }
+
+    motor_list *current = published.load();
+    motor_list *spare = current == &lists[0] ? &lists[1] : &lists[0];
+    *spare = *current;
+
+    return spare;
+}
+
+
+/**
+ * the thread is done with the old list once it is not in use, the next tick
+ * takes the new one so the old one can be reused as the spare
+ */
+void MotorThread::publish(motor_list *list)
+{
+    motor_list *old = published.load();
+    published.store(list);
+    publishes.fetch_add(1);
+    while ( in_use.load() == old ) {
+        pros::delay(1);
+    }
+
+    lock.exchange(false);
+}
+
+
+void MotorThread::discard()
+{
+    lock.exchange(false);
+}
+
+
+/**
+ * a tick that starts after this is called loads everything again, so only
+ * the one that is running has to finish
+ */
+void MotorThread::wait_for_tick()
+{
+    std::uint32_t ticks = ticks_finished.load();
+    while ( in_use.load() != NULL && ticks_finished.load() == ticks ) {
+        pros::delay(1);
     }
 }
 
@@ -66,93 +288,213 @@ MotorThread* MotorThread::get_instance() {
 
 
 void MotorThread::start_thread() {
+    stopping.store(false);
+    running.store(true);
     thread->resume();
 }
 
 void MotorThread::stop_thread() {
-    thread->suspend();
+    stopping.store(true);
+    if ( running.exchange(false) ) {
+        while ( !parked.load() && stopping.load() ) {
+            pros::delay(1);
+        }
+    }
+    if ( stopping.load() ) {  // not started again while waiting
+        thread->suspend();
+    }
+}
+
+
+void MotorThread::enable_fixed_rate() {
+    if ( !fixed_rate.exchange(true) ) {
+        wake_reset.store(true);
+    }
+}
+
+void MotorThread::disable_fixed_rate() {
+    fixed_rate.store(false);
+}
+
+
+motor_thread_timing MotorThread::get_timing() {
+    motor_thread_timing copy;
+    std::uint32_t sequence;
+    do {
+        sequence = timing_sequence.load();
+        copy = timing;
+    } while ( sequence % 2 != 0 || sequence != timing_sequence.load() );
+
+    if ( timing_reset.load() ) {  // thread has not cleared them yet
+        copy = {};
+    }
+
+    return copy;
+}
+
+void MotorThread::reset_timing() {
+    timing_reset.store(true);
+}
+
+
+motor_telemetry MotorThread::get_telemetry() {
+    motor_telemetry copy;
+    std::uint32_t sequence;
+    do {
+        sequence = telemetry_sequence.load();
+        copy = telemetry[sequence % 2];
+    } while ( sequence != telemetry_sequence.load() );  // the thread starts filling this buffer as soon as it publishes the next one
+
+    return copy;
 }
 
 
 int MotorThread::register_motor( Motor &motor ) {
-    while ( lock.exchange( true ) );
-    
     Logger logger;
     log_entry entry;
-    char buffer[10];
-    
-    
-    try
-    {
-        motors.push_back(&motor);
-        
-        sprintf(buffer, "%p", &motor);
-        entry.stream = "clog";
-        entry.content = "[INFO], " + std::to_string(pros::millis()) +  ", motor added at " + buffer;
-        logger.add(entry);
-    } 
-    catch ( ... )
+    char buffer[32];  // "0x" + pointer digits, leaves room for 64 bit pointers in the host sim
+    snprintf(buffer, sizeof(buffer), "%p", (void*)&motor);
+
+    motor_list *list = begin_update();
+    if ( list->num_motors >= MAX_REGISTERED_MOTORS )
     {
-        sprintf(buffer, "%p", &motor);
+        discard();
+
         entry.content = "[WARNING], " + std::to_string(pros::millis()) +  ", could not add motor at " + buffer;
         entry.stream = "cerr";
-        logger.add(entry);
+        logger.add(entry, e_log_source_motor);
 
-        lock.exchange(false);
         return 0;
     }
-    
-    lock.exchange(false);
+
+    list->motors[list->num_motors] = &motor;
+    list->num_motors += 1;
+    publish(list);
+
+    entry.stream = "clog";
+    entry.content = "[INFO], " + std::to_string(pros::millis()) +  ", motor added at " + buffer;
+    logger.add(entry, e_log_source_motor);
+
     return 1;
 }
 
 
 int MotorThread::unregister_motor( Motor &motor )
 {
-    while ( lock.exchange( true ) );
-    
     Logger logger;
     log_entry entry;
-    char buffer[10];
-    
-    auto element = std::find(begin(motors), end(motors), &motor);
-    if ( element != motors.end())
-    {
-        motors.erase(element);
-        
-        sprintf(buffer, "%p", &motor);
-        entry.stream = "clog";
-        entry.content = "[INFO] " + std::to_string(pros::millis()) + ", motor removed at " + buffer;
-        logger.add(entry);
-    }
-    else 
+    char buffer[32];  // "0x" + pointer digits, leaves room for 64 bit pointers in the host sim
+    snprintf(buffer, sizeof(buffer), "%p", (void*)&motor);
+
+    motor_list *list = begin_update();
+    Motor **end = list->motors + list->num_motors;
+    Motor **element = std::find(list->motors, end, &motor);
+    if ( element == end )
     {
-        sprintf(buffer, "%p", &motor);
+        discard();
+
         entry.content = "[WARNING] " + std::to_string(pros::millis()) +  ", could not remove motor at " + buffer;
         entry.stream = "cerr";
-        logger.add(entry);
-        
-        lock.exchange(false);
+        logger.add(entry, e_log_source_motor);
+
         return 0;
     }
-    
-    lock.exchange(false);
+
+    std::copy(element + 1, end, element);
+    list->num_motors -= 1;
+    publish(list);
+
+    entry.stream = "clog";
+    entry.content = "[INFO] " + std::to_string(pros::millis()) + ", motor removed at " + buffer;
+    logger.add(entry, e_log_source_motor);
+
     return 1;
-    
 }
 
 
+/**
+ * writers only change the list that is not published, and a list only stops
+ * being published once publishes is counted, so if the count did not change
+ * the list that was read was not changed under it
+ */
 int MotorThread::is_registered(Motor &motor) {
-    int registered = 0;
-    
-    while ( lock.exchange( true ) );
-    
-    auto element = std::find(begin(motors), end(motors), &motor);
-    if ( element != motors.end()) {
-        registered = 1;
-    }
-    
-    lock.exchange(false);
-    
+    std::uint32_t count;
+    int registered;
+    do {
+        count = publishes.load();
+        const motor_list *list = published.load();
+        registered = std::find(list->motors, list->motors + list->num_motors, &motor) != list->motors + list->num_motors;
+    } while ( count != publishes.load() );
+
     return registered;
-}
\ No newline at end of file
+}
+
+
+
+int MotorThread::register_group( MotorGroup &group ) {
+    Logger logger;
+    log_entry entry;
+    char buffer[32];  // "0x" + pointer digits, leaves room for 64 bit pointers in the host sim
+    snprintf(buffer, sizeof(buffer), "%p", (void*)&group);
+
+    motor_list *list = begin_update();
+    MotorGroup **end = list->groups + list->num_groups;
+    if ( std::find(list->groups, end, &group) != end )  // already registered
+    {
+        discard();
+    }
+    else if ( list->num_groups >= MAX_REGISTERED_GROUPS )
+    {
+        discard();
+
+        entry.content = "[WARNING], " + std::to_string(pros::millis()) +  ", could not add motor group at " + buffer;
+        entry.stream = "cerr";
+        logger.add(entry, e_log_source_motor);
+
+        return 0;
+    }
+    else
+    {
+        list->groups[list->num_groups] = &group;
+        list->num_groups += 1;
+        publish(list);
+    }
+
+    entry.stream = "clog";
+    entry.content = "[INFO], " + std::to_string(pros::millis()) +  ", motor group added at " + buffer;
+    logger.add(entry, e_log_source_motor);
+
+    return 1;
+}
+
+
+int MotorThread::unregister_group( MotorGroup &group ) {
+    Logger logger;
+    log_entry entry;
+    char buffer[32];  // "0x" + pointer digits, leaves room for 64 bit pointers in the host sim
+    snprintf(buffer, sizeof(buffer), "%p", (void*)&group);
+
+    motor_list *list = begin_update();
+    MotorGroup **end = list->groups + list->num_groups;
+    MotorGroup **element = std::find(list->groups, end, &group);
+    if ( element == end )
+    {
+        discard();
+
+        entry.content = "[WARNING] " + std::to_string(pros::millis()) +  ", could not remove motor group at " + buffer;
+        entry.stream = "cerr";
+        logger.add(entry, e_log_source_motor);
+
+        return 0;
+    }
+
+    std::copy(element + 1, end, element);
+    list->num_groups -= 1;
+    publish(list);
+
+    entry.stream = "clog";
+    entry.content = "[INFO] " + std::to_string(pros::millis()) + ", motor group removed at " + buffer;
+    logger.add(entry, e_log_source_motor);
+
+    return 1;
+}
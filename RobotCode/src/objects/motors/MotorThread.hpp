@@ -13,19 +13,62 @@
 
 #include <vector>
 #include <atomic>
+#include <cstdint>
 
 #include "main.h"
 
 #include "../../Configuration.hpp"
 #include "Motor.hpp"
+#include "MotorGroup.hpp"
+#include "MotorTelemetry.hpp"
+#include "VelocityEstimator.hpp"
+
+
+#define MOTOR_THREAD_PERIOD   5   // ms, velocity loops are tuned for this cadence
+#define PERIOD_HISTOGRAM_BINS 16  // 1ms bins, last bin holds anything longer
+#define MAX_REGISTERED_MOTORS 32
+#define MAX_REGISTERED_GROUPS 8
+
+
+/**
+ * timing of the motor thread loop, always collected
+ * times are in ms because that is the resolution of pros::millis()
+ */
+typedef struct
+{
+    std::uint32_t ticks;
+    std::uint32_t overruns;      // ticks that started later than MOTOR_THREAD_PERIOD after the last one
+    std::uint32_t wcet;          // longest time spent running every motor in one tick
+    std::uint32_t last_period;
+    std::uint32_t period_histogram[PERIOD_HISTOGRAM_BINS];
+} motor_thread_timing;
+
+
+/**
+ * fixed capacity list of what the motor thread runs, a list is never changed
+ * while it is published so the thread can iterate it without a lock
+ */
+typedef struct
+{
+    Motor *motors[MAX_REGISTERED_MOTORS];
+    int num_motors;
+    MotorGroup *groups[MAX_REGISTERED_GROUPS];
+    int num_groups;
+} motor_list;
 
 
 /**
  * @see: Motor.hpp
  *
  * contains singleton class for using motors in a thread
- * motors are added to a vector and iterated over in a thread so that the voltage
+ * motors are added to a list and iterated over in a thread so that the voltage
  * can be set
+ *
+ * registering copies the published list into the spare one, changes the copy,
+ * and publishes it with a pointer swap. The thread takes the published list
+ * at the start of each tick and keeps it until the end, so it never waits on
+ * a registration. The writer waits until the thread is done with the old list
+ * before returning, after that the old list is the spare
  */
 class MotorThread
 {
@@ -33,8 +76,26 @@ class MotorThread
         MotorThread();
         static MotorThread *thread_obj;
         
-        static std::vector<Motor*> motors;
-        static std::atomic<bool> lock;  //protect vector from concurrent access
+        static motor_list lists[2];  // published and spare
+        static std::atomic<motor_list*> published;
+        static std::atomic<motor_list*> in_use;  // list the thread is running, NULL between ticks
+        static std::atomic<std::uint32_t> ticks_finished;  // counted when in_use goes back to NULL
+        static std::atomic<std::uint32_t> publishes;  // counted by publish() before the old list can be changed
+        static std::atomic<bool> lock;  // serializes writers of the spare list, never taken by the thread
+        static std::atomic<bool> running;  // thread has been started and not stopped
+        static std::atomic<bool> stopping;  // set by stop_thread(), thread parks between ticks while set
+        static std::atomic<bool> parked;  // thread is between ticks and will not start one while stopping
+
+        static std::atomic<bool> fixed_rate;  // set by any task, read by the thread
+        static std::atomic<bool> wake_reset;  // set by enable_fixed_rate(), cleared by the thread
+        static motor_thread_timing timing;
+        static std::atomic<std::uint32_t> timing_sequence;  // odd while the thread is updating timing
+        static std::atomic<bool> timing_reset;  // set by reset_timing(), cleared by the thread
+
+        static motor_telemetry telemetry[2];  // front is telemetry_sequence % 2, the other is filled by the thread
+        static std::atomic<std::uint32_t> telemetry_sequence;
+        static VelocityEstimator estimators[NUM_MOTOR_PORTS];
+        static std::uint32_t estimator_tared_at[NUM_MOTOR_PORTS];  // tare of each motor the estimator has seen
         
         
         /**
@@ -43,8 +104,65 @@ class MotorThread
          *
          * the function to be run on a thread that calls the run function for 
          * each motor that sets the voltage and performs logging
+         * group commands are handed to their members first so every member
+         * of a group changes on the same tick
+         * in fixed rate mode ticks are scheduled with delay_until so the period
+         * does not grow with the time spent running motors
          */
         static void run(void*);
+
+        /**
+         * @param: std::uint32_t period -> time since the start of the last tick
+         * @param: std::uint32_t execution_time -> time spent running motors this tick
+         * @return: None
+         *
+         * adds a tick to the timing stats, only called by the thread
+         */
+        static void record_tick(std::uint32_t period, std::uint32_t execution_time);
+
+        /**
+         * @param: std::uint32_t tick -> number of ticks the thread has run
+         * @param: const motor_list &list -> motors to read
+         * @return: None
+         *
+         * reads every registered motor into the back snapshot and then swaps
+         * it to the front, slow fields are only read every TELEMETRY_SLOW_DIVIDER
+         * ticks and are carried over from the last snapshot otherwise
+         */
+        static void sample_telemetry(std::uint32_t tick, const motor_list &list);
+
+        /**
+         * @return: motor_list* -> the published list, marked as in use
+         *
+         * only called by the thread, retries if a writer publishes between
+         * reading the list and marking it so a writer never misses it
+         */
+        static motor_list* acquire_list();
+
+        /**
+         * @return: motor_list* -> the spare list holding a copy of the published one
+         *
+         * takes the writer lock, publish() or discard() has to be called after.
+         * Waits for another writer by sleeping so a writer at any priority
+         * lets the writer holding the lock, and the thread it waits on, run
+         */
+        static motor_list* begin_update();
+
+        /**
+         * @param: motor_list *list -> list from begin_update()
+         * @return: None
+         *
+         * swaps the list in, waits for the thread to finish a tick on the old
+         * list if it is running one, and releases the writer lock
+         */
+        static void publish(motor_list *list);
+
+        /**
+         * @return: None
+         *
+         * releases the writer lock without publishing
+         */
+        static void discard();
         
         pros::Task *thread;  // the motor thread
                 
@@ -73,32 +191,154 @@ class MotorThread
         /**
          * @return: None
          *
-         * stops the thread from being scheduled
+         * stops the thread from being scheduled. Waits for the tick that is
+         * running to finish first so the thread is never suspended with a
+         * list in use, which would block publish() and wait_for_tick()
          */
         void stop_thread();
+
+        /**
+         * @return: None
+         *
+         * schedule ticks every MOTOR_THREAD_PERIOD ms from the start of the
+         * last tick, this is the default. The thread starts scheduling from
+         * its next tick so the time spent in the other mode is not caught up
+         */
+        void enable_fixed_rate();
+
+        /**
+         * @return: None
+         *
+         * delay MOTOR_THREAD_PERIOD ms after running motors, so the period is
+         * the delay plus the time spent in the loop
+         */
+        void disable_fixed_rate();
+
+        /**
+         * @param: std::uint32_t tick -> number of ticks run so far, picks the ticks telemetry is sampled on
+         * @param: std::uint32_t period -> time since the start of the last tick
+         * @return: None
+         *
+         * runs one tick on the calling task: samples telemetry, updates the
+         * power budget and faults, and runs every registered group and motor.
+         * Called by the thread, and by the host benchmark while the thread is
+         * stopped so the whole tick is measured
+         */
+        static void run_tick(std::uint32_t tick, std::uint32_t period);
+
+        /**
+         * @return: None
+         *
+         * waits until a tick that may have started before this was called has
+         * finished, returns right away if the thread is between ticks. Used
+         * to free what the thread could still be using, ie. a Motor's device
+         * after set_port()
+         */
+        static void wait_for_tick();
+
+        /**
+         * @return: motor_thread_timing -> copy of the loop timing stats
+         *
+         * copy is retried if the thread updated the stats while it was made
+         */
+        motor_thread_timing get_timing();
+
+        /**
+         * @return: None
+         *
+         * clears the loop timing stats, the thread clears them on its next
+         * tick and get_timing() reads as cleared until then
+         */
+        void reset_timing();
+
+        /**
+         * @param: T (motor_telemetry::*field)[NUM_MOTOR_PORTS] -> field to read
+         * @param: int port -> port of the motor, 1 to NUM_MOTOR_PORTS - 1
+         * @param: bool slow_field -> the field is one that is sampled less often
+         * @param: std::uint32_t not_before -> snapshots older than this are not used
+         * @param: T &value -> set to the field from the front snapshot
+         * @return: bool -> true if value was set, false if the snapshot is
+         *                  older than TELEMETRY_MAX_AGE or does not have the port
+         *
+         * used by Motor accessors to read a single field, the read is retried
+         * if the thread published a new snapshot while it was made since the
+         * thread starts overwriting the old front as soon as it publishes
+         */
+        template <typename T>
+        static bool read_telemetry( T (motor_telemetry::*field)[NUM_MOTOR_PORTS], int port, bool slow_field, std::uint32_t not_before, T &value ) {
+            std::uint32_t sequence;
+            bool usable;
+            do {
+                sequence = telemetry_sequence.load();
+                const motor_telemetry &snapshot = telemetry[sequence % 2];
+                usable = (
+                    sequence != 0
+                    && snapshot.valid[port]
+                    && (!slow_field || snapshot.slow_valid[port])
+                    && snapshot.timestamp >= not_before
+                    && pros::millis() - snapshot.timestamp <= TELEMETRY_MAX_AGE
+                );
+                value = (snapshot.*field)[port];
+            } while ( sequence != telemetry_sequence.load() );
+
+            return usable;
+        }
+
+        /**
+         * @return: motor_telemetry -> copy of the front snapshot
+         *
+         * copy is retried if the thread published a new snapshot while it was
+         * being made so every field is from the same instant
+         */
+        motor_telemetry get_telemetry();
                 
                 
                 
                 
         /**
-         * @param: Motor &motor -> the motor to add to the vector
-         * @return: int -> 1 if motor was successfully added, 0 otherwise
+         * @param: Motor &motor -> the motor to add to the list
+         * @return: int -> 1 if motor was successfully added, 0 if the list is full
          *
-         * adds a motor to the vector of motors to operate
+         * adds a motor to the list of motors to operate
          * logs that the motor was added to the logger queue
          */
         int register_motor( Motor &motor );
         
         /**
-         * @param: Motor &motor -> the motor to remove from the vector
-         * @return: int -> 1 if motor was successfully added, 0 otherwise
+         * @param: Motor &motor -> the motor to remove from the list
+         * @return: int -> 1 if motor was successfully removed, 0 otherwise
          *
-         * removes a motor from the vector of motors to operate
+         * removes a motor from the list of motors to operate, once this
+         * returns the motor thread is no longer using the motor
          * logs that the motor was removed to the logger queue
          */
         int unregister_motor( Motor &motor );
         
+        /**
+         * @param: Motor &motor -> the motor to look for
+         * @return: int -> 1 if the motor is in the published list, 0 otherwise
+         *
+         * does not take the writer lock, the list is read again if a writer
+         * published while it was being read
+         */
         int is_registered(Motor &motor);
+
+        /**
+         * @param: MotorGroup &group -> the group to add to the list
+         * @return: int -> 1 if group was successfully added, 0 if the list is full
+         *
+         * adds a group whose commands are applied at the start of each tick
+         * the members still have to be registered to be run
+         */
+        int register_group( MotorGroup &group );
+
+        /**
+         * @param: MotorGroup &group -> the group to remove from the list
+         * @return: int -> 1 if group was successfully removed, 0 otherwise
+         *
+         * once this returns the motor thread is no longer using the group
+         */
+        int unregister_group( MotorGroup &group );
     
     
 };
@@ -0,0 +1,374 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/MotorTrace.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains implementation for the binary motor trace
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "main.h"
+
+#include "../../Configuration.hpp"
+#include "../serial/Logger.hpp"
+#include "Motor.hpp"
+#include "MotorThread.hpp"
+#include "MotorTrace.hpp"
+
+
+MotorTrace *MotorTrace::trace_obj = NULL;
+
+
+MotorTrace::MotorTrace()
+{
+    records = new motor_trace_record[MOTOR_TRACE_RECORDS];
+    head = 0;
+    tail = 0;
+    enabled_ports = 0;
+
+    for ( int i = 0; i < NUM_MOTOR_PORTS; i++ )
+    {
+        last_gains[i] = {};
+        ticks_since_gains[i] = MOTOR_TRACE_GAINS_INTERVAL;  // first tick writes the gains
+        gains_sequence[i] = 0;
+    }
+}
+
+
+/**
+ * inits object if object is not already initialized based on a static bool
+ * sets bool if it is not set
+ */
+MotorTrace* MotorTrace::get_instance()
+{
+    if ( trace_obj == NULL )
+    {
+        trace_obj = new MotorTrace;
+    }
+    return trace_obj;
+}
+
+
+
+int MotorTrace::enable( int port )
+{
+    if ( port <= 0 || port >= NUM_MOTOR_PORTS )
+    {
+        return 0;
+    }
+
+    enabled_ports |= (std::uint32_t)1 << port;
+    return 1;
+}
+
+
+int MotorTrace::disable( int port )
+{
+    if ( port <= 0 || port >= NUM_MOTOR_PORTS )
+    {
+        return 0;
+    }
+
+    enabled_ports &= ~((std::uint32_t)1 << port);
+    return 1;
+}
+
+
+bool MotorTrace::is_enabled( int port )
+{
+    if ( port <= 0 || port >= NUM_MOTOR_PORTS )
+    {
+        return false;
+    }
+
+    return enabled_ports.load() & ((std::uint32_t)1 << port);
+}
+
+
+
+/**
+ * the head is stored after the record is copied so a reader that sees the
+ * new head also sees the record
+ */
+void MotorTrace::write( motor_trace_record &record )
+{
+    std::uint32_t sequence = head.load(std::memory_order_relaxed);
+    record.sequence = sequence;
+    record.time = pros::millis();
+    records[sequence % MOTOR_TRACE_RECORDS] = record;
+    head.store(sequence + 1, std::memory_order_release);
+}
+
+
+void MotorTrace::record( int port, const motor_trace_tick &tick, const motor_trace_gains &gains )
+{
+    if ( port <= 0 || port >= NUM_MOTOR_PORTS )
+    {
+        return;
+    }
+
+    ticks_since_gains[port] += 1;
+    if (
+        ticks_since_gains[port] >= MOTOR_TRACE_GAINS_INTERVAL
+        || gains_sequence[port] < tail.load()  // trace was cleared since the gains were written
+        || std::memcmp(&gains, &last_gains[port], sizeof(gains)) != 0
+    )
+    {
+        motor_trace_record gains_record = {};
+        gains_record.kind = e_trace_gains;
+        gains_record.port = port;
+        gains_record.gains = gains;
+        write(gains_record);
+
+        gains_sequence[port] = gains_record.sequence;
+        last_gains[port] = gains;
+        ticks_since_gains[port] = 0;
+    }
+
+    motor_trace_record tick_record = {};
+    tick_record.kind = e_trace_tick;
+    tick_record.port = port;
+    tick_record.tick = tick;
+    write(tick_record);
+}
+
+
+
+/**
+ * the motor thread keeps writing while the ring is copied, a slot holds the
+ * record that was copied only if it still has that record's sequence and
+ * the writer could not have reached it by the time the copy finished. The
+ * slots it could have reached are the oldest ones so what is kept is the
+ * newest records in order
+ */
+std::vector<motor_trace_record> MotorTrace::snapshot( )
+{
+    std::uint32_t end = head.load(std::memory_order_acquire);
+    std::uint32_t start = std::max(tail.load(), end > MOTOR_TRACE_RECORDS ? end - MOTOR_TRACE_RECORDS : 0);
+
+    std::vector<motor_trace_record> copied;
+    copied.reserve(end - start);
+    for ( std::uint32_t sequence = start; sequence < end; sequence++ )
+    {
+        copied.push_back(records[sequence % MOTOR_TRACE_RECORDS]);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    std::uint32_t head_after = head.load(std::memory_order_acquire);
+    std::uint32_t oldest = head_after + 1 > MOTOR_TRACE_RECORDS ? head_after + 1 - MOTOR_TRACE_RECORDS : 0;  // the one being written is counted
+
+    std::vector<motor_trace_record> trace;
+    trace.reserve(copied.size());
+    for ( std::uint32_t i = 0; i < copied.size(); i++ )
+    {
+        if ( copied.at(i).sequence == start + i && start + i >= oldest )
+        {
+            trace.push_back(copied.at(i));
+        }
+    }
+
+    return trace;
+}
+
+
+/**
+ * moves the start of the trace up to the head, the motor thread sees that
+ * and writes the gains of each motor again on its next tick
+ */
+void MotorTrace::clear( )
+{
+    tail = head.load();
+}
+
+
+
+int MotorTrace::save( std::string path )
+{
+    std::vector<motor_trace_record> trace = snapshot();
+
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if ( file == NULL )
+    {
+        Logger logger;
+        log_entry entry;
+        entry.content = "[ERROR], " + std::to_string(pros::millis()) + ", could not save motor trace to " + path;
+        entry.stream = "cerr";
+        logger.add(entry);
+
+        return 0;
+    }
+
+    motor_trace_header header = {MOTOR_TRACE_MAGIC, MOTOR_TRACE_VERSION, sizeof(motor_trace_record), (std::uint32_t)trace.size()};
+    std::fwrite(&header, sizeof(header), 1, file);
+    std::fwrite(trace.data(), sizeof(motor_trace_record), trace.size(), file);
+    std::fclose(file);
+
+    return 1;
+}
+
+
+int MotorTrace::load( std::string path, std::vector<motor_trace_record> &trace )
+{
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if ( file == NULL )
+    {
+        return 0;
+    }
+
+    motor_trace_header header;
+    if (
+        std::fread(&header, sizeof(header), 1, file) != 1
+        || header.magic != MOTOR_TRACE_MAGIC
+        || header.version != MOTOR_TRACE_VERSION
+        || header.record_size != sizeof(motor_trace_record)
+    )
+    {
+        std::fclose(file);
+        return 0;
+    }
+
+    trace.resize(header.records);
+    std::size_t read = std::fread(trace.data(), sizeof(motor_trace_record), header.records, file);
+    trace.resize(read);
+    std::fclose(file);
+
+    return 1;
+}
+
+
+
+/**
+ * mirrors what Motor::run() does around get_target_voltage(), take_commands()
+ * clears the integral when the voltage setpoint changes before the state is
+ * recorded so the carried state has to be cleared the same way
+ */
+motor_trace_replay MotorTrace::replay( const std::vector<motor_trace_record> &trace )
+{
+    motor_trace_replay result = {};
+
+    Motor *motors[NUM_MOTOR_PORTS] = {};
+    bool have_gains[NUM_MOTOR_PORTS] = {};
+    bool carried[NUM_MOTOR_PORTS] = {};  // state in the motor came from replaying the port's last tick
+
+    for ( int i = 0; i < trace.size(); i++ )
+    {
+        const motor_trace_record &record = trace.at(i);
+        if ( record.port <= 0 || record.port >= NUM_MOTOR_PORTS )
+        {
+            continue;
+        }
+
+        if ( i > 0 && record.sequence != trace.at(i - 1).sequence + 1 )  // records were lost, state can not be carried over
+        {
+            std::fill(std::begin(carried), std::end(carried), false);
+        }
+
+        if ( motors[record.port] == NULL )
+        {
+            motors[record.port] = new Motor(record.port, pros::E_MOTOR_GEARSET_18, false);
+        }
+        Motor &motor = *motors[record.port];
+
+        if ( record.kind == e_trace_gains )
+        {
+            motor.internal_motor_pid.kP = record.gains.kP;
+            motor.internal_motor_pid.kI = record.gains.kI;
+            motor.internal_motor_pid.kD = record.gains.kD;
+            motor.internal_motor_pid.i_max = record.gains.i_max;
+            motor.feedforward_consts.kS = record.gains.kS;
+            motor.feedforward_consts.kV = record.gains.kV;
+            motor.feedforward_consts.kA = record.gains.kA;
+            have_gains[record.port] = true;
+            continue;
+        }
+        else if ( record.kind != e_trace_tick )
+        {
+            continue;
+        }
+
+        const motor_trace_tick &tick = record.tick;
+        result.ticks += 1;
+        if ( !have_gains[record.port] )
+        {
+            continue;
+        }
+
+        bool state_matches = true;
+        if ( carried[record.port] )
+        {
+            //same reset as Motor::take_commands(), a velocity step changes the
+            //setpoint with no acceleration
+            bool velocity_step = tick.velocity_setpoint != motor.velocity_setpoint && tick.setpoint_acceleration == 0;
+            if ( tick.mode == e_feedforward_velocity )
+            {
+                if ( tick.mode != motor.mode || velocity_step )
+                {
+                    motor.integral = 0;
+                }
+            }
+            else if ( tick.voltage_setpoint != motor.prev_voltage_setpoint )
+            {
+                motor.integral = 0;
+            }
+            state_matches = (
+                motor.integral == tick.integral
+                && motor.prev_error == tick.prev_error
+                && motor.prev_voltage_setpoint == tick.prev_voltage_setpoint
+            );
+        }
+        else
+        {
+            motor.integral = tick.integral;
+            motor.prev_error = tick.prev_error;
+            motor.prev_voltage_setpoint = tick.prev_voltage_setpoint;
+        }
+
+        motor.mode = (motor_mode)tick.mode;
+        motor.slew_enabled = tick.slew_enabled;
+        motor.slew_rate = tick.slew_rate;
+        motor.max_velocity = tick.max_velocity;
+        motor.voltage_setpoint = tick.voltage_setpoint;
+        motor.velocity_setpoint = tick.velocity_setpoint;
+        motor.setpoint_acceleration = tick.setpoint_acceleration;
+
+        int output;
+        switch ( motor.mode )
+        {
+            case e_builtin_velocity_pid:
+                output = tick.velocity_setpoint;
+                break;
+            case e_voltage:
+                output = tick.voltage_setpoint;
+                break;
+            default:
+                output = motor.get_target_voltage(tick.delta_t, tick.measured_velocity, tick.actual_voltage);
+                break;
+        }
+
+        result.replayed += 1;
+        if ( output != tick.output || !state_matches )
+        {
+            if ( result.mismatches == 0 )
+            {
+                result.first_mismatch = record.sequence;
+            }
+            result.mismatches += 1;
+        }
+        carried[record.port] = true;
+    }
+
+    for ( Motor *motor : motors )
+    {
+        delete motor;
+    }
+
+    return result;
+}
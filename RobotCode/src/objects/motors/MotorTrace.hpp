@@ -0,0 +1,211 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/MotorTrace.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains a binary trace of every Motor::run and a replayer that feeds a
+ * trace back through the motor's voltage calculation
+ */
+
+#ifndef __MOTORTRACE_HPP__
+#define __MOTORTRACE_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "main.h"
+
+#include "../../Configuration.hpp"
+#include "MotorTelemetry.hpp"
+
+
+#define MOTOR_TRACE_RECORDS        8192  // ring size, about 5 seconds of all 8 motors
+#define MOTOR_TRACE_GAINS_INTERVAL 200   // ticks of a motor between repeats of its gains so a wrapped trace can still be replayed
+#define MOTOR_TRACE_MAGIC          0x4352544D  // "MTRC" in a little endian file
+#define MOTOR_TRACE_VERSION        1
+#define MOTOR_TRACE_PATH           "/usd/motor_trace.bin"
+
+
+typedef enum {
+    e_trace_tick = 1,
+    e_trace_gains = 2
+} motor_trace_kind;
+
+
+/**
+ * everything Motor::get_target_voltage() reads, the state it carries
+ * between ticks as it was before the call, and what it returned
+ */
+typedef struct
+{
+    std::int32_t delta_t;
+    std::uint8_t mode;          // motor_mode
+    std::uint8_t slew_enabled;
+    std::int32_t slew_rate;
+    std::int32_t max_velocity;
+    std::int32_t voltage_setpoint;
+    std::int32_t prev_voltage_setpoint;
+    std::int32_t velocity_setpoint;
+    std::int32_t output;        // mV before the output scale, the setpoint in modes without a calculation
+    std::int32_t current;       // mA
+    double integral;
+    double prev_error;
+    double setpoint_acceleration;
+    double measured_velocity;   // estimated velocity the calculation used
+    double actual_voltage;
+    double output_scale;
+} motor_trace_tick;
+
+
+typedef struct
+{
+    double kP;
+    double kI;
+    double kD;
+    double i_max;
+    double kS;
+    double kV;
+    double kA;
+} motor_trace_gains;
+
+
+typedef struct
+{
+    std::uint32_t sequence;  // position in the trace, a gap means records were overwritten
+    std::uint32_t time;      // ms
+    std::uint8_t kind;       // motor_trace_kind
+    std::uint8_t port;
+    union {
+        motor_trace_tick tick;
+        motor_trace_gains gains;
+    };
+} motor_trace_record;
+
+
+typedef struct
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t record_size;  // a trace written by a build with a different layout is rejected
+    std::uint32_t records;
+} motor_trace_header;
+
+
+typedef struct
+{
+    int ticks;       // tick records in the trace
+    int replayed;    // ticks that had gains to replay with
+    int mismatches;  // replayed ticks whose output or carried state differed from the trace
+    std::uint32_t first_mismatch;  // sequence of the first mismatch
+} motor_trace_replay;
+
+
+/**
+ * @see: Motor::run()
+ *
+ * singleton holding a preallocated ring of fixed size records that the
+ * motor thread writes for each traced motor every tick, in place of the
+ * text the log levels build. Only the motor thread writes so a write is a
+ * copy into the ring and a store of the head
+ *
+ * gains are written as their own record when they change and every
+ * MOTOR_TRACE_GAINS_INTERVAL ticks, replay starts for a motor at its first
+ * gains record
+ */
+class MotorTrace
+{
+    private:
+        MotorTrace();
+        static MotorTrace *trace_obj;
+
+        motor_trace_record *records;
+        std::atomic<std::uint32_t> head;  // sequence of the next record
+        std::atomic<std::uint32_t> tail;  // sequence of the first record after the last clear
+        std::atomic<std::uint32_t> enabled_ports;  // bit i is set if port i is traced
+
+        // only used by the motor thread
+        motor_trace_gains last_gains[NUM_MOTOR_PORTS];
+        int ticks_since_gains[NUM_MOTOR_PORTS];
+        std::uint32_t gains_sequence[NUM_MOTOR_PORTS];  // sequence of the last gains record
+
+        /**
+         * @param: motor_trace_record &record -> kind, port, and contents are set, the rest is filled in
+         * @return: None
+         */
+        void write( motor_trace_record &record );
+
+
+    public:
+        /**
+         * @return: MotorTrace -> instance of class to be used throughout program
+         *
+         * give the instance of the singleton class or creates it if it does
+         * not yet exist
+         */
+        static MotorTrace* get_instance();
+
+        /**
+         * @param: int port -> port of the motor
+         * @return: int -> 1 if the port is valid, 0 otherwise
+         */
+        int enable( int port );
+        int disable( int port );
+        bool is_enabled( int port );
+
+        /**
+         * @param: int port -> port of the motor
+         * @param: const motor_trace_tick &tick -> the tick to record
+         * @param: const motor_trace_gains &gains -> gains the tick was calculated with
+         * @return: None
+         *
+         * only called by the motor thread, writes the gains first if they
+         * changed or are due to be repeated
+         */
+        void record( int port, const motor_trace_tick &tick, const motor_trace_gains &gains );
+
+        /**
+         * @return: std::vector<motor_trace_record> -> the records in the ring, oldest first
+         *
+         * safe to call while the motor thread is tracing, records it
+         * overwrote or could have been writing while they were copied are
+         * left out so what is returned has no gaps
+         */
+        std::vector<motor_trace_record> snapshot( );
+
+        /**
+         * @return: None
+         *
+         * drops every record, the next tick of each motor writes its gains
+         */
+        void clear( );
+
+        /**
+         * @param: std::string path -> file to write
+         * @return: int -> 1 if the trace was written, 0 otherwise
+         */
+        int save( std::string path=MOTOR_TRACE_PATH );
+
+        /**
+         * @param: std::string path -> file written by save()
+         * @param: std::vector<motor_trace_record> &trace -> filled with the records
+         * @return: int -> 1 if the file was read, 0 if it could not be opened or has a different layout
+         */
+        static int load( std::string path, std::vector<motor_trace_record> &trace );
+
+        /**
+         * @param: const std::vector<motor_trace_record> &trace -> records to replay, oldest first
+         * @return: motor_trace_replay -> how many ticks were reproduced
+         *
+         * runs each tick through Motor::get_target_voltage() with the recorded
+         * inputs. State is carried from tick to tick like the motor thread
+         * does and only loaded from the trace at the start or after a gap,
+         * so the carried state is checked as well as the output
+         */
+        static motor_trace_replay replay( const std::vector<motor_trace_record> &trace );
+};
+
+
+#endif
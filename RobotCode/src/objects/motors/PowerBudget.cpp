@@ -0,0 +1,234 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/PowerBudget.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains implementation for the motor current and temperature budget
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include "main.h"
+
+#include "MotorTelemetry.hpp"
+#include "PowerBudget.hpp"
+
+
+PowerBudget *PowerBudget::budget_obj = NULL;
+
+
+PowerBudget::PowerBudget()
+{
+    enabled = true;
+    current_budget = POWER_BUDGET_CURRENT;
+    soft_temperature = POWER_BUDGET_SOFT_TEMP;
+    hard_temperature = POWER_BUDGET_HARD_TEMP;
+    reset_requested = false;
+
+    for ( int port = 0; port < NUM_MOTOR_PORTS; port++ )
+    {
+        priority[port] = 1;
+        scale[port] = 1;
+    }
+
+    working_status = {};
+    working_status.current_budget = current_budget;
+    working_status.headroom = current_budget;
+    working_status.min_scale = 1;
+    status.publish(working_status);
+}
+
+
+/**
+ * inits object if object is not already initialized based on a static bool
+ * sets bool if it is not set
+ */
+PowerBudget* PowerBudget::get_instance()
+{
+    if ( budget_obj == NULL )
+    {
+        budget_obj = new PowerBudget;
+    }
+    return budget_obj;
+}
+
+
+
+/**
+ * draw is estimated from the measured current divided by the scale that was
+ * applied, so the budget is split based on what each motor is asking for and
+ * not on what it was allowed last update
+ */
+void PowerBudget::update( const motor_telemetry &telemetry )
+{
+    double demand[NUM_MOTOR_PORTS] = {};
+    double weights[NUM_MOTOR_PORTS] = {};
+    double target[NUM_MOTOR_PORTS];
+
+    int budget = current_budget;
+    int soft_limit = soft_temperature;
+    int hard_limit = hard_temperature;
+
+    double total_current = 0;
+    double total_demand = 0;
+    double weighted_demand = 0;
+    double max_temperature = 0;
+    int hottest_port = 0;
+
+    for ( int port = 1; port < NUM_MOTOR_PORTS; port++ )
+    {
+        target[port] = 1;
+        if ( !telemetry.valid[port] || telemetry.current_draw[port] == PROS_ERR )  // unregistered or disconnected
+        {
+            continue;
+        }
+
+        double current = std::abs(telemetry.current_draw[port]);
+        weights[port] = std::max(priority[port].load(), 0.01);
+        demand[port] = current / std::max(scale[port], POWER_BUDGET_MIN_SCALE);
+
+        total_current += current;
+        total_demand += demand[port];
+        weighted_demand += demand[port] / weights[port];
+
+        if ( telemetry.slow_valid[port] && !std::isinf(telemetry.temperature[port]) && telemetry.temperature[port] > max_temperature )
+        {
+            max_temperature = telemetry.temperature[port];
+            hottest_port = port;
+        }
+    }
+
+    bool is_enabled = enabled;
+    double excess = total_demand - budget;
+    for ( int port = 1; port < NUM_MOTOR_PORTS; port++ )
+    {
+        if ( !is_enabled || !telemetry.valid[port] || telemetry.current_draw[port] == PROS_ERR )
+        {
+            scale[port] = 1;
+            continue;
+        }
+
+        // current share, excess is taken from each motor in proportion to demand / priority
+        if ( excess > 0 && weighted_demand > 0 && demand[port] > 0 )
+        {
+            double reduction = (excess / weighted_demand) / weights[port];
+            target[port] = 1 - reduction;
+        }
+
+        // thermal derate
+        if ( telemetry.slow_valid[port] && !std::isinf(telemetry.temperature[port]) && telemetry.temperature[port] > soft_limit )
+        {
+            double fraction = (telemetry.temperature[port] - soft_limit) / std::max(hard_limit - soft_limit, 1);
+            target[port] = std::min(target[port], 1 - ((1 - POWER_BUDGET_MIN_SCALE) * fraction));
+        }
+
+        target[port] = std::clamp(target[port], POWER_BUDGET_MIN_SCALE, 1.0);
+        if ( target[port] < scale[port] )
+        {
+            scale[port] = target[port];
+        }
+        else
+        {
+            scale[port] = std::min(target[port], scale[port] + POWER_BUDGET_RECOVERY);
+        }
+    }
+
+
+    if ( reset_requested.exchange(false) )
+    {
+        working_status.updates = 0;
+        working_status.limited_updates = 0;
+    }
+
+    working_status.total_current = total_current;
+    working_status.demanded_current = total_demand;
+    working_status.current_budget = budget;
+    working_status.headroom = budget - total_demand;
+    working_status.max_temperature = max_temperature;
+    working_status.hottest_port = hottest_port;
+    working_status.min_scale = 1;
+    working_status.limited_motors = 0;
+    for ( int port = 1; port < NUM_MOTOR_PORTS; port++ )
+    {
+        if ( scale[port] < 1 )
+        {
+            working_status.min_scale = std::min(working_status.min_scale, scale[port]);
+            working_status.limited_motors += 1;
+        }
+    }
+    working_status.updates += 1;
+    if ( working_status.limited_motors > 0 )
+    {
+        working_status.limited_updates += 1;
+    }
+
+    status.try_publish(working_status);  // only writer, never collides
+}
+
+
+double PowerBudget::get_scale( int port )
+{
+    if ( port <= 0 || port >= NUM_MOTOR_PORTS )
+    {
+        return 1;
+    }
+
+    return scale[port];
+}
+
+
+power_budget_status PowerBudget::get_status( )
+{
+    return status.read();
+}
+
+
+void PowerBudget::reset_status( )
+{
+    reset_requested = true;
+}
+
+
+
+
+void PowerBudget::enable( )
+{
+    enabled = true;
+}
+
+
+void PowerBudget::disable( )
+{
+    enabled = false;
+}
+
+
+int PowerBudget::set_limits( int budget, int soft_limit, int hard_limit )
+{
+    if ( budget <= 0 || soft_limit >= hard_limit )
+    {
+        return 0;
+    }
+
+    current_budget = budget;
+    soft_temperature = soft_limit;
+    hard_temperature = hard_limit;
+
+    return 1;
+}
+
+
+int PowerBudget::set_priority( int port, double weight )
+{
+    if ( port <= 0 || port >= NUM_MOTOR_PORTS || weight <= 0 )
+    {
+        return 0;
+    }
+
+    priority[port] = weight;
+
+    return 1;
+}
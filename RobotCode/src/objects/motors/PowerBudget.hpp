@@ -0,0 +1,137 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/PowerBudget.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains a class that keeps the total current drawn by the motors under a
+ * budget and derates motors as they heat up
+ */
+
+#ifndef __POWERBUDGET_HPP__
+#define __POWERBUDGET_HPP__
+
+#include <atomic>
+#include <cstdint>
+
+#include "main.h"
+
+#include "Mailbox.hpp"
+#include "MotorTelemetry.hpp"
+
+
+#define POWER_BUDGET_CURRENT     20000  // mA, total draw the brain can supply before it starts limiting motors
+#define POWER_BUDGET_SOFT_TEMP   45     // degrees C, motors start to be derated
+#define POWER_BUDGET_HARD_TEMP   55     // degrees C, firmware halves motor power here
+#define POWER_BUDGET_MIN_SCALE   0.3    // no motor is scaled below this
+#define POWER_BUDGET_RECOVERY    0.02   // most a motor's scale can increase in one update
+
+
+/**
+ * @see: PowerBudget::get_status()
+ *
+ * what the budget saw and did on its last update
+ */
+typedef struct
+{
+    int total_current;       // mA, measured
+    int demanded_current;    // mA, estimated draw if no motor were scaled
+    int current_budget;      // mA
+    int headroom;            // mA, budget minus demanded current, negative while limiting
+    double max_temperature;  // degrees C
+    int hottest_port;
+    double min_scale;        // smallest scale applied to a motor
+    int limited_motors;      // motors with a scale below 1
+    std::uint32_t limited_updates;  // updates where any motor was limited
+    std::uint32_t updates;
+} power_budget_status;
+
+
+/**
+ * @see: MotorThread.hpp
+ *
+ * singleton consulted by the motor thread every time it samples telemetry
+ *
+ * each motor gets a scale on [POWER_BUDGET_MIN_SCALE, 1] that its output is
+ * multiplied by. When the motors would draw more than the budget the excess is
+ * taken from each motor in proportion to its draw divided by its priority, so
+ * a motor with priority 2 gives up half as much as one with priority 1. Motors
+ * hotter than the soft limit are derated linearly to the minimum scale at the
+ * hard limit. Scales drop right away but recover a little each update so the
+ * draw does not oscillate around the budget
+ */
+class PowerBudget
+{
+    private:
+        PowerBudget();
+        static PowerBudget *budget_obj;
+
+        std::atomic<bool> enabled;
+        std::atomic<int> current_budget;
+        std::atomic<int> soft_temperature;
+        std::atomic<int> hard_temperature;
+        std::atomic<double> priority[NUM_MOTOR_PORTS];
+        std::atomic<bool> reset_requested;  // counters are cleared by the motor thread on its next update
+
+        double scale[NUM_MOTOR_PORTS];  // only used by the motor thread
+        power_budget_status working_status;
+        Mailbox<power_budget_status> status;
+
+
+    public:
+        /**
+         * @return: PowerBudget -> instance of class to be used throughout program
+         *
+         * give the instance of the singleton class or creates it if it does
+         * not yet exist
+         */
+        static PowerBudget* get_instance();
+
+        /**
+         * @param: const motor_telemetry &telemetry -> the snapshot the motor thread just took
+         * @return: None
+         *
+         * recalculates the scale of every motor in the snapshot
+         * only called by the motor thread
+         */
+        void update( const motor_telemetry &telemetry );
+
+        /**
+         * @param: int port -> the port of the motor
+         * @return: double -> what the motor's output should be multiplied by
+         */
+        double get_scale( int port );
+
+        /**
+         * @return: power_budget_status -> what the budget saw and did on its last update
+         */
+        power_budget_status get_status( );
+
+        /**
+         * @return: None
+         *
+         * clears the update counters in the status on the next update
+         */
+        void reset_status( );
+
+        void enable( );
+        void disable( );
+
+        /**
+         * @param: int budget -> the total current in mA that the motors should stay under
+         * @param: int soft_limit -> temperature in degrees C that motors start to be derated
+         * @param: int hard_limit -> temperature in degrees C that motors reach the minimum scale
+         * @return: int -> 1 if the limits were set, 0 if they are invalid
+         */
+        int set_limits( int budget, int soft_limit, int hard_limit );
+
+        /**
+         * @param: int port -> the port of the motor
+         * @param: double weight -> the priority of the motor, higher is scaled less, defaults to 1
+         * @return: int -> 1 if the priority was set, 0 if the port or weight is invalid
+         */
+        int set_priority( int port, double weight );
+};
+
+
+#endif
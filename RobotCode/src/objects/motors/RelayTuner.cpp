@@ -0,0 +1,250 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/RelayTuner.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains implementation for the relay feedback auto-tuner
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "main.h"
+
+#include "../../Configuration.hpp"
+#include "../serial/Logger.hpp"
+#include "Motor.hpp"
+#include "MotorFaults.hpp"
+#include "MotorThread.hpp"
+#include "RelayTuner.hpp"
+
+
+
+/**
+ * a cycle starts each time the relay switches high, the period is the time
+ * between those switches and the amplitude is half of the range the process
+ * covered in between. Ku = 4d / (pi * sqrt(a^2 - e^2)) corrects for the
+ * hysteresis e which delays each switch
+ */
+relay_result RelayTuner::tune(
+    std::string name,
+    std::function<double()> measure,
+    std::function<void(double)> actuate,
+    double setpoint,
+    relay_params params,
+    pid current_gains,
+    std::function<bool()> should_stop
+)
+{
+    Logger logger;
+    log_entry entry;
+    entry.stream = "clog";
+
+    relay_result result = {};
+    result.gains = current_gains;
+
+    double relay = setpoint - measure() > 0 ? params.amplitude : -params.amplitude;
+    std::uint32_t start_time = pros::millis();
+    std::uint32_t cycle_start = 0;  // 0 until the relay has switched high once
+    int cycles_seen = 0;
+    double cycle_max = -INFINITY;
+    double cycle_min = INFINITY;
+    double period_sum = 0;
+    double amplitude_sum = 0;
+
+    while ( result.cycles < params.cycles && pros::millis() - start_time < (std::uint32_t)params.timeout )
+    {
+        if ( should_stop() )
+        {
+            break;
+        }
+
+        double process = measure();
+        double error = setpoint - process;
+        cycle_max = std::max(cycle_max, process);
+        cycle_min = std::min(cycle_min, process);
+
+        if ( relay > 0 && error < -params.hysteresis )
+        {
+            relay = -params.amplitude;
+        }
+        else if ( relay < 0 && error > params.hysteresis )
+        {
+            relay = params.amplitude;
+
+            std::uint32_t now = pros::millis();
+            if ( cycle_start != 0 )
+            {
+                cycles_seen += 1;
+                if ( cycles_seen > 1 )  // first cycle starts from rest and is not periodic yet
+                {
+                    period_sum += now - cycle_start;
+                    amplitude_sum += (cycle_max - cycle_min) / 2;
+                    result.cycles += 1;
+                }
+            }
+            cycle_start = now;
+            cycle_max = process;
+            cycle_min = process;
+        }
+
+        actuate(params.bias + relay);
+
+        if ( params.log_data )
+        {
+            entry.content = (
+                "[INFO] RELAY_TUNE_SAMPLE"
+                ", Name: " + name
+                + ", Time: " + std::to_string(pros::millis())
+                + ", Sp: " + std::to_string(setpoint)
+                + ", Process: " + std::to_string(process)
+                + ", Output: " + std::to_string(params.bias + relay)
+            );
+            logger.add(entry);
+        }
+
+        pros::delay(params.sample_period);
+    }
+    actuate(params.bias);
+
+    if ( result.cycles < RELAY_MIN_CYCLES )
+    {
+        entry.content = (
+            "[WARNING], " + std::to_string(pros::millis())
+            + ", relay test of " + name + " ended after " + std::to_string(result.cycles)
+            + " cycles, gains were not changed"
+        );
+        entry.stream = "cerr";
+        logger.add(entry);
+
+        result.cycles = 0;
+        return result;
+    }
+
+    result.ultimate_period = period_sum / result.cycles;
+    result.amplitude = amplitude_sum / result.cycles;
+    double effective_amplitude = std::sqrt(std::max(std::pow(result.amplitude, 2) - std::pow(params.hysteresis, 2), 1e-9));
+    result.ultimate_gain = (4 * params.amplitude) / (M_PI * effective_amplitude);
+    result.gains = compute_gains(result.ultimate_gain, result.ultimate_period, params, current_gains);
+
+    entry.content = (
+        "[INFO] RELAY_TUNE"
+        ", Name: " + name
+        + ", Time: " + std::to_string(pros::millis())
+        + ", Cycles: " + std::to_string(result.cycles)
+        + ", Ku: " + std::to_string(result.ultimate_gain)
+        + ", Tu: " + std::to_string(result.ultimate_period)
+        + ", Amplitude: " + std::to_string(result.amplitude)
+        + ", Rule: " + std::to_string(params.rule)
+        + ", kP: " + std::to_string(result.gains.kP)
+        + ", kI: " + std::to_string(result.gains.kI)
+        + ", kD: " + std::to_string(result.gains.kD)
+    );
+    entry.stream = "clog";
+    logger.add(entry);
+
+    return result;
+}
+
+
+
+relay_result RelayTuner::tune_motor( Motor &motor, int velocity, relay_params params )
+{
+    int max_velocity = Motor::get_max_velocity(motor.get_gearset());
+    params.bias = Motor::to_voltage(velocity, max_velocity);
+    params.loop_period = MOTOR_THREAD_PERIOD;  // custom pid runs every motor thread tick
+    params.integral_step = MOTOR_THREAD_PERIOD;  // and adds the error once per tick
+
+    bool slew_enabled = motor.is_slew_enabled();  // restored when the tune is done
+    motor_mode mode = motor.get_motor_mode();
+    motor.disable_driver_control();
+    motor.disable_slew();
+    motor.set_motor_mode(e_voltage);
+
+    // the voltage for a velocity depends on the load, so find the bias by
+    // integrating the velocity error before starting the relay
+    for ( int i = 0; i < RELAY_BIAS_SEARCH_TIME / params.sample_period; i++ )
+    {
+        motor.set_voltage(params.bias);
+        pros::delay(params.sample_period);
+
+        double error = velocity - motor.get_estimated_velocity();
+        params.bias += RELAY_BIAS_SEARCH_GAIN * Motor::to_voltage(error, max_velocity) * params.sample_period / 1000;
+        params.bias = std::clamp(params.bias, -12000.0, 12000.0);
+    }
+
+    motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe({&motor}, e_fault_stall);
+    relay_result result = tune(
+        "Motor " + std::to_string(motor.get_port()),
+        [&motor]() { return motor.get_estimated_velocity(); },
+        [&motor](double output) { motor.set_voltage(std::clamp(output, -12000.0, 12000.0)); },
+        velocity,
+        params,
+        motor.get_pid(),
+        [&stalls]() { return MotorFaults::get_instance()->check(stalls); }
+    );
+
+    motor.set_voltage(0);
+    motor.set_motor_mode(mode);
+    if ( slew_enabled )
+    {
+        motor.enable_slew();
+    }
+    motor.enable_driver_control();
+
+    if ( result.cycles > 0 && params.apply )
+    {
+        motor.set_pid(result.gains);
+    }
+
+    return result;
+}
+
+
+
+/**
+ * the rules give Kp, Ti, and Td, the loops in this project use
+ * kI * sum(error * integral_step) and kD * (error - prev_error) so
+ * kI = Kp * integral_step / Ti and kD = Kp * Td / loop_period
+ */
+pid RelayTuner::compute_gains( double ultimate_gain, double ultimate_period, const relay_params &params, pid current_gains )
+{
+    double kP = 0;
+    double integral_time = 0;    // ms, 0 if there is no integral term
+    double derivative_time = 0;  // ms
+    switch ( params.rule )
+    {
+        case e_ziegler_nichols_p:
+            kP = 0.5 * ultimate_gain;
+            break;
+        case e_ziegler_nichols_pi:
+            kP = 0.45 * ultimate_gain;
+            integral_time = ultimate_period / 1.2;
+            break;
+        case e_ziegler_nichols_pid:
+            kP = 0.6 * ultimate_gain;
+            integral_time = ultimate_period / 2;
+            derivative_time = ultimate_period / 8;
+            break;
+        case e_tyreus_luyben_pi:
+            kP = ultimate_gain / 3.2;
+            integral_time = 2.2 * ultimate_period;
+            break;
+        case e_tyreus_luyben_pid:
+            kP = ultimate_gain / 2.2;
+            integral_time = 2.2 * ultimate_period;
+            derivative_time = ultimate_period / 6.3;
+            break;
+    }
+
+    pid gains = current_gains;
+    gains.kP = kP;
+    gains.kI = integral_time > 0 ? kP * params.integral_step / integral_time : 0;
+    gains.kD = params.loop_period > 0 ? kP * derivative_time / params.loop_period : 0;
+
+    return gains;
+}
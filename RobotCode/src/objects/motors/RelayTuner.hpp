@@ -0,0 +1,126 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/RelayTuner.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains a relay feedback auto-tuner for the pid loops of the motors and
+ * subsystems
+ */
+
+#ifndef __RELAYTUNER_HPP__
+#define __RELAYTUNER_HPP__
+
+#include <functional>
+#include <string>
+
+#include "main.h"
+
+#include "../../Configuration.hpp"
+#include "Motor.hpp"
+
+
+#define RELAY_MIN_CYCLES        2     // cycles needed after the first before the result is trusted
+#define RELAY_BIAS_SEARCH_TIME  1000  // ms, motor tests find the voltage that holds their velocity before starting
+#define RELAY_BIAS_SEARCH_GAIN  5     // 1/s, how fast the bias is integrated
+
+
+typedef enum {
+    e_ziegler_nichols_p,
+    e_ziegler_nichols_pi,
+    e_ziegler_nichols_pid,
+    e_tyreus_luyben_pi,     // less overshoot than ziegler nichols, better for loops that should not oscillate
+    e_tyreus_luyben_pid
+} tuning_rule;
+
+
+typedef struct
+{
+    double amplitude=50;    // output units, relay switches between bias + amplitude and bias - amplitude
+    double bias=0;          // output units, output that holds the process near the setpoint
+    double hysteresis=1;    // process units, error has to leave this band before the relay switches
+    int cycles=4;           // cycles averaged, the first cycle is a transient and is not counted
+    int timeout=10000;      // ms
+    int sample_period=10;   // ms, how often the relay is updated
+    tuning_rule rule=e_tyreus_luyben_pid;
+    bool apply=true;        // replace the gains of the loop when the test succeeds
+    bool log_data=false;    // log every sample as well as the result
+
+    // set by the subsystem to match the loop being tuned
+    double loop_period=10;   // ms between the loop's derivative samples
+    double integral_step=1;  // ms that one error sample adds to the loop's integral
+} relay_params;
+
+
+typedef struct
+{
+    double ultimate_gain;    // output units per process unit
+    double ultimate_period;  // ms
+    double amplitude;        // process units, half of the peak to peak oscillation
+    int cycles;              // measured, 0 if the test failed
+    pid gains;
+} relay_result;
+
+
+/**
+ * @see: Motor.hpp
+ * @see: ../subsystems/chassis.hpp
+ * @see: ../subsystems/LiftController.hpp
+ *
+ * runs an Astrom-Hagglund relay test on a loop, the output is switched
+ * between two levels each time the process crosses the setpoint which makes
+ * the loop oscillate at its ultimate period. The ultimate gain comes from
+ * the amplitude of the oscillation and gains are calculated from both with
+ * a ziegler nichols or tyreus luyben rule
+ *
+ * gains are scaled to the way the loops in this project accumulate their
+ * integral and take their derivative, see loop_period and integral_step
+ */
+class RelayTuner
+{
+    public:
+        /**
+         * @param: std::string name -> what is being tuned, used in the log
+         * @param: std::function<double()> measure -> reads the process
+         * @param: std::function<void(double)> actuate -> sets the output, a positive output must increase the process
+         * @param: double setpoint -> the process oscillates around this
+         * @param: relay_params params -> relay levels, cycles, and the rule to use
+         * @param: pid current_gains -> i_max and slew are kept from these
+         * @param: std::function<bool()> should_stop -> ends the test early, ie. on a stall
+         * @return: relay_result -> cycles is 0 if the loop did not oscillate before the timeout
+         *
+         * blocks until the test ends, the output is left at the bias
+         */
+        static relay_result tune(
+            std::string name,
+            std::function<double()> measure,
+            std::function<void(double)> actuate,
+            double setpoint,
+            relay_params params,
+            pid current_gains,
+            std::function<bool()> should_stop=[]() { return false; }
+        );
+
+        /**
+         * @param: Motor &motor -> the motor to tune
+         * @param: int velocity -> velocity in rpm to oscillate around
+         * @param: relay_params params -> amplitude is in mV, bias is found by the test
+         * @return: relay_result -> cycles is 0 if the test failed
+         *
+         * tunes the custom velocity pid of the motor, blocks the caller until
+         * the test ends and leaves the motor in voltage mode at 0
+         */
+        static relay_result tune_motor( Motor &motor, int velocity, relay_params params={} );
+
+        /**
+         * @param: double ultimate_gain -> output units per process unit
+         * @param: double ultimate_period -> ms
+         * @param: const relay_params &params -> the rule and the loop's timing
+         * @param: pid current_gains -> i_max and slew are kept from these
+         * @return: pid -> the new gains
+         */
+        static pid compute_gains( double ultimate_gain, double ultimate_period, const relay_params &params, pid current_gains );
+};
+
+
+#endif
@@ -0,0 +1,494 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/SystemId.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains implementation for motor system identification
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "main.h"
+
+#include "../../Configuration.hpp"
+#include "../serial/Logger.hpp"
+#include "Motor.hpp"
+#include "MotorFaults.hpp"
+#include "SystemId.hpp"
+
+
+SystemId *SystemId::sysid_obj = NULL;
+std::atomic<bool> SystemId::running = ATOMIC_VAR_INIT(false);
+std::atomic<bool> SystemId::stop_requested = ATOMIC_VAR_INIT(false);
+pros::Task *SystemId::thread = NULL;
+std::vector<Motor*> SystemId::test_motors;
+sysid_params SystemId::test_params;
+std::vector<sysid_sample> SystemId::samples;
+Mailbox<motor_model> SystemId::model;
+
+
+SystemId::SystemId() { }
+
+
+/**
+ * inits object if object is not already initialized based on a static bool
+ * sets bool if it is not set
+ */
+SystemId* SystemId::get_instance()
+{
+    if ( sysid_obj == NULL )
+    {
+        sysid_obj = new SystemId;
+    }
+    return sysid_obj;
+}
+
+
+
+void SystemId::record_sample( std::vector<Motor*> motors, bool log_data )
+{
+    sysid_sample sample = {};
+    sample.time = pros::millis();
+    for ( Motor *motor : motors )
+    {
+        sample.voltage += motor->get_actual_voltage();
+        sample.velocity += motor->get_estimated_velocity();
+        sample.acceleration += motor->get_estimated_acceleration();
+    }
+    sample.voltage /= motors.size();
+    sample.velocity /= motors.size();
+    sample.acceleration /= motors.size();
+
+    if ( samples.size() < SYSID_MAX_SAMPLES )
+    {
+        samples.push_back(sample);
+    }
+
+    if ( log_data )
+    {
+        Logger logger;
+        log_entry entry;
+        entry.content = format_sample(sample);
+        entry.stream = "clog";
+        logger.add(entry);
+    }
+}
+
+
+/**
+ * a stall ends the test early but is not an error, the stalled samples are
+ * too slow to be used in the fit anyways
+ */
+int SystemId::hold_voltage( std::vector<Motor*> motors, int voltage, int duration, bool record, bool log_data )
+{
+    motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(motors, e_fault_stall);
+    std::uint32_t start_time = pros::millis();
+    for ( Motor *motor : motors )
+    {
+        motor->set_voltage(voltage);
+    }
+
+    while ( pros::millis() - start_time < (std::uint32_t)duration )
+    {
+        if ( stop_requested )
+        {
+            return 0;
+        }
+        else if ( MotorFaults::get_instance()->check(stalls) )
+        {
+            break;
+        }
+
+        pros::delay(SYSID_SAMPLE_PERIOD);
+        if ( record )
+        {
+            record_sample(motors, log_data);
+        }
+    }
+
+    return 1;
+}
+
+
+int SystemId::ramp_voltage( std::vector<Motor*> motors, int direction, const sysid_params &params )
+{
+    motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(motors, e_fault_stall);
+    std::uint32_t start_time = pros::millis();
+    int voltage = 0;
+    while ( std::abs(voltage) < params.ramp_voltage )
+    {
+        if ( stop_requested )
+        {
+            return 0;
+        }
+        else if ( MotorFaults::get_instance()->check(stalls) )
+        {
+            break;
+        }
+
+        voltage = direction * std::min(params.ramp_voltage, (int)(params.ramp_rate * (pros::millis() - start_time) / 1000));
+        for ( Motor *motor : motors )
+        {
+            motor->set_voltage(voltage);
+        }
+
+        pros::delay(SYSID_SAMPLE_PERIOD);
+        record_sample(motors, params.log_data);
+    }
+
+    return 1;
+}
+
+
+void SystemId::settle( std::vector<Motor*> motors )
+{
+    for ( Motor *motor : motors )
+    {
+        motor->set_voltage(0);
+    }
+
+    std::uint32_t start_time = pros::millis();
+    bool moving = true;
+    while ( moving && pros::millis() - start_time < SYSID_SETTLE_TIMEOUT && !stop_requested )
+    {
+        pros::delay(SYSID_SAMPLE_PERIOD);
+        moving = false;
+        for ( Motor *motor : motors )
+        {
+            if ( std::abs(motor->get_estimated_velocity()) > 1 )
+            {
+                moving = true;
+            }
+        }
+    }
+}
+
+
+int SystemId::run( std::vector<Motor*> motors, sysid_params params )
+{
+    if ( motors.empty() || running.exchange(true) )
+    {
+        return 0;
+    }
+    stop_requested = false;
+
+    samples.clear();
+    samples.reserve(SYSID_MAX_SAMPLES);
+
+    std::vector<bool> slew_enabled;  // restored when the tests are done
+    std::vector<motor_mode> modes;
+    for ( Motor *motor : motors )
+    {
+        slew_enabled.push_back(motor->is_slew_enabled());
+        modes.push_back(motor->get_motor_mode());
+
+        motor->disable_driver_control();
+        motor->disable_slew();
+        motor->set_motor_mode(e_voltage);
+    }
+
+    int finished = 1;
+    for ( int direction : {1, -1} )
+    {
+        settle(motors);
+        finished = finished && ramp_voltage(motors, direction, params);
+
+        settle(motors);
+        finished = finished && hold_voltage(motors, direction * params.step_voltage, params.step_duration, true, params.log_data);
+    }
+    settle(motors);
+
+    for ( int i = 0; i < motors.size(); i++ )
+    {
+        motors.at(i)->set_motor_mode(modes.at(i));
+        if ( slew_enabled.at(i) )
+        {
+            motors.at(i)->enable_slew();
+        }
+        motors.at(i)->enable_driver_control();
+    }
+
+    Logger logger;
+    log_entry entry;
+    entry.stream = "clog";
+    if ( !finished )
+    {
+        entry.content = "[INFO], " + std::to_string(pros::millis()) + ", system identification stopped";
+        logger.add(entry);
+
+        running = false;
+        return 0;
+    }
+
+    motor_model fitted = fit(samples);
+    model.publish(fitted);
+
+    entry.content = (
+        "[INFO] SYSID_MODEL"
+        ", Time: " + std::to_string(pros::millis())
+        + ", Port: " + std::to_string(motors.at(0)->get_port())
+        + ", kS: " + std::to_string(fitted.ff.kS)
+        + ", kV: " + std::to_string(fitted.ff.kV)
+        + ", kA: " + std::to_string(fitted.ff.kA)
+        + ", Time_Constant: " + std::to_string(fitted.time_constant)
+        + ", R_Squared: " + std::to_string(fitted.r_squared)
+        + ", Samples: " + std::to_string(fitted.samples)
+    );
+    logger.add(entry);
+
+    if ( params.save && fitted.samples > 0 )
+    {
+        save_model(SYSID_MODEL_PATH + std::to_string(motors.at(0)->get_port()) + ".txt", fitted);
+    }
+
+    running = false;
+    return fitted.samples > 0;
+}
+
+
+void SystemId::sysid_task( void* )
+{
+    SystemId::get_instance()->run(test_motors, test_params);
+}
+
+
+int SystemId::start( std::vector<Motor*> motors, sysid_params params )
+{
+    if ( running )
+    {
+        return 0;
+    }
+
+    if ( thread != NULL )  // last test has finished
+    {
+        delete thread;
+    }
+
+    test_motors = motors;
+    test_params = params;
+    thread = new pros::Task( sysid_task, (void*)NULL, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, "sysid_thread");
+
+    return 1;
+}
+
+
+void SystemId::stop( )
+{
+    stop_requested = true;
+}
+
+
+bool SystemId::is_running( )
+{
+    return running;
+}
+
+
+motor_model SystemId::get_model( )
+{
+    return model.read();
+}
+
+
+
+
+/**
+ * solves the 3x3 normal equations with gaussian elimination
+ * samples that are barely moving are left out because static friction does
+ * not follow the model there
+ */
+motor_model SystemId::fit( const std::vector<sysid_sample> &data )
+{
+    motor_model fitted = {};
+
+    double ata[3][3] = {};
+    double atb[3] = {};
+    int used = 0;
+    double voltage_sum = 0;
+    for ( const sysid_sample &sample : data )
+    {
+        if ( std::abs(sample.velocity) < SYSID_MIN_VELOCITY )
+        {
+            continue;
+        }
+
+        double row[3] = {(double)((sample.velocity > 0) - (sample.velocity < 0)), sample.velocity, sample.acceleration};
+        for ( int i = 0; i < 3; i++ )
+        {
+            for ( int j = 0; j < 3; j++ )
+            {
+                ata[i][j] += row[i] * row[j];
+            }
+            atb[i] += row[i] * sample.voltage;
+        }
+        voltage_sum += sample.voltage;
+        used += 1;
+    }
+
+    if ( used < 3 )
+    {
+        return fitted;
+    }
+
+    for ( int col = 0; col < 3; col++ )
+    {
+        int pivot = col;
+        for ( int row = col + 1; row < 3; row++ )
+        {
+            if ( std::abs(ata[row][col]) > std::abs(ata[pivot][col]) )
+            {
+                pivot = row;
+            }
+        }
+        if ( std::abs(ata[pivot][col]) < 1e-9 )
+        {
+            return fitted;  // tests did not excite every term, ie. no acceleration
+        }
+
+        std::swap(ata[col], ata[pivot]);
+        std::swap(atb[col], atb[pivot]);
+        for ( int row = col + 1; row < 3; row++ )
+        {
+            double factor = ata[row][col] / ata[col][col];
+            for ( int k = col; k < 3; k++ )
+            {
+                ata[row][k] -= factor * ata[col][k];
+            }
+            atb[row] -= factor * atb[col];
+        }
+    }
+
+    double solution[3];
+    for ( int row = 2; row >= 0; row-- )
+    {
+        double sum = atb[row];
+        for ( int k = row + 1; k < 3; k++ )
+        {
+            sum -= ata[row][k] * solution[k];
+        }
+        solution[row] = sum / ata[row][row];
+    }
+
+    fitted.ff.kS = solution[0];
+    fitted.ff.kV = solution[1];
+    fitted.ff.kA = solution[2];
+    fitted.time_constant = fitted.ff.kV != 0 ? fitted.ff.kA / fitted.ff.kV : 0;
+    fitted.samples = used;
+
+    double mean = voltage_sum / used;
+    double residual_sum = 0;
+    double total_sum = 0;
+    for ( const sysid_sample &sample : data )
+    {
+        if ( std::abs(sample.velocity) < SYSID_MIN_VELOCITY )
+        {
+            continue;
+        }
+
+        int sign = (sample.velocity > 0) - (sample.velocity < 0);
+        double predicted = (fitted.ff.kS * sign) + (fitted.ff.kV * sample.velocity) + (fitted.ff.kA * sample.acceleration);
+        residual_sum += std::pow(sample.voltage - predicted, 2);
+        total_sum += std::pow(sample.voltage - mean, 2);
+    }
+    fitted.r_squared = total_sum > 0 ? 1 - (residual_sum / total_sum) : 0;
+
+    return fitted;
+}
+
+
+std::string SystemId::format_sample( const sysid_sample &sample )
+{
+    return (
+        "[INFO] SYSID"
+        ", Time: " + std::to_string(sample.time)
+        + ", Voltage: " + std::to_string(sample.voltage)
+        + ", Velocity: " + std::to_string(sample.velocity)
+        + ", Acceleration: " + std::to_string(sample.acceleration)
+    );
+}
+
+
+int SystemId::parse_sample( const std::string &line, sysid_sample &sample )
+{
+    std::size_t start = line.find("[INFO] SYSID,");
+    if ( start == std::string::npos )
+    {
+        return 0;
+    }
+
+    unsigned long time;
+    double voltage, velocity, acceleration;
+    int read = std::sscanf(
+        line.c_str() + start,
+        "[INFO] SYSID, Time: %lu, Voltage: %lf, Velocity: %lf, Acceleration: %lf",
+        &time, &voltage, &velocity, &acceleration
+    );
+    if ( read != 4 )
+    {
+        return 0;
+    }
+
+    sample.time = time;
+    sample.voltage = voltage;
+    sample.velocity = velocity;
+    sample.acceleration = acceleration;
+
+    return 1;
+}
+
+
+int SystemId::save_model( std::string path, motor_model fitted )
+{
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if ( file == NULL )
+    {
+        Logger logger;
+        log_entry entry;
+        entry.content = "[ERROR], " + std::to_string(pros::millis()) + ", could not save motor model to " + path;
+        entry.stream = "cerr";
+        logger.add(entry);
+
+        return 0;
+    }
+
+    // kS kV kA time_constant r_squared samples
+    std::fprintf(
+        file, "%f %f %f %f %f %d\n",
+        fitted.ff.kS, fitted.ff.kV, fitted.ff.kA, fitted.time_constant, fitted.r_squared, fitted.samples
+    );
+    std::fclose(file);
+
+    return 1;
+}
+
+
+int SystemId::load_model( std::string path, motor_model &fitted )
+{
+    std::FILE *file = std::fopen(path.c_str(), "r");
+    if ( file == NULL )
+    {
+        return 0;
+    }
+
+    motor_model loaded = {};
+    int read = std::fscanf(
+        file, "%lf %lf %lf %lf %lf %d",
+        &loaded.ff.kS, &loaded.ff.kV, &loaded.ff.kA, &loaded.time_constant, &loaded.r_squared, &loaded.samples
+    );
+    std::fclose(file);
+
+    if ( read != 6 )
+    {
+        return 0;
+    }
+
+    fitted = loaded;
+    return 1;
+}
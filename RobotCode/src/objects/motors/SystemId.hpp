@@ -0,0 +1,217 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/SystemId.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains a class that runs voltage tests on motors and fits a model of
+ * them that feedforward and pid gains can be derived from
+ */
+
+#ifndef __SYSTEMID_HPP__
+#define __SYSTEMID_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "main.h"
+
+#include "../../Configuration.hpp"
+#include "Mailbox.hpp"
+#include "Motor.hpp"
+
+
+#define SYSID_SAMPLE_PERIOD    10     // ms, motors report every 10ms
+#define SYSID_MIN_VELOCITY     5      // rpm, slower samples are sticking and are left out of the fit
+#define SYSID_SETTLE_TIMEOUT   2000   // ms, longest wait for the motors to stop between tests
+#define SYSID_MAX_SAMPLES      4096
+#define SYSID_MODEL_PATH       "/usd/sysid_"  // followed by the port of the first motor and .txt
+
+
+typedef struct
+{
+    int ramp_rate=1000;       // mV/s, slow enough that acceleration is negligible
+    int ramp_voltage=8000;    // mV, ramp stops here
+    int step_voltage=6000;    // mV
+    int step_duration=1000;   // ms
+    bool log_data=true;       // log every sample so the fit can be redone on the host
+    bool save=true;           // write the model to the sd card
+} sysid_params;
+
+
+typedef struct
+{
+    std::uint32_t time;   // ms
+    double voltage;       // mV
+    double velocity;      // rpm
+    double acceleration;  // rpm/s
+} sysid_sample;
+
+
+/**
+ * voltage = kS * sign(velocity) + kV * velocity + kA * acceleration
+ * the time constant of the first order response to a step is kA / kV
+ */
+typedef struct
+{
+    feedforward ff;
+    double time_constant;  // s
+    double r_squared;      // how much of the voltage the model explains, 1 is a perfect fit
+    int samples;           // used in the fit, 0 if it failed
+} motor_model;
+
+
+/**
+ * @see: Motor.hpp
+ * @see: ../../../sim/tools/sysid_fit.cpp
+ *
+ * singleton that identifies a motor, or several motors that move together
+ * like a side of the chassis
+ *
+ * runs a quasi-static ramp then a step in each direction while recording
+ * the voltage, velocity, and acceleration of the motors, then fits kS, kV,
+ * and kA with least squares. Every sample is logged in a format parse_sample()
+ * reads so the same fit can be run on the host against a log
+ */
+class SystemId
+{
+    private:
+        SystemId();
+        static SystemId *sysid_obj;
+
+        static std::atomic<bool> running;
+        static std::atomic<bool> stop_requested;
+        static pros::Task *thread;
+
+        static std::vector<Motor*> test_motors;  // for the task started by start()
+        static sysid_params test_params;
+
+        static std::vector<sysid_sample> samples;
+        static Mailbox<motor_model> model;
+
+        /**
+         * @param: std::vector<Motor*> motors -> the motors under test
+         * @param: bool log_data -> log the sample
+         * @return: None
+         *
+         * averages the motors into one sample and records it
+         */
+        static void record_sample( std::vector<Motor*> motors, bool log_data );
+
+        /**
+         * @param: std::vector<Motor*> motors -> the motors under test
+         * @param: int voltage -> the voltage in mV to hold
+         * @param: int duration -> ms to hold it for
+         * @param: bool record -> record samples while holding
+         * @param: bool log_data -> log each sample
+         * @return: int -> 1 if finished, 0 if stopped early
+         */
+        static int hold_voltage( std::vector<Motor*> motors, int voltage, int duration, bool record, bool log_data );
+
+        /**
+         * @param: std::vector<Motor*> motors -> the motors under test
+         * @param: int direction -> 1 or -1
+         * @param: const sysid_params &params -> ramp rate and limit
+         * @return: int -> 1 if finished, 0 if stopped early
+         */
+        static int ramp_voltage( std::vector<Motor*> motors, int direction, const sysid_params &params );
+
+        /**
+         * @param: std::vector<Motor*> motors -> the motors under test
+         * @return: None
+         *
+         * stops the motors and waits for them to come to rest
+         */
+        static void settle( std::vector<Motor*> motors );
+
+        /**
+         * @param: void* -> not used, but necessary to follow thread making constructor
+         * @return: None
+         *
+         * runs the test started by start()
+         */
+        static void sysid_task( void* );
+
+
+    public:
+        /**
+         * @return: SystemId -> instance of class to be used throughout program
+         *
+         * give the instance of the singleton class or creates it if it does
+         * not yet exist
+         */
+        static SystemId* get_instance();
+
+        /**
+         * @param: std::vector<Motor*> motors -> motors to test together, they should drive the same mechanism
+         * @param: sysid_params params -> test voltages and durations
+         * @return: int -> 1 if the model was fit, 0 if a test is already running, was stopped, or the fit failed
+         *
+         * blocks until the tests finish, driver control is disabled on the
+         * motors while they run
+         */
+        int run( std::vector<Motor*> motors, sysid_params params={} );
+
+        /**
+         * @param: std::vector<Motor*> motors -> motors to test together
+         * @param: sysid_params params -> test voltages and durations
+         * @return: int -> 1 if the test was started, 0 if one is already running
+         *
+         * runs the tests in their own task so the caller is not blocked
+         */
+        int start( std::vector<Motor*> motors, sysid_params params={} );
+
+        /**
+         * @return: None
+         *
+         * ends the running test, no model is fit
+         */
+        void stop( );
+
+        bool is_running( );
+
+        /**
+         * @return: motor_model -> the last model that was fit
+         */
+        motor_model get_model( );
+
+    //fitting, these do not use the robot and are also built for the host
+
+        /**
+         * @param: const std::vector<sysid_sample> &data -> samples from the tests
+         * @return: motor_model -> least squares fit, samples is 0 if it could not be fit
+         */
+        static motor_model fit( const std::vector<sysid_sample> &data );
+
+        /**
+         * @param: const sysid_sample &sample -> the sample to format
+         * @return: std::string -> the log line for the sample
+         */
+        static std::string format_sample( const sysid_sample &sample );
+
+        /**
+         * @param: const std::string &line -> a line from a log
+         * @param: sysid_sample &sample -> filled in if the line is a sample
+         * @return: int -> 1 if the line is a sample, 0 otherwise
+         */
+        static int parse_sample( const std::string &line, sysid_sample &sample );
+
+        /**
+         * @param: std::string path -> the file to write
+         * @param: motor_model fitted -> the model to save
+         * @return: int -> 1 if the file was written, 0 otherwise
+         */
+        static int save_model( std::string path, motor_model fitted );
+
+        /**
+         * @param: std::string path -> the file to read
+         * @param: motor_model &fitted -> filled in from the file
+         * @return: int -> 1 if the file was read, 0 otherwise
+         */
+        static int load_model( std::string path, motor_model &fitted );
+};
+
+
+#endif
@@ -0,0 +1,120 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/VelocityEstimator.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains implementation for the motor velocity estimator
+ */
+
+#include <cstdint>
+
+#include "main.h"
+#include "okapi/api.hpp"
+
+#include "VelocityEstimator.hpp"
+
+
+VelocityEstimator::VelocityEstimator()
+{
+    filter_type = e_kalman_filter;
+    kalman = NULL;
+    reset();
+}
+
+
+VelocityEstimator::~VelocityEstimator()
+{
+    delete kalman;
+}
+
+
+
+void VelocityEstimator::update( double encoder_position, std::uint32_t timestamp )
+{
+    if ( !initialized )
+    {
+        prev_position = encoder_position;
+        position = encoder_position;
+        prev_timestamp = timestamp;
+        initialized = true;
+        return;
+    }
+
+    double dt = timestamp - prev_timestamp;  // ms
+    if ( dt <= 0 )
+    {
+        return;
+    }
+
+    double measured_velocity = ((encoder_position - prev_position) / dt) * DEGREES_PER_MS_TO_RPM;
+    double prev_velocity = velocity;
+
+    switch ( filter_type )
+    {
+        case e_ema_filter:
+            velocity = (VELOCITY_EMA_ALPHA * measured_velocity) + ((1 - VELOCITY_EMA_ALPHA) * velocity);
+            break;
+
+        case e_alpha_beta_filter: {
+            double predicted = position + ((velocity / DEGREES_PER_MS_TO_RPM) * dt);
+            double residual = encoder_position - predicted;
+            position = predicted + (VELOCITY_ALPHA * residual);
+            velocity = velocity + ((VELOCITY_BETA * residual / dt) * DEGREES_PER_MS_TO_RPM);
+            break;
+
+        } case e_kalman_filter:
+            // the acceleration estimate is the control input so the prediction
+            // keeps up with the motor while it speeds up
+            velocity = kalman->filter(measured_velocity, acceleration * dt / 1000);
+            break;
+    }
+
+    double measured_acceleration = (velocity - prev_velocity) * 1000 / dt;
+    acceleration = (ACCELERATION_EMA_ALPHA * measured_acceleration) + ((1 - ACCELERATION_EMA_ALPHA) * acceleration);
+
+    prev_position = encoder_position;
+    prev_timestamp = timestamp;
+}
+
+
+void VelocityEstimator::reset( )
+{
+    delete kalman;
+    kalman = new okapi::EKFFilter(VELOCITY_KALMAN_Q, VELOCITY_KALMAN_R);
+
+    initialized = false;
+    prev_position = 0;
+    prev_timestamp = 0;
+    position = 0;
+    velocity = 0;
+    acceleration = 0;
+}
+
+
+void VelocityEstimator::rezero( )
+{
+    initialized = false;
+}
+
+
+void VelocityEstimator::set_filter( velocity_filter new_filter )
+{
+    if ( new_filter != filter_type )
+    {
+        filter_type = new_filter;
+        reset();
+    }
+}
+
+
+double VelocityEstimator::get_velocity( )
+{
+    return velocity;
+}
+
+
+double VelocityEstimator::get_acceleration( )
+{
+    return acceleration;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file: ./RobotCode/src/objects/motors/VelocityEstimator.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains a class that estimates velocity and acceleration of a motor from
+ * its encoder position
+ */
+
+#ifndef __VELOCITYESTIMATOR_HPP__
+#define __VELOCITYESTIMATOR_HPP__
+
+#include <cstdint>
+
+#include "main.h"
+#include "okapi/api.hpp"
+
+
+#define VELOCITY_EMA_ALPHA      0.7   // weight of the newest finite difference
+#define VELOCITY_ALPHA          0.8   // alpha beta position correction
+#define VELOCITY_BETA           0.4   // alpha beta velocity correction
+#define VELOCITY_KALMAN_Q       25    // rpm^2, how much the velocity can change between samples beyond the acceleration estimate
+#define VELOCITY_KALMAN_R       16    // rpm^2, noise of the finite difference
+#define ACCELERATION_EMA_ALPHA  0.2   // weight of the newest change in velocity
+#define DEGREES_PER_MS_TO_RPM   (1000.0 * 60 / 360)
+
+
+typedef enum {
+    e_ema_filter,
+    e_alpha_beta_filter,
+    e_kalman_filter
+} velocity_filter;
+
+
+/**
+ * @see: MotorThread::sample_telemetry()
+ *
+ * fed the encoder position and the time it was read every time the motor
+ * thread samples a motor. The firmware velocity is averaged over a longer
+ * window and lags, this gives a velocity that responds in one sample
+ *
+ * ema and kalman filter the finite difference of the position, alpha beta
+ * tracks the position itself and corrects its velocity from the error in the
+ * predicted position. Acceleration is a smoothed finite difference of the
+ * velocity estimate for every filter
+ *
+ * only used by the motor thread
+ */
+class VelocityEstimator
+{
+    private:
+        velocity_filter filter_type;
+        okapi::EKFFilter *kalman;
+
+        bool initialized;
+        double prev_position;  // degrees
+        std::uint32_t prev_timestamp;
+        double position;       // degrees, alpha beta estimate
+        double velocity;       // rpm
+        double acceleration;   // rpm/s
+
+    public:
+        VelocityEstimator();
+        ~VelocityEstimator();
+
+        /**
+         * @param: double encoder_position -> position of the motor in degrees
+         * @param: std::uint32_t timestamp -> time in ms the position was read
+         * @return: None
+         *
+         * samples taken in the same ms as the last one are skipped
+         */
+        void update( double encoder_position, std::uint32_t timestamp );
+
+        /**
+         * @return: None
+         *
+         * forgets the previous position and zeroes the estimates, the next
+         * update only sets the reference position
+         */
+        void reset( );
+
+        /**
+         * @return: None
+         *
+         * keeps the estimates but takes the next position as the new reference
+         * used when the encoder is tared
+         */
+        void rezero( );
+
+        /**
+         * @param: velocity_filter new_filter -> the filter to use
+         * @return: None
+         *
+         * resets the estimator if the filter changes
+         */
+        void set_filter( velocity_filter new_filter );
+
+        /**
+         * @return: double -> velocity in rpm
+         */
+        double get_velocity( );
+
+        /**
+         * @return: double -> acceleration in rpm/s
+         */
+        double get_acceleration( );
+};
+
+
+#endif
@@ -8,7 +8,9 @@
  * contains implementation for functions that track position
  */
 
+#include <algorithm>
 #include <atomic>
+#include <cstdio>
 
 #include "main.h"
 
@@ -192,64 +194,56 @@ void PositionTracker::calc_position(void*)
         current_position.theta = new_abs_theta_rad;
 
 
-        Logger logger;
-        log_entry entry;
-
-        for(int i = 0; i <= log_level; i++) {
-            switch(i) {
-                case 0:
-                    entry.content = "";
-                    break;
-                case 1:
-                    entry.content += ("[INFO], " + std::string("Position Tracking Data")
-                        + ", Time: " + std::to_string(pros::millis())
-                        + ", X_POS: " + std::to_string(current_position.x_pos)
-                        + ", Y_POS: " + std::to_string(current_position.y_pos)
-                        + ", Angle: " + std::to_string(to_degrees(current_position.theta))
-                    );
-                    break;
-                case 2:
-                    entry.content += (
-                        "angle_from_imu_radians: " + std::to_string(imu_reading_rad)
-                        + "angle_from_encoders_radians: " + std::to_string(encoder_reading_rad)
-                        + "angle_from_imu_degrees: " + std::to_string(to_degrees(imu_reading_rad))
-                        + "angle_from_encoders_degrees: " + std::to_string(to_degrees(encoder_reading_rad))
-                    );
-                    break;
-                case 3:
-                    entry.content += (
-                        "local_delta_y: " + std::to_string(delta_local_y)
-                        + "local_delta_x: " + std::to_string(delta_local_x)
-                        + "global_delta_y: " + std::to_string(delta_global_y)
-                        + "global_delta_x: " + std::to_string(delta_global_x)
-                    );
-                    break;
-                case 4:
-                    entry.content += (
-                        "l_enc: " + std::to_string(l_enc)
-                        + "r_enc: " + std::to_string(r_enc)
-                        + "s_enc: " + std::to_string(s_enc)
-                        + "delta_l_enc_in: " + std::to_string(delta_l_in)
-                        + "delta_r_enc_in: " + std::to_string(delta_r_in)
-                        + "delta_s_enc_in: " + std::to_string(delta_s_in)
-                    );
-                    break;
-                case 5:
-                    if(use_imu) {
-                        entry.content += (
-                            "imu_reading: " + std::to_string(Sensors::imu.get_heading())
-                            + "imu_offset: " + std::to_string(imu_offset)
+        if constexpr ( LOG_COMPILED(1) ) {  // nothing is built when logging is compiled out
+            char content[LOGGER_RECORD_SIZE];  // levels append to one entry, built here so nothing is allocated
+            int length = 0;
+            for(int i = 0; i <= std::min(log_level, LOG_LEVEL_MAX) && length < (int)sizeof(content); i++) {
+                char *end = content + length;
+                int remaining = sizeof(content) - length;
+                switch(i) {
+                    case 0:
+                        content[0] = '\0';
+                        break;
+                    case 1:
+                        length += std::snprintf(end, remaining,
+                            "[INFO], Position Tracking Data, Time: %u, X_POS: %Lf, Y_POS: %Lf, Angle: %Lf",
+                            (unsigned int)pros::millis(), current_position.x_pos, current_position.y_pos, to_degrees(current_position.theta)
                         );
-                    }
-                    break;
+                        break;
+                    case 2:
+                        length += std::snprintf(end, remaining,
+                            "angle_from_imu_radians: %Lfangle_from_encoders_radians: %Lfangle_from_imu_degrees: %Lfangle_from_encoders_degrees: %Lf",
+                            imu_reading_rad, encoder_reading_rad, to_degrees(imu_reading_rad), to_degrees(encoder_reading_rad)
+                        );
+                        break;
+                    case 3:
+                        length += std::snprintf(end, remaining,
+                            "local_delta_y: %Lflocal_delta_x: %Lfglobal_delta_y: %Lfglobal_delta_x: %Lf",
+                            delta_local_y, delta_local_x, delta_global_y, delta_global_x
+                        );
+                        break;
+                    case 4:
+                        length += std::snprintf(end, remaining,
+                            "l_enc: %Lfr_enc: %Lfs_enc: %Lfdelta_l_enc_in: %Lfdelta_r_enc_in: %Lfdelta_s_enc_in: %Lf",
+                            l_enc, r_enc, s_enc, delta_l_in, delta_r_in, delta_s_in
+                        );
+                        break;
+                    case 5:
+                        if(use_imu) {
+                            length += std::snprintf(end, remaining,
+                                "imu_reading: %fimu_offset: %Lf", Sensors::imu.get_heading(), imu_offset
+                            );
+                        }
+                        break;
+                }
+            }
+
+            if(length > 0) {
+                Logger logger;
+                logger.add(e_log_source_tracker, e_log_clog, "%s", content);
             }
         }
-        
-        entry.stream = "clog";
-        if(!entry.content.empty()) {
-            logger.add(entry);
-        }
-        
+
         lock.exchange(false);
         
         pros::delay(5);
@@ -95,6 +95,12 @@ class PositionTracker
         
         void kill_thread();
         
+        /**
+         * @param: int log_lvl -> 0-5, 5 is most verbose
+         * @return: None
+         *
+         * levels above LOG_LEVEL_MAX are not compiled in and log nothing
+         */
         void set_log_level(int log_lvl);
 
         void enable_imu();
@@ -0,0 +1,153 @@
+/**
+ * @file: ./RobotCode/src/objects/serial/FrameReader.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * @see FrameReader.hpp
+ *
+ * contains implementation for the server request parser
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "FrameReader.hpp"
+
+
+FrameReader::FrameReader() : head(0), tail(0), frame_size(0)
+{
+    std::memset(&stats, 0, sizeof(stats));
+}
+
+
+
+std::uint8_t FrameReader::at( int offset )
+{
+    return buffer[(tail + offset) % SERVER_RX_BUFFER_SIZE];
+}
+
+
+void FrameReader::skip( int bytes )
+{
+    tail += bytes;
+    stats.skipped_bytes += bytes;
+}
+
+
+
+int FrameReader::write( const std::uint8_t *data, int length )
+{
+    int written = std::min(length, space());
+    int index = head % SERVER_RX_BUFFER_SIZE;
+    int first = std::min(written, SERVER_RX_BUFFER_SIZE - index);  // up to the end of the buffer
+    std::memcpy(buffer + index, data, first);
+    std::memcpy(buffer, data + first, written - first);
+    head += written;
+
+    stats.overflowed_bytes += length - written;
+    return written;
+}
+
+
+
+/**
+ * the preamble and length are checked a byte at a time as they arrive so
+ * garbage is skipped right away, after that nothing is looked at again until
+ * the whole frame is in the buffer
+ */
+int FrameReader::next_frame( server_request_record &request )
+{
+    while ( true )
+    {
+        int available = size();
+        if ( frame_size == 0 )
+        {
+            if ( available < 1 )
+            {
+                return 0;
+            }
+            else if ( at(0) != SERVER_PREAMBLE1 )
+            {
+                skip(1);
+                continue;
+            }
+            else if ( available < 2 )
+            {
+                return 0;
+            }
+            else if ( at(1) != SERVER_PREAMBLE2 )
+            {
+                skip(1);
+                continue;
+            }
+            else if ( available < 3 )
+            {
+                return 0;
+            }
+            else if ( at(2) != SERVER_PREAMBLE3 )
+            {
+                skip(1);
+                continue;
+            }
+            else if ( available < 4 )
+            {
+                return 0;
+            }
+            else if ( at(3) < SERVER_HEADER_SIZE - 4 )  // too short for the ids
+            {
+                stats.bad_frames += 1;
+                skip(1);
+                continue;
+            }
+
+            frame_size = 4 + at(3) + 1;
+        }
+
+        if ( available < frame_size )  // rest of the frame comes with a later read
+        {
+            return 0;
+        }
+
+        if ( at(frame_size - 1) != SERVER_CHECKSUM )
+        {
+            stats.bad_frames += 1;
+            frame_size = 0;
+            skip(1);  // another frame could start inside this one
+            continue;
+        }
+
+        request.return_id = (at(4) << 8) | at(5);
+        request.command_id = (at(6) << 8) | at(7);
+        request.length = frame_size - SERVER_HEADER_SIZE - 1;
+        std::uint32_t start = (tail + SERVER_HEADER_SIZE) % SERVER_RX_BUFFER_SIZE;
+        int before_wrap = std::min<int>(request.length, SERVER_RX_BUFFER_SIZE - start);
+        std::memcpy(request.msg, buffer + start, before_wrap);
+        std::memcpy(request.msg + before_wrap, buffer, request.length - before_wrap);  // nothing unless the msg wraps
+
+        tail += frame_size;
+        frame_size = 0;
+        stats.frames += 1;
+        return 1;
+    }
+}
+
+
+
+int FrameReader::space( )
+{
+    return SERVER_RX_BUFFER_SIZE - size();
+}
+
+
+int FrameReader::size( )
+{
+    return head - tail;
+}
+
+
+frame_reader_stats FrameReader::get_stats( )
+{
+    return stats;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file: ./RobotCode/src/objects/serial/FrameReader.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains class that buffers bytes read from serial and parses server
+ * requests out of them
+ */
+
+#ifndef __FRAMEREADER_HPP__
+#define __FRAMEREADER_HPP__
+
+#include <cstdint>
+
+
+#define SERVER_RX_BUFFER_SIZE  1024  // power of two so positions wrap cleanly, fits a few of the largest frames
+#define SERVER_READ_BLOCK      128   // max bytes taken from stdin by one read
+#define SERVER_PREAMBLE1       0xAA
+#define SERVER_PREAMBLE2       0x55
+#define SERVER_PREAMBLE3       0x1E
+#define SERVER_CHECKSUM        0xC6
+#define SERVER_HEADER_SIZE     8     // preamble, length, return id, and command id
+#define SERVER_MAX_FRAME       260   // preamble, length, 255 bytes counted by the length, and checksum
+#define SERVER_MAX_MSG         251   // bytes a request's length can count after the ids
+
+
+typedef struct
+{
+    std::uint16_t return_id;
+    std::uint16_t command_id;
+    std::uint16_t length;  // bytes in msg
+    char msg[SERVER_MAX_MSG];
+} server_request_record;
+
+
+typedef struct
+{
+    std::uint32_t frames;            // requests parsed
+    std::uint32_t bad_frames;        // preambles that were not followed by a valid frame
+    std::uint32_t skipped_bytes;     // bytes that were not part of a frame
+    std::uint32_t overflowed_bytes;  // bytes that did not fit in the buffer
+} frame_reader_stats;
+
+
+/**
+ * Contains a ring buffer that serial reads are written to in blocks and the
+ * parser that takes requests out of it
+ *
+ * a request is
+ *     0xAA 0x55 0x1E length return_id(u16) command_id(u16) msg checksum
+ * where length counts the ids and the msg, ids are big endian and the
+ * checksum is always 0xC6
+ *
+ * parsing picks up where it left off so a frame can arrive over any number
+ * of reads. When a preamble is not followed by a valid frame only its first
+ * byte is skipped and the search starts again from the next one, so a frame
+ * that starts inside a corrupt one is still found
+ *
+ * one task writes and parses, nothing is locked
+ */
+class FrameReader
+{
+    private:
+        std::uint8_t buffer[SERVER_RX_BUFFER_SIZE];
+        std::uint32_t head;  // position the next byte is written to
+        std::uint32_t tail;  // position of the first byte that is not parsed
+        int frame_size;      // bytes in the frame at the tail once its header is checked, 0 while looking for one
+        frame_reader_stats stats;
+
+        /**
+         * @param: int offset -> bytes after the tail
+         * @return: std::uint8_t -> the byte
+         */
+        std::uint8_t at( int offset );
+
+        /**
+         * @param: int bytes -> bytes that are not part of a frame
+         * @return: None
+         */
+        void skip( int bytes );
+
+    public:
+        FrameReader();
+
+        /**
+         * @param: const std::uint8_t *data -> bytes read from serial
+         * @param: int length -> number of bytes
+         * @return: int -> bytes written, the rest did not fit and are counted as overflowed
+         */
+        int write( const std::uint8_t *data, int length );
+
+        /**
+         * @param: server_request_record &request -> set to the next request if there is one
+         * @return: int -> 1 if a request was parsed, 0 if more bytes are needed
+         *
+         * the msg is copied straight out of the buffer, request is left as
+         * it was if there is no request
+         */
+        int next_frame( server_request_record &request );
+
+        /**
+         * @return: int -> bytes that can be written
+         */
+        int space( );
+
+        /**
+         * @return: int -> bytes written that are not parsed yet
+         */
+        int size( );
+
+        /**
+         * @return: frame_reader_stats -> frame and byte counters
+         */
+        frame_reader_stats get_stats( );
+};
+
+
+
+#endif
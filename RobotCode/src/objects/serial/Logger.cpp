@@ -9,19 +9,72 @@
  * contains implementation for the logger class
  */
 
+#include <algorithm>
 #include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
-#include <queue>
 #include <string>
-#include <vector>
 
 #include "main.h"
 
 #include "Logger.hpp"
 
-std::queue<log_entry> Logger::logger_queue;
-std::atomic<bool> Logger::lock = ATOMIC_VAR_INIT(false);
+
+namespace
+{
+    void raise_to( std::atomic<int> &high_water, int value )
+    {
+        int current = high_water.load(std::memory_order_relaxed);
+        while ( value > current && !high_water.compare_exchange_weak(current, value, std::memory_order_relaxed) );
+    }
+}
+
+
+RecordRing<log_record, LOGGER_RECORDS> Logger::ring;
+std::atomic<bool> Logger::draining = ATOMIC_VAR_INIT(false);
+std::uint32_t Logger::reported_dropped = 0;
 bool Logger::use_queue = true;
+pros::Task *Logger::drain_thread = NULL;
+
+char Logger::batch[LOGGER_BATCH_SIZE];
+int Logger::batch_length = 0;
+log_stream Logger::batch_stream = e_log_cout;
+bool Logger::batch_to_file = false;
+std::atomic<std::uint32_t> Logger::entries_written = ATOMIC_VAR_INIT(0);
+std::atomic<std::uint32_t> Logger::bytes_written = ATOMIC_VAR_INIT(0);
+std::atomic<std::uint32_t> Logger::batches_written = ATOMIC_VAR_INIT(0);
+std::atomic<std::uint32_t> Logger::throughput = ATOMIC_VAR_INIT(0);
+std::atomic<std::uint32_t> Logger::drain_period = ATOMIC_VAR_INIT(LOGGER_DRAIN_PERIOD);
+
+std::FILE *Logger::file = NULL;
+std::atomic<int> Logger::file_number = ATOMIC_VAR_INIT(-1);
+char Logger::file_block[LOGGER_FILE_BLOCK];
+int Logger::file_block_length = 0;
+std::atomic<std::uint32_t> Logger::file_committed = ATOMIC_VAR_INIT(0);
+std::uint32_t Logger::file_opened_at = 0;
+std::uint32_t Logger::file_last_write = 0;
+std::atomic<std::uint32_t> Logger::file_errors = ATOMIC_VAR_INIT(0);
+std::atomic<int> Logger::file_request = ATOMIC_VAR_INIT(e_log_file_none);
+std::atomic<bool> Logger::request_lock = ATOMIC_VAR_INIT(false);
+char Logger::requested_prefix[LOGGER_FILE_PATH_SIZE];
+
+std::atomic<int> Logger::high_water = ATOMIC_VAR_INIT(0);
+std::atomic<int> Logger::source_policy[LOGGER_SOURCES] = {
+    {e_log_drop_newest}, {e_log_drop_newest}, {e_log_drop_newest}, {e_log_drop_newest}, {e_log_drop_newest}
+};
+std::atomic<int> Logger::source_capacity[LOGGER_SOURCES] = {
+    {LOGGER_RECORDS}, {LOGGER_MOTOR_CAPACITY}, {LOGGER_RECORDS}, {LOGGER_RECORDS}, {LOGGER_RECORDS}
+};
+std::atomic<int> Logger::source_sample_every[LOGGER_SOURCES] = { {1}, {1}, {1}, {1}, {1} };
+std::atomic<std::uint32_t> Logger::source_seen[LOGGER_SOURCES] = { };
+std::atomic<std::uint32_t> Logger::source_accepted[LOGGER_SOURCES] = { };
+std::atomic<std::uint32_t> Logger::source_dropped[LOGGER_SOURCES] = { };
+std::atomic<int> Logger::source_depth[LOGGER_SOURCES] = { };
+std::atomic<int> Logger::source_high_water[LOGGER_SOURCES] = { };
+std::atomic<int> Logger::source_stale[LOGGER_SOURCES] = { };
 
 
 Logger::Logger() { }
@@ -35,26 +88,47 @@ Logger::~Logger() { }
 
 
 /**
- * fsends data on the given stream based on the log entry
+ * sends data on the given stream based on the log entry
  */
-bool Logger::log( log_entry entry ) {
-    if ( entry.stream == "cout" )
+bool Logger::log( log_stream stream, const char *content ) {
+    record_stamp stamp = Timestamp::stamp(e_stamp_log);
+    switch ( stream )
     {
-        std::cout << pros::millis() << " " << entry.content << "\n";
+        case e_log_cout:
+            std::cout << stamp.time << " " << stamp.sequence << " " << content << "\n";
+            break;
+        case e_log_cerr:
+            std::cerr << stamp.time << " " << stamp.sequence << " " << content << "\n";
+            break;
+        case e_log_clog:
+            std::clog << stamp.time << " " << stamp.sequence << " " << content << "\n";
+            break;
+        default:
+            return false;
     }
-    else if ( entry.stream == "cerr" )
+
+    return true;
+}
+
+
+bool Logger::parse_stream( const std::string &stream, log_stream &parsed ) {
+    if ( stream == "cout" )
     {
-        std::cerr << pros::millis() << " " << entry.content << "\n";
+        parsed = e_log_cout;
     }
-    else if ( entry.stream == "clog" )
+    else if ( stream == "cerr" )
     {
-        std::clog << pros::millis() << " " << entry.content << "\n";
+        parsed = e_log_cerr;
+    }
+    else if ( stream == "clog" )
+    {
+        parsed = e_log_clog;
     }
     else
     {
         return false;
     }
-    
+
     return true;
 }
 
@@ -62,65 +136,509 @@ bool Logger::log( log_entry entry ) {
 
 
 /**
- * add item to the queue by aquiring and releasing atomic lock
+ * an entry past the capacity of a drop oldest source is still queued, the
+ * source's stale count tells the drain task to skip that many of the
+ * source's oldest entries so what gets written is the newest entries. An
+ * entry is only counted once it has a slot
  */
-bool Logger::add( log_entry entry ) {
-    if ( !entry.stream.empty() && !entry.content.empty() )
-    {
-        if(use_queue) {  // save the message in a queue to be viewed later
-            while ( lock.exchange( true ) ); //aquire lock
-            logger_queue.push( entry );
-            lock.exchange( false ); //release lock
-        } else {  // log the message right away
-            log(entry);
+log_record* Logger::claim( log_source source, std::uint32_t &position ) {
+    record_stamp stamp = Timestamp::stamp(e_stamp_log);  // dropped entries still use a sequence number so they leave a gap
+    int policy = source_policy[source].load(std::memory_order_relaxed);
+    if ( policy == e_log_sample )
+    {
+        std::uint32_t seen = source_seen[source].fetch_add(1, std::memory_order_relaxed);
+        if ( seen % source_sample_every[source].load(std::memory_order_relaxed) != 0 )
+        {
+            source_dropped[source].fetch_add(1, std::memory_order_relaxed);
+            return NULL;
+        }
+    }
+
+    int depth = source_depth[source].fetch_add(1, std::memory_order_relaxed) + 1;
+    bool replaces_oldest = false;
+    if ( depth - source_stale[source].load(std::memory_order_relaxed) > source_capacity[source].load(std::memory_order_relaxed) )
+    {
+        if ( policy != e_log_drop_oldest )
+        {
+            source_depth[source].fetch_sub(1, std::memory_order_relaxed);
+            source_dropped[source].fetch_add(1, std::memory_order_relaxed);
+            return NULL;
         }
-        
-        return true;
+        replaces_oldest = true;
     }
-    
-    return false;
+
+    log_record *record = ring.claim(position);
+    if ( record == NULL )  // the whole ring is full
+    {
+        source_depth[source].fetch_sub(1, std::memory_order_relaxed);
+        source_dropped[source].fetch_add(1, std::memory_order_relaxed);
+        return NULL;
+    }
+
+    if ( replaces_oldest )
+    {
+        source_stale[source].fetch_add(1, std::memory_order_relaxed);
+        source_dropped[source].fetch_add(1, std::memory_order_relaxed);
+    }
+    source_accepted[source].fetch_add(1, std::memory_order_relaxed);
+    raise_to(source_high_water[source], depth);
+    raise_to(high_water, ring.size());
+
+    record->time = stamp.time;
+    record->sequence = stamp.sequence;
+    record->source = source;
+    return record;
+}
+
+
+bool Logger::release( log_source source ) {
+    source_depth[source].fetch_sub(1, std::memory_order_relaxed);
+
+    int stale = source_stale[source].load(std::memory_order_relaxed);
+    while ( stale > 0 )
+    {
+        if ( source_stale[source].compare_exchange_weak(stale, stale - 1, std::memory_order_relaxed) )
+        {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 
 
 
 /**
- * gets an item from the queue by acquiring the lock and releasing it
+ * copies the entry into a claimed slot of the ring
  */
-std::vector<log_entry> Logger::get_entries(int num_entries) {
-    std::vector<log_entry> contents;
-
-    while ( lock.exchange( true ) ); //aquire lock
-    
-    for(int i=0; i<num_entries; i++) {
-        if ( !logger_queue.empty() ) {
-            contents.push_back(logger_queue.front());
-            logger_queue.pop();
-        } else {
-            break;
+bool Logger::add( log_entry entry, log_source source /*e_log_source_other*/ ) {
+    log_stream stream;
+    if ( entry.content.empty() || !parse_stream(entry.stream, stream) )
+    {
+        return false;
+    }
+
+    if ( !use_queue )  // log the message right away
+    {
+        return log(stream, entry.content.c_str());
+    }
+
+    std::uint32_t position;
+    log_record *record = claim(source, position);
+    if ( record == NULL )
+    {
+        return false;
+    }
+
+    record->stream = stream;
+    record->length = std::min<std::size_t>(entry.content.size(), LOGGER_RECORD_SIZE - 1);
+    std::memcpy(record->content, entry.content.data(), record->length);
+    record->content[record->length] = '\0';
+    ring.publish(position);
+
+    return true;
+}
+
+
+bool Logger::add_formatted( log_source source, log_stream stream, const char *format, std::va_list args ) {
+    if ( !use_queue )  // log the message right away
+    {
+        char content[LOGGER_RECORD_SIZE];
+        std::vsnprintf(content, sizeof(content), format, args);
+
+        return log(stream, content);
+    }
+
+    std::uint32_t position;
+    log_record *record = claim(source, position);
+    if ( record == NULL )
+    {
+        return false;
+    }
+
+    int length = std::vsnprintf(record->content, LOGGER_RECORD_SIZE, format, args);
+
+    record->stream = stream;
+    record->length = std::clamp(length, 0, LOGGER_RECORD_SIZE - 1);
+    ring.publish(position);
+
+    return true;
+}
+
+
+bool Logger::add( log_stream stream, const char *format, ... ) {
+    std::va_list args;
+    va_start(args, format);
+    bool added = add_formatted(e_log_source_other, stream, format, args);
+    va_end(args);
+
+    return added;
+}
+
+
+bool Logger::add( log_source source, log_stream stream, const char *format, ... ) {
+    std::va_list args;
+    va_start(args, format);
+    bool added = add_formatted(source, stream, format, args);
+    va_end(args);
+
+    return added;
+}
+
+
+
+
+/**
+ * lines are written as "<time> <sequence> <content>" like log() does, cout
+ * goes to stdout and cerr and clog go to stderr
+ */
+void Logger::append( log_stream stream, record_stamp stamp, const char *content, int length ) {
+    char prefix[24];
+    int prefix_length = std::snprintf(prefix, sizeof(prefix), "%u %u ", (unsigned int)stamp.time, (unsigned int)stamp.sequence);
+    int needed = prefix_length + length + 1;
+    if ( batch_length > 0 && (stream != batch_stream || batch_length + needed > LOGGER_BATCH_SIZE) )
+    {
+        write_batch();
+    }
+
+    batch_stream = stream;
+    std::memcpy(batch + batch_length, prefix, prefix_length);
+    std::memcpy(batch + batch_length + prefix_length, content, length);
+    batch[batch_length + needed - 1] = '\n';
+    batch_length += needed;
+}
+
+
+void Logger::write_batch( ) {
+    if ( batch_length == 0 )
+    {
+        return;
+    }
+
+    std::FILE *output = batch_stream == e_log_cout ? stdout : stderr;
+    std::fwrite(batch, 1, batch_length, output);
+    std::fflush(output);
+
+    if ( batch_to_file && file != NULL )
+    {
+        append_file(batch, batch_length);
+    }
+
+    bytes_written.fetch_add(batch_length, std::memory_order_relaxed);
+    batches_written.fetch_add(1, std::memory_order_relaxed);
+    batch_length = 0;
+}
+
+
+
+
+void Logger::append_file( const char *data, int length ) {
+    while ( length > 0 && file != NULL )
+    {
+        int copied = std::min(length, LOGGER_FILE_BLOCK - file_block_length);
+        std::memcpy(file_block + file_block_length, data, copied);
+        file_block_length += copied;
+        data += copied;
+        length -= copied;
+
+        if ( file_block_length == LOGGER_FILE_BLOCK )
+        {
+            write_file_block();
+        }
+    }
+}
+
+
+/**
+ * a write that fails usually means the card was pulled, the file is closed
+ * so the drain task does not keep trying
+ */
+void Logger::write_file_block( ) {
+    if ( file == NULL || file_block_length == 0 )
+    {
+        return;
+    }
+
+    std::size_t written = std::fwrite(file_block, 1, file_block_length, file);
+    if ( written != (std::size_t)file_block_length || std::fflush(file) != 0 )
+    {
+        abandon_file();
+        return;
+    }
+
+    file_committed.fetch_add(file_block_length, std::memory_order_relaxed);
+    file_block_length = 0;
+    file_last_write = pros::millis();
+    if ( !write_file_header() )
+    {
+        abandon_file();
+    }
+}
+
+
+/**
+ * the header is one fixed size text line so it can be rewritten in place,
+ * a file recovered after a crash is valid up to the committed length
+ */
+int Logger::write_file_header( ) {
+    char header[LOGGER_FILE_HEADER_SIZE + 1];
+    int length = std::snprintf(
+        header, sizeof(header), "# match log v1, file %04d, opened at %010u ms, committed %010u bytes",
+        file_number.load(), (unsigned int)file_opened_at, (unsigned int)file_committed.load()
+    );
+    std::memset(header + length, ' ', LOGGER_FILE_HEADER_SIZE - 1 - length);
+    header[LOGGER_FILE_HEADER_SIZE - 1] = '\n';
+
+    if (
+        std::fseek(file, 0, SEEK_SET) != 0
+        || std::fwrite(header, 1, LOGGER_FILE_HEADER_SIZE, file) != LOGGER_FILE_HEADER_SIZE
+        || std::fflush(file) != 0
+        || std::fseek(file, 0, SEEK_END) != 0
+    )
+    {
+        return 0;
+    }
+
+    return 1;
+}
+
+
+void Logger::abandon_file( ) {
+    file_errors.fetch_add(1, std::memory_order_relaxed);
+    std::fclose(file);
+    file = NULL;
+    file_number = -1;
+    file_block_length = 0;
+}
+
+
+void Logger::open_next_file( const char *prefix ) {
+    char path[LOGGER_FILE_PATH_SIZE + 16];
+    int start = file_number.load() + 1;
+    for ( int i = 0; i < LOGGER_FILE_MAX; i++ )
+    {
+        int number = (start + i) % LOGGER_FILE_MAX;
+        std::snprintf(path, sizeof(path), "%s%04d.log", prefix, number);
+
+        std::FILE *existing = std::fopen(path, "r");
+        if ( existing != NULL )
+        {
+            std::fclose(existing);
+            continue;
+        }
+
+        file = std::fopen(path, "wb");
+        if ( file == NULL )  // no card
+        {
+            file_errors.fetch_add(1, std::memory_order_relaxed);
+            return;
         }
+
+        file_number = number;
+        file_block_length = 0;
+        file_committed = 0;
+        file_opened_at = pros::millis();
+        file_last_write = file_opened_at;
+        if ( !write_file_header() )
+        {
+            abandon_file();
+        }
+        return;
     }
-    
-    lock.exchange( false ); //release lock because there is no more iteraction
-                            //with the queue
-    return contents;
 }
 
 
+void Logger::close_current_file( ) {
+    if ( file == NULL )
+    {
+        return;
+    }
+
+    write_file_block();
+    if ( file != NULL )
+    {
+        std::fclose(file);
+        file = NULL;
+    }
+}
 
 
 /**
- * builds up a cache of items 
- * this is used so that data can be sent at closer to the max speed
+ * file numbers continue from the last file this run so a rotation does not
+ * have to look at every older file again
  */
-void Logger::dump( ) {
-    std::vector<log_entry> entries = get_entries(50);
+void Logger::service_file( ) {
+    int request = file_request.exchange(e_log_file_none);
+    if ( request == e_log_file_none && file == NULL )
+    {
+        return;
+    }
 
-    for ( int i = 0; i < entries.size(); i++ )
+    if ( draining.exchange(true) )  // another task is dumping, try again next time
     {
-        log(entries.at(i));
+        if ( request != e_log_file_none )
+        {
+            file_request.store(request);
+        }
+        return;
     }
 
+    if ( request == e_log_file_rotate || request == e_log_file_close )
+    {
+        close_current_file();
+    }
+
+    if ( (request == e_log_file_open || request == e_log_file_rotate) && file == NULL )
+    {
+        char prefix[LOGGER_FILE_PATH_SIZE];
+        while ( request_lock.exchange( true ) );
+        std::memcpy(prefix, requested_prefix, sizeof(prefix));
+        request_lock.exchange(false);
+
+        open_next_file(prefix);
+    }
+
+    if ( file != NULL && file_block_length > 0 && pros::millis() - file_last_write >= LOGGER_FILE_SYNC_PERIOD )
+    {
+        write_file_block();
+    }
+
+    draining.store(false);
+}
+
+
+void Logger::request_file( log_file_request request, std::string prefix ) {
+    while ( request_lock.exchange( true ) );
+    std::snprintf(requested_prefix, sizeof(requested_prefix), "%s", prefix.c_str());
+    request_lock.exchange(false);
+
+    file_request.store(request);
+}
+
+
+void Logger::open_file( std::string prefix /*LOGGER_FILE_PREFIX*/ ) {
+    request_file(e_log_file_open, prefix);
+}
+
+
+void Logger::rotate_file( std::string prefix /*LOGGER_FILE_PREFIX*/ ) {
+    request_file(e_log_file_rotate, prefix);
+}
+
+
+void Logger::close_file( ) {
+    request_file(e_log_file_close, "");
+}
+
+
+
+
+/**
+ * takes entries in order until one is not published yet, that one is
+ * still being written by the task that claimed it and is taken next time
+ *
+ * the ring keeps taking new entries while a batch is written so the batch
+ * buffer and the ring act as a double buffer, no task that logs ever waits
+ * on the write
+ */
+int Logger::dump_queue( bool to_file ) {
+    if ( draining.exchange(true) )  // another task is dumping
+    {
+        return 0;
+    }
+    batch_to_file = to_file;
+
+    std::uint32_t total_dropped = ring.get_dropped();
+    if ( total_dropped != reported_dropped )
+    {
+        char warning[96];
+        int length = std::snprintf(
+            warning, sizeof(warning), "[WARNING], %u, %u log entries dropped because the queue was full",
+            (unsigned int)pros::millis(), (unsigned int)(total_dropped - reported_dropped)
+        );
+        append(e_log_cerr, Timestamp::stamp(e_stamp_log), warning, length);
+        reported_dropped = total_dropped;
+    }
+
+    int written = 0;
+    log_record *record;
+    while ( written < LOGGER_DUMP_ENTRIES && (record = ring.peek()) != NULL )
+    {
+        if ( release((log_source)record->source) )
+        {
+            record_stamp stamp;
+            stamp.time = record->time;
+            stamp.sequence = record->sequence;
+            append((log_stream)record->stream, stamp, record->content, record->length);
+        }
+        ring.pop();
+        written += 1;
+    }
+    write_batch();
+
+    entries_written.fetch_add(written, std::memory_order_relaxed);
+    batch_to_file = false;
+    draining.store(false);
+    return written;
+}
+
+
+int Logger::dump( ) {
+    return dump_queue(false);
+}
+
+
+/**
+ * the period is halved when a quarter of the ring filled up since the last
+ * wake and doubled when almost nothing did, so the ring does not overflow
+ * during bursts and the task stays asleep when nothing is logged
+ */
+void Logger::drain(void*) {
+    std::uint32_t period = LOGGER_DRAIN_PERIOD;
+    std::uint32_t window_start = pros::millis();
+    std::uint32_t window_written = 0;
+
+    while ( true )
+    {
+        service_file();  // before dumping so entries logged after a rotation go to the new file
+
+        int written = 0;
+        int dumped;
+        do {
+            dumped = dump_queue(true);
+            written += dumped;
+        } while ( dumped == LOGGER_DUMP_ENTRIES );  // keep going while there is a backlog
+
+        if ( written > LOGGER_RECORDS / 4 )
+        {
+            period = std::max<std::uint32_t>(period / 2, LOGGER_DRAIN_PERIOD_MIN);
+        }
+        else if ( written < LOGGER_RECORDS / 16 )
+        {
+            period = std::min<std::uint32_t>(period * 2, LOGGER_DRAIN_PERIOD_MAX);
+        }
+        drain_period.store(period, std::memory_order_relaxed);
+
+        std::uint32_t now = pros::millis();
+        if ( now - window_start >= 1000 )
+        {
+            std::uint32_t total = entries_written.load(std::memory_order_relaxed);
+            throughput.store(((total - window_written) * 1000) / (now - window_start), std::memory_order_relaxed);
+            window_start = now;
+            window_written = total;
+        }
+
+        pros::delay(period);
+    }
+}
+
+
+void Logger::start_drain_task() {
+    if ( drain_thread == NULL )
+    {
+        drain_thread = new pros::Task( drain, (void*)NULL, TASK_PRIORITY_MIN + 1, TASK_STACK_DEPTH_DEFAULT, "logger_drain");
+    }
 }
 
 
@@ -134,8 +652,75 @@ void Logger::stop_queueing() {
 
 
 /**
- * gets the size of the writer queue
+ * gets the size of the writer queue, entries still being written by the task
+ * that claimed them are counted
  */
 int Logger::get_count() {
-    return logger_queue.size();
+    return ring.size();
+}
+
+
+int Logger::get_count( log_source source ) {
+    return source_depth[source].load(std::memory_order_relaxed) - source_stale[source].load(std::memory_order_relaxed);
+}
+
+
+std::uint32_t Logger::get_dropped() {
+    return ring.get_dropped();
+}
+
+
+logger_stats Logger::get_stats() {
+    logger_stats stats;
+    stats.depth = ring.size();
+    stats.high_water = high_water.load(std::memory_order_relaxed);
+    stats.written = entries_written.load(std::memory_order_relaxed);
+    stats.bytes = bytes_written.load(std::memory_order_relaxed);
+    stats.batches = batches_written.load(std::memory_order_relaxed);
+    stats.dropped = ring.get_dropped();
+    stats.throughput = throughput.load(std::memory_order_relaxed);
+    stats.drain_period = drain_period.load(std::memory_order_relaxed);
+    stats.file_number = file_number.load();
+    stats.file_bytes = file_committed.load(std::memory_order_relaxed);
+    stats.file_errors = file_errors.load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+
+
+/**
+ * the sample count restarts so the first entry after a change is queued
+ */
+int Logger::set_policy( log_source source, log_policy policy, int capacity /*LOGGER_RECORDS*/, int sample_every /*1*/ ) {
+    if (
+        source < 0 || source >= LOGGER_SOURCES
+        || policy < e_log_drop_newest || policy > e_log_sample
+        || capacity < 1 || capacity > LOGGER_RECORDS
+        || sample_every < 1
+    )
+    {
+        return 0;
+    }
+
+    source_sample_every[source].store(sample_every, std::memory_order_relaxed);
+    source_capacity[source].store(capacity, std::memory_order_relaxed);
+    source_seen[source].store(0, std::memory_order_relaxed);
+    source_policy[source].store(policy, std::memory_order_relaxed);
+
+    return 1;
+}
+
+
+log_source_stats Logger::get_source_stats( log_source source ) {
+    log_source_stats stats;
+    stats.policy = (log_policy)source_policy[source].load(std::memory_order_relaxed);
+    stats.capacity = source_capacity[source].load(std::memory_order_relaxed);
+    stats.sample_every = source_sample_every[source].load(std::memory_order_relaxed);
+    stats.accepted = source_accepted[source].load(std::memory_order_relaxed);
+    stats.dropped = source_dropped[source].load(std::memory_order_relaxed);
+    stats.depth = get_count(source);
+    stats.high_water = source_high_water[source].load(std::memory_order_relaxed);
+
+    return stats;
 }
@@ -12,8 +12,59 @@
 #define __LOGGER_HPP__
 
 #include <atomic>
-#include <queue>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
 #include <string>
+#include <vector>
+
+#include "main.h"
+
+#include "RecordRing.hpp"
+#include "Timestamp.hpp"
+
+#define LOGGER_RECORDS        256  // power of two so positions wrap cleanly
+#define LOGGER_RECORD_SIZE    512  // chars per entry including the terminator, longer entries are cut off
+#define LOGGER_DUMP_ENTRIES   50   // max entries written by one dump()
+#define LOGGER_BATCH_SIZE     4096 // bytes in the batch buffer, a full batch is written with one fwrite
+#define LOGGER_DRAIN_PERIOD   20   // ms between dumps of the drain task when it starts
+#define LOGGER_DRAIN_PERIOD_MIN  5    // ms, the drain task wakes more often while the queue is filling
+#define LOGGER_DRAIN_PERIOD_MAX  100  // and less often while it is idle
+
+#define LOGGER_FILE_PREFIX       "/usd/match_"  // followed by a 4 digit file number and .log
+#define LOGGER_FILE_PATH_SIZE    64
+#define LOGGER_FILE_BLOCK        4096  // bytes buffered before a write to the card
+#define LOGGER_FILE_HEADER_SIZE  96    // fixed so the header can be rewritten in place
+#define LOGGER_FILE_SYNC_PERIOD  1000  // ms a partial block can wait before it is written
+#define LOGGER_FILE_MAX          10000 // file numbers wrap after this
+
+#define LOGGER_SOURCES           5
+#define LOGGER_MOTOR_CAPACITY    (LOGGER_RECORDS / 2)  // motors log every tick so they can not crowd out everything else
+
+#ifndef LOG_LEVEL_MAX
+#define LOG_LEVEL_MAX         5    // most verbose level compiled in, competition builds use make LOG_LEVEL_MAX=0
+#endif
+
+
+/**
+ * true if statements at the level are compiled in, use with if constexpr
+ * around logging that is more than one statement
+ */
+#define LOG_COMPILED(level) ((level) <= LOG_LEVEL_MAX)
+
+/**
+ * logs a printf style entry when enabled is true, the arguments are only
+ * evaluated when the entry is logged. When the level is above LOG_LEVEL_MAX
+ * the statement compiles to nothing
+ */
+#define LOG_IF(level, enabled, source, stream, ...) \
+    do { \
+        if constexpr ( LOG_COMPILED(level) ) { \
+            if ( enabled ) { \
+                Logger().add(source, stream, __VA_ARGS__); \
+            } \
+        } \
+    } while ( 0 )
 
 
 typedef struct
@@ -23,35 +74,269 @@ typedef struct
 } log_entry;
 
 
+typedef enum {
+    e_log_cout,
+    e_log_cerr,
+    e_log_clog
+} log_stream;
+
+
+typedef enum {
+    e_log_source_other,
+    e_log_source_motor,
+    e_log_source_chassis,
+    e_log_source_tracker,
+    e_log_source_server
+} log_source;
+
+
+typedef enum {
+    e_log_drop_newest,  // entries are dropped while the source has capacity entries queued
+    e_log_drop_oldest,  // entries are always queued and the oldest queued entry of the source is skipped instead
+    e_log_sample        // every sample_every'th entry is queued, the rest are dropped, then drop newest past capacity
+} log_policy;
+
+
+typedef struct
+{
+    log_policy policy;
+    int capacity;                  // max entries of the source that are queued to be written
+    int sample_every;
+    std::uint32_t accepted;        // entries queued
+    std::uint32_t dropped;         // entries dropped by the policy or because the queue was full
+    int depth;                     // entries of the source in the queue
+    int high_water;                // most entries of the source that were in the queue at once
+} log_source_stats;
+
+
+typedef enum {
+    e_log_file_none,
+    e_log_file_open,
+    e_log_file_rotate,
+    e_log_file_close
+} log_file_request;
+
+
+typedef struct
+{
+    int depth;                     // entries in the queue
+    int high_water;                // most entries that were in the queue at once
+    std::uint32_t written;         // entries written since the program started
+    std::uint32_t bytes;           // bytes written
+    std::uint32_t batches;         // writes, one per batch
+    std::uint32_t dropped;         // entries dropped because the queue was full
+    std::uint32_t throughput;      // entries written per second over the last second, updated by the drain task
+    std::uint32_t drain_period;    // ms the drain task waits between dumps
+    int file_number;               // number of the open log file, -1 if there is none
+    std::uint32_t file_bytes;      // bytes of the open log file that are on the card
+    std::uint32_t file_errors;     // failed writes, the file is closed after one
+} logger_stats;
+
+
+typedef struct
+{
+    std::uint32_t time;     // us when the entry was added
+    std::uint32_t sequence;
+    std::uint8_t stream;    // log_stream
+    std::uint8_t source;    // log_source
+    std::uint16_t length;
+    char content[LOGGER_RECORD_SIZE];
+} log_record;
+
+
 /**
  * Contains a queue that can be added to and dumped out so that data can
  * be gathered and exported
  *
+ * the queue is a preallocated ring of fixed size records that any task can
+ * add to and one task at a time takes from. Adding copies into a claimed
+ * slot so it never allocates, and never waits, when the ring is full the
+ * entry is dropped and counted instead
+ *
+ * entries are stamped with the time in us and a sequence number when they
+ * are added and written as "<time> <sequence> <content>" lines, see
+ * Timestamp.hpp
+ *
+ * every entry comes from a source that has its own policy and capacity
+ * within the ring, so a motor logging every tick at a high log level can not
+ * take all of the ring from the chassis or the server
  */
 class Logger
 {
     private:
-        static std::queue<log_entry> logger_queue;
-        static std::atomic<bool> lock;
+        static RecordRing<log_record, LOGGER_RECORDS> ring;
+        static std::atomic<bool> draining;  // held by the one task taking from the ring
+        static std::uint32_t reported_dropped;  // dropped count as of the last warning, only used while draining
         static bool use_queue;
+        static pros::Task *drain_thread;
+
+        static char batch[LOGGER_BATCH_SIZE];  // only used while draining
+        static int batch_length;
+        static log_stream batch_stream;
+        static bool batch_to_file;  // the drain task is dumping, only it writes the file sink
+        static std::atomic<std::uint32_t> entries_written;
+        static std::atomic<std::uint32_t> bytes_written;
+        static std::atomic<std::uint32_t> batches_written;
+        static std::atomic<std::uint32_t> throughput;
+        static std::atomic<std::uint32_t> drain_period;
+
+        static std::FILE *file;  // file sink, only used while draining
+        static std::atomic<int> file_number;
+        static char file_block[LOGGER_FILE_BLOCK];
+        static int file_block_length;
+        static std::atomic<std::uint32_t> file_committed;  // bytes after the header that are on the card
+        static std::uint32_t file_opened_at;
+        static std::uint32_t file_last_write;
+        static std::atomic<std::uint32_t> file_errors;
+        static std::atomic<int> file_request;  // log_file_request for the drain task
+        static std::atomic<bool> request_lock;  // guards requested_prefix
+        static char requested_prefix[LOGGER_FILE_PATH_SIZE];
+
+        static std::atomic<int> high_water;
+        static std::atomic<int> source_policy[LOGGER_SOURCES];  // log_policy
+        static std::atomic<int> source_capacity[LOGGER_SOURCES];
+        static std::atomic<int> source_sample_every[LOGGER_SOURCES];
+        static std::atomic<std::uint32_t> source_seen[LOGGER_SOURCES];  // entries added, used for sampling
+        static std::atomic<std::uint32_t> source_accepted[LOGGER_SOURCES];
+        static std::atomic<std::uint32_t> source_dropped[LOGGER_SOURCES];
+        static std::atomic<int> source_depth[LOGGER_SOURCES];
+        static std::atomic<int> source_high_water[LOGGER_SOURCES];
+        static std::atomic<int> source_stale[LOGGER_SOURCES];  // queued entries to skip for drop oldest
 
         /**
-         * @param: num_entries -> max number of entries to get
-         * @return: std::vector<log_entry> -> the list of items gotton from queue
+         * @param: log_source source -> where the entry comes from
+         * @param: std::uint32_t &position -> set to the position of the claimed slot
+         * @return: log_record* -> the claimed record, NULL if the entry was dropped
          *
-         * gets an object from the logger queue
-         * returns an empty string if the queue is empty
+         * stamps the entry, applies the policy of the source, and claims a
+         * slot, the caller fills in the content and publishes it
+         */
+        static log_record* claim( log_source source, std::uint32_t &position );
+
+        /**
+         * @param: log_source source -> source of the record that was taken
+         * @return: bool -> true if the record should be written, false if
+         *                  it was replaced by a newer entry of a drop oldest source
+         */
+        static bool release( log_source source );
+
+        /**
+         * @param: log_source source -> where the entry comes from
+         * @param: log_stream stream -> where the entry is sent
+         * @param: const char *format -> printf style format of the entry
+         * @param: std::va_list args -> arguments of the format
+         * @return: bool -> true on success and false if the entry was dropped
          */
-        std::vector<log_entry> get_entries(int num_entries);
+        static bool add_formatted( log_source source, log_stream stream, const char *format, std::va_list args );
 
         /**
-         * @param: log_entry contents -> what to log
-         * @return: bool -> true if the file was actually written to, false if an error occured
+         * @param: log_stream stream -> where to send it
+         * @param: const char *content -> what to log
+         * @return: bool -> true if the stream is supported
          *
-         * sends an entry on a given stream
+         * stamps an entry and sends it on a given stream
          * currently supports cout, clog, and cerr
          */
-        bool log( log_entry entry );
+        static bool log( log_stream stream, const char *content );
+
+        /**
+         * @param: std::string stream -> "cout", "cerr", or "clog"
+         * @param: log_stream &parsed -> set to the stream
+         * @return: bool -> true if the stream is supported
+         */
+        static bool parse_stream( const std::string &stream, log_stream &parsed );
+
+        /**
+         * @param: log_stream stream -> where the entry is sent
+         * @param: record_stamp stamp -> when the entry was added
+         * @param: const char *content -> the entry
+         * @param: int length -> chars in the entry
+         * @return: None
+         *
+         * adds a line to the batch, the batch is written first if it is for
+         * another stream or the line does not fit
+         */
+        static void append( log_stream stream, record_stamp stamp, const char *content, int length );
+
+        /**
+         * @return: None
+         *
+         * writes the batch with one fwrite and empties it, and adds it to
+         * the file sink when the drain task is dumping
+         */
+        static void write_batch( );
+
+        /**
+         * @param: const char *data -> bytes to add to the file sink
+         * @param: int length -> number of bytes
+         * @return: None
+         *
+         * copies into the block buffer, every full block is written
+         */
+        static void append_file( const char *data, int length );
+
+        /**
+         * @return: None
+         *
+         * writes the buffered block and then the header with the new
+         * committed length, so the header never counts bytes that are not
+         * on the card
+         */
+        static void write_file_block( );
+
+        /**
+         * @return: int -> 1 if the header is on the card, 0 if a seek or write failed
+         */
+        static int write_file_header( );
+
+        /**
+         * @return: None
+         *
+         * counts a failed write and closes the file so the drain task does
+         * not keep trying
+         */
+        static void abandon_file( );
+
+        /**
+         * @param: const char *prefix -> path up to the file number
+         * @return: None
+         *
+         * opens the first file number after the last one that does not exist
+         */
+        static void open_next_file( const char *prefix );
+
+        static void close_current_file( );
+
+        /**
+         * @return: None
+         *
+         * handles open, rotate, and close requests and writes a partial
+         * block that waited LOGGER_FILE_SYNC_PERIOD ms, only called by the
+         * drain task so the card is never written by a control task
+         */
+        static void service_file( );
+
+        /**
+         * @param: log_file_request request -> what the drain task should do
+         * @param: std::string prefix -> path up to the file number
+         * @return: None
+         */
+        static void request_file( log_file_request request, std::string prefix );
+
+        /**
+         * @param: bool to_file -> also write the entries to the file sink
+         * @return: int -> number of entries written
+         */
+        static int dump_queue( bool to_file );
+
+        /**
+         * @param: void* -> not used, but necessary to follow thread making constructor
+         * @return: None
+         *
+         * dumps the queue, waking more often while the queue is filling
+         * and less often while it is idle
+         */
+        static void drain(void*);
 
     public:
         Logger();
@@ -59,25 +344,53 @@ class Logger
 
         /**
          * @param: log_entry test_item -> item to add to the writer queue
-         * @return: bool -> true on success and false if an error occured in the process
+         * @param: log_source source -> where the entry comes from
+         * @return: bool -> true on success and false if the entry is empty or was dropped
          *
          * adds an item to the logger queue
-         * the queue is protected using a spinlock implemented with an
-         * std::atomic bool
+         * the content is copied into the ring so nothing is allocated
          */
-        bool add( log_entry entry );
+        bool add( log_entry entry, log_source source=e_log_source_other );
 
         /**
-         * @return: None
+         * @param: log_stream stream -> where the entry is sent
+         * @param: const char *format -> printf style format of the entry
+         * @return: bool -> true on success and false if the entry was dropped
          *
-         * builds up a cache of items from the queue for 50ms so that they can be
-         * logged at closer to the max speed
+         * formats the entry straight into the ring so the caller does not
+         * have to build a string
          */
-        void dump( );
-        
+        bool add( log_stream stream, const char *format, ... ) __attribute__((format(printf, 3, 4)));
+
+        /**
+         * @param: log_source source -> where the entry comes from
+         * @param: log_stream stream -> where the entry is sent
+         * @param: const char *format -> printf style format of the entry
+         * @return: bool -> true on success and false if the entry was dropped
+         */
+        bool add( log_source source, log_stream stream, const char *format, ... ) __attribute__((format(printf, 4, 5)));
+
+        /**
+         * @return: int -> number of entries written
+         *
+         * writes up to LOGGER_DUMP_ENTRIES entries from the queue in batches
+         * returns right away if another task is already dumping
+         * only goes to stdout and stderr, entries are written to the log
+         * file by the drain task so the card is never written by the caller
+         */
+        int dump( );
+
         static void stop_queueing();
         static void start_queueing();
 
+        /**
+         * @return: None
+         *
+         * starts the low priority task that dumps the queue, entries are
+         * only written when something dumps the queue
+         */
+        static void start_drain_task();
+
 
 
         /**
@@ -86,6 +399,65 @@ class Logger
          * returns the size of the logger queue
          */
         static int get_count();
+
+        /**
+         * @param: log_source source -> the source
+         * @return: int -> number of entries from the source in the logger queue
+         */
+        static int get_count( log_source source );
+
+        /**
+         * @param: log_source source -> the source
+         * @param: log_policy policy -> what to do with entries past capacity
+         * @param: int capacity -> max entries of the source queued to be written,
+         *                         1 to LOGGER_RECORDS
+         * @param: int sample_every -> only used by e_log_sample, queue one of every this many entries
+         * @return: int -> 1 if the policy was set, 0 if an argument is out of range
+         */
+        static int set_policy( log_source source, log_policy policy, int capacity=LOGGER_RECORDS, int sample_every=1 );
+
+        /**
+         * @param: log_source source -> the source
+         * @return: log_source_stats -> the policy and counters of the source
+         */
+        static log_source_stats get_source_stats( log_source source );
+
+        /**
+         * @return: std::uint32_t -> entries dropped because the queue was full
+         */
+        static std::uint32_t get_dropped();
+
+        /**
+         * @param: std::string prefix -> path of the file up to its number
+         * @return: None
+         *
+         * asks the drain task to open a log file if none is open, entries
+         * that are dumped are then written to the file as well. The file
+         * starts with a fixed size header that is rewritten with the number
+         * of bytes that are on the card after every block
+         */
+        static void open_file( std::string prefix=LOGGER_FILE_PREFIX );
+
+        /**
+         * @param: std::string prefix -> path of the file up to its number
+         * @return: None
+         *
+         * asks the drain task to close the open log file and start the next
+         * one, used at the start of every match
+         */
+        static void rotate_file( std::string prefix=LOGGER_FILE_PREFIX );
+
+        /**
+         * @return: None
+         *
+         * asks the drain task to write what is buffered and close the file
+         */
+        static void close_file( );
+
+        /**
+         * @return: logger_stats -> queue depth and throughput counters
+         */
+        static logger_stats get_stats();
 };
 
 
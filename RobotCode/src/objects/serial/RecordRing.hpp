@@ -0,0 +1,147 @@
+/**
+ * @file: ./RobotCode/src/objects/serial/RecordRing.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains a preallocated ring of fixed size records that any task can add to
+ * and one task at a time takes from, used by the logger and telemetry
+ */
+
+#ifndef __RECORDRING_HPP__
+#define __RECORDRING_HPP__
+
+#include <atomic>
+#include <cstdint>
+
+#include "main.h"
+
+
+/**
+ * multi producer single consumer ring of N records of type T
+ *
+ * every slot has a turn that says whose turn it is to use the slot. It is the
+ * lap of the position (position - index) when the slot is free for a
+ * producer, one more than that once the record is written, and the next lap
+ * once the consumer has taken it, so a zeroed ring is an empty ring and a
+ * static ring can be used before static constructors run
+ *
+ * producers never wait on each other or the consumer, when the ring is full
+ * the record is dropped and counted instead. The caller makes sure only one
+ * task at a time calls peek() and pop()
+ *
+ * T must be trivially copyable, N must be a power of two so positions wrap
+ * cleanly
+ */
+template <typename T, std::uint32_t N>
+class RecordRing
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "RecordRing size must be a power of two");
+
+    private:
+        struct slot
+        {
+            std::atomic<std::uint32_t> turn{0};
+            T record{};
+        };
+
+        slot slots[N];
+        std::atomic<std::uint32_t> head;  // position of the next slot to claim
+        std::atomic<std::uint32_t> tail;  // position of the next slot to take
+        std::atomic<std::uint32_t> dropped;
+
+    public:
+        constexpr RecordRing() : slots(), head(0), tail(0), dropped(0) { }
+
+        /**
+         * @param: std::uint32_t &position -> set to the position of the claimed slot
+         * @return: T* -> the claimed record, NULL if the ring is full
+         *
+         * claims the next slot for writing, retries only when another task
+         * claimed it first. The record is handed to the consumer by publish()
+         */
+        T* claim( std::uint32_t &position ) {
+            position = head.load(std::memory_order_relaxed);
+            while ( true )
+            {
+                slot &claimed = slots[position % N];
+                std::uint32_t lap = position - (position % N);
+                std::int32_t difference = (std::int32_t)(claimed.turn.load(std::memory_order_acquire) - lap);
+
+                if ( difference == 0 )
+                {
+                    if ( head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed) )
+                    {
+                        return &claimed.record;
+                    }
+                }
+                else if ( difference < 0 )  // consumer has not taken last lap's record
+                {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return NULL;
+                }
+                else  // another task claimed the position first
+                {
+                    position = head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @param: std::uint32_t position -> position from claim() with the record written
+         * @return: None
+         */
+        void publish( std::uint32_t position ) {
+            std::uint32_t lap = position - (position % N);
+            slots[position % N].turn.store(lap + 1, std::memory_order_release);
+        }
+
+        /**
+         * @return: T* -> the oldest record, NULL if it is not published yet
+         *
+         * a record that is claimed but not published is still being written
+         * by the task that claimed it, it and everything after it are taken
+         * once it is published
+         */
+        T* peek( ) {
+            std::uint32_t position = tail.load(std::memory_order_relaxed);
+            slot &oldest = slots[position % N];
+            std::uint32_t lap = position - (position % N);
+            if ( oldest.turn.load(std::memory_order_acquire) != lap + 1 )
+            {
+                return NULL;
+            }
+
+            return &oldest.record;
+        }
+
+        /**
+         * @return: None
+         *
+         * frees the record returned by peek() for the next lap
+         */
+        void pop( ) {
+            std::uint32_t position = tail.load(std::memory_order_relaxed);
+            std::uint32_t lap = position - (position % N);
+            slots[position % N].turn.store(lap + N, std::memory_order_release);
+            tail.store(position + 1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @return: int -> number of records in the ring, records still being
+         *                 written by the task that claimed them are counted
+         */
+        int size( ) {
+            return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return: std::uint32_t -> records dropped because the ring was full
+         */
+        std::uint32_t get_dropped( ) {
+            return dropped.load(std::memory_order_relaxed);
+        }
+};
+
+
+#endif
@@ -6,26 +6,238 @@
  *
  * contains implementation for server implementation
  */
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
-#include <queue>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
+#include <type_traits>
+#include <vector>
+#include <unistd.h>
 
 #include "main.h"
 #include "pros/apix.h"
 
 #include "../../Configuration.hpp"
 #include "../motors/Motors.hpp"
+#include "../motors/MotorFaults.hpp"
 #include "../motors/MotorThread.hpp"
+#include "../motors/MotorTrace.hpp"
+#include "../motors/PowerBudget.hpp"
+#include "../motors/SystemId.hpp"
 #include "Logger.hpp"
 #include "Server.hpp"
+#include "Timestamp.hpp"
 
-std::queue<server_request> Server::request_queue;
-std::atomic<bool> Server::lock = ATOMIC_VAR_INIT(false);
+
+namespace
+{
+    /**
+     * returns NULL for a motor number that is out of range so a bad request
+     * fails instead of throwing
+     */
+    Motor* motor_at( int motor_number )
+    {
+        if ( motor_number < 0 || motor_number >= (int)Motors::motor_array.size() )
+        {
+            return NULL;
+        }
+        return Motors::motor_array.at(motor_number);
+    }
+
+    /**
+     * crc-8 with polynomial 0x07, the same one telemetry frames use
+     */
+    std::uint8_t crc8( const std::uint8_t *data, int length )
+    {
+        std::uint8_t crc = 0;
+        for ( int i = 0; i < length; i++ )
+        {
+            crc ^= data[i];
+            for ( int bit = 0; bit < 8; bit++ )
+            {
+                crc = (crc & 0x80) ? (std::uint8_t)((crc << 1) ^ 0x07) : (std::uint8_t)(crc << 1);
+            }
+        }
+        return crc;
+    }
+
+    void put_u16( std::uint8_t *destination, std::uint16_t value )
+    {
+        destination[0] = value & 0xFF;
+        destination[1] = value >> 8;
+    }
+}
+
+
+
+RecordRing<server_request_record, SERVER_REQUEST_RECORDS> Server::requests;
+server_request_record *Server::pending_request = NULL;
+std::uint32_t Server::pending_position = 0;
+std::atomic<bool> Server::handling = ATOMIC_VAR_INIT(false);
 pros::Task *Server::read_thread = NULL;
+pros::Task *Server::send_thread = NULL;
+FrameReader Server::reader;
+RecordRing<server_reply_record, SERVER_REPLY_RECORDS> Server::replies;
+std::atomic<bool> Server::sending = ATOMIC_VAR_INIT(false);
+std::uint32_t Server::replies_sent = 0;
 int Server::num_instances = 0;
 bool Server::debug = false;
 int Server::delay = 100;
+server_command Server::commands[SERVER_MAX_COMMANDS];
+int Server::num_commands = 0;
+std::atomic<bool> Server::commands_lock = ATOMIC_VAR_INIT(false);
+
+
+PayloadView::PayloadView( const char *data, int length ) : data(data), length(length), position(0) { }
+
+
+int PayloadView::read_byte( )
+{
+    if ( position >= length )
+    {
+        return -1;
+    }
+    return (std::uint8_t)data[position++];
+}
+
+
+int PayloadView::read_digit( )
+{
+    if ( position >= length || data[position] < '0' || data[position] > '9' )
+    {
+        return -1;
+    }
+    return data[position++] - '0';
+}
+
+
+/**
+ * the number is copied to a terminated buffer first since the msg is not
+ * terminated and strtol would read past it
+ */
+bool PayloadView::read_int( int &value )
+{
+    double number;
+    if ( !read_double(number) )
+    {
+        return false;
+    }
+    value = (int)number;
+    return true;
+}
+
+
+bool PayloadView::read_double( double &value )
+{
+    while ( position < length && data[position] == ' ' )
+    {
+        position += 1;
+    }
+
+    char buffer[32];
+    int copied = std::min<int>(length - position, sizeof(buffer) - 1);
+    std::memcpy(buffer, data + position, copied);
+    buffer[copied] = '\0';
+
+    char *end;
+    value = std::strtod(buffer, &end);
+    if ( end == buffer )
+    {
+        return false;
+    }
+    position += end - buffer;
+    return true;
+}
+
+
+bool PayloadView::read_raw_double( double &value )
+{
+    if ( length - position < (int)sizeof(double) )
+    {
+        return false;
+    }
+    std::memcpy(&value, data + position, sizeof(double));
+    position += sizeof(double);
+    return true;
+}
+
+
+const char* PayloadView::remaining( )
+{
+    return data + position;
+}
+
+
+int PayloadView::size( )
+{
+    return length - position;
+}
+
+
+
+
+ServerReply::ServerReply( ) : length(0), overflowed(false) { }
+
+
+int ServerReply::put( server_value_type type, const void *value, int size )
+{
+    if ( length + 1 + size > SERVER_REPLY_SIZE )
+    {
+        overflowed = true;
+        return 0;
+    }
+
+    values[length] = type;
+    std::memcpy(values + length + 1, value, size);
+    length += 1 + size;
+    return 1;
+}
+
+
+int ServerReply::add_text( const char *text, int size )
+{
+    size = std::min(size, 255);
+    if ( length + 2 + size > SERVER_REPLY_SIZE )
+    {
+        overflowed = true;
+        return 0;
+    }
+
+    values[length] = e_server_text;
+    values[length + 1] = size;
+    std::memcpy(values + length + 2, text, size);
+    length += 2 + size;
+    return 1;
+}
+
+
+int ServerReply::add_text( const char *text )
+{
+    return add_text(text, std::strlen(text));
+}
+
+
+const std::uint8_t* ServerReply::data( )
+{
+    return values;
+}
+
+
+int ServerReply::size( )
+{
+    return length;
+}
+
+
+bool ServerReply::truncated( )
+{
+    return overflowed;
+}
+
+
 
 
 Server::Server() { 
@@ -34,6 +246,15 @@ Server::Server() {
         read_thread->suspend();
     }
 
+    if(send_thread == NULL) {
+        send_thread = new pros::Task( send_replies, (void*)NULL, TASK_PRIORITY_DEFAULT - 1, TASK_STACK_DEPTH_DEFAULT, "server_sender");
+        send_thread->suspend();
+    }
+
+    if(num_commands == 0) {
+        register_builtin_commands();
+    }
+
     num_instances += 1;
 }
 
@@ -46,449 +267,801 @@ Server::~Server() {
     if(num_instances == 0) {
         read_thread->remove();
         delete read_thread;
-        read_thread = NULL;        
+        read_thread = NULL;
+
+        send_thread->remove();
+        delete send_thread;
+        send_thread = NULL;
     }
 }
 
 
 
+/**
+ * everything waiting is read before parsing so a request that arrives over
+ * several reads is parsed as soon as its last byte is in, the task always
+ * sleeps after so it can not starve lower priority tasks
+ */
 void Server::read_stdin(void*) {
-    int read_check = 0;
-    Logger logger;
-    log_entry entry;
-    int wait_check = 0;
-    
-    while(1) {
-        char byte = getchar_unlocked();
+    std::uint8_t block[SERVER_READ_BLOCK];
 
-        if(debug) {
-            entry.stream = "clog";
-            entry.content = "[INFO] " + std::to_string(pros::millis()) + " Byte read from stdin: " + byte;
-            logger.add(entry);
-        }
-
-        if(read_check == 0 && byte == '\xAA') {
-            read_check = 1;
-        } else if(read_check == 1 && byte == '\x55') {
-            read_check = 2;
-        } else if(read_check == 2 && byte == '\x1E') {
-            read_check = 3;
-        } else if(read_check == 3) {
-            std::string msg;
-            int len_msg = (int)byte - 4;  // byte read will be length of bytes to follow 
-                                          // subtract 4 because next four bytes are handled different
-                                          // because they are identifiers
-            uint8_t return_msb = getchar_unlocked();
-            uint8_t return_lsb = getchar_unlocked();
-            uint8_t command_msb = getchar_unlocked();
-            uint8_t command_lsb = getchar_unlocked();
-                        
-            uint16_t return_id = (return_msb << 8) | return_lsb;
-            uint16_t command_id = (command_msb << 8) | command_lsb;
-
-            for(int i=0; i<len_msg; i++) {  // read rest message
-                msg.push_back(getchar_unlocked());
+    while(1) {
+        int available = pros::c::fdctl(STDIN_FILENO, DEVCTL_FIONREAD, NULL);
+        if(available == PROS_ERR) {
+            available = 0;
+        }
+        while(available > 0) {
+            int count = ::read(STDIN_FILENO, block, std::min({available, SERVER_READ_BLOCK, reader.space()}));
+            if(count <= 0) {
+                break;
             }
+            reader.write(block, count);
+            available -= count;
 
-            char checksum = getchar_unlocked();  // checksum is directly after end of message
-
-            if(debug) {
-                entry.stream = "clog";
-                entry.content = (
-                    "[INFO], " 
-                    + std::to_string(pros::millis()) 
-                    + ", Return ID read: " + std::to_string(return_id)
-                    + ", Command ID read: " + std::to_string(command_id)
-                    + ", Msg read: " + msg
-                    + ", Checksum read: " + checksum
-                );
-                logger.add(entry);
-            }
+            queue_requests();
+        }
+        queue_requests();  // frames that were left while the ring was full
 
-            if(checksum == '\xC6')
-            {
-                server_request request;
-                request.return_id = return_id;
-                request.command_id = command_id;
-                request.msg = msg;
-                
-                while ( lock.exchange( true ) ); //aquire lock
-                request_queue.push(request);
-                msg = '\0';
-                lock.exchange( false ); //release lock
+        pros::delay(delay);
+    }
+}
+
+
+
+/**
+ * requests are parsed straight into a claimed slot of the ring. The read task
+ * is the only one adding requests, so a slot it claimed while no request was
+ * complete is kept for the next one, the sender task stops at it since
+ * nothing after it is published. A full ring leaves the rest of the frames in
+ * the reader until the sender task catches up
+ */
+void Server::queue_requests() {
+    while(true) {
+        if(pending_request == NULL) {
+            if(requests.size() >= SERVER_REQUEST_RECORDS) {
+                return;
+            }
+            pending_request = requests.claim(pending_position);
+            if(pending_request == NULL) {
+                return;
             }
-            
-            read_check = 0;
-            len_msg = 0;
-            msg[0] = '\0';
-            
-        } else {
-            read_check = 0;
         }
-        
-        wait_check += 1;
-        if(wait_check > 1024) {  // wait after 1024 interactions
-            wait_check = 0;
-            pros::delay(10);
+
+        if(!reader.next_frame(*pending_request)) {
+            return;
         }
+
+        if(debug) {
+            Logger logger;
+            logger.add(
+                e_log_source_server, e_log_clog, "[INFO], %u, Return ID read: %u, Command ID read: %u, Msg length: %u",
+                (unsigned int)pros::millis(), pending_request->return_id, pending_request->command_id, pending_request->length
+            );
+        }
+
+        requests.publish(pending_position);
+        pending_request = NULL;
     }
 }
 
 
 
-int Server::handle_request(server_request request) {
-    // cases are defined in commands.ods
-    Logger logger;
-    log_entry entry;
-    entry.stream = "clog";
+/**
+ * runs above the logger and telemetry tasks so a reply is never stuck
+ * behind a slow write of theirs
+ */
+void Server::send_replies(void*) {
+    while(1) {
+        handle_requests(SERVER_REPLY_RECORDS);
+        send();
+        pros::delay(SERVER_SEND_PERIOD);
+    }
+}
 
-    std::string return_msg;
-    return_msg.push_back('\xAA');
-    return_msg.push_back('\x55');
-    return_msg.push_back('\x1E');
-    
-    std::string return_msg_body;
-    int status;
 
-    switch(request.command_id) {
-    // motor interaction post cases
-        case 45232: {  //0xB0 0xB0  Set voltage
-                int motor_number = std::stoi(std::to_string(request.msg.at(0)));
-                request.msg.erase(0);
-                int voltage = std::stoi(request.msg);
-                
-                status = Motors::motor_array.at(motor_number)->set_voltage(voltage);
-            }
-            break;
-            
-        case 45233: {  //0xB0 0xB1  Set Slew Rate
-                int motor_number = std::stoi(std::to_string(request.msg.at(0)));
-                request.msg.erase(0);
-                int slew_rate = std::stoi(request.msg);
-                
-                status = Motors::motor_array.at(motor_number)->set_slew(slew_rate);
-            }
-            break;
-            
-        case 45234: {  //0xB0 0xB2  Set Port
-                int motor_number = std::stoi(std::to_string(request.msg.at(0)));
-                request.msg.erase(0);
-                int port = std::stoi(request.msg);
-                
-                status = Motors::motor_array.at(motor_number)->set_port(port);
-            }
-            break;
-            
-        case 45235: {  //0xB0 0xB3  Tare IME
-                int motor_number = std::stoi(std::to_string(request.msg.at(0)));
-                request.msg.erase(0);
-                
-                status = Motors::motor_array.at(motor_number)->tare_encoder();
-            }
-            break;
-            
-        case 45236: {  //0xB0 0xB4  Set Brakemode
-                int motor_number = std::stoi(std::to_string(request.msg.at(0)));
-                request.msg.erase(0);
-                pros::motor_brake_mode_e_t new_brake_mode = static_cast<pros::motor_brake_mode_e_t>(std::stoi(request.msg));
-                
-                status = Motors::motor_array.at(motor_number)->set_brake_mode(new_brake_mode);
-            }
-            break;
-            
-        case 45237: {  //0xB0 0xB5  Set Gearing
-                int motor_number = std::stoi(std::to_string(request.msg.at(0)));
-                request.msg.erase(0);
-                pros::motor_gearset_e_t new_gearing = static_cast<pros::motor_gearset_e_t>(std::stoi(request.msg));
-                
-                status = Motors::motor_array.at(motor_number)->set_gearing(new_gearing);
-            }
-            break;
-            
-        case 45238: {  //0xB0 0xB6  Set PID
-                int motor_number = std::stoi(std::to_string(request.msg.at(0)));
-                request.msg.erase(0);
-                
-                char buffer1[8];
-                char buffer2[8];
-                char buffer3[8];
-                char buffer4[8];
-                
-                std::copy(request.msg.begin(), request.msg.begin() + 8, buffer1);
-                std::copy(request.msg.begin() + 8, request.msg.begin() + 16, buffer2);
-                std::copy(request.msg.begin() + 16, request.msg.begin() + 24, buffer3);
-                std::copy(request.msg.begin() + 24, request.msg.begin() + 32, buffer4);
-                
-                double n1 = *reinterpret_cast<double*>(buffer1);
-                double n2 = *reinterpret_cast<double*>(buffer2);
-                double n3 = *reinterpret_cast<double*>(buffer3);
-                double n4 = *reinterpret_cast<double*>(buffer4);
-                
-                pid pid_constants;
-                pid_constants.kP = n1;
-                pid_constants.kI = n2;
-                pid_constants.kD = n3;
-                pid_constants.i_max = n4;
-                
-                status = Motors::motor_array.at(motor_number)->set_pid(pid_constants);
-            }
-            break;
-            
-        case 45239: {  //0xB0 0xB7  Reverse Motor
-                int motor_number = std::stoi(std::to_string(request.msg.at(0)));
-                request.msg.erase(0);
-                int reveresed = std::stoi(request.msg);
-                status = Motors::motor_array.at(motor_number)->reverse_motor();
-            }
-            break;
-        case 45240: {  //0xB0 0xB8  Set Log Level
-                int motor_number = std::stoi(std::to_string(request.msg.at(0)));
-                request.msg.erase(0);
-                int new_log_level = std::stoi(request.msg);
-                Motors::motor_array.at(motor_number)->set_log_level(new_log_level);
-                status = 1;
-            }
-            break;
-        case 45241: {  //0xB0 0xB9  Set Slew enabled/disabled
-                int motor_number = std::stoi(std::to_string(request.msg.at(0)));
-                request.msg.erase(0);
-                int enabled = std::stoi(request.msg);
-                if(enabled) {
-                    Motors::motor_array.at(motor_number)->enable_slew();
-                } else {
-                    Motors::motor_array.at(motor_number)->disable_slew();
-                }
-                status = 1;
-            }
-            break;
-            
-            
-    // motor interaction get cases
-        case 41120: {  // 0xA0 0xA0  Actual Velocity
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->get_actual_velocity());
-            }
-            break;
-            
-        case 41121: {  // 0xA0 0xA1  Actual Voltage
-                int motor_number = request.msg.at(0) - 48;  // i think this is to convert from ascii char to integer
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->get_actual_voltage());
-            }
-            break;
-            
-        case 41122: {  // 0xA0 0xA2  Current Draw
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->get_current_draw());
-            }
-            break;
-            
-        case 41123: {  // 0xA0 0xA3  Encoder Position
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->get_encoder_position());
-            }
-            break;
-            
-        case 41124: {  // 0xA0 0xA4  Brakemode
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->get_brake_mode());
-            }
-            break;
-            
-        case 41125: {  // 0xA0 0xA5  Gearset
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->get_gearset());
-            }
-            break;
-            
-        case 41126: {  // 0xA0 0xA6  Port
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->get_port());
-            }
-            break;
-            
-        case 41127: {  // 0xA0 0xA7  PID Constants
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body += std::to_string(Motors::motor_array.at(motor_number)->get_pid().kP);
-                return_msg_body += " " + std::to_string(Motors::motor_array.at(motor_number)->get_pid().kI);
-                return_msg_body += " " + std::to_string(Motors::motor_array.at(motor_number)->get_pid().kD);
-                return_msg_body += " " + std::to_string(Motors::motor_array.at(motor_number)->get_pid().i_max);
-            }
-            break;
-            
-        case 41128: {  // 0xA0 0xA8  Slew Rate
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->get_slew_rate());
-            }
-            break;
-            
-        case 41129: {  // 0xA0 0xA9  Power
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->get_power());
-            }
-            break;
-            
-        case 41130: {  // 0xA0 0xAA  Temperature
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->get_temperature());
-            }
-            break;
-            
-        case 41131: {  // 0xA0 0xAB  Torque
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->get_torque());
-            }
-            break;
-            
-        case 41132: {  // 0xA0 0xAC  Direction
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->get_direction());
-            }
-            break;
-            
-        case 41133: {  // 0xA0 0xAD  Efficiency
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->get_efficiency());
-            }
-            break;
-            
-        case 41134: {  // 0xA0 0xAE  is stopped
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->is_stopped());
-            }
-            break;
-            
-        case 41135: {  // 0xA0 0xAF  is reversed
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-                return_msg_body = std::to_string(Motors::motor_array.at(motor_number)->is_reversed());
-            }
-            break;
-            
-        case 41376: {  // 0xA1 0xA0  is registered
-                int motor_number = request.msg.at(0) - 48;
-                request.msg.erase(0);    
-                
-                status = 1;
-            
-                MotorThread* motor_thread = MotorThread::get_instance();
-                return_msg_body = std::to_string(motor_thread->is_registered(*Motors::motor_array.at(motor_number)));
+
+/**
+ * the holder can be the sender task, which is below the tasks that register
+ * commands, so a waiter sleeps instead of spinning to let it finish
+ */
+void Server::lock_commands( ) {
+    while ( commands_lock.exchange( true ) ) {
+        pros::delay(1);
+    }
+}
+
+
+
+int Server::find_command( std::uint16_t command_id ) {
+    server_command *end = commands + num_commands;
+    server_command *found = std::lower_bound(
+        commands, end, command_id,
+        [](const server_command &command, std::uint16_t id) { return command.command_id < id; }
+    );
+
+    if(found == end || found->command_id != command_id) {
+        return -1;
+    }
+    return found - commands;
+}
+
+
+
+int Server::register_command( std::uint16_t command_id, server_handler handler ) {
+    lock_commands();
+
+    if(handler == NULL || num_commands >= SERVER_MAX_COMMANDS || find_command(command_id) >= 0) {
+        commands_lock.exchange( false );
+
+        Logger logger;
+        logger.add(e_log_source_server, e_log_cerr, "[ERROR], %u, could not register server command %u", (unsigned int)pros::millis(), command_id);
+        return 0;
+    }
+
+    int index = num_commands;
+    while(index > 0 && commands[index - 1].command_id > command_id) {  // keep the table sorted
+        commands[index] = commands[index - 1];
+        index -= 1;
+    }
+
+    commands[index] = {command_id, handler, 0, 0, 0, 0};
+    num_commands += 1;
+    commands_lock.exchange( false );
+
+    return 1;
+}
+
+
+int Server::get_command( std::uint16_t command_id, server_command &command ) {
+    lock_commands();
+    int index = find_command(command_id);
+    if(index >= 0) {
+        command = commands[index];
+    }
+    commands_lock.exchange( false );
+
+    return index >= 0;
+}
+
+
+
+int Server::handle_init_server( PayloadView &payload, ServerReply &reply ) {
+    pros::c::serctl(SERCTL_DISABLE_COBS, NULL);
+    set_server_task_priority(TASK_PRIORITY_DEFAULT);  // more messages are sure to follow so give read task more CPU time
+    delay = SERVER_ACTIVE_DELAY; // lower delay because of expected messages
+    reply.add_text("server is running");
+    return 1;
+}
+
+
+int Server::handle_shutdown_server( PayloadView &payload, ServerReply &reply ) {
+    pros::c::serctl(SERCTL_ENABLE_COBS, NULL);
+    set_server_task_priority(2);
+    delay = 100;
+    reply.add_text("server is no longer running");
+    return 1;
+}
+
+
+int Server::handle_command_stats( PayloadView &payload, ServerReply &reply ) {
+    // command id as two bytes, msb first
+    int msb = payload.read_byte();
+    int lsb = payload.read_byte();
+    server_command command;
+    if(lsb < 0 || !get_command((msb << 8) | lsb, command)) {
+        return 0;
+    }
+
+    // calls, calls that failed, mean and max us in the handler
+    reply.add(command.calls);
+    reply.add(command.failures);
+    reply.add(command.calls ? command.total_us / command.calls : 0);
+    reply.add(command.max_us);
+    return 1;
+}
+
+
+
+/**
+ * ids are defined in commands.ods, subsystems that are not here register
+ * their own commands with register_command()
+ */
+void Server::register_builtin_commands() {
+    // motor interaction post commands, the first byte is the motor number
+    register_command(45232, [](PayloadView &payload, ServerReply &reply) {  // 0xB0 0xB0  Set voltage
+        Motor *motor = motor_at(payload.read_byte());
+        int voltage;
+        return motor != NULL && payload.read_int(voltage) ? motor->set_voltage(voltage) : 0;
+    });
+
+    register_command(45233, [](PayloadView &payload, ServerReply &reply) {  // 0xB0 0xB1  Set Slew Rate
+        Motor *motor = motor_at(payload.read_byte());
+        int slew_rate;
+        return motor != NULL && payload.read_int(slew_rate) ? motor->set_slew(slew_rate) : 0;
+    });
+
+    register_command(45234, [](PayloadView &payload, ServerReply &reply) {  // 0xB0 0xB2  Set Port
+        Motor *motor = motor_at(payload.read_byte());
+        int port;
+        return motor != NULL && payload.read_int(port) ? motor->set_port(port) : 0;
+    });
+
+    register_command(45235, [](PayloadView &payload, ServerReply &reply) {  // 0xB0 0xB3  Tare IME
+        Motor *motor = motor_at(payload.read_byte());
+        return motor != NULL ? motor->tare_encoder() : 0;
+    });
+
+    register_command(45236, [](PayloadView &payload, ServerReply &reply) {  // 0xB0 0xB4  Set Brakemode
+        Motor *motor = motor_at(payload.read_byte());
+        int brake_mode;
+        if(motor == NULL || !payload.read_int(brake_mode)) {
+            return 0;
+        }
+        return motor->set_brake_mode(static_cast<pros::motor_brake_mode_e_t>(brake_mode));
+    });
+
+    register_command(45237, [](PayloadView &payload, ServerReply &reply) {  // 0xB0 0xB5  Set Gearing
+        Motor *motor = motor_at(payload.read_byte());
+        int gearing;
+        if(motor == NULL || !payload.read_int(gearing)) {
+            return 0;
+        }
+        return motor->set_gearing(static_cast<pros::motor_gearset_e_t>(gearing));
+    });
+
+    register_command(45238, [](PayloadView &payload, ServerReply &reply) {  // 0xB0 0xB6  Set PID
+        // kP, kI, kD, and i_max as 8 byte doubles
+        Motor *motor = motor_at(payload.read_byte());
+        pid pid_constants = {};
+        if(
+            motor == NULL
+            || !payload.read_raw_double(pid_constants.kP)
+            || !payload.read_raw_double(pid_constants.kI)
+            || !payload.read_raw_double(pid_constants.kD)
+            || !payload.read_raw_double(pid_constants.i_max)
+        ) {
+            return 0;
+        }
+        return motor->set_pid(pid_constants);
+    });
+
+    register_command(45239, [](PayloadView &payload, ServerReply &reply) {  // 0xB0 0xB7  Reverse Motor
+        Motor *motor = motor_at(payload.read_byte());
+        return motor != NULL ? motor->reverse_motor() : 0;
+    });
+
+    register_command(45240, [](PayloadView &payload, ServerReply &reply) {  // 0xB0 0xB8  Set Log Level
+        Motor *motor = motor_at(payload.read_byte());
+        int log_level;
+        if(motor == NULL || !payload.read_int(log_level)) {
+            return 0;
+        }
+        motor->set_log_level(log_level);
+        return 1;
+    });
+
+    register_command(45241, [](PayloadView &payload, ServerReply &reply) {  // 0xB0 0xB9  Set Slew enabled/disabled
+        Motor *motor = motor_at(payload.read_byte());
+        int enabled;
+        if(motor == NULL || !payload.read_int(enabled)) {
+            return 0;
+        }
+        if(enabled) {
+            motor->enable_slew();
+        } else {
+            motor->disable_slew();
+        }
+        return 1;
+    });
+
+    register_command(45242, [](PayloadView &payload, ServerReply &reply) {  // 0xB0 0xBA  Set velocity filter
+        Motor *motor = motor_at(payload.read_byte());
+        int filter;
+        if(motor == NULL || !payload.read_int(filter)) {
+            return 0;
+        }
+        motor->set_velocity_filter(static_cast<velocity_filter>(filter));
+        return 1;
+    });
+
+
+    // motor interaction get commands, the first byte is the motor number as an ascii digit
+    register_command(41120, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xA0  Actual Velocity
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_actual_velocity());
+        return 1;
+    });
+
+    register_command(41121, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xA1  Actual Voltage
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_actual_voltage());
+        return 1;
+    });
+
+    register_command(41122, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xA2  Current Draw
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_current_draw());
+        return 1;
+    });
+
+    register_command(41123, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xA3  Encoder Position
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_encoder_position());
+        return 1;
+    });
+
+    register_command(41124, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xA4  Brakemode
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_brake_mode());
+        return 1;
+    });
+
+    register_command(41125, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xA5  Gearset
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_gearset());
+        return 1;
+    });
+
+    register_command(41126, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xA6  Port
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_port());
+        return 1;
+    });
+
+    register_command(41127, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xA7  PID Constants
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        pid pid_constants = motor->get_pid();
+        reply.add(pid_constants.kP);
+        reply.add(pid_constants.kI);
+        reply.add(pid_constants.kD);
+        reply.add(pid_constants.i_max);
+        return 1;
+    });
+
+    register_command(41128, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xA8  Slew Rate
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_slew_rate());
+        return 1;
+    });
+
+    register_command(41129, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xA9  Power
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_power());
+        return 1;
+    });
+
+    register_command(41130, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xAA  Temperature
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_temperature());
+        return 1;
+    });
+
+    register_command(41131, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xAB  Torque
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_torque());
+        return 1;
+    });
+
+    register_command(41132, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xAC  Direction
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_direction());
+        return 1;
+    });
+
+    register_command(41133, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xAD  Efficiency
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_efficiency());
+        return 1;
+    });
+
+    register_command(41134, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xAE  is stopped
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->is_stopped());
+        return 1;
+    });
+
+    register_command(41135, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xAF  is reversed
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->is_reversed());
+        return 1;
+    });
+
+    register_command(41136, [](PayloadView &payload, ServerReply &reply) {  // 0xA0 0xB0  Estimated velocity and acceleration
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(motor->get_estimated_velocity());
+        reply.add(motor->get_estimated_acceleration());
+        return 1;
+    });
+
+    register_command(41376, [](PayloadView &payload, ServerReply &reply) {  // 0xA1 0xA0  is registered
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        reply.add(MotorThread::get_instance()->is_registered(*motor));
+        return 1;
+    });
+
+    register_command(41379, [](PayloadView &payload, ServerReply &reply) {  // 0xA1 0xA3  Motor faults
+        Motor *motor = motor_at(payload.read_digit());
+        if(motor == NULL) {
+            return 0;
+        }
+        // motor_fault bits that are raised, 1 stall, 2 disconnected, 4 over temperature
+        reply.add(MotorFaults::get_instance()->get_faults(motor->get_port()));
+        return 1;
+    });
+
+
+    // motor thread interaction post commands
+    register_command(45488, [](PayloadView &payload, ServerReply &reply) {  // 0xB1 0xB0  Reset motor thread timing
+        MotorThread::get_instance()->reset_timing();
+        return 1;
+    });
+
+    register_command(45489, [](PayloadView &payload, ServerReply &reply) {  // 0xB1 0xB1  Set motor thread fixed rate enabled/disabled
+        int enabled;
+        if(!payload.read_int(enabled)) {
+            return 0;
+        }
+        if(enabled) {
+            MotorThread::get_instance()->enable_fixed_rate();
+        } else {
+            MotorThread::get_instance()->disable_fixed_rate();
+        }
+        return 1;
+    });
+
+    register_command(45490, [](PayloadView &payload, ServerReply &reply) {  // 0xB1 0xB2  Set power budget limits
+        // budget in mA, soft and hard temperature limits in degrees C separated by spaces
+        int budget;
+        int soft_limit;
+        int hard_limit;
+        if(!payload.read_int(budget) || !payload.read_int(soft_limit) || !payload.read_int(hard_limit)) {
+            return 0;
+        }
+        return PowerBudget::get_instance()->set_limits(budget, soft_limit, hard_limit);
+    });
+
+    register_command(45491, [](PayloadView &payload, ServerReply &reply) {  // 0xB1 0xB3  Set power budget priority
+        Motor *motor = motor_at(payload.read_byte());
+        double weight;
+        if(motor == NULL || !payload.read_double(weight)) {
+            return 0;
+        }
+        return PowerBudget::get_instance()->set_priority(motor->get_port(), weight);
+    });
+
+    register_command(45492, [](PayloadView &payload, ServerReply &reply) {  // 0xB1 0xB4  Set power budget enabled/disabled
+        int enabled;
+        if(!payload.read_int(enabled)) {
+            return 0;
+        }
+        if(enabled) {
+            PowerBudget::get_instance()->enable();
+        } else {
+            PowerBudget::get_instance()->disable();
+        }
+        return 1;
+    });
+
+    register_command(45493, [](PayloadView &payload, ServerReply &reply) {  // 0xB1 0xB5  Reset power budget counters
+        PowerBudget::get_instance()->reset_status();
+        return 1;
+    });
+
+    register_command(45494, [](PayloadView &payload, ServerReply &reply) {  // 0xB1 0xB6  Set motor trace enabled/disabled
+        Motor *motor = motor_at(payload.read_byte());
+        int enabled;
+        if(motor == NULL || !payload.read_int(enabled)) {
+            return 0;
+        }
+        if(enabled) {
+            return MotorTrace::get_instance()->enable(motor->get_port());
+        }
+        return MotorTrace::get_instance()->disable(motor->get_port());
+    });
+
+    register_command(45495, [](PayloadView &payload, ServerReply &reply) {  // 0xB1 0xB7  Save motor trace to the sd card
+        return MotorTrace::get_instance()->save();
+    });
+
+    register_command(45496, [](PayloadView &payload, ServerReply &reply) {  // 0xB1 0xB8  Clear motor trace
+        MotorTrace::get_instance()->clear();
+        return 1;
+    });
+
+    register_command(45744, [](PayloadView &payload, ServerReply &reply) {  // 0xB2 0xB0  Start system identification
+        // one byte for each motor to test, all of them are tested together ie. a side of the chassis
+        std::vector<Motor*> motors;
+        while(payload.size() > 0) {
+            Motor *motor = motor_at(payload.read_byte());
+            if(motor == NULL) {
+                return 0;
             }
-            break;
-        
-        // encoder interaction post cases
-        // encoder iteraction get cases
-        
-        // analog in sensor interaction post cases
-        // analog in sensor interaction get cases
-        
-        // imu interaction post cases
-        // imu interaction get cases
-        
-        // position tracker post cases
-        // position tracker get cases
-        
-        // sd card interaction post cases
-        
-        // misc 
-        case 43936:  // 0xAB 0xA0  debug
-            status = 1;
-            return_msg_body = " debug msg received: " + request.msg;
-            break;
-            
-        case 43937:  // 0xAB 0xA1  init server
-            status = 1;
-            pros::c::serctl(SERCTL_DISABLE_COBS, NULL);
-            set_server_task_priority(TASK_PRIORITY_DEFAULT);  // more messages are sure to follow so give read task more CPU time
-            delay = 10; // lower delay because of expected messages
-            return_msg_body = "server is running";
-            break;
-            
-        case 43938:  // 0xAB 0xA2  shutdown server
-            status = 1;
-            pros::c::serctl(SERCTL_ENABLE_COBS, NULL);
-            set_server_task_priority(2);
-            delay = 100;
-            return_msg_body = "server is no longer running";
-            break;            
-        
-        default:
-            status = 1;
-            return_msg_body = " [INFO], " + std::to_string(pros::millis()) + ", Invalid Command: " + request.msg;
-            break;
-                    
-        
-    }
-    
-    return_msg.push_back(return_msg_body.length() + 2);
-    return_msg.push_back((char)(request.return_id >> 8) & 0xFF);
-    return_msg.push_back((char)request.return_id & 0xFF);
-    return_msg += return_msg_body;
-    // return_msg += std::to_string(pros::millis());
-    return_msg.push_back('\xC6');
-    
-    entry.content = return_msg;
-    
-    logger.add(entry);
-    
+            motors.push_back(motor);
+        }
+        return SystemId::get_instance()->start(motors);
+    });
+
+    register_command(45745, [](PayloadView &payload, ServerReply &reply) {  // 0xB2 0xB1  Stop system identification
+        SystemId::get_instance()->stop();
+        return 1;
+    });
+
+
+    // motor thread interaction get commands
+    register_command(41377, [](PayloadView &payload, ServerReply &reply) {  // 0xA1 0xA1  Motor thread timing
+        motor_thread_timing timing = MotorThread::get_instance()->get_timing();
+
+        // ticks, overruns, wcet, last period, then the count for each 1ms period bin
+        reply.add(timing.ticks);
+        reply.add(timing.overruns);
+        reply.add(timing.wcet);
+        reply.add(timing.last_period);
+        for(int i=0; i<PERIOD_HISTOGRAM_BINS; i++) {
+            reply.add(timing.period_histogram[i]);
+        }
+        return 1;
+    });
+
+    register_command(41378, [](PayloadView &payload, ServerReply &reply) {  // 0xA1 0xA2  Power budget status
+        power_budget_status budget = PowerBudget::get_instance()->get_status();
+
+        reply.add(budget.total_current);
+        reply.add(budget.demanded_current);
+        reply.add(budget.current_budget);
+        reply.add(budget.headroom);
+        reply.add(budget.max_temperature);
+        reply.add(budget.hottest_port);
+        reply.add(budget.min_scale);
+        reply.add(budget.limited_motors);
+        reply.add(budget.limited_updates);
+        reply.add(budget.updates);
+        return 1;
+    });
+
+    register_command(41632, [](PayloadView &payload, ServerReply &reply) {  // 0xA2 0xA0  System identification model
+        motor_model model = SystemId::get_instance()->get_model();
+
+        // running, then kS, kV, kA, time constant, r squared, and samples of the last fit
+        reply.add(SystemId::get_instance()->is_running());
+        reply.add(model.ff.kS);
+        reply.add(model.ff.kV);
+        reply.add(model.ff.kA);
+        reply.add(model.time_constant);
+        reply.add(model.r_squared);
+        reply.add(model.samples);
+        return 1;
+    });
+
+
+    // logger interaction post commands
+    register_command(46000, [](PayloadView &payload, ServerReply &reply) {  // 0xB3 0xB0  Set logger policy
+        // one byte for the log_source, then policy, capacity, and sample every separated by spaces
+        int source = payload.read_byte();
+        int policy;
+        int capacity;
+        int sample_every;
+        if(source < 0 || !payload.read_int(policy) || !payload.read_int(capacity) || !payload.read_int(sample_every)) {
+            return 0;
+        }
+        return Logger::set_policy(static_cast<log_source>(source), static_cast<log_policy>(policy), capacity, sample_every);
+    });
+
+
+    // logger interaction get commands
+    register_command(41888, [](PayloadView &payload, ServerReply &reply) {  // 0xA3 0xA0  Logger status
+        logger_stats stats = Logger::get_stats();
+
+        // depth, high water, written, dropped because the queue was full, and throughput, then
+        // policy, capacity, sample every, accepted, dropped, depth, and high water for each log_source
+        reply.add(stats.depth);
+        reply.add(stats.high_water);
+        reply.add(stats.written);
+        reply.add(stats.dropped);
+        reply.add(stats.throughput);
+        for(int i=0; i<LOGGER_SOURCES; i++) {
+            log_source_stats source = Logger::get_source_stats(static_cast<log_source>(i));
+            reply.add(source.policy);
+            reply.add(source.capacity);
+            reply.add(source.sample_every);
+            reply.add(source.accepted);
+            reply.add(source.dropped);
+            reply.add(source.depth);
+            reply.add(source.high_water);
+        }
+        return 1;
+    });
+
+
+    // misc
+    register_command(43936, [](PayloadView &payload, ServerReply &reply) {  // 0xAB 0xA0  debug
+        reply.add_text(payload.remaining(), payload.size());
+        return 1;
+    });
+
+    register_command(43937, handle_init_server);  // 0xAB 0xA1  init server
+    register_command(43938, handle_shutdown_server);  // 0xAB 0xA2  shutdown server
+    register_command(43939, handle_command_stats);  // 0xAB 0xA3  calls and latency of a command
+
+    register_command(43940, [](PayloadView &payload, ServerReply &reply) {  // 0xAB 0xA4  Reply queue status
+        server_reply_stats stats = get_reply_stats();
+
+        // replies sent, dropped because the queue was full, and waiting to be sent
+        reply.add(stats.sent);
+        reply.add(stats.dropped);
+        reply.add(stats.depth);
+        return 1;
+    });
+}
+
+
+
+/**
+ * the time in the handler is added to the command's counters, the table is
+ * searched again after since a command could have been registered while the
+ * handler ran
+ */
+int Server::handle_request(server_request_record &request) {
+    ServerReply reply;
+    PayloadView payload(request.msg, request.length);
+
+    lock_commands();
+    int index = find_command(request.command_id);
+    server_handler handler = index >= 0 ? commands[index].handler : NULL;
+    commands_lock.exchange( false );
+
+    if(handler == NULL) {
+        return queue_reply(request, e_server_unknown_command, reply);
+    }
+
+    std::uint32_t start = Timestamp::micros();
+    int status = handler(payload, reply);
+    std::uint32_t elapsed = Timestamp::micros() - start;
+
+    lock_commands();
+    index = find_command(request.command_id);
+    server_command &command = commands[index];
+    command.calls += 1;
+    command.failures += status ? 0 : 1;
+    command.total_us += elapsed;
+    command.max_us = std::max(command.max_us, elapsed);
+    commands_lock.exchange( false );
+
+    if(!status) {
+        return queue_reply(request, e_server_failed, reply);
+    }
+    return queue_reply(request, reply.truncated() ? e_server_truncated : e_server_ok, reply);
+}
+
+
+
+/**
+ * the frame is built in the claimed record so nothing is copied again
+ * before it is written
+ */
+int Server::queue_reply( const server_request_record &request, server_status status, ServerReply &reply ) {
+    std::uint32_t position;
+    server_reply_record *record = replies.claim(position);
+    if(record == NULL) {
+        Logger logger;
+        logger.add(e_log_source_server, e_log_cerr, "[WARNING], %u, reply to %u dropped, queue is full", (unsigned int)pros::millis(), request.return_id);
+        return 0;
+    }
+
+    std::uint8_t *frame = record->frame;
+    int length = reply.size() + 5;
+    frame[0] = SERVER_PREAMBLE1;
+    frame[1] = SERVER_PREAMBLE2;
+    frame[2] = SERVER_REPLY_PREAMBLE3;
+    put_u16(frame + 3, length);
+    put_u16(frame + 5, request.return_id);
+    put_u16(frame + 7, request.command_id);
+    frame[9] = status;
+    std::memcpy(frame + 10, reply.data(), reply.size());
+    frame[10 + reply.size()] = crc8(frame + 3, length + 2);
+    record->length = reply.size() + SERVER_REPLY_OVERHEAD;
+
+    replies.publish(position);
     return 1;
 }
 
 
 
+int Server::send( ) {
+    if ( sending.exchange( true ) )
+    {
+        return 0;
+    }
+
+    int sent = 0;
+    server_reply_record *record;
+    while ( (record = replies.peek()) != NULL )
+    {
+        std::fwrite(record->frame, 1, record->length, stdout);
+        replies.pop();
+        sent += 1;
+    }
+
+    if ( sent )
+    {
+        std::fflush(stdout);
+        replies_sent += sent;
+    }
+
+    sending.exchange( false );
+    return sent;
+}
+
+
+
+server_reply_stats Server::get_reply_stats( ) {
+    return {replies_sent, replies.get_dropped(), replies.size()};
+}
+
+
+
 
 void Server::start_server() {
     read_thread->resume();
+    send_thread->resume();
 }
 
 void Server::stop_server() {
     read_thread->suspend();
+    send_thread->suspend();
 }
 
 void Server::set_server_task_priority(int new_prio) {
@@ -506,25 +1079,26 @@ void Server::clear_stdin() {
 
 
 
+/**
+ * each request is copied out of the ring before it is handled so the read
+ * task has the slot back while the handler runs
+ */
 int Server::handle_requests(int max_requests) {
-    std::vector<server_request> requests;
-    
-    if ( !request_queue.empty() ) {
-        while ( lock.exchange( true ) ); //aquire lock
-        for(int i=0; i<max_requests; i++) {
-            if ( !request_queue.empty() ) {
-                server_request request = request_queue.front();
-                request_queue.pop();
-                
-                requests.push_back(request);
-            }
-        }    
-        lock.exchange( false ); //release lock
+    if ( handling.exchange( true ) )
+    {
+        return 0;
     }
-    
-    for (int i=0; i<requests.size(); i++) {
-        handle_request(requests.at(i));
+
+    int handled = 0;
+    server_request_record *record;
+    while ( handled < max_requests && (record = requests.peek()) != NULL )
+    {
+        server_request_record request = *record;
+        requests.pop();
+        handle_request(request);
+        handled += 1;
     }
-    
-    return requests.size();
+
+    handling.exchange( false );
+    return handled;
 }
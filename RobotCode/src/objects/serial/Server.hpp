@@ -2,7 +2,7 @@
  * @file: ./RobotCode/src/objects/serial/Server.hpp
  * @author: Aiden Carney
  * @reviewed_on:
- * @reviewed_by: 
+ * @reviewed_by:
  *
  * contains class for a server that works over serial communication
  */
@@ -11,60 +11,398 @@
 #define __SERVER_HPP__
 
 #include <atomic>
-#include <queue>
 #include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "FrameReader.hpp"
+#include "RecordRing.hpp"
+
+
+#define SERVER_MAX_COMMANDS     96
+#define SERVER_REPLY_SIZE       240   // max bytes of values in one reply
+#define SERVER_REPLY_RECORDS    16    // power of two so positions wrap cleanly
+#define SERVER_REQUEST_RECORDS  16    // power of two so positions wrap cleanly
+#define SERVER_REPLY_PREAMBLE3  0xE1  // replaces the third byte of the request preamble so replies are not mistaken for requests
+#define SERVER_REPLY_OVERHEAD   11    // preamble, length (2), return id (2), command id (2), status, and crc
+#define SERVER_MAX_REPLY_FRAME  (SERVER_REPLY_SIZE + SERVER_REPLY_OVERHEAD)
+#define SERVER_SEND_PERIOD      2     // ms between wakes of the sender task
+#define SERVER_ACTIVE_DELAY     2     // ms the read task sleeps while the server is initialized
+
+
+typedef enum {
+    e_server_int32 = 1,  // same codes as telemetry_type
+    e_server_uint32,
+    e_server_float,
+    e_server_double,
+    e_server_text        // length (u8) then the chars, not terminated
+} server_value_type;
+
+
+typedef enum {
+    e_server_failed = 0,
+    e_server_ok,
+    e_server_unknown_command,
+    e_server_truncated   // the command was carried out but its values did not fit in the reply
+} server_status;
+
+
+/**
+ * Contains a view of a request's msg that handlers read values from in order
+ *
+ * nothing is copied or erased, reading moves a position through the msg.
+ * Every read returns false or -1 once the msg runs out so a short request
+ * fails the command instead of throwing
+ */
+class PayloadView
+{
+    private:
+        const char *data;
+        int length;
+        int position;
+
+    public:
+        PayloadView( const char *data, int length );
+
+        /**
+         * @return: int -> the next byte as a number, ie. the motor number of
+         *                 post commands, -1 if there is none
+         */
+        int read_byte( );
+
+        /**
+         * @return: int -> the next byte as an ascii digit, ie. the motor
+         *                 number of get commands, -1 if it is not a digit
+         */
+        int read_digit( );
+
+        /**
+         * @param: int &value -> set to the number
+         * @return: bool -> true if a number was read
+         *
+         * reads a decimal number written as text, leading spaces are skipped
+         */
+        bool read_int( int &value );
+
+        /**
+         * @param: double &value -> set to the number
+         * @return: bool -> true if a number was read
+         *
+         * reads a decimal number written as text, leading spaces are skipped
+         */
+        bool read_double( double &value );
+
+        /**
+         * @param: double &value -> set to the number
+         * @return: bool -> true if 8 bytes were left
+         *
+         * reads a double sent as its 8 bytes
+         */
+        bool read_raw_double( double &value );
+
+        /**
+         * @return: const char* -> what has not been read yet
+         */
+        const char* remaining( );
+
+        /**
+         * @return: int -> bytes that have not been read yet
+         */
+        int size( );
+};
+
+
+/**
+ * Contains the values a handler replies with, each one is a server_value_type
+ * byte followed by the value in little endian
+ *
+ * both the V5 and the sim are little endian so values are copied as is, like
+ * telemetry samples. A value that does not fit is dropped and the reply is
+ * marked as truncated
+ */
+class ServerReply
+{
+    private:
+        std::uint8_t values[SERVER_REPLY_SIZE];
+        int length;
+        bool overflowed;
+
+        /**
+         * @param: server_value_type type -> type byte written before the value
+         * @param: const void *value -> the value
+         * @param: int size -> bytes in the value
+         * @return: int -> 1 if the value fit, 0 otherwise
+         */
+        int put( server_value_type type, const void *value, int size );
+
+    public:
+        ServerReply();
+
+        /**
+         * @param: T value -> integer, bool, enum, float, or double
+         * @return: int -> 1 if the value fit, 0 otherwise
+         *
+         * integers up to 32 bits are sent as int32 or uint32 and floating
+         * point values keep their precision
+         */
+        template <typename T>
+        int add( T value ) {
+            if constexpr ( std::is_same<T, double>::value )
+            {
+                return put(e_server_double, &value, sizeof(value));
+            }
+            else if constexpr ( std::is_floating_point<T>::value )
+            {
+                float number = value;
+                return put(e_server_float, &number, sizeof(number));
+            }
+            else
+            {
+                static_assert(sizeof(T) <= sizeof(std::int32_t), "server replies hold integers up to 32 bits");
+                if constexpr ( std::is_unsigned<T>::value )
+                {
+                    std::uint32_t number = value;
+                    return put(e_server_uint32, &number, sizeof(number));
+                }
+                else
+                {
+                    std::int32_t number = value;
+                    return put(e_server_int32, &number, sizeof(number));
+                }
+            }
+        }
+
+        /**
+         * @param: const char *text -> chars to send, does not need to be terminated
+         * @param: int size -> number of chars, more than 255 are cut off
+         * @return: int -> 1 if the text fit, 0 otherwise
+         */
+        int add_text( const char *text, int size );
+
+        /**
+         * @param: const char *text -> terminated string to send
+         * @return: int -> 1 if the text fit, 0 otherwise
+         */
+        int add_text( const char *text );
+
+        /**
+         * @return: const std::uint8_t* -> the encoded values
+         */
+        const std::uint8_t* data( );
+
+        /**
+         * @return: int -> bytes of encoded values
+         */
+        int size( );
+
+        /**
+         * @return: bool -> true if a value was dropped because the reply was full
+         */
+        bool truncated( );
+};
+
+
+/**
+ * @param: PayloadView &payload -> msg of the request
+ * @param: ServerReply &reply -> values of the reply, empty when the handler is called
+ * @return: int -> 1 if the command was carried out, 0 otherwise
+ */
+typedef int (*server_handler)( PayloadView &payload, ServerReply &reply );
 
 
 typedef struct
 {
-    uint16_t return_id;
-    uint16_t command_id;
-    std::string msg;
-} server_request;
+    std::uint16_t command_id;
+    server_handler handler;
+    std::uint32_t calls;
+    std::uint32_t failures;    // calls that returned 0
+    std::uint32_t total_us;    // time spent in the handler
+    std::uint32_t max_us;
+} server_command;
 
+
+typedef struct
+{
+    std::uint16_t length;  // bytes in the frame
+    std::uint8_t frame[SERVER_MAX_REPLY_FRAME];
+} server_reply_record;
+
+
+typedef struct
+{
+    std::uint32_t sent;     // replies written to stdout
+    std::uint32_t dropped;  // replies dropped because the queue was full
+    int depth;              // replies waiting for the sender task
+} server_reply_stats;
+
+
+/**
+ * Contains the server that reads requests from stdin and replies to them on
+ * stdout
+ *
+ * replies do not go through the logger, they are queued in a preallocated
+ * ring and the sender task writes them out every SERVER_SEND_PERIOD ms. The
+ * sender task also handles the requests that were read so a request is
+ * answered within a few ms without anything else calling handle_requests().
+ * Requests are passed from the read task in a ring as well so neither task
+ * ever waits on the other, whatever their priorities are
+ * A reply is
+ *     0xAA 0x55 0xE1 length(u16) return_id(u16) command_id(u16) status values crc8
+ * where length counts the ids, status, and values, the crc is the one
+ * telemetry uses and covers length through the values, and everything is
+ * little endian. status is a server_status and values are encoded by
+ * ServerReply
+ */
 class Server
 {
     private:
-        static std::atomic<bool> lock;
-        static std::queue<server_request> request_queue;
-        
+        static RecordRing<server_request_record, SERVER_REQUEST_RECORDS> requests;
+        static server_request_record *pending_request;  // claimed by the read task for the next request, NULL if none is claimed
+        static std::uint32_t pending_position;
+        static std::atomic<bool> handling;  // held by the one task taking from the request ring
+
         static pros::Task *read_thread;  // the thread for reading stdin
-        
+        static pros::Task *send_thread;  // the thread for handling requests and writing replies
+        static FrameReader reader;  // only used by the read thread
+
+        static RecordRing<server_reply_record, SERVER_REPLY_RECORDS> replies;
+        static std::atomic<bool> sending;  // held by the one task taking from the ring
+        static std::uint32_t replies_sent;
+
+        /**
+         * @param: void* -> not used, but necessary to follow thread making constructor
+         * @return: None
+         *
+         * reads what is waiting on stdin in blocks, queues every request
+         * that was completed, and then sleeps for delay ms
+         */
         static void read_stdin(void*);
-        
+
+        /**
+         * @return: None
+         *
+         * parses the requests the reader has into the request ring, only
+         * called by the read task
+         */
+        static void queue_requests( );
+
+        /**
+         * @param: void* -> not used, but necessary to follow thread making constructor
+         * @return: None
+         *
+         * handles what requests are queued and sends the replies every
+         * SERVER_SEND_PERIOD ms
+         */
+        static void send_replies(void*);
+
         static int num_instances;
         static bool debug;
-        
+
         static int delay;
-        
-        int handle_request(server_request request);
-        
+
+        static server_command commands[SERVER_MAX_COMMANDS];  // sorted by command id
+        static int num_commands;
+        static std::atomic<bool> commands_lock;  // held while the table is searched or changed, not while a handler runs
+
+        /**
+         * @return: None
+         *
+         * takes commands_lock, sleeping while another task has it
+         */
+        static void lock_commands( );
+
+        /**
+         * @param: std::uint16_t command_id -> id to look for
+         * @return: int -> index of the command in the table, -1 if it is not registered
+         *
+         * binary search, call with commands_lock held
+         */
+        static int find_command( std::uint16_t command_id );
+
+        /**
+         * @return: None
+         *
+         * registers the commands in Server.cpp, done once by the first server
+         */
+        static void register_builtin_commands( );
+
+        static int handle_init_server( PayloadView &payload, ServerReply &reply );
+        static int handle_shutdown_server( PayloadView &payload, ServerReply &reply );
+        static int handle_command_stats( PayloadView &payload, ServerReply &reply );
+
+        /**
+         * @param: const server_request_record &request -> request that was answered
+         * @param: server_status status -> how the command went
+         * @param: ServerReply &reply -> values to send
+         * @return: int -> 1 if the reply was queued, 0 if the queue was full
+         */
+        static int queue_reply( const server_request_record &request, server_status status, ServerReply &reply );
+
+        static int handle_request(server_request_record &request);
+
     public:
         Server();
         ~Server();
-        
+
         /**
          * @return: None
          *
-         * starts the thread or resmes it if it was stopped
+         * starts the threads or resmes them if they were stopped
          */
         void start_server();
-        
+
         /**
          * @return: None
          *
-         * stops the thread from being scheduled
+         * stops the threads from being scheduled
          */
         void stop_server();
-        
-        void set_server_task_priority(int new_prio);
-        
+
+        static void set_server_task_priority(int new_prio);
+
         void set_debug_mode(bool debug_mode);
-        
+
         void clear_stdin();
-        
-        int handle_requests(int max_requests=10);
+
+        /**
+         * @param: int max_requests -> most requests to handle in this call
+         * @return: int -> number of requests handled, 0 if another task is already handling them
+         */
+        static int handle_requests(int max_requests=10);
+
+        /**
+         * @return: int -> number of replies written
+         *
+         * writes every reply that is queued to stdout and flushes it, returns
+         * right away if another task is already sending
+         */
+        static int send( );
+
+        /**
+         * @return: server_reply_stats -> counters of the reply queue
+         */
+        static server_reply_stats get_reply_stats( );
+
+        /**
+         * @param: std::uint16_t command_id -> id of the command, see commands.ods
+         * @param: server_handler handler -> function that carries out the command
+         * @return: int -> 1 if the command was registered, 0 if the id is
+         *                 taken or the table is full
+         *
+         * subsystems register their own commands so they do not have to be
+         * added to the server, the table is kept sorted so a request is
+         * looked up with a binary search
+         */
+        static int register_command( std::uint16_t command_id, server_handler handler );
+
+        /**
+         * @param: std::uint16_t command_id -> id of the command
+         * @param: server_command &command -> set to the command and its call and latency counters
+         * @return: int -> 1 if the command is registered, 0 otherwise
+         */
+        static int get_command( std::uint16_t command_id, server_command &command );
 };
-        
-        
+
+
 #endif
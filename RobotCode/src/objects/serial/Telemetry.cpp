@@ -0,0 +1,412 @@
+/**
+ * @file: ./RobotCode/src/objects/serial/Telemetry.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * @see Telemetry.hpp
+ *
+ * contains implementation for typed telemetry channels
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "main.h"
+
+#include "Logger.hpp"
+#include "Telemetry.hpp"
+
+
+namespace
+{
+    int type_size( std::uint8_t type )
+    {
+        switch ( type )
+        {
+            case e_telemetry_int32:
+            case e_telemetry_uint32:
+            case e_telemetry_float:
+                return 4;
+            case e_telemetry_double:
+                return 8;
+            default:
+                return 0;
+        }
+    }
+
+    /**
+     * crc-8 with polynomial 0x07, matches crc8() in PIDDebugging/telemetry_decoder.py
+     */
+    std::uint8_t crc8( const std::uint8_t *data, int length )
+    {
+        std::uint8_t crc = 0;
+        for ( int i = 0; i < length; i++ )
+        {
+            crc ^= data[i];
+            for ( int bit = 0; bit < 8; bit++ )
+            {
+                crc = (crc & 0x80) ? (std::uint8_t)((crc << 1) ^ 0x07) : (std::uint8_t)(crc << 1);
+            }
+        }
+        return crc;
+    }
+
+    /**
+     * writes a u32 little endian
+     */
+    void put_u32( std::uint8_t *destination, std::uint32_t value )
+    {
+        destination[0] = value & 0xFF;
+        destination[1] = (value >> 8) & 0xFF;
+        destination[2] = (value >> 16) & 0xFF;
+        destination[3] = value >> 24;
+    }
+
+    /**
+     * copies a string with its terminator and returns the bytes copied
+     */
+    int put_string( std::uint8_t *destination, const char *string )
+    {
+        int length = std::strlen(string) + 1;
+        std::memcpy(destination, string, length);
+        return length;
+    }
+}
+
+
+
+Telemetry *Telemetry::telemetry_obj = NULL;
+
+
+Telemetry::Telemetry()
+{
+    std::memset(channels, 0, sizeof(channels));
+    num_channels = 0;
+    register_lock = false;
+    flushing = false;
+    output = stdout;
+    schemas_sent = 0;
+    last_schema_time = 0;
+    flush_thread = NULL;
+}
+
+
+Telemetry::~Telemetry()
+{
+    if ( flush_thread != NULL )
+    {
+        flush_thread->remove();
+        delete flush_thread;
+    }
+    close();
+}
+
+
+/**
+ * inits object if object is not already initialized based on a static bool
+ * sets bool if it is not set
+ */
+Telemetry* Telemetry::get_instance()
+{
+    if ( telemetry_obj == NULL )
+    {
+        telemetry_obj = new Telemetry;
+    }
+    return telemetry_obj;
+}
+
+
+
+/**
+ * a channel is filled in before num_channels is raised past it so push() and
+ * flush() only ever see complete channels
+ */
+int Telemetry::register_channel( std::string name, std::vector<telemetry_field> fields )
+{
+    Logger logger;
+    int sample_size = 0;
+    for ( const telemetry_field &field : fields )
+    {
+        if ( type_size(field.type) == 0 || std::strlen(field.name) >= TELEMETRY_NAME_SIZE || std::strlen(field.unit) >= TELEMETRY_NAME_SIZE )
+        {
+            logger.add(e_log_cerr, "[ERROR], %u, telemetry channel %s has an invalid field", (unsigned int)pros::millis(), name.c_str());
+            return -1;
+        }
+        sample_size += type_size(field.type);
+    }
+
+    if ( name.empty() || name.size() >= TELEMETRY_NAME_SIZE || fields.empty() || fields.size() > TELEMETRY_MAX_FIELDS || sample_size > TELEMETRY_SAMPLE_SIZE )
+    {
+        logger.add(e_log_cerr, "[ERROR], %u, telemetry channel %s is too large to register", (unsigned int)pros::millis(), name.c_str());
+        return -1;
+    }
+
+    while ( register_lock.exchange( true ) );
+
+    int registered = num_channels.load(std::memory_order_relaxed);
+    for ( int i = 0; i < registered; i++ )
+    {
+        if ( name != channels[i].name )
+        {
+            continue;
+        }
+
+        bool same_fields = channels[i].num_fields == fields.size();
+        for ( int j = 0; same_fields && j < fields.size(); j++ )
+        {
+            same_fields = (
+                channels[i].types[j] == fields.at(j).type
+                && std::strcmp(channels[i].field_names[j], fields.at(j).name) == 0
+                && std::strcmp(channels[i].units[j], fields.at(j).unit) == 0
+            );
+        }
+
+        register_lock.exchange(false);
+        if ( !same_fields )
+        {
+            logger.add(e_log_cerr, "[ERROR], %u, telemetry channel %s was already registered with other fields", (unsigned int)pros::millis(), name.c_str());
+            return -1;
+        }
+        return i;
+    }
+
+    if ( registered >= TELEMETRY_MAX_CHANNELS )
+    {
+        register_lock.exchange(false);
+        logger.add(e_log_cerr, "[WARNING], %u, no telemetry channel left for %s", (unsigned int)pros::millis(), name.c_str());
+        return -1;
+    }
+
+    telemetry_channel &channel = channels[registered];
+    std::strcpy(channel.name, name.c_str());
+    channel.num_fields = fields.size();
+    for ( int j = 0; j < fields.size(); j++ )
+    {
+        channel.types[j] = fields.at(j).type;
+        std::strcpy(channel.field_names[j], fields.at(j).name);
+        std::strcpy(channel.units[j], fields.at(j).unit);
+    }
+    channel.sample_size = sample_size;
+
+    num_channels.store(registered + 1, std::memory_order_release);
+    register_lock.exchange(false);
+
+    return registered;
+}
+
+
+
+bool Telemetry::push( int channel, const void *sample, std::size_t size )
+{
+    if ( channel < 0 || channel >= num_channels.load(std::memory_order_acquire) || size != channels[channel].sample_size )
+    {
+        return false;
+    }
+
+    record_stamp stamp = Timestamp::stamp(e_stamp_telemetry);  // taken first so a dropped sample leaves a gap
+    std::uint32_t position;
+    telemetry_record *record = ring.claim(position);
+    if ( record == NULL )
+    {
+        return false;
+    }
+
+    record->time = stamp.time;
+    record->sequence = stamp.sequence;
+    record->channel = channel;
+    record->length = size;
+    std::memcpy(record->sample, sample, size);
+    ring.publish(position);
+
+    return true;
+}
+
+
+
+int Telemetry::build_frame( std::uint8_t *frame, telemetry_frame kind, int channel, const std::uint8_t *payload, std::uint16_t length )
+{
+    frame[0] = TELEMETRY_SYNC1;
+    frame[1] = TELEMETRY_SYNC2;
+    frame[2] = kind;
+    frame[3] = channel;
+    frame[4] = length & 0xFF;
+    frame[5] = length >> 8;
+    if ( payload != NULL )
+    {
+        std::memcpy(frame + 6, payload, length);
+    }
+    frame[6 + length] = crc8(frame + 2, length + 4);
+
+    return length + TELEMETRY_FRAME_OVERHEAD;
+}
+
+
+int Telemetry::build_schema_frame( int channel, std::uint8_t *frame )
+{
+    const telemetry_channel &schema = channels[channel];
+    std::uint8_t *payload = frame + 6;
+    int length = 0;
+
+    payload[length++] = TELEMETRY_VERSION;
+    payload[length++] = schema.sample_size & 0xFF;
+    payload[length++] = schema.sample_size >> 8;
+    payload[length++] = schema.num_fields;
+    length += put_string(payload + length, schema.name);
+    for ( int j = 0; j < schema.num_fields; j++ )
+    {
+        payload[length++] = schema.types[j];
+        length += put_string(payload + length, schema.field_names[j]);
+        length += put_string(payload + length, schema.units[j]);
+    }
+
+    return build_frame(frame, e_telemetry_schema_frame, channel, NULL, length);
+}
+
+
+
+/**
+ * schemas are written one frame at a time since they are rare, samples are
+ * built into one buffer so a flush is a single write. A sample of a channel
+ * registered after the schemas were written waits for the next flush so its
+ * schema always comes first
+ */
+int Telemetry::flush( )
+{
+    if ( flushing.exchange(true) )  // another task is flushing
+    {
+        return 0;
+    }
+
+    std::uint32_t now = pros::millis();
+    if ( now - last_schema_time >= TELEMETRY_SCHEMA_PERIOD )
+    {
+        schemas_sent = 0;
+        last_schema_time = now;
+    }
+
+    int registered = num_channels.load(std::memory_order_acquire);
+    bool wrote_schema = schemas_sent < registered;
+    for ( ; schemas_sent < registered; schemas_sent++ )
+    {
+        int length = build_schema_frame(schemas_sent, frame_buffer);
+        std::fwrite(frame_buffer, 1, length, output);
+    }
+
+    int written = 0;
+    int length = 0;
+    telemetry_record *record;
+    while ( written < TELEMETRY_FLUSH_SAMPLES && (record = ring.peek()) != NULL && record->channel < registered )
+    {
+        std::uint8_t *frame = frame_buffer + length;
+        std::uint8_t *payload = frame + 6;
+        put_u32(payload, record->time);
+        put_u32(payload + 4, record->sequence);
+        std::memcpy(payload + TELEMETRY_STAMP_SIZE, record->sample, record->length);
+        length += build_frame(frame, e_telemetry_sample_frame, record->channel, NULL, record->length + TELEMETRY_STAMP_SIZE);
+
+        ring.pop();
+        written += 1;
+    }
+
+    if ( length > 0 )
+    {
+        std::fwrite(frame_buffer, 1, length, output);
+    }
+    if ( length > 0 || wrote_schema )
+    {
+        std::fflush(output);
+    }
+
+    flushing.store(false);
+    return written;
+}
+
+
+
+int Telemetry::open( std::string path )
+{
+    while ( flushing.exchange(true) )
+    {
+        pros::delay(1);
+    }
+
+    if ( output != stdout )
+    {
+        std::fclose(output);
+    }
+
+    output = std::fopen(path.c_str(), "wb");
+    schemas_sent = 0;
+    int opened = 1;
+    if ( output == NULL )
+    {
+        output = stdout;
+        opened = 0;
+    }
+    flushing.store(false);
+
+    if ( !opened )
+    {
+        Logger logger;
+        logger.add(e_log_cerr, "[ERROR], %u, could not open %s for telemetry", (unsigned int)pros::millis(), path.c_str());
+    }
+    return opened;
+}
+
+
+void Telemetry::close( )
+{
+    while ( flush() == TELEMETRY_FLUSH_SAMPLES );
+
+    while ( flushing.exchange(true) )
+    {
+        pros::delay(1);
+    }
+
+    if ( output != stdout )
+    {
+        std::fclose(output);
+        output = stdout;
+        schemas_sent = 0;
+    }
+    flushing.store(false);
+}
+
+
+
+void Telemetry::flush_task(void*)
+{
+    Telemetry *telemetry = Telemetry::get_instance();
+    while ( true )
+    {
+        while ( telemetry->flush() == TELEMETRY_FLUSH_SAMPLES );  // keep going while there is a backlog
+        pros::delay(TELEMETRY_FLUSH_PERIOD);
+    }
+}
+
+
+void Telemetry::start_flush_task( )
+{
+    if ( flush_thread == NULL )
+    {
+        flush_thread = new pros::Task( flush_task, (void*)NULL, TASK_PRIORITY_MIN + 1, TASK_STACK_DEPTH_DEFAULT, "telemetry_flush");
+    }
+}
+
+
+
+int Telemetry::get_count( )
+{
+    return ring.size();
+}
+
+
+std::uint32_t Telemetry::get_dropped( )
+{
+    return ring.get_dropped();
+}
@@ -0,0 +1,232 @@
+/**
+ * @file: ./RobotCode/src/objects/serial/Telemetry.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains class for typed telemetry channels that are written out as a
+ * framed binary stream instead of formatted text
+ */
+
+#ifndef __TELEMETRY_HPP__
+#define __TELEMETRY_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "main.h"
+
+#include "RecordRing.hpp"
+#include "Timestamp.hpp"
+
+
+#define TELEMETRY_MAX_CHANNELS    16
+#define TELEMETRY_MAX_FIELDS      24
+#define TELEMETRY_NAME_SIZE       24    // chars in a channel, field, or unit name including the terminator
+#define TELEMETRY_SAMPLE_SIZE     192   // max bytes in one sample
+#define TELEMETRY_RECORDS         256   // power of two so positions wrap cleanly
+#define TELEMETRY_FLUSH_SAMPLES   64    // max samples written by one flush()
+#define TELEMETRY_FLUSH_PERIOD    20    // ms between flushes of the flush task
+#define TELEMETRY_SCHEMA_PERIOD   2000  // ms between repeats of the schemas so a reader that starts late can decode
+
+#define TELEMETRY_SYNC1           0xA5  // never in ascii text so frames can share a stream with the logger
+#define TELEMETRY_SYNC2           0x5A
+#define TELEMETRY_VERSION         2     // 2 stamps samples with us and a sequence number instead of ms
+#define TELEMETRY_FRAME_OVERHEAD  7     // sync, sync, kind, channel, length (2), and crc
+#define TELEMETRY_STAMP_SIZE      8     // time and sequence number at the start of a sample payload
+
+
+typedef enum {
+    e_telemetry_int32 = 1,
+    e_telemetry_uint32,
+    e_telemetry_float,
+    e_telemetry_double
+} telemetry_type;
+
+
+typedef enum {
+    e_telemetry_schema_frame = 1,
+    e_telemetry_sample_frame
+} telemetry_frame;
+
+
+typedef struct
+{
+    const char *name;
+    telemetry_type type;
+    const char *unit;
+} telemetry_field;
+
+
+typedef struct
+{
+    char name[TELEMETRY_NAME_SIZE];
+    std::uint8_t num_fields;
+    std::uint8_t types[TELEMETRY_MAX_FIELDS];  // telemetry_type
+    char field_names[TELEMETRY_MAX_FIELDS][TELEMETRY_NAME_SIZE];
+    char units[TELEMETRY_MAX_FIELDS][TELEMETRY_NAME_SIZE];
+    std::uint16_t sample_size;
+} telemetry_channel;
+
+
+typedef struct
+{
+    std::uint32_t time;      // us when the sample was pushed
+    std::uint32_t sequence;
+    std::uint8_t channel;
+    std::uint16_t length;
+    std::uint8_t sample[TELEMETRY_SAMPLE_SIZE];
+} telemetry_record;
+
+
+/**
+ * Contains typed channels that tasks push samples to, samples are queued and
+ * written out as binary frames by the flush task
+ *
+ * a channel is registered once with the name, type, and unit of each field,
+ * after that a sample is a packed struct with the fields in the same order
+ * and is copied into a preallocated ring as is, so pushing never formats,
+ * allocates, or waits
+ *
+ * every frame is
+ *     0xA5 0x5A kind channel length(u16) payload crc8
+ * where the crc covers kind through the payload and everything is little
+ * endian. A schema frame's payload is the version, sample size (u16), number
+ * of fields, and the channel name followed by type, name, and unit for each
+ * field, strings are null terminated. A sample frame's payload is the time in
+ * us (u32) and sequence number (u32) from Timestamp followed by the sample.
+ * Schemas are repeated every TELEMETRY_SCHEMA_PERIOD ms. See
+ * PIDDebugging/telemetry_decoder.py
+ */
+class Telemetry
+{
+    private:
+        Telemetry();
+        static Telemetry *telemetry_obj;
+
+        telemetry_channel channels[TELEMETRY_MAX_CHANNELS];
+        std::atomic<int> num_channels;  // channels below this are complete and never change
+        std::atomic<bool> register_lock;  // serializes register_channel(), never taken by push()
+
+        RecordRing<telemetry_record, TELEMETRY_RECORDS> ring;
+        std::atomic<bool> flushing;  // held by the one task taking from the ring
+        std::FILE *output;
+        int schemas_sent;  // channels whose schema has been written since the last repeat
+        std::uint32_t last_schema_time;
+        std::uint8_t frame_buffer[TELEMETRY_FLUSH_SAMPLES * (TELEMETRY_SAMPLE_SIZE + TELEMETRY_FRAME_OVERHEAD + TELEMETRY_STAMP_SIZE)];
+
+        pros::Task *flush_thread;
+
+        /**
+         * @param: std::uint8_t *frame -> where to build the frame
+         * @param: telemetry_frame kind -> schema or sample
+         * @param: int channel -> channel the frame is for
+         * @param: const std::uint8_t *payload -> the payload, NULL if it is already in place after the header
+         * @param: std::uint16_t length -> bytes in the payload
+         * @return: int -> bytes in the frame
+         */
+        static int build_frame( std::uint8_t *frame, telemetry_frame kind, int channel, const std::uint8_t *payload, std::uint16_t length );
+
+        /**
+         * @param: int channel -> the channel
+         * @param: std::uint8_t *frame -> where to build the frame
+         * @return: int -> bytes in the frame
+         */
+        int build_schema_frame( int channel, std::uint8_t *frame );
+
+        /**
+         * @param: void* -> not used, but necessary to follow thread making constructor
+         * @return: None
+         *
+         * flushes the queue every TELEMETRY_FLUSH_PERIOD ms
+         */
+        static void flush_task(void*);
+
+    public:
+        ~Telemetry();
+
+        /**
+         * @return: Telemetry* -> instance of class to be used throughout program
+         *
+         * give the user the singleton instance of the class
+         */
+        static Telemetry* get_instance();
+
+        /**
+         * @param: std::string name -> name of the channel, shorter than TELEMETRY_NAME_SIZE
+         * @param: std::vector<telemetry_field> fields -> fields of a sample in order
+         * @return: int -> the channel, -1 if it could not be registered
+         *
+         * registers a channel, if one with the same name and fields was
+         * already registered that one is returned so it is safe to call this
+         * every time a routine starts
+         */
+        int register_channel( std::string name, std::vector<telemetry_field> fields );
+
+        /**
+         * @param: int channel -> channel from register_channel()
+         * @param: const void *sample -> packed sample with the channel's fields in order
+         * @param: std::size_t size -> size of the sample
+         * @return: bool -> true if the sample was queued, false if the channel or size
+         *                  is wrong or the queue was full
+         */
+        bool push( int channel, const void *sample, std::size_t size );
+
+        /**
+         * @param: int channel -> channel from register_channel()
+         * @param: const T &sample -> packed struct, use __attribute__((packed))
+         * @return: bool -> true if the sample was queued
+         */
+        template <typename T>
+        bool push( int channel, const T &sample ) {
+            return push(channel, &sample, sizeof(T));
+        }
+
+        /**
+         * @return: int -> number of samples written
+         *
+         * writes any schemas that are due and up to TELEMETRY_FLUSH_SAMPLES
+         * samples in one write, returns right away if another task is
+         * already flushing
+         */
+        int flush( );
+
+        /**
+         * @param: std::string path -> file to write the stream to instead of stdout
+         * @return: int -> 1 if the file was opened, 0 otherwise
+         *
+         * every schema is written again at the start of the new file
+         */
+        int open( std::string path );
+
+        /**
+         * @return: None
+         *
+         * flushes what is queued and goes back to writing to stdout
+         */
+        void close( );
+
+        /**
+         * @return: None
+         *
+         * starts the low priority task that flushes the queue
+         */
+        void start_flush_task( );
+
+        /**
+         * @return: int -> number of samples in the queue
+         */
+        int get_count( );
+
+        /**
+         * @return: std::uint32_t -> samples dropped because the queue was full
+         */
+        std::uint32_t get_dropped( );
+};
+
+
+
+#endif
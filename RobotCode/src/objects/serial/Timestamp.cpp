@@ -0,0 +1,40 @@
+/**
+ * @file: ./RobotCode/src/objects/serial/Timestamp.cpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * @see Timestamp.hpp
+ *
+ * contains implementation for the record stamp
+ */
+
+#include <atomic>
+#include <cstdint>
+
+#include "main.h"
+
+#include "Timestamp.hpp"
+
+
+// vex sdk high resolution clock, pros 3.3 has no micros() of its own
+extern "C" std::uint64_t vexSystemHighResTimeGet( void );
+
+
+std::atomic<std::uint32_t> Timestamp::next_sequence[e_stamp_num_streams] = {};
+
+
+std::uint32_t Timestamp::micros( )
+{
+    return (std::uint32_t)vexSystemHighResTimeGet();
+}
+
+
+record_stamp Timestamp::stamp( stamp_stream stream )
+{
+    record_stamp stamp;
+    stamp.time = micros();
+    stamp.sequence = next_sequence[stream].fetch_add(1, std::memory_order_relaxed);
+
+    return stamp;
+}
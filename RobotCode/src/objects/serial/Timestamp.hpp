@@ -0,0 +1,62 @@
+/**
+ * @file: ./RobotCode/src/objects/serial/Timestamp.hpp
+ * @author: Aiden Carney
+ * @reviewed_on:
+ * @reviewed_by:
+ *
+ * contains the microsecond clock and the per stream sequence numbers that log
+ * and telemetry records are stamped with when they are made
+ */
+
+#ifndef __TIMESTAMP_HPP__
+#define __TIMESTAMP_HPP__
+
+#include <atomic>
+#include <cstdint>
+
+#include "main.h"
+
+
+typedef enum {
+    e_stamp_log,
+    e_stamp_telemetry,
+    e_stamp_num_streams
+} stamp_stream;
+
+
+typedef struct
+{
+    std::uint32_t time;      // us since the program started, wraps after about 71 minutes
+    std::uint32_t sequence;  // counted separately for each stamp_stream
+} record_stamp;
+
+
+/**
+ * Contains the stamp every record gets once, when it is made
+ *
+ * the sequence number is taken before the record is queued so a record that
+ * is dropped leaves a gap. Log entries and telemetry samples are numbered
+ * separately so a reader with only one of them can still tell how many of
+ * its records were lost, records from both are ordered by time
+ */
+class Timestamp
+{
+    private:
+        static std::atomic<std::uint32_t> next_sequence[e_stamp_num_streams];
+
+    public:
+        /**
+         * @return: std::uint32_t -> us since the program started
+         */
+        static std::uint32_t micros( );
+
+        /**
+         * @param: stamp_stream stream -> the stream the record goes to
+         * @return: record_stamp -> the time now and the stream's next sequence number
+         */
+        static record_stamp stamp( stamp_stream stream );
+};
+
+
+
+#endif
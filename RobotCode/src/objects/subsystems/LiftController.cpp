@@ -11,6 +11,7 @@
 #include "main.h"
 
 
+#include "../motors/MotorFaults.hpp"
 #include "../serial/Logger.hpp"
 #include "LiftController.hpp"
 
@@ -23,6 +24,7 @@ std::atomic<bool> LiftController::command_finish_lock = ATOMIC_VAR_INIT(false);
 std::vector<Motor*> LiftController::motors;
 
 pid LiftController::gains = {0.3, 0.000000, 0, INT32_MAX, INT32_MAX};
+Mailbox<relay_result> LiftController::tuning;
 
 
 LiftController::LiftController(Motor &motor) {
@@ -129,12 +131,16 @@ void LiftController::lift_motion_task(void*) {
                     m->disable_driver_control();
                 }
 
+                motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(motors, e_fault_stall);
+
                 do {
                     int dt = pros::millis() - current_time;
 
                     long double error = action.args.setpoint - Sensors::lift_potentiometer.get_raw_value();
 
-                    std::cout << error << "\n";
+                    if constexpr ( LOG_COMPILED(5) ) {
+                        std::cout << error << "\n";
+                    }
 
                   //  std::cout << prev_velocity << "\n";
 
@@ -162,7 +168,9 @@ void LiftController::lift_motion_task(void*) {
                         assert(delta_velocity != 0);
 
                         int sign = std::abs(delta_velocity) / delta_velocity;
-                        std::cout << "over slew: " << sign << " " << dt << " " << slew_rate << "\n";
+                        if constexpr ( LOG_COMPILED(5) ) {
+                            std::cout << "over slew: " << sign << " " << dt << " " << slew_rate << "\n";
+                        }
                         abs_velocity = prev_velocity + (sign * dt * slew_rate);
                         over_slew = 1;
                     }
@@ -207,6 +215,14 @@ void LiftController::lift_motion_task(void*) {
                         logger.add(entry);
                     }
 
+                    if ( action.args.stop_on_stall && MotorFaults::get_instance()->check(stalls) ) {  // against a hard stop
+                        for(Motor* m : motors) {
+                            m->set_motor_mode(e_voltage);
+                            m->set_voltage(0);
+                        }
+                        break;
+                    }
+
                     if (
                         std::abs(error_difference) < .007
                         && error_history.size() == max_history_length
@@ -229,7 +245,9 @@ void LiftController::lift_motion_task(void*) {
                         m->move_velocity(abs_velocity);
                     }
 
-                    std::cout << abs_velocity << "\n";
+                    if constexpr ( LOG_COMPILED(5) ) {
+                        std::cout << abs_velocity << "\n";
+                    }
 
                     pros::delay(10);
                 } while ( pros::millis() < (start_time + action.args.timeout) );
@@ -240,6 +258,44 @@ void LiftController::lift_motion_task(void*) {
                     m->enable_driver_control();
                 }
 
+                break;
+            } case e_tune: {  // matches e_move_to, integral adds error * dt in ms and derivative is taken every 10ms
+                for(Motor* m : motors) {
+                    m->set_motor_mode(e_builtin_velocity_pid);
+                    m->disable_driver_control();
+                }
+
+                relay_params params = action.args.relay;
+                params.timeout = std::min(params.timeout, action.args.timeout);
+                params.loop_period = 10;
+                params.integral_step = 1;
+
+                motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(motors, e_fault_stall);
+                relay_result result = RelayTuner::tune(
+                    "Lift",
+                    []() { return (double)Sensors::lift_potentiometer.get_raw_value(); },
+                    [](double velocity) {
+                        for(Motor* m : motors) {
+                            m->move_velocity(velocity);
+                        }
+                    },
+                    action.args.setpoint,
+                    params,
+                    gains,
+                    [&]() { return action.args.stop_on_stall && MotorFaults::get_instance()->check(stalls); }
+                );
+
+                for(Motor* m : motors) {
+                    m->set_motor_mode(e_voltage);
+                    m->set_voltage(0);
+                    m->enable_driver_control();
+                }
+
+                if(result.cycles > 0 && params.apply) {
+                    gains = result.gains;
+                }
+                tuning.publish(result);
+
                 break;
             }
         }
@@ -325,6 +381,24 @@ void LiftController::set_gains(pid new_gains) {
 }
 
 
+int LiftController::tune(double sensor_value, relay_params params, bool asynch) {
+    lift_args args;
+    args.setpoint = sensor_value;
+    args.timeout = params.timeout;
+    args.relay = params;
+    int uid = send_command(e_tune, args);
+    if(!asynch) {
+        wait_until_finished(uid);
+    }
+    return uid;
+}
+
+
+relay_result LiftController::get_tuning() {
+    return tuning.read();
+}
+
+
 
 void LiftController::move_up() {
     send_command(e_start_up);
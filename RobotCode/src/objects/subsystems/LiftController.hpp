@@ -15,7 +15,9 @@
 
 #include "main.h"
 
+#include "../motors/Mailbox.hpp"
 #include "../motors/Motor.hpp"
+#include "../motors/RelayTuner.hpp"
 #include "../sensors/Sensors.hpp"
 #include "../../Configuration.hpp"
 
@@ -25,7 +27,8 @@ typedef enum e_lift_command {
     e_start_up,
     e_start_down,
     e_move_to,
-    e_stop
+    e_stop,
+    e_tune
 } lift_command;
 
 typedef struct {
@@ -34,6 +37,8 @@ typedef struct {
     int timeout=INT32_MAX;
     bool log_data=false;
     double motor_slew=INT32_MAX;
+    bool stop_on_stall=true;  // end the command when a lift motor stalls
+    relay_params relay;  // only used by e_tune
 }lift_args;
 
 typedef struct {
@@ -63,6 +68,7 @@ class LiftController
         std::vector<int> setpoints;
 
         static pid gains;
+        static Mailbox<relay_result> tuning;
 
         int send_command(lift_command command, lift_args args={});
 
@@ -78,6 +84,24 @@ class LiftController
 
         void set_gains(pid new_gains);
 
+        /**
+         * @param: double sensor_value -> potentiometer value to oscillate around
+         * @param: relay_params params -> amplitude is the lift velocity in rpm, hysteresis is in potentiometer counts
+         * @param: bool asynch -> return right away instead of waiting for the test to finish
+         * @return: int -> uid of the command
+         *
+         * @see: RelayTuner.hpp
+         *
+         * tunes the gains used by move_to with a relay test and replaces them
+         * with the result if params.apply is set
+         */
+        int tune(double sensor_value, relay_params params={}, bool asynch=false);
+
+        /**
+         * @return: relay_result -> result of the last tuning, cycles is 0 if it failed or never ran
+         */
+        relay_result get_tuning();
+
 
         void move_down();
         void move_up();
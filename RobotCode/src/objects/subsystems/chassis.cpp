@@ -17,12 +17,62 @@
 #include "main.h"
 #include "okapi/api.hpp"
 
+#include "../motors/MotorFaults.hpp"
+#include "../motors/MotorThread.hpp"
 #include "../serial/Logger.hpp"
+#include "../serial/Telemetry.hpp"
 #include "../position_tracking/PositionTracker.hpp"
 #include "chassis.hpp"
 #include "../../Configuration.hpp"
 
 
+/**
+ * channels are registered the first time a movement logs data
+ */
+int chassis_pid_telemetry_channel()
+{
+    static int channel = Telemetry::get_instance()->register_channel("chassis_pid", {
+        {"position_sp", e_telemetry_float, "deg"},
+        {"position_l", e_telemetry_float, "deg"},
+        {"position_r", e_telemetry_float, "deg"},
+        {"heading_sp", e_telemetry_float, "deg"},
+        {"relative_heading", e_telemetry_float, "deg"},
+        {"integral", e_telemetry_float, "deg*ms"},
+        {"velocity_l", e_telemetry_float, "rpm"},
+        {"velocity_r", e_telemetry_float, "rpm"},
+        {"correction", e_telemetry_float, "rpm"},
+        {"kP", e_telemetry_float, ""},
+        {"kI", e_telemetry_float, ""},
+        {"kD", e_telemetry_float, ""},
+        {"i_max", e_telemetry_float, "deg*ms"},
+        {"slew", e_telemetry_float, "rpm/ms"}
+    });
+    return channel;
+}
+
+int chassis_turn_telemetry_channel()
+{
+    static int channel = Telemetry::get_instance()->register_channel("chassis_turn", {
+        {"heading_sp", e_telemetry_float, "deg"},
+        {"relative_heading", e_telemetry_float, "deg"},
+        {"absolute_angle", e_telemetry_float, "rad"},
+        {"position_l", e_telemetry_float, "deg"},
+        {"position_r", e_telemetry_float, "deg"},
+        {"integral", e_telemetry_float, "deg*ms"},
+        {"velocity_l", e_telemetry_float, "rpm"},
+        {"velocity_r", e_telemetry_float, "rpm"},
+        {"error_difference", e_telemetry_float, "deg"},
+        {"over_slew", e_telemetry_int32, ""},
+        {"kP", e_telemetry_float, ""},
+        {"kI", e_telemetry_float, ""},
+        {"kD", e_telemetry_float, ""},
+        {"i_max", e_telemetry_float, "deg*ms"},
+        {"slew", e_telemetry_float, "rpm/ms"}
+    });
+    return channel;
+}
+
+
 
 std::vector<double> generate_chassis_velocity_profile(int encoder_ticks, const std::function<double(double)>& max_acceleration, double max_decceleration, double max_velocity, double initial_velocity) {
     if(encoder_ticks <= 0) {
@@ -36,7 +86,7 @@ std::vector<double> generate_chassis_velocity_profile(int encoder_ticks, const s
             + ", max_velocity: " + std::to_string(max_velocity)
         );
         entry.stream = "clog";
-        logger.add(entry);
+        logger.add(entry, e_log_source_chassis);
         pros::delay(100); // add delay for msg to be logged
         throw std::invalid_argument("Cannot generate profile with negative or 0 encoder ticks");
     }
@@ -52,7 +102,7 @@ std::vector<double> generate_chassis_velocity_profile(int encoder_ticks, const s
             + ", max_velocity: " + std::to_string(max_velocity)
         );
         entry.stream = "clog";
-        logger.add(entry);
+        logger.add(entry, e_log_source_chassis);
         pros::delay(100); // add delay for msg to be logged
         throw std::invalid_argument("(Profile Gen) Could not generate profile with 0 accleration or decceleration");
     }
@@ -89,6 +139,7 @@ std::atomic<bool> Chassis::command_finish_lock = ATOMIC_VAR_INIT(false);
 
 std::vector<Motor*> Chassis::r_motors;
 std::vector<Motor*> Chassis::l_motors;
+MotorGroup* Chassis::drive = NULL;
 
 
 Encoder* Chassis::left_encoder;
@@ -103,6 +154,7 @@ pid Chassis::profiled_sdrive_gains = {0.77, 0.000002, 7, INT32_MAX, 0.2};
 pid Chassis::okapi_sdrive_gains = {0.77, 0.000002, 7, INT32_MAX, 0.2};
 pid Chassis::heading_gains = {0.05, 0, 0, INT32_MAX, INT32_MAX};
 pid Chassis::turn_gains = {2.8, 0.0005, 50, INT32_MAX, 15};
+Mailbox<relay_result> Chassis::turn_tuning;
 
 
 Chassis::Chassis( Motor &front_left, Motor &front_right, Motor &back_left, Motor &back_right, Motor &mid_left, Motor &mid_right, Encoder &l_encoder, Encoder &r_encoder, double chassis_width, double gearing /*1*/, double wheel_size /*4.05*/)
@@ -117,6 +169,13 @@ Chassis::Chassis( Motor &front_left, Motor &front_right, Motor &back_left, Motor
     l_motors.push_back(&back_left);
     l_motors.push_back(&mid_left);
 
+    if(drive != NULL) {  // motors may have changed since the last chassis was made
+        MotorThread::get_instance()->unregister_group(*drive);
+        delete drive;
+    }
+    drive = new MotorGroup(l_motors, r_motors);
+    MotorThread::get_instance()->register_group(*drive);
+
     left_encoder = &l_encoder;
     right_encoder = &r_encoder;
 
@@ -130,16 +189,9 @@ Chassis::Chassis( Motor &front_left, Motor &front_right, Motor &back_left, Motor
 
     num_instances += 1;
 
-    for(Motor* motor : r_motors) {
-        motor->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-        motor->set_motor_mode(e_voltage);
-        motor->disable_slew();
-    }
-    for(Motor* motor : l_motors) {
-        motor->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-        motor->set_motor_mode(e_voltage);
-        motor->disable_slew();
-    }
+    drive->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
+    drive->set_motor_mode(e_voltage);
+    drive->disable_slew();
 
 }
 
@@ -153,6 +205,13 @@ Chassis::Chassis( Motor &front_left, Motor &front_right, Motor &back_left, Motor
     l_motors.push_back(&front_left);
     l_motors.push_back(&back_left);
 
+    if(drive != NULL) {  // motors may have changed since the last chassis was made
+        MotorThread::get_instance()->unregister_group(*drive);
+        delete drive;
+    }
+    drive = new MotorGroup(l_motors, r_motors);
+    MotorThread::get_instance()->register_group(*drive);
+
     left_encoder = &l_encoder;
     right_encoder = &r_encoder;
 
@@ -166,16 +225,9 @@ Chassis::Chassis( Motor &front_left, Motor &front_right, Motor &back_left, Motor
 
     num_instances += 1;
 
-    for(Motor* motor : r_motors) {
-        motor->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-        motor->set_motor_mode(e_voltage);
-        motor->disable_slew();
-    }
-    for(Motor* motor : l_motors) {
-        motor->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-        motor->set_motor_mode(e_voltage);
-        motor->disable_slew();
-    }
+    drive->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
+    drive->set_motor_mode(e_voltage);
+    drive->disable_slew();
 }
 
 
@@ -185,6 +237,10 @@ Chassis::~Chassis() {
     num_instances -= 1;
     if(num_instances == 0) {
         delete thread;
+
+        MotorThread::get_instance()->unregister_group(*drive);
+        delete drive;
+        drive = NULL;
     }
 }
 
@@ -309,7 +365,11 @@ void Chassis::chassis_motion_task(void*) {
 
                 long double dx = action.args.setpoint1 - tracker->get_position().x_pos;
                 long double dy = action.args.setpoint2 - tracker->get_position().y_pos;
-                std::cout << tracker->get_position().x_pos << " " << tracker->get_position().y_pos << "\n";
+                if constexpr ( LOG_COMPILED(5) ) {
+                    if ( action.args.log_data ) {
+                        std::cout << tracker->get_position().x_pos << " " << tracker->get_position().y_pos << "\n";
+                    }
+                }
                 // convert end coordinates to polar and then calculate waypoints
                 long double delta_radius_polar = std::sqrt((std::pow(dx, 2) + std::pow(dy, 2)));
                 long double delta_theta_polar = std::atan2(dy, dx);
@@ -325,27 +385,29 @@ void Chassis::chassis_motion_task(void*) {
                     recalc_point.dtheta = delta_theta_polar;
                     waypoints.insert(waypoints.begin(), recalc_point);
                 }
-                std::cout << "\n\n\n\n\n";
-                if(action.args.log_data) {
-                    Logger logger;
-                    log_entry entry;
-                    std::string msg = (
-                        "[INFO] " + std::string("CHASSIS_ODOM")
-                        + ", Time: " + std::to_string(pros::millis())
-                        + ", dx: " + std::to_string(dx)
-                        + ", dy: " + std::to_string(dy)
-                        + ", delta_theta_polar: " + std::to_string(delta_theta_polar)
-                        + ", current x: " + std::to_string(tracker->get_position().x_pos)
-                        + ", current y: " + std::to_string(tracker->get_position().y_pos)
-                        + ", current theta: " + std::to_string(tracker->to_degrees(tracker->get_position().theta))
-                    );
-                    int i = 0;
-                    for(waypoint point : waypoints) {  // add waypoints to debug message
-                        msg += ", waypoint " + std::to_string(i) + ": " + point.get_string();
+                if constexpr ( LOG_COMPILED(5) ) {
+                    if ( action.args.log_data ) {
+                        std::cout << "\n\n\n\n\n";
+                    }
+                }
+                if constexpr ( LOG_COMPILED(1) ) {
+                    if(action.args.log_data) {
+                        char content[LOGGER_RECORD_SIZE];  // waypoints are appended to one entry, built here so nothing is allocated
+                        int length = std::snprintf(content, sizeof(content),
+                            "[INFO] CHASSIS_ODOM, Time: %u, dx: %Lf, dy: %Lf, delta_theta_polar: %Lf, current x: %Lf, current y: %Lf, current theta: %Lf",
+                            (unsigned int)pros::millis(), dx, dy, delta_theta_polar,
+                            tracker->get_position().x_pos, tracker->get_position().y_pos, tracker->to_degrees(tracker->get_position().theta)
+                        );
+                        for(int i = 0; i < waypoints.size() && length < (int)sizeof(content); i++) {  // add waypoints to debug message
+                            const waypoint &point = waypoints.at(i);
+                            length += std::snprintf(content + length, sizeof(content) - length,
+                                ", waypoint %d: {x: %Lf y: %Lf dx: %Lf dy: %Lf radius: %Lf dtheta: %Lf}",
+                                i, point.x, point.y, point.dx, point.dy, point.radius, point.dtheta
+                            );
+                        }
+                        Logger logger;
+                        logger.add(e_log_source_chassis, e_log_clog, "%s", content);
                     }
-                    entry.content = msg;
-                    entry.stream = "clog";
-                    logger.add(entry);
                 }
 
                 int start = pros::millis();
@@ -370,21 +432,11 @@ void Chassis::chassis_motion_task(void*) {
 
                 t_turn(turn_args);
 
-                if(action.args.log_data) {
-                    Logger logger;
-                    log_entry entry;
-                    entry.content = (
-                        "[INFO] " + std::string("CHASSIS_ODOM")
-                        + ", Time: " + std::to_string(pros::millis())
-                        + ", X " + std::to_string(action.args.setpoint1)
-                        + ", Y " + std::to_string(action.args.setpoint2)
-                        + ", Current X: " + std::to_string(tracker->get_position().x_pos)
-                        + ", Current Y: " + std::to_string(tracker->get_position().y_pos)
-                        + ", Theta: " + std::to_string(tracker->to_degrees(tracker->get_position().theta))
-                    );
-                    entry.stream = "clog";
-                    logger.add(entry);
-                }
+                LOG_IF(1, action.args.log_data, e_log_source_chassis, e_log_clog,
+                    "[INFO] CHASSIS_ODOM, Time: %u, X %f, Y %f, Current X: %Lf, Current Y: %Lf, Theta: %Lf",
+                    (unsigned int)pros::millis(), action.args.setpoint1, action.args.setpoint2,
+                    tracker->get_position().x_pos, tracker->get_position().y_pos, tracker->to_degrees(tracker->get_position().theta)
+                );
                 break;
             } case e_turn_to_angle: {
                 PositionTracker* tracker = PositionTracker::get_instance();
@@ -399,24 +451,18 @@ void Chassis::chassis_motion_task(void*) {
                 turn_args.motor_slew = action.args.motor_slew;
                 turn_args.log_data = action.args.log_data;
 
-                if(action.args.log_data) {
-                    Logger logger;
-                    log_entry entry;
-                    std::string msg = (
-                        "[INFO] " + std::string("CHASSIS_ODOM")
-                        + ", Time: " + std::to_string(pros::millis())
-                        + ", turning: " + std::to_string(to_turn)
-                        + ", Current re-bounded angle: " + std::to_string(tracker->to_degrees(tracker->get_position().theta))
-                        + ", Current angle: " + std::to_string(tracker->to_degrees(tracker->get_heading_rad()))
-                    );
-                    entry.content = msg;
-                    entry.stream = "clog";
-                    logger.add(entry);
-                }
+                LOG_IF(1, action.args.log_data, e_log_source_chassis, e_log_clog,
+                    "[INFO] CHASSIS_ODOM, Time: %u, turning: %f, Current re-bounded angle: %Lf, Current angle: %Lf",
+                    (unsigned int)pros::millis(), to_turn,
+                    tracker->to_degrees(tracker->get_position().theta), tracker->to_degrees(tracker->get_heading_rad())
+                );
 
                 // perform turn
                 t_turn(turn_args);
 
+                break;
+            } case e_tune_turn: {
+                t_tune_turn(action.args);
                 break;
             }
         }
@@ -443,19 +489,10 @@ void Chassis::t_pid_straight_drive(chassis_params args) {
     double kD_r = pid_sdrive_gains.kD;
     double i_max_r = pid_sdrive_gains.i_max;
 
-    for(Motor* motor : r_motors) {
-        motor->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-        motor->disable_driver_control();
-        motor->set_motor_mode(e_builtin_velocity_pid);
-        motor->disable_slew();
-    }
-
-    for(Motor* motor : l_motors) {
-        motor->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-        motor->disable_driver_control();
-        motor->set_motor_mode(e_builtin_velocity_pid);
-        motor->disable_slew();
-    }
+    drive->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
+    drive->disable_driver_control();
+    drive->set_motor_mode(e_builtin_velocity_pid);
+    drive->disable_slew();
 
 
     int r_id = right_encoder->get_unique_id(true);
@@ -487,6 +524,8 @@ void Chassis::t_pid_straight_drive(chassis_params args) {
     int current_time = pros::millis();
     int start_time = current_time;
 
+    motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(drive->get_motors(), e_fault_stall);
+
     do {
         int dt = pros::millis() - current_time;
         // pid distance controller
@@ -581,36 +620,17 @@ void Chassis::t_pid_straight_drive(chassis_params args) {
             right_velocity = right_velocity > 0 ? args.max_velocity : -args.max_velocity;
         }
 
-        if ( args.log_data ) {
-            Logger logger;
-            log_entry entry;
-            entry.content = (
-                "[INFO] " + std::string("CHASSIS_PID")
-                + ", Time: " + std::to_string(pros::millis())
-                // + ", Actual_Vol1: " + std::to_string(front_left_drive->get_actual_voltage())
-                // + ", Actual_Vol2: " + std::to_string(front_right_drive->get_actual_voltage())
-                // + ", Actual_Vol3: " + std::to_string(back_left_drive->get_actual_voltage())
-                // + ", Actual_Vol4: " + std::to_string(back_right_drive->get_actual_voltage())
-                + ", Slew: " + std::to_string(args.motor_slew)
-                // + ", Brake: " + std::to_string(front_left_drive->get_brake_mode())
-                // + ", Gear: " + std::to_string(front_left_drive->get_gearset())
-                + ", i_max: " + std::to_string(i_max_l)
-                + ", I: " + std::to_string(integral_l)
-                + ", kD: " + std::to_string(kD_l)
-                + ", kI: " + std::to_string(kI_l)
-                + ", kP: " + std::to_string(kP_l)
-                + ", Position_Sp: " + std::to_string(args.setpoint1)
-                + ", position_l: " + std::to_string(std::get<0>(Sensors::get_average_encoders(l_id, r_id)))
-                + ", position_r: " + std::to_string(std::get<1>(Sensors::get_average_encoders(l_id, r_id)))
-                + ", Heading_Sp: " + std::to_string(args.setpoint2)
-                + ", Relative_Heading: " + std::to_string(relative_angle)
-                // + ", Actual_Vel1: " + std::to_string(front_left_drive->get_actual_velocity())
-                // + ", Actual_Vel2: " + std::to_string(front_right_drive->get_actual_velocity())
-                // + ", Actual_Vel3: " + std::to_string(back_left_drive->get_actual_velocity())
-                // + ", Actual_Vel4: " + std::to_string(back_right_drive->get_actual_velocity())
-            );
-            entry.stream = "clog";
-            logger.add(entry);
+        if constexpr ( LOG_COMPILED(1) ) {
+            if ( args.log_data ) {
+                std::tuple<double, double> positions = Sensors::get_average_encoders(l_id, r_id);
+                chassis_pid_sample sample = {
+                    (float)args.setpoint1, (float)std::get<0>(positions), (float)std::get<1>(positions),
+                    0, (float)relative_angle, (float)integral_l,
+                    (float)left_velocity, (float)right_velocity, (float)velocity_correction,
+                    (float)kP_l, (float)kI_l, (float)kD_l, (float)i_max_l, (float)args.motor_slew
+                };
+                Telemetry::get_instance()->push(chassis_pid_telemetry_channel(), sample);
+            }
         }
 
         prev_velocity_l = left_velocity;
@@ -630,6 +650,10 @@ void Chassis::t_pid_straight_drive(chassis_params args) {
         double l_difference = *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).second - *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).first;
         double r_difference = *std::minmax_element(previous_r_velocities.begin(), previous_r_velocities.end()).second - *std::minmax_element(previous_r_velocities.begin(), previous_r_velocities.end()).first;
         // std::cout << "difference: " << *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).second << " " << previous_l_velocities.size() << "\n";
+        if ( args.stop_on_stall && MotorFaults::get_instance()->check(stalls) ) {
+            break;  // pushing against something, waiting for the timeout will not get any further
+        }
+
         if (
             std::abs(l_difference) < 2
             && previous_l_velocities.size() == velocity_history
@@ -641,27 +665,15 @@ void Chassis::t_pid_straight_drive(chassis_params args) {
             break; // end before timeout
         }
 
-        for(Motor* motor : r_motors) {
-            motor->move_velocity(right_velocity);
-        }
-        for(Motor* motor : l_motors) {
-            motor->move_velocity(left_velocity);
-        }
+        drive->move_velocity(left_velocity, right_velocity);
 
         pros::delay(10);
     } while ( pros::millis() < start_time + args.timeout );
 
 
-    for(Motor* motor : r_motors) {
-        motor->enable_driver_control();
-        motor->set_motor_mode(e_voltage);
-        motor->set_voltage(0);
-    }
-    for(Motor* motor : l_motors) {
-        motor->enable_driver_control();
-        motor->set_motor_mode(e_voltage);
-        motor->set_voltage(0);
-    }
+    drive->enable_driver_control();
+    drive->set_motor_mode(e_voltage);
+    drive->set_voltage(0);
 
 
     right_encoder->forget_position(r_id);  // free up space in the encoders log
@@ -680,15 +692,8 @@ void Chassis::t_okapi_pid_straight_drive(chassis_params args) {
     heading_controller.setTarget(0);
 
 
-    for(Motor* motor : r_motors) {
-        motor->disable_driver_control();
-        motor->set_motor_mode(e_voltage);
-    }
-
-    for(Motor* motor : l_motors) {
-        motor->disable_driver_control();
-        motor->set_motor_mode(e_voltage);
-    }
+    drive->disable_driver_control();
+    drive->set_motor_mode(e_voltage);
 
 
     int r_id = right_encoder->get_unique_id(true);
@@ -702,6 +707,8 @@ void Chassis::t_okapi_pid_straight_drive(chassis_params args) {
     std::vector<double> previous_r_velocities;
     int velocity_history = 15;
 
+    motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(drive->get_motors(), e_fault_stall);
+
     while (pros::millis() < start_time + args.timeout) {
         abs_angle = tracker->get_heading_rad();
         abs_angle = std::atan2(std::sin(abs_angle), std::cos(abs_angle));
@@ -724,8 +731,8 @@ void Chassis::t_okapi_pid_straight_drive(chassis_params args) {
         left_voltage += heading_correction;
         right_voltage -= heading_correction;
 
-        previous_l_velocities.push_back(l_motors.at(0)->get_actual_velocity());
-        previous_r_velocities.push_back(r_motors.at(0)->get_actual_velocity());
+        previous_l_velocities.push_back(l_motors.at(0)->get_estimated_velocity());
+        previous_r_velocities.push_back(r_motors.at(0)->get_estimated_velocity());
         if(previous_l_velocities.size() > velocity_history) {
             previous_l_velocities.erase(previous_l_velocities.begin());
         }
@@ -736,38 +743,35 @@ void Chassis::t_okapi_pid_straight_drive(chassis_params args) {
         // settled is when error is almost zero and velocity is minimal
         double l_difference = *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).second - *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).first;
         double r_difference = *std::minmax_element(previous_r_velocities.begin(), previous_r_velocities.end()).second - *std::minmax_element(previous_r_velocities.begin(), previous_r_velocities.end()).first;
-        std::cout << l_difference << " " << r_difference << "\n";
+        if constexpr ( LOG_COMPILED(5) ) {
+            if ( args.log_data ) {
+                std::cout << l_difference << " " << r_difference << "\n";
+            }
+        }
+        if ( args.stop_on_stall && MotorFaults::get_instance()->check(stalls) ) {
+            break;  // pushing against something, waiting for the timeout will not get any further
+        }
+
         if (
             std::abs(l_difference) < 2
             && previous_l_velocities.size() == velocity_history
             && std::abs(r_difference) < 2
             && previous_r_velocities.size() == velocity_history
-            && r_motors.at(0)->get_actual_velocity() < 2
-            && l_motors.at(0)->get_actual_velocity() < 2
+            && r_motors.at(0)->get_estimated_velocity() < 2
+            && l_motors.at(0)->get_estimated_velocity() < 2
         ) {
             break; // end before timeout
         }
 
-        for(Motor* motor : r_motors) {
-            motor->set_voltage(right_voltage);
-        }
-        for(Motor* motor : l_motors) {
-            motor->set_voltage(left_voltage);
-        }
+        drive->set_voltage(left_voltage, right_voltage);
 
 
         pros::delay(10);
     }
 
 
-    for(Motor* motor : r_motors) {
-        motor->set_voltage(0);
-        motor->enable_driver_control();
-    }
-    for(Motor* motor : l_motors) {
-        motor->set_voltage(0);
-        motor->enable_driver_control();
-    }
+    drive->set_voltage(0);
+    drive->enable_driver_control();
 
 
     right_encoder->forget_position(r_id);  // free up space in the encoders log
@@ -784,14 +788,8 @@ void Chassis::t_profiled_straight_drive(chassis_params args) {
     double i_max = profiled_sdrive_gains.i_max;
 
 
-    for(Motor* motor : r_motors) {
-        motor->disable_driver_control();
-        motor->set_motor_mode(e_builtin_velocity_pid);
-    }
-    for(Motor* motor : l_motors) {
-        motor->disable_driver_control();
-        motor->set_motor_mode(e_builtin_velocity_pid);
-    }
+    drive->disable_driver_control();
+    drive->set_motor_mode(e_builtin_velocity_pid);
 
 
     int r_id = right_encoder->get_unique_id(true);
@@ -819,6 +817,8 @@ void Chassis::t_profiled_straight_drive(chassis_params args) {
     // auto accel_func = [](double n) -> double { return 1; };
     std::vector<double> velocity_profile = generate_chassis_velocity_profile(std::abs(args.setpoint1), accel_func, .55, args.max_velocity, 50);  // .45 is decceleration, 10 is initial velocity
 
+    motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(drive->get_motors(), e_fault_stall);
+
     do {
         int dt = pros::millis() - current_time;
         current_time = pros::millis();
@@ -851,7 +851,11 @@ void Chassis::t_profiled_straight_drive(chassis_params args) {
 
         long double error = 0 - relative_angle;  // setpoint is 0 because we want to drive straight
         // long double error = std::get<0>(Sensors::get_average_encoders(l_id, r_id)) - std::get<1>(Sensors::get_average_encoders(l_id, r_id));
-        std::cout << "relative angle: " << relative_angle << " | dtheta: " << delta_theta << "\n";
+        if constexpr ( LOG_COMPILED(5) ) {
+            if ( args.log_data ) {
+                std::cout << "relative angle: " << relative_angle << " | dtheta: " << delta_theta << "\n";
+            }
+        }
         // cap velocity to max velocity with regard to velocity
         integral = integral + (error * dt);
         if(integral > i_max) {
@@ -874,7 +878,11 @@ void Chassis::t_profiled_straight_drive(chassis_params args) {
     // PI heading correction
         // double velocity_correction = std::abs(kI * integral);
         double velocity_correction = std::abs(kP * error + kI * integral + kD * derivative);
-        std::cout << "integral: " << integral << " " << velocity_correction << "\n";
+        if constexpr ( LOG_COMPILED(5) ) {
+            if ( args.log_data ) {
+                std::cout << "integral: " << integral << " " << velocity_correction << "\n";
+            }
+        }
         if(args.correct_heading  && error > 0.000001) {  // veering off course, so correct
             velocity_r -= velocity_correction / 2;
             velocity_l += velocity_correction / 2;
@@ -892,37 +900,17 @@ void Chassis::t_profiled_straight_drive(chassis_params args) {
             velocity_r = velocity_r > 0 ? args.max_velocity : -args.max_velocity;
         }
 
-        if ( args.log_data ) {
-            Logger logger;
-            log_entry entry;
-            entry.content = (
-                "[INFO] " + std::string("CHASSIS_PROFILED_STRAIGHT_DRIVE")
-                + ", Time: " + std::to_string(pros::millis())
-                // + ", Actual_Vol1: " + std::to_string(front_left_drive->get_actual_voltage())
-                // + ", Actual_Vol2: " + std::to_string(front_right_drive->get_actual_voltage())
-                // + ", Actual_Vol3: " + std::to_string(back_left_drive->get_actual_voltage())
-                // + ", Actual_Vol4: " + std::to_string(back_right_drive->get_actual_voltage())
-                + ", Slew: " + std::to_string(args.motor_slew)
-                // + ", Brake: " + std::to_string(front_left_drive->get_brake_mode())
-                // + ", Gear: " + std::to_string(front_left_drive->get_gearset())
-                + ", i_max: " + std::to_string(i_max)
-                + ", I: " + std::to_string(integral)
-                + ", kD: " + std::to_string(kD)
-                + ", kI: " + std::to_string(kI)
-                + ", kP: " + std::to_string(kP)
-                + ", Position_Sp: " + std::to_string(args.setpoint1)
-                + ", position_l: " + std::to_string(std::get<0>(Sensors::get_average_encoders(l_id, r_id)))
-                + ", position_r: " + std::to_string(std::get<1>(Sensors::get_average_encoders(l_id, r_id)))
-                + ", Heading_Sp: " + std::to_string(args.setpoint2)
-                + ", Relative_Heading: " + std::to_string(relative_angle)
-                + ", Actual_Vel1: " + std::to_string(velocity_l)
-                + ", Actual_Vel2: " + std::to_string(velocity_r)
-                // + ", Actual_Vel3: " + std::to_string(back_left_drive->get_actual_velocity())
-                // + ", Actual_Vel4: " + std::to_string(back_right_drive->get_actual_velocity())
-                + ", Correction: " + std::to_string(velocity_correction)
-            );
-            entry.stream = "clog";
-            logger.add(entry);
+        if constexpr ( LOG_COMPILED(1) ) {
+            if ( args.log_data ) {
+                std::tuple<double, double> positions = Sensors::get_average_encoders(l_id, r_id);
+                chassis_pid_sample sample = {
+                    (float)args.setpoint1, (float)std::get<0>(positions), (float)std::get<1>(positions),
+                    (float)args.setpoint2, (float)relative_angle, (float)integral,
+                    (float)velocity_l, (float)velocity_r, (float)velocity_correction,
+                    (float)kP, (float)kI, (float)kD, (float)i_max, (float)args.motor_slew
+                };
+                Telemetry::get_instance()->push(chassis_pid_telemetry_channel(), sample);
+            }
         }
 
         double error_l = std::abs(args.setpoint1 - std::get<0>(Sensors::get_average_encoders(l_id, r_id)));
@@ -940,6 +928,10 @@ void Chassis::t_profiled_straight_drive(chassis_params args) {
         // settled is when error is almost zero and velocity is minimal
         double l_difference = *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).second - *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).first;
         double r_difference = *std::minmax_element(previous_r_velocities.begin(), previous_r_velocities.end()).second - *std::minmax_element(previous_r_velocities.begin(), previous_r_velocities.end()).first;
+        if ( args.stop_on_stall && MotorFaults::get_instance()->check(stalls) ) {
+            break;  // pushing against something, waiting for the timeout will not get any further
+        }
+
         if (
             std::abs(l_difference) < 2
             && previous_l_velocities.size() == velocity_history
@@ -951,30 +943,17 @@ void Chassis::t_profiled_straight_drive(chassis_params args) {
             break; // end before timeout
         }
 
-        for(Motor* motor : r_motors) {
-            motor->move_velocity(velocity_r);
-        }
-        for(Motor* motor : l_motors) {
-            motor->move_velocity(velocity_l);
-        }
+        drive->move_velocity(velocity_l, velocity_r);
 
         pros::delay(10);
     } while (pros::millis() < start_time + args.timeout);
 
 
 
-    for(Motor* motor : r_motors) {
-        motor->set_motor_mode(e_voltage);
-        motor->set_voltage(0);
-        motor->enable_driver_control();
-        motor->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-    }
-    for(Motor* motor : l_motors) {
-        motor->set_motor_mode(e_voltage);
-        motor->set_voltage(0);
-        motor->enable_driver_control();
-        motor->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-    }
+    drive->set_motor_mode(e_voltage);
+    drive->set_voltage(0);
+    drive->enable_driver_control();
+    drive->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
 
 
     right_encoder->forget_position(r_id);  // free up space in the encoders log
@@ -992,16 +971,9 @@ void Chassis::t_turn(chassis_params args) {
     double kD = turn_gains.kD;
     double i_max = turn_gains.i_max;
 
-    for(Motor* motor : r_motors) {
-        motor->disable_driver_control();
-        motor->set_motor_mode(e_builtin_velocity_pid);
-        motor->move_velocity(0);
-    }
-    for(Motor* motor : l_motors) {
-        motor->disable_driver_control();
-        motor->set_motor_mode(e_builtin_velocity_pid);
-        motor->move_velocity(0);
-    }
+    drive->disable_driver_control();
+    drive->set_motor_mode(e_builtin_velocity_pid);
+    drive->move_velocity(0);
 
 
     int r_id = right_encoder->get_unique_id();
@@ -1027,6 +999,8 @@ void Chassis::t_turn(chassis_params args) {
     std::vector<double> error_history;
     int max_history_length = 15;
 
+    motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(drive->get_motors(), e_fault_stall);
+
     do {
         int dt = pros::millis() - current_time;
 
@@ -1075,7 +1049,11 @@ void Chassis::t_turn(chassis_params args) {
                 std::cout << error_history.at(999) << "\n";  // throw some error that is easy to see
             }
             int sign = std::abs(delta_velocity_l) / delta_velocity_l;
-            std::cout << "l over slew: " << sign << " " << dt << " " << slew_rate << "\n";
+            if constexpr ( LOG_COMPILED(5) ) {
+                if ( args.log_data ) {
+                    std::cout << "l over slew: " << sign << " " << dt << " " << slew_rate << "\n";
+                }
+            }
             l_velocity = prev_velocity_l + (sign * dt * slew_rate);
             over_slew = 1;
         }
@@ -1087,7 +1065,11 @@ void Chassis::t_turn(chassis_params args) {
                 std::cout << error_history.at(999) << "\n";  // throw some error that is easy to see
             }
             int sign = std::abs(delta_velocity_r) / delta_velocity_r;
-            std::cout << "r over slew: " << sign << " " << dt << " " << slew_rate << "\n";
+            if constexpr ( LOG_COMPILED(5) ) {
+                if ( args.log_data ) {
+                    std::cout << "r over slew: " << sign << " " << dt << " " << slew_rate << "\n";
+                }
+            }
             r_velocity = prev_velocity_r + (sign * dt * slew_rate);
             over_slew = 1;
         }
@@ -1107,49 +1089,32 @@ void Chassis::t_turn(chassis_params args) {
         }
 
 
-        std::cout << l_velocity << " " << r_velocity << " " << relative_angle << " " << error << "\n";
+        if constexpr ( LOG_COMPILED(5) ) {
+            if ( args.log_data ) {
+                std::cout << l_velocity << " " << r_velocity << " " << relative_angle << " " << error << "\n";
+            }
+        }
         // for(int i=0; i < previous_l_velocities.size(); i++) {
         //     std::cout << previous_l_velocities.at(i) << " ";
         // }
         // std::cout << "\n";
         double error_difference = *std::minmax_element(error_history.begin(), error_history.end()).second - *std::minmax_element(error_history.begin(), error_history.end()).first;
 
-        if ( args.log_data ) {
-            Logger logger;
-            log_entry entry;
-            entry.content = (
-                "[INFO] " + std::string("CHASSIS_PID_TURN")
-                + ", Time: " + std::to_string(pros::millis())
-                // + ", Actual_Vol1: " + std::to_string(front_left_drive->get_actual_voltage())
-                // + ", Actual_Vol2: " + std::to_string(front_right_drive->get_actual_voltage())
-                // + ", Actual_Vol3: " + std::to_string(back_left_drive->get_actual_voltage())
-                // + ", Actual_Vol4: " + std::to_string(back_right_drive->get_actual_voltage())
-                + ", Slew: " + std::to_string(args.motor_slew)
-                // + ", Brake: " + std::to_string(front_left_drive->get_brake_mode())
-                // + ", Gear: " + std::to_string(front_left_drive->get_gearset())
-                + ", i_max: " + std::to_string(i_max)
-                + ", I: " + std::to_string(integral)
-                + ", kD: " + std::to_string(kD)
-                + ", kI: " + std::to_string(kI)
-                + ", kP: " + std::to_string(kP)
-                + ", Position_Sp: " + std::to_string(0)
-                + ", position_l: " + std::to_string(std::get<0>(Sensors::get_average_encoders(l_id, r_id)))
-                + ", position_r: " + std::to_string(std::get<1>(Sensors::get_average_encoders(l_id, r_id)))
-                + ", Heading_Sp: " + std::to_string(args.setpoint1)
-                + ", Relative_Heading: " + std::to_string(relative_angle)
-                + ", Absolute Angle: " + std::to_string(abs_angle)
-                + ", error history: " + std::to_string(error_history.size())
-                + ", history size: " + std::to_string(max_history_length)
-                + ", time out time: " + std::to_string(start_time + args.timeout)
-                + ", error difference: " + std::to_string(error_difference)
-                + ", over slew: " + std::to_string(over_slew)
-                // + ", Actual_Vel1: " + std::to_string(front_left_drive->get_actual_velocity())
-                // + ", Actual_Vel2: " + std::to_string(front_right_drive->get_actual_velocity())
-                // + ", Actual_Vel3: " + std::to_string(back_left_drive->get_actual_velocity())
-                // + ", Actual_Vel4: " + std::to_string(back_right_drive->get_actual_velocity())
-            );
-            entry.stream = "clog";
-            logger.add(entry);
+        if constexpr ( LOG_COMPILED(1) ) {
+            if ( args.log_data ) {
+                std::tuple<double, double> positions = Sensors::get_average_encoders(l_id, r_id);
+                chassis_turn_sample sample = {
+                    (float)args.setpoint1, (float)relative_angle, (float)abs_angle,
+                    (float)std::get<0>(positions), (float)std::get<1>(positions), (float)integral,
+                    (float)l_velocity, (float)r_velocity, (float)error_difference, over_slew,
+                    (float)kP, (float)kI, (float)kD, (float)i_max, (float)args.motor_slew
+                };
+                Telemetry::get_instance()->push(chassis_turn_telemetry_channel(), sample);
+            }
+        }
+
+        if ( args.stop_on_stall && MotorFaults::get_instance()->check(stalls) ) {
+            break;  // pushing against something, waiting for the timeout will not get any further
         }
 
         if (
@@ -1163,40 +1128,22 @@ void Chassis::t_turn(chassis_params args) {
             // && l_velocity < 2
             // && r_velocity < 2
         ) {  // velocity change has been minimal, so stop
-            for(Motor* motor : r_motors) {
-                motor->set_motor_mode(e_voltage);
-                motor->set_voltage(0);
-            }
-            for(Motor* motor : l_motors) {
-                motor->set_motor_mode(e_voltage);
-                motor->set_voltage(0);
-            }
+            drive->set_motor_mode(e_voltage);
+            drive->set_voltage(0);
 
             break; // end before timeout
         }
 
-        for(Motor* motor : r_motors) {
-            motor->move_velocity(r_velocity);
-        }
-        for(Motor* motor : l_motors) {
-            motor->move_velocity(l_velocity);
-        }
+        drive->move_velocity(l_velocity, r_velocity);
 
 
         pros::delay(10);
     } while ( pros::millis() < (start_time + args.timeout) );
 
 
-    for(Motor* motor : r_motors) {
-        motor->set_motor_mode(e_voltage);
-        motor->set_voltage(0);
-        motor->enable_driver_control();
-    }
-    for(Motor* motor : l_motors) {
-        motor->set_motor_mode(e_voltage);
-        motor->set_voltage(0);
-        motor->enable_driver_control();
-    }
+    drive->set_motor_mode(e_voltage);
+    drive->set_voltage(0);
+    drive->enable_driver_control();
 
     right_encoder->forget_position(r_id);  // free up space in the encoders log
     left_encoder->forget_position(l_id);
@@ -1204,6 +1151,56 @@ void Chassis::t_turn(chassis_params args) {
 
 
 
+/**
+ * heading is unwrapped the same way as in t_turn so that the relay can
+ * oscillate across +-180 degrees
+ * matches t_turn's loop, the integral adds error * dt in ms and the
+ * derivative is taken every 10ms
+ */
+void Chassis::t_tune_turn(chassis_params args) {
+    PositionTracker* tracker = PositionTracker::get_instance();
+
+    drive->disable_driver_control();
+    drive->set_motor_mode(e_builtin_velocity_pid);
+    drive->move_velocity(0);
+
+    long double prev_heading = tracker->get_heading_rad();
+    long double relative_angle = 0;
+    auto measure = [&]() {
+        long double heading = tracker->get_heading_rad();
+        relative_angle += tracker->to_degrees(std::remainder(heading - prev_heading, 2 * M_PI));
+        prev_heading = heading;
+        return (double)relative_angle;
+    };
+
+    relay_params params = args.relay;
+    params.timeout = std::min(params.timeout, args.timeout);
+    params.loop_period = 10;
+    params.integral_step = 1;
+
+    motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(drive->get_motors(), e_fault_stall);
+    relay_result result = RelayTuner::tune(
+        "Chassis Turn",
+        measure,
+        [](double velocity) { drive->move_velocity(velocity, -velocity); },
+        0,
+        params,
+        turn_gains,
+        [&]() { return args.stop_on_stall && MotorFaults::get_instance()->check(stalls); }
+    );
+
+    drive->set_motor_mode(e_voltage);
+    drive->set_voltage(0);
+    drive->enable_driver_control();
+
+    if ( result.cycles > 0 && params.apply ) {
+        turn_gains = result.gains;
+    }
+    turn_tuning.publish(result);
+}
+
+
+
 void Chassis::t_move_to_waypoint(chassis_params args, waypoint point) {
     PositionTracker* tracker = PositionTracker::get_instance();
 
@@ -1286,28 +1283,18 @@ void Chassis::t_move_to_waypoint(chassis_params args, waypoint point) {
 
     t_okapi_pid_straight_drive(drive_straight_args);
 
-    std::cout << "drive finished\n";
-    if(args.log_data) {
-        Logger logger;
-        log_entry entry;
-        entry.content = (
-            "[INFO] " + std::string("CHASSIS_ODOM")
-            + ", Time: " + std::to_string(pros::millis())
-            + ", Waypoint: " + point.get_string()
-            + ", ToTurnForwards: " + std::to_string(tracker->to_degrees(to_turn_face_forwards))
-            + ", ToTurnBackwards: " + std::to_string(tracker->to_degrees(to_turn_face_backwards))
-            + ", ToTurn: " + std::to_string(to_turn)
-            + ", ToDrive: " + std::to_string(to_drive)
-            + ", Direction: " + std::to_string(direction)
-            + ", dx: " + std::to_string(dx)
-            + ", dy: " + std::to_string(dy)
-            + ", X: " + std::to_string(tracker->get_position().x_pos)
-            + ", Y: " + std::to_string(tracker->get_position().y_pos)
-            + ", Theta: " + std::to_string(tracker->to_degrees(tracker->get_position().theta))
-        );
-        entry.stream = "clog";
-        logger.add(entry);
+    if constexpr ( LOG_COMPILED(5) ) {
+        if ( args.log_data ) {
+            std::cout << "drive finished\n";
+        }
     }
+    LOG_IF(1, args.log_data, e_log_source_chassis, e_log_clog,
+        "[INFO] CHASSIS_ODOM, Time: %u, Waypoint: {x: %Lf y: %Lf dx: %Lf dy: %Lf radius: %Lf dtheta: %Lf}, "
+        "ToTurnForwards: %Lf, ToTurnBackwards: %Lf, ToTurn: %Lf, ToDrive: %Lf, Direction: %d, dx: %Lf, dy: %Lf, X: %Lf, Y: %Lf, Theta: %Lf",
+        (unsigned int)pros::millis(), point.x, point.y, point.dx, point.dy, point.radius, point.dtheta,
+        tracker->to_degrees(to_turn_face_forwards), tracker->to_degrees(to_turn_face_backwards), to_turn, to_drive, direction, dx, dy,
+        tracker->get_position().x_pos, tracker->get_position().y_pos, tracker->to_degrees(tracker->get_position().theta)
+    );
 }
 
 
@@ -1578,16 +1565,37 @@ void Chassis::set_turn_gains(pid new_gains) {
 }
 
 
+int Chassis::tune_turn(relay_params params /*{}*/, bool asynch /*false*/) {
+    chassis_params args;
+    args.relay = params;
+    args.timeout = params.timeout;
+
+    // generate a unique id based on time, parameters, and seemingly random value of the voltage of one of the motors
+    int uid = pros::millis() * (params.amplitude + 1) + l_motors.at(0)->get_actual_voltage();
+
+    chassis_action command = {args, uid, e_tune_turn};
+    while ( command_start_lock.exchange( true ) ); //aquire lock
+    command_queue.push(command);
+    command_start_lock.exchange( false ); //release lock
+
+    if(!asynch) {
+        wait_until_finished(uid);
+    }
+
+    return uid;
+}
+
+
+relay_result Chassis::get_turn_tuning() {
+    return turn_tuning.read();
+}
+
+
 /**
  * sets scaled voltage of each drive motor
  */
 void Chassis::move( int voltage ) {
-    for(Motor* motor : r_motors) {
-        motor->move(voltage);
-    }
-    for(Motor* motor : l_motors) {
-        motor->move(voltage);
-    }
+    drive->move(voltage);
 }
 
 
@@ -1595,12 +1603,7 @@ void Chassis::move( int voltage ) {
  * sets a new brakemode for each drive motor
  */
 void Chassis::set_brake_mode( pros::motor_brake_mode_e_t new_brake_mode ) {
-    for(Motor* motor : r_motors) {
-        motor->set_brake_mode(new_brake_mode);
-    }
-    for(Motor* motor : l_motors) {
-        motor->set_brake_mode(new_brake_mode);
-    }
+    drive->set_brake_mode(new_brake_mode);
 }
 
 
@@ -1627,14 +1630,8 @@ void Chassis::change_direction()  {
  * sets the rate of the slew to the rate parameter
  */
 void Chassis::enable_slew( int rate /*120*/ ) {
-    for(Motor* motor : r_motors) {
-        motor->enable_slew();
-        motor->set_slew(rate);
-    }
-    for(Motor* motor : l_motors) {
-        motor->enable_slew();
-        motor->set_slew(rate);
-    }
+    drive->enable_slew();
+    drive->set_slew(rate);
 }
 
 
@@ -1644,12 +1641,7 @@ void Chassis::enable_slew( int rate /*120*/ ) {
  * sets slew to disabled for each motor
  */
 void Chassis::disable_slew( ) {
-    for(Motor* motor : r_motors) {
-        motor->disable_slew();
-    }
-    for(Motor* motor : l_motors) {
-        motor->disable_slew();
-    }
+    drive->disable_slew();
 }
 
 
@@ -11,12 +11,16 @@
 #ifndef __CHASSIS_HPP__
 #define __CHASSIS_HPP__
 
+#include <cstdint>
 #include <tuple>
 #include <queue>
 
 #include "main.h"
 
 #include "../motors/Motor.hpp"
+#include "../motors/Mailbox.hpp"
+#include "../motors/MotorGroup.hpp"
+#include "../motors/RelayTuner.hpp"
 #include "../sensors/Sensors.hpp"
 #include "../../Configuration.hpp"
 
@@ -31,7 +35,8 @@ typedef enum {
     e_turn,
     e_drive_to_point,
     e_turn_to_point,
-    e_turn_to_angle
+    e_turn_to_angle,
+    e_tune_turn
 } chassis_commands;
 
 
@@ -68,10 +73,67 @@ typedef struct {
     int explicit_direction=0;
     double motor_slew=INT32_MAX;
     bool correct_heading=true;
+    bool stop_on_stall=true;  // end the command when a drive motor stalls
     bool log_data=false;
+    relay_params relay;  // only used by e_tune_turn
 } chassis_params;
 
 
+/**
+ * samples of the chassis telemetry channels, fields are in the same order as
+ * they are registered in chassis.cpp
+ */
+typedef struct __attribute__((packed)) {
+    float position_sp;
+    float position_l;
+    float position_r;
+    float heading_sp;
+    float relative_heading;
+    float integral;
+    float velocity_l;
+    float velocity_r;
+    float correction;
+    float kP;
+    float kI;
+    float kD;
+    float i_max;
+    float slew;
+} chassis_pid_sample;
+
+
+typedef struct __attribute__((packed)) {
+    float heading_sp;
+    float relative_heading;
+    float absolute_angle;
+    float position_l;
+    float position_r;
+    float integral;
+    float velocity_l;
+    float velocity_r;
+    float error_difference;
+    std::int32_t over_slew;
+    float kP;
+    float kI;
+    float kD;
+    float i_max;
+    float slew;
+} chassis_turn_sample;
+
+
+/**
+ * @return: int -> the telemetry channel for chassis_pid_sample, -1 if it could not be registered
+ *
+ * registered the first time it is called, shared by every chassis class so
+ * they all log the same schema
+ */
+int chassis_pid_telemetry_channel();
+
+/**
+ * @return: int -> the telemetry channel for chassis_turn_sample, -1 if it could not be registered
+ */
+int chassis_turn_telemetry_channel();
+
+
 
 typedef struct {
     chassis_params args;
@@ -91,6 +153,7 @@ class Chassis
     private:
         static std::vector<Motor*> r_motors;
         static std::vector<Motor*> l_motors;
+        static MotorGroup *drive;  // both sides, registered with the motor thread while a chassis exists
 
         static Encoder* left_encoder;
         static Encoder* right_encoder;
@@ -107,6 +170,7 @@ class Chassis
         static pid okapi_sdrive_gains;
         static pid heading_gains;
         static pid turn_gains;
+        static Mailbox<relay_result> turn_tuning;
 
         static double get_angle_to_turn(double x, double y, int explicit_direction=1);
         static double get_angle_to_turn(double theta);
@@ -115,6 +179,7 @@ class Chassis
         static void t_okapi_pid_straight_drive(chassis_params args);
         static void t_profiled_straight_drive(chassis_params args);
         static void t_turn(chassis_params args);
+        static void t_tune_turn(chassis_params args);
         static void t_move_to_waypoint(chassis_params args, waypoint point);
 
         static double wheel_diameter;
@@ -145,6 +210,23 @@ class Chassis
         void set_heading_gains(pid new_gains);
         void set_turn_gains(pid new_gains);
 
+        /**
+         * @param: relay_params params -> amplitude is the turn velocity in rpm, hysteresis is in degrees
+         * @param: bool asynch -> return right away instead of waiting for the test to finish
+         * @return: int -> uid of the command
+         *
+         * @see: RelayTuner.hpp
+         *
+         * oscillates the chassis around its current heading with a relay test
+         * and replaces the turn gains with the result if params.apply is set
+         */
+        int tune_turn(relay_params params={}, bool asynch=false);
+
+        /**
+         * @return: relay_result -> result of the last turn tuning, cycles is 0 if it failed or never ran
+         */
+        relay_result get_turn_tuning();
+
         /**
          * @param: int voltage -> the voltage on interval [-127, 127] to set the motor to
          * @return: None
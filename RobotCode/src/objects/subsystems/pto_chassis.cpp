@@ -7,7 +7,10 @@
 #include "main.h"
 #include "okapi/api.hpp"
 
+#include "../motors/MotorFaults.hpp"
+#include "../motors/MotorThread.hpp"
 #include "../serial/Logger.hpp"
+#include "../serial/Telemetry.hpp"
 #include "../position_tracking/PositionTracker.hpp"
 #include "chassis.hpp"
 #include "pto_chassis.hpp"
@@ -27,6 +30,7 @@ Motor* PTOChassis::r_extra;
 Motor* PTOChassis::l_back;
 Motor* PTOChassis::l_front;
 Motor* PTOChassis::l_extra;
+MotorGroup* PTOChassis::drive = NULL;
 
 pros::ADIDigitalOut* PTOChassis::pto;
 
@@ -44,6 +48,7 @@ pid PTOChassis::profiled_sdrive_gains = {1, 0, 0, INT32_MAX, 0.22};
 pid PTOChassis::okapi_sdrive_gains = {1, 0, 0, INT32_MAX, 0.2};
 pid PTOChassis::heading_gains = {0.05, 0, 0, INT32_MAX, INT32_MAX};
 pid PTOChassis::turn_gains = {2.9, 0, 0, INT32_MAX, 15};
+Mailbox<relay_result> PTOChassis::turn_tuning;
 
 
 PTOChassis::PTOChassis(Motor &front_left, Motor &front_right, Motor &back_left, Motor &back_right, Motor &extra_left, Motor &extra_right, pros::ADIDigitalOut& piston1, Encoder &l_encoder, Encoder &r_encoder, double chassis_width, double gearing, double wheel_size)
@@ -55,6 +60,17 @@ PTOChassis::PTOChassis(Motor &front_left, Motor &front_right, Motor &back_left,
     l_front = &front_left;
     l_extra = &extra_left;
 
+    if(drive != NULL) {  // motors may have changed since the last chassis was made
+        MotorThread::get_instance()->unregister_group(*drive);
+        delete drive;
+    }
+    drive = new MotorGroup({l_front, l_back, l_extra}, {r_front, r_back, r_extra});
+    if(pto_state) {  // extra motors are running the rings
+        drive->disable_motor(*r_extra);
+        drive->disable_motor(*l_extra);
+    }
+    MotorThread::get_instance()->register_group(*drive);
+
     pto = &piston1;
 
     left_encoder = &l_encoder;
@@ -78,6 +94,10 @@ PTOChassis::~PTOChassis() {
     num_instances -= 1;
     if(num_instances == 0) {
         delete thread;
+
+        MotorThread::get_instance()->unregister_group(*drive);
+        delete drive;
+        drive = NULL;
     }
 }
 
@@ -202,7 +222,11 @@ void PTOChassis::chassis_motion_task(void*) {
 
                 long double dx = action.args.setpoint1 - tracker->get_position().x_pos;
                 long double dy = action.args.setpoint2 - tracker->get_position().y_pos;
-                std::cout << tracker->get_position().x_pos << " " << tracker->get_position().y_pos << "\n";
+                if constexpr ( LOG_COMPILED(5) ) {
+                    if ( action.args.log_data ) {
+                        std::cout << tracker->get_position().x_pos << " " << tracker->get_position().y_pos << "\n";
+                    }
+                }
                 // convert end coordinates to polar and then calculate waypoints
                 long double delta_radius_polar = std::sqrt((std::pow(dx, 2) + std::pow(dy, 2)));
                 long double delta_theta_polar = std::atan2(dy, dx);
@@ -218,27 +242,29 @@ void PTOChassis::chassis_motion_task(void*) {
                     recalc_point.dtheta = delta_theta_polar;
                     waypoints.insert(waypoints.begin(), recalc_point);
                 }
-                std::cout << "\n\n\n\n\n";
-                if(action.args.log_data) {
-                    Logger logger;
-                    log_entry entry;
-                    std::string msg = (
-                        "[INFO] " + std::string("CHASSIS_ODOM")
-                        + ", Time: " + std::to_string(pros::millis())
-                        + ", dx: " + std::to_string(dx)
-                        + ", dy: " + std::to_string(dy)
-                        + ", delta_theta_polar: " + std::to_string(delta_theta_polar)
-                        + ", current x: " + std::to_string(tracker->get_position().x_pos)
-                        + ", current y: " + std::to_string(tracker->get_position().y_pos)
-                        + ", current theta: " + std::to_string(tracker->to_degrees(tracker->get_position().theta))
-                    );
-                    int i = 0;
-                    for(waypoint point : waypoints) {  // add waypoints to debug message
-                        msg += ", waypoint " + std::to_string(i) + ": " + point.get_string();
+                if constexpr ( LOG_COMPILED(5) ) {
+                    if ( action.args.log_data ) {
+                        std::cout << "\n\n\n\n\n";
+                    }
+                }
+                if constexpr ( LOG_COMPILED(1) ) {
+                    if(action.args.log_data) {
+                        char content[LOGGER_RECORD_SIZE];  // waypoints are appended to one entry, built here so nothing is allocated
+                        int length = std::snprintf(content, sizeof(content),
+                            "[INFO] CHASSIS_ODOM, Time: %u, dx: %Lf, dy: %Lf, delta_theta_polar: %Lf, current x: %Lf, current y: %Lf, current theta: %Lf",
+                            (unsigned int)pros::millis(), dx, dy, delta_theta_polar,
+                            tracker->get_position().x_pos, tracker->get_position().y_pos, tracker->to_degrees(tracker->get_position().theta)
+                        );
+                        for(int i = 0; i < waypoints.size() && length < (int)sizeof(content); i++) {  // add waypoints to debug message
+                            const waypoint &point = waypoints.at(i);
+                            length += std::snprintf(content + length, sizeof(content) - length,
+                                ", waypoint %d: {x: %Lf y: %Lf dx: %Lf dy: %Lf radius: %Lf dtheta: %Lf}",
+                                i, point.x, point.y, point.dx, point.dy, point.radius, point.dtheta
+                            );
+                        }
+                        Logger logger;
+                        logger.add(e_log_source_chassis, e_log_clog, "%s", content);
                     }
-                    entry.content = msg;
-                    entry.stream = "clog";
-                    logger.add(entry);
                 }
 
                 int start = pros::millis();
@@ -263,21 +289,11 @@ void PTOChassis::chassis_motion_task(void*) {
 
                 t_turn(turn_args);
 
-                if(action.args.log_data) {
-                    Logger logger;
-                    log_entry entry;
-                    entry.content = (
-                        "[INFO] " + std::string("CHASSIS_ODOM")
-                        + ", Time: " + std::to_string(pros::millis())
-                        + ", X " + std::to_string(action.args.setpoint1)
-                        + ", Y " + std::to_string(action.args.setpoint2)
-                        + ", Current X: " + std::to_string(tracker->get_position().x_pos)
-                        + ", Current Y: " + std::to_string(tracker->get_position().y_pos)
-                        + ", Theta: " + std::to_string(tracker->to_degrees(tracker->get_position().theta))
-                    );
-                    entry.stream = "clog";
-                    logger.add(entry);
-                }
+                LOG_IF(1, action.args.log_data, e_log_source_chassis, e_log_clog,
+                    "[INFO] CHASSIS_ODOM, Time: %u, X %f, Y %f, Current X: %Lf, Current Y: %Lf, Theta: %Lf",
+                    (unsigned int)pros::millis(), action.args.setpoint1, action.args.setpoint2,
+                    tracker->get_position().x_pos, tracker->get_position().y_pos, tracker->to_degrees(tracker->get_position().theta)
+                );
                 break;
             } case e_turn_to_angle: {
                 PositionTracker* tracker = PositionTracker::get_instance();
@@ -292,24 +308,18 @@ void PTOChassis::chassis_motion_task(void*) {
                 turn_args.motor_slew = action.args.motor_slew;
                 turn_args.log_data = action.args.log_data;
 
-                if(action.args.log_data) {
-                    Logger logger;
-                    log_entry entry;
-                    std::string msg = (
-                        "[INFO] " + std::string("CHASSIS_ODOM")
-                        + ", Time: " + std::to_string(pros::millis())
-                        + ", turning: " + std::to_string(to_turn)
-                        + ", Current re-bounded angle: " + std::to_string(tracker->to_degrees(tracker->get_position().theta))
-                        + ", Current angle: " + std::to_string(tracker->to_degrees(tracker->get_heading_rad()))
-                    );
-                    entry.content = msg;
-                    entry.stream = "clog";
-                    logger.add(entry);
-                }
+                LOG_IF(1, action.args.log_data, e_log_source_chassis, e_log_clog,
+                    "[INFO] CHASSIS_ODOM, Time: %u, turning: %f, Current re-bounded angle: %Lf, Current angle: %Lf",
+                    (unsigned int)pros::millis(), to_turn,
+                    tracker->to_degrees(tracker->get_position().theta), tracker->to_degrees(tracker->get_heading_rad())
+                );
 
                 // perform turn
                 t_turn(turn_args);
 
+                break;
+            } case e_tune_turn: {
+                t_tune_turn(action.args);
                 break;
             }
         }
@@ -368,6 +378,8 @@ void PTOChassis::t_pid_straight_drive(chassis_params args) {
     int current_time = pros::millis();
     int start_time = current_time;
 
+    motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(drive->get_motors(), e_fault_stall);
+
     do {
         int dt = pros::millis() - current_time;
         // pid distance controller
@@ -462,36 +474,17 @@ void PTOChassis::t_pid_straight_drive(chassis_params args) {
             right_velocity = right_velocity > 0 ? args.max_velocity : -args.max_velocity;
         }
 
-        if ( args.log_data ) {
-            Logger logger;
-            log_entry entry;
-            entry.content = (
-                "[INFO] " + std::string("CHASSIS_PID")
-                + ", Time: " + std::to_string(pros::millis())
-                // + ", Actual_Vol1: " + std::to_string(front_left_drive->get_actual_voltage())
-                // + ", Actual_Vol2: " + std::to_string(front_right_drive->get_actual_voltage())
-                // + ", Actual_Vol3: " + std::to_string(back_left_drive->get_actual_voltage())
-                // + ", Actual_Vol4: " + std::to_string(back_right_drive->get_actual_voltage())
-                + ", Slew: " + std::to_string(args.motor_slew)
-                // + ", Brake: " + std::to_string(front_left_drive->get_brake_mode())
-                // + ", Gear: " + std::to_string(front_left_drive->get_gearset())
-                + ", i_max: " + std::to_string(i_max_l)
-                + ", I: " + std::to_string(integral_l)
-                + ", kD: " + std::to_string(kD_l)
-                + ", kI: " + std::to_string(kI_l)
-                + ", kP: " + std::to_string(kP_l)
-                + ", Position_Sp: " + std::to_string(args.setpoint1)
-                + ", position_l: " + std::to_string(std::get<0>(Sensors::get_average_encoders(l_id, r_id)))
-                + ", position_r: " + std::to_string(std::get<1>(Sensors::get_average_encoders(l_id, r_id)))
-                + ", Heading_Sp: " + std::to_string(args.setpoint2)
-                + ", Relative_Heading: " + std::to_string(relative_angle)
-                // + ", Actual_Vel1: " + std::to_string(front_left_drive->get_actual_velocity())
-                // + ", Actual_Vel2: " + std::to_string(front_right_drive->get_actual_velocity())
-                // + ", Actual_Vel3: " + std::to_string(back_left_drive->get_actual_velocity())
-                // + ", Actual_Vel4: " + std::to_string(back_right_drive->get_actual_velocity())
-            );
-            entry.stream = "clog";
-            logger.add(entry);
+        if constexpr ( LOG_COMPILED(1) ) {
+            if ( args.log_data ) {
+                std::tuple<double, double> positions = Sensors::get_average_encoders(l_id, r_id);
+                chassis_pid_sample sample = {
+                    (float)args.setpoint1, (float)std::get<0>(positions), (float)std::get<1>(positions),
+                    0, (float)relative_angle, (float)integral_l,
+                    (float)left_velocity, (float)right_velocity, (float)velocity_correction,
+                    (float)kP_l, (float)kI_l, (float)kD_l, (float)i_max_l, (float)args.motor_slew
+                };
+                Telemetry::get_instance()->push(chassis_pid_telemetry_channel(), sample);
+            }
         }
 
         prev_velocity_l = left_velocity;
@@ -511,6 +504,10 @@ void PTOChassis::t_pid_straight_drive(chassis_params args) {
         double l_difference = *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).second - *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).first;
         double r_difference = *std::minmax_element(previous_r_velocities.begin(), previous_r_velocities.end()).second - *std::minmax_element(previous_r_velocities.begin(), previous_r_velocities.end()).first;
         // std::cout << "difference: " << *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).second << " " << previous_l_velocities.size() << "\n";
+        if ( args.stop_on_stall && MotorFaults::get_instance()->check(stalls) ) {
+            break;  // pushing against something, waiting for the timeout will not get any further
+        }
+
         if (
             std::abs(l_difference) < 2
             && previous_l_velocities.size() == velocity_history
@@ -563,6 +560,8 @@ void PTOChassis::t_okapi_pid_straight_drive(chassis_params args) {
     std::vector<double> previous_r_velocities;
     int velocity_history = 15;
 
+    motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(drive->get_motors(), e_fault_stall);
+
     while (pros::millis() < start_time + args.timeout) {
         abs_angle = tracker->get_heading_rad();
         abs_angle = std::atan2(std::sin(abs_angle), std::cos(abs_angle));
@@ -585,8 +584,8 @@ void PTOChassis::t_okapi_pid_straight_drive(chassis_params args) {
         left_voltage += heading_correction;
         right_voltage -= heading_correction;
 
-        previous_l_velocities.push_back(l_front->get_actual_velocity());
-        previous_r_velocities.push_back(r_front->get_actual_velocity());
+        previous_l_velocities.push_back(l_front->get_estimated_velocity());
+        previous_r_velocities.push_back(r_front->get_estimated_velocity());
         if(previous_l_velocities.size() > velocity_history) {
             previous_l_velocities.erase(previous_l_velocities.begin());
         }
@@ -597,19 +596,31 @@ void PTOChassis::t_okapi_pid_straight_drive(chassis_params args) {
         // settled is when error is almost zero and velocity is minimal
         double l_difference = *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).second - *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).first;
         double r_difference = *std::minmax_element(previous_r_velocities.begin(), previous_r_velocities.end()).second - *std::minmax_element(previous_r_velocities.begin(), previous_r_velocities.end()).first;
-        std::cout << l_difference << " " << r_difference << "\n";
+        if constexpr ( LOG_COMPILED(5) ) {
+            if ( args.log_data ) {
+                std::cout << l_difference << " " << r_difference << "\n";
+            }
+        }
+        if ( args.stop_on_stall && MotorFaults::get_instance()->check(stalls) ) {
+            break;  // pushing against something, waiting for the timeout will not get any further
+        }
+
         if (
             std::abs(l_difference) < 2
             && previous_l_velocities.size() == velocity_history
             && std::abs(r_difference) < 2
             && previous_r_velocities.size() == velocity_history
-            && r_front->get_actual_velocity() < 2
-            && l_front->get_actual_velocity() < 2
+            && r_front->get_estimated_velocity() < 2
+            && l_front->get_estimated_velocity() < 2
             && pros::millis() > start_time + 500
         ) {
             break; // end before timeout
         }
-        std::cout << std::get<0>(Sensors::get_average_encoders(l_id, r_id)) << " " << std::get<1>(Sensors::get_average_encoders(l_id, r_id)) << " " << left_voltage << " " << right_voltage << "\n";
+        if constexpr ( LOG_COMPILED(5) ) {
+            if ( args.log_data ) {
+                std::cout << std::get<0>(Sensors::get_average_encoders(l_id, r_id)) << " " << std::get<1>(Sensors::get_average_encoders(l_id, r_id)) << " " << left_voltage << " " << right_voltage << "\n";
+            }
+        }
         pto_move_voltage(right_voltage, left_voltage);
 
 
@@ -660,6 +671,8 @@ void PTOChassis::t_profiled_straight_drive(chassis_params args) {
     // auto accel_func = [](double n) -> double { return 1; };
     std::vector<double> velocity_profile = generate_chassis_velocity_profile(std::abs(args.setpoint1), accel_func, .55, args.max_velocity, 50);  // .45 is decceleration, 10 is initial velocity
 
+    motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(drive->get_motors(), e_fault_stall);
+
     do {
         int dt = pros::millis() - current_time;
         current_time = pros::millis();
@@ -692,7 +705,11 @@ void PTOChassis::t_profiled_straight_drive(chassis_params args) {
 
         long double error = 0 - relative_angle;  // setpoint is 0 because we want to drive straight
         // long double error = std::get<0>(Sensors::get_average_encoders(l_id, r_id)) - std::get<1>(Sensors::get_average_encoders(l_id, r_id));
-        std::cout << "relative angle: " << relative_angle << " | dtheta: " << delta_theta << "\n";
+        if constexpr ( LOG_COMPILED(5) ) {
+            if ( args.log_data ) {
+                std::cout << "relative angle: " << relative_angle << " | dtheta: " << delta_theta << "\n";
+            }
+        }
         // cap velocity to max velocity with regard to velocity
         integral = integral + (error * dt);
         if(integral > i_max) {
@@ -715,7 +732,11 @@ void PTOChassis::t_profiled_straight_drive(chassis_params args) {
     // PI heading correction
         // double velocity_correction = std::abs(kI * integral);
         double velocity_correction = std::abs(kP * error + kI * integral + kD * derivative);
-        std::cout << "integral: " << integral << " " << velocity_correction << "\n";
+        if constexpr ( LOG_COMPILED(5) ) {
+            if ( args.log_data ) {
+                std::cout << "integral: " << integral << " " << velocity_correction << "\n";
+            }
+        }
         if(args.correct_heading  && error > 0.000001) {  // veering off course, so correct
             velocity_r -= velocity_correction / 2;
             velocity_l += velocity_correction / 2;
@@ -733,37 +754,17 @@ void PTOChassis::t_profiled_straight_drive(chassis_params args) {
             velocity_r = velocity_r > 0 ? args.max_velocity : -args.max_velocity;
         }
 
-        if ( args.log_data ) {
-            Logger logger;
-            log_entry entry;
-            entry.content = (
-                "[INFO] " + std::string("CHASSIS_PROFILED_STRAIGHT_DRIVE")
-                + ", Time: " + std::to_string(pros::millis())
-                // + ", Actual_Vol1: " + std::to_string(front_left_drive->get_actual_voltage())
-                // + ", Actual_Vol2: " + std::to_string(front_right_drive->get_actual_voltage())
-                // + ", Actual_Vol3: " + std::to_string(back_left_drive->get_actual_voltage())
-                // + ", Actual_Vol4: " + std::to_string(back_right_drive->get_actual_voltage())
-                + ", Slew: " + std::to_string(args.motor_slew)
-                // + ", Brake: " + std::to_string(front_left_drive->get_brake_mode())
-                // + ", Gear: " + std::to_string(front_left_drive->get_gearset())
-                + ", i_max: " + std::to_string(i_max)
-                + ", I: " + std::to_string(integral)
-                + ", kD: " + std::to_string(kD)
-                + ", kI: " + std::to_string(kI)
-                + ", kP: " + std::to_string(kP)
-                + ", Position_Sp: " + std::to_string(args.setpoint1)
-                + ", position_l: " + std::to_string(std::get<0>(Sensors::get_average_encoders(l_id, r_id)))
-                + ", position_r: " + std::to_string(std::get<1>(Sensors::get_average_encoders(l_id, r_id)))
-                + ", Heading_Sp: " + std::to_string(args.setpoint2)
-                + ", Relative_Heading: " + std::to_string(relative_angle)
-                + ", Actual_Vel1: " + std::to_string(velocity_l)
-                + ", Actual_Vel2: " + std::to_string(velocity_r)
-                // + ", Actual_Vel3: " + std::to_string(back_left_drive->get_actual_velocity())
-                // + ", Actual_Vel4: " + std::to_string(back_right_drive->get_actual_velocity())
-                + ", Correction: " + std::to_string(velocity_correction)
-            );
-            entry.stream = "clog";
-            logger.add(entry);
+        if constexpr ( LOG_COMPILED(1) ) {
+            if ( args.log_data ) {
+                std::tuple<double, double> positions = Sensors::get_average_encoders(l_id, r_id);
+                chassis_pid_sample sample = {
+                    (float)args.setpoint1, (float)std::get<0>(positions), (float)std::get<1>(positions),
+                    (float)args.setpoint2, (float)relative_angle, (float)integral,
+                    (float)velocity_l, (float)velocity_r, (float)velocity_correction,
+                    (float)kP, (float)kI, (float)kD, (float)i_max, (float)args.motor_slew
+                };
+                Telemetry::get_instance()->push(chassis_pid_telemetry_channel(), sample);
+            }
         }
 
         double error_l = std::abs(args.setpoint1 - std::get<0>(Sensors::get_average_encoders(l_id, r_id)));
@@ -781,6 +782,10 @@ void PTOChassis::t_profiled_straight_drive(chassis_params args) {
         // settled is when error is almost zero and velocity is minimal
         double l_difference = *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).second - *std::minmax_element(previous_l_velocities.begin(), previous_l_velocities.end()).first;
         double r_difference = *std::minmax_element(previous_r_velocities.begin(), previous_r_velocities.end()).second - *std::minmax_element(previous_r_velocities.begin(), previous_r_velocities.end()).first;
+        if ( args.stop_on_stall && MotorFaults::get_instance()->check(stalls) ) {
+            break;  // pushing against something, waiting for the timeout will not get any further
+        }
+
         if (
             std::abs(l_difference) < 2
             && previous_l_velocities.size() == velocity_history
@@ -844,6 +849,8 @@ void PTOChassis::t_turn(chassis_params args) {
     std::vector<double> error_history;
     int max_history_length = 15;
 
+    motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(drive->get_motors(), e_fault_stall);
+
     do {
         int dt = pros::millis() - current_time;
 
@@ -892,7 +899,11 @@ void PTOChassis::t_turn(chassis_params args) {
                 std::cout << error_history.at(999) << "\n";  // throw some error that is easy to see
             }
             int sign = std::abs(delta_velocity_l) / delta_velocity_l;
-            std::cout << "l over slew: " << sign << " " << dt << " " << slew_rate << "\n";
+            if constexpr ( LOG_COMPILED(5) ) {
+                if ( args.log_data ) {
+                    std::cout << "l over slew: " << sign << " " << dt << " " << slew_rate << "\n";
+                }
+            }
             l_velocity = prev_velocity_l + (sign * dt * slew_rate);
             over_slew = 1;
         }
@@ -904,7 +915,11 @@ void PTOChassis::t_turn(chassis_params args) {
                 std::cout << error_history.at(999) << "\n";  // throw some error that is easy to see
             }
             int sign = std::abs(delta_velocity_r) / delta_velocity_r;
-            std::cout << "r over slew: " << sign << " " << dt << " " << slew_rate << "\n";
+            if constexpr ( LOG_COMPILED(5) ) {
+                if ( args.log_data ) {
+                    std::cout << "r over slew: " << sign << " " << dt << " " << slew_rate << "\n";
+                }
+            }
             r_velocity = prev_velocity_r + (sign * dt * slew_rate);
             over_slew = 1;
         }
@@ -924,49 +939,32 @@ void PTOChassis::t_turn(chassis_params args) {
         }
 
 
-        std::cout << l_velocity << " " << r_velocity << " " << relative_angle << " " << error << "\n";
+        if constexpr ( LOG_COMPILED(5) ) {
+            if ( args.log_data ) {
+                std::cout << l_velocity << " " << r_velocity << " " << relative_angle << " " << error << "\n";
+            }
+        }
         // for(int i=0; i < previous_l_velocities.size(); i++) {
         //     std::cout << previous_l_velocities.at(i) << " ";
         // }
         // std::cout << "\n";
         double error_difference = *std::minmax_element(error_history.begin(), error_history.end()).second - *std::minmax_element(error_history.begin(), error_history.end()).first;
 
-        if ( args.log_data ) {
-            Logger logger;
-            log_entry entry;
-            entry.content = (
-                "[INFO] " + std::string("CHASSIS_PID_TURN")
-                + ", Time: " + std::to_string(pros::millis())
-                // + ", Actual_Vol1: " + std::to_string(front_left_drive->get_actual_voltage())
-                // + ", Actual_Vol2: " + std::to_string(front_right_drive->get_actual_voltage())
-                // + ", Actual_Vol3: " + std::to_string(back_left_drive->get_actual_voltage())
-                // + ", Actual_Vol4: " + std::to_string(back_right_drive->get_actual_voltage())
-                + ", Slew: " + std::to_string(args.motor_slew)
-                // + ", Brake: " + std::to_string(front_left_drive->get_brake_mode())
-                // + ", Gear: " + std::to_string(front_left_drive->get_gearset())
-                + ", i_max: " + std::to_string(i_max)
-                + ", I: " + std::to_string(integral)
-                + ", kD: " + std::to_string(kD)
-                + ", kI: " + std::to_string(kI)
-                + ", kP: " + std::to_string(kP)
-                + ", Position_Sp: " + std::to_string(0)
-                + ", position_l: " + std::to_string(std::get<0>(Sensors::get_average_encoders(l_id, r_id)))
-                + ", position_r: " + std::to_string(std::get<1>(Sensors::get_average_encoders(l_id, r_id)))
-                + ", Heading_Sp: " + std::to_string(args.setpoint1)
-                + ", Relative_Heading: " + std::to_string(relative_angle)
-                + ", Absolute Angle: " + std::to_string(abs_angle)
-                + ", error history: " + std::to_string(error_history.size())
-                + ", history size: " + std::to_string(max_history_length)
-                + ", time out time: " + std::to_string(start_time + args.timeout)
-                + ", error difference: " + std::to_string(error_difference)
-                + ", over slew: " + std::to_string(over_slew)
-                // + ", Actual_Vel1: " + std::to_string(front_left_drive->get_actual_velocity())
-                // + ", Actual_Vel2: " + std::to_string(front_right_drive->get_actual_velocity())
-                // + ", Actual_Vel3: " + std::to_string(back_left_drive->get_actual_velocity())
-                // + ", Actual_Vel4: " + std::to_string(back_right_drive->get_actual_velocity())
-            );
-            entry.stream = "clog";
-            logger.add(entry);
+        if constexpr ( LOG_COMPILED(1) ) {
+            if ( args.log_data ) {
+                std::tuple<double, double> positions = Sensors::get_average_encoders(l_id, r_id);
+                chassis_turn_sample sample = {
+                    (float)args.setpoint1, (float)relative_angle, (float)abs_angle,
+                    (float)std::get<0>(positions), (float)std::get<1>(positions), (float)integral,
+                    (float)l_velocity, (float)r_velocity, (float)error_difference, over_slew,
+                    (float)kP, (float)kI, (float)kD, (float)i_max, (float)args.motor_slew
+                };
+                Telemetry::get_instance()->push(chassis_turn_telemetry_channel(), sample);
+            }
+        }
+
+        if ( args.stop_on_stall && MotorFaults::get_instance()->check(stalls) ) {
+            break;  // pushing against something, waiting for the timeout will not get any further
         }
 
         if (
@@ -1082,92 +1080,79 @@ void PTOChassis::t_move_to_waypoint(chassis_params args, waypoint point) {
 
     t_okapi_pid_straight_drive(drive_straight_args);
 
-    std::cout << "drive finished\n";
-    if(args.log_data) {
-        Logger logger;
-        log_entry entry;
-        entry.content = (
-            "[INFO] " + std::string("CHASSIS_ODOM")
-            + ", Time: " + std::to_string(pros::millis())
-            + ", Waypoint: " + point.get_string()
-            + ", ToTurnForwards: " + std::to_string(tracker->to_degrees(to_turn_face_forwards))
-            + ", ToTurnBackwards: " + std::to_string(tracker->to_degrees(to_turn_face_backwards))
-            + ", ToTurn: " + std::to_string(to_turn)
-            + ", ToDrive: " + std::to_string(to_drive)
-            + ", Direction: " + std::to_string(direction)
-            + ", dx: " + std::to_string(dx)
-            + ", dy: " + std::to_string(dy)
-            + ", X: " + std::to_string(tracker->get_position().x_pos)
-            + ", Y: " + std::to_string(tracker->get_position().y_pos)
-            + ", Theta: " + std::to_string(tracker->to_degrees(tracker->get_position().theta))
-        );
-        entry.stream = "clog";
-        logger.add(entry);
+    if constexpr ( LOG_COMPILED(5) ) {
+        if ( args.log_data ) {
+            std::cout << "drive finished\n";
+        }
     }
+    LOG_IF(1, args.log_data, e_log_source_chassis, e_log_clog,
+        "[INFO] CHASSIS_ODOM, Time: %u, Waypoint: {x: %Lf y: %Lf dx: %Lf dy: %Lf radius: %Lf dtheta: %Lf}, "
+        "ToTurnForwards: %Lf, ToTurnBackwards: %Lf, ToTurn: %Lf, ToDrive: %Lf, Direction: %d, dx: %Lf, dy: %Lf, X: %Lf, Y: %Lf, Theta: %Lf",
+        (unsigned int)pros::millis(), point.x, point.y, point.dx, point.dy, point.radius, point.dtheta,
+        tracker->to_degrees(to_turn_face_forwards), tracker->to_degrees(to_turn_face_backwards), to_turn, to_drive, direction, dx, dy,
+        tracker->get_position().x_pos, tracker->get_position().y_pos, tracker->to_degrees(tracker->get_position().theta)
+    );
 }
 
 
-void PTOChassis::allow_movement() {
-    r_front->disable_driver_control();
-    r_front->set_motor_mode(e_builtin_velocity_pid);
-    r_front->move_velocity(0);
-    r_front->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-
-    r_back->disable_driver_control();
-    r_back->set_motor_mode(e_builtin_velocity_pid);
-    r_back->move_velocity(0);
-    r_back->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-
-    l_front->disable_driver_control();
-    l_front->set_motor_mode(e_builtin_velocity_pid);
-    l_front->move_velocity(0);
-    l_front->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-
-    l_back->disable_driver_control();
-    l_back->set_motor_mode(e_builtin_velocity_pid);
-    l_back->move_velocity(0);
-    l_back->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-
-    if(!pto_state) {  // extra motors enabled use them
-        r_extra->disable_driver_control();
-        r_extra->set_motor_mode(e_builtin_velocity_pid);
-        r_extra->move_velocity(0);
-        r_extra->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-
-        l_extra->disable_driver_control();
-        l_extra->set_motor_mode(e_builtin_velocity_pid);
-        l_extra->move_velocity(0);
-        l_extra->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
-    }
-}
+/**
+ * heading is unwrapped the same way as in t_turn so that the relay can
+ * oscillate across +-180 degrees
+ * matches t_turn's loop, the integral adds error * dt in ms and the
+ * derivative is taken every 10ms
+ */
+void PTOChassis::t_tune_turn(chassis_params args) {
+    PositionTracker* tracker = PositionTracker::get_instance();
 
+    allow_movement();
 
-void PTOChassis::stop_movement() {
-    r_front->set_motor_mode(e_voltage);
-    r_front->set_voltage(0);
-    r_front->enable_driver_control();
+    long double prev_heading = tracker->get_heading_rad();
+    long double relative_angle = 0;
+    auto measure = [&]() {
+        long double heading = tracker->get_heading_rad();
+        relative_angle += tracker->to_degrees(std::remainder(heading - prev_heading, 2 * M_PI));
+        prev_heading = heading;
+        return (double)relative_angle;
+    };
+
+    relay_params params = args.relay;
+    params.timeout = std::min(params.timeout, args.timeout);
+    params.loop_period = 10;
+    params.integral_step = 1;
+
+    motor_fault_subscription stalls = MotorFaults::get_instance()->subscribe(drive->get_motors(), e_fault_stall);
+    relay_result result = RelayTuner::tune(
+        "PTO Chassis Turn",
+        measure,
+        [](double velocity) { drive->move_velocity(velocity, -velocity); },
+        0,
+        params,
+        turn_gains,
+        [&]() { return args.stop_on_stall && MotorFaults::get_instance()->check(stalls); }
+    );
 
-    r_back->set_motor_mode(e_voltage);
-    r_back->set_voltage(0);
-    r_back->enable_driver_control();
+    stop_movement();
 
-    l_front->set_motor_mode(e_voltage);
-    l_front->set_voltage(0);
-    l_front->enable_driver_control();
+    if ( result.cycles > 0 && params.apply ) {
+        turn_gains = result.gains;
+    }
+    turn_tuning.publish(result);
+}
 
-    l_back->set_motor_mode(e_voltage);
-    l_back->set_voltage(0);
-    l_back->enable_driver_control();
 
-    if(!pto_state) {  // extra motors enabled use them
-        r_extra->set_motor_mode(e_voltage);
-        r_extra->set_voltage(0);
-        r_extra->enable_driver_control();
 
-        l_extra->set_motor_mode(e_voltage);
-        l_extra->set_voltage(0);
-        l_extra->enable_driver_control();
-    }
+void PTOChassis::allow_movement() {
+    drive->disable_driver_control();
+    drive->set_motor_mode(e_builtin_velocity_pid);
+    drive->move_velocity(0);
+    drive->set_brake_mode(pros::E_MOTOR_BRAKE_BRAKE);
+}
+
+
+void PTOChassis::stop_movement() {
+    drive->set_motor_mode(e_voltage);
+    drive->set_voltage(0);
+    drive->enable_driver_control();
 }
 
 
@@ -1437,67 +1422,48 @@ void PTOChassis::set_turn_gains(pid new_gains) {
 }
 
 
-void PTOChassis::pto_move_voltage(int r_voltage, int l_voltage) {
-    r_back->set_motor_mode(e_voltage);
-    r_front->set_motor_mode(e_voltage);
-    l_back->set_motor_mode(e_voltage);
-    l_front->set_motor_mode(e_voltage);
+int PTOChassis::tune_turn(relay_params params /*{}*/, bool asynch /*false*/) {
+    chassis_params args;
+    args.relay = params;
+    args.timeout = params.timeout;
 
-    r_back->set_voltage(r_voltage);
-    r_front->set_voltage(r_voltage);
-    l_back->set_voltage(l_voltage);
-    l_front->set_voltage(l_voltage);
+    // generate a unique id based on time, parameters, and seemingly random value of the voltage of one of the motors
+    int uid = pros::millis() * (params.amplitude + 1) + r_back->get_actual_voltage();
 
-    if(!pto_state) {  // extra motors enabled use them
-        r_extra->set_motor_mode(e_voltage);
-        l_extra->set_motor_mode(e_voltage);
+    chassis_action command = {args, uid, e_tune_turn};
+    while ( command_start_lock.exchange( true ) ); //aquire lock
+    command_queue.push(command);
+    command_start_lock.exchange( false ); //release lock
 
-        r_extra->set_voltage(r_voltage);
-        l_extra->set_voltage(l_voltage);
+    if(!asynch) {
+        wait_until_finished(uid);
     }
+
+    return uid;
+}
+
+
+relay_result PTOChassis::get_turn_tuning() {
+    return turn_tuning.read();
+}
+
+
+
+void PTOChassis::pto_move_voltage(int r_voltage, int l_voltage) {
+    drive->set_motor_mode(e_voltage);
+    drive->set_voltage(l_voltage, r_voltage);
 }
 
 
 void PTOChassis::pto_move_velocity(int r_velocity, int l_velocity) {
-    r_back->set_motor_mode(e_builtin_velocity_pid);
-    r_front->set_motor_mode(e_builtin_velocity_pid);
-    l_back->set_motor_mode(e_builtin_velocity_pid);
-    l_front->set_motor_mode(e_builtin_velocity_pid);
-
-    r_back->move_velocity(r_velocity);
-    r_front->move_velocity(r_velocity);
-    l_back->move_velocity(l_velocity);
-    l_front->move_velocity(l_velocity);
-
-    if(!pto_state) {  // extra motors enabled use them
-        r_extra->set_motor_mode(e_builtin_velocity_pid);
-        l_extra->set_motor_mode(e_builtin_velocity_pid);
-
-        r_extra->move_velocity(r_velocity);
-        l_extra->move_velocity(l_velocity);
-    }
+    drive->set_motor_mode(e_builtin_velocity_pid);
+    drive->move_velocity(l_velocity, r_velocity);
 }
 
 
 void PTOChassis::pto_user_move(int r_voltage, int l_voltage) {
-    r_back->set_motor_mode(e_voltage);
-    r_front->set_motor_mode(e_voltage);
-    l_back->set_motor_mode(e_voltage);
-    l_front->set_motor_mode(e_voltage);
-
-    r_back->user_move(r_voltage);
-    r_front->user_move(r_voltage);
-    l_back->user_move(l_voltage);
-    l_front->user_move(l_voltage);
-
-    // if pto state is true then robot is in ring mode
-    if(!pto_state) {  // extra motors not enabled use them
-        r_extra->set_motor_mode(e_voltage);
-        l_extra->set_motor_mode(e_voltage);
-
-        r_extra->user_move(r_voltage);
-        l_extra->user_move(l_voltage);
-    }
+    drive->set_motor_mode(e_voltage);
+    drive->user_move(l_voltage, r_voltage);
 }
 
 
@@ -1538,11 +1504,15 @@ void PTOChassis::toggle_pto() {
 void PTOChassis::pto_enable_drive() {
     pto_state = false;
     pto->set_value(false);
+    drive->enable_motor(*r_extra);
+    drive->enable_motor(*l_extra);
 }
 
 void PTOChassis::pto_enable_rings() {
     pto_state = true;
     pto->set_value(true);
+    drive->disable_motor(*r_extra);
+    drive->disable_motor(*l_extra);
 }
 
 
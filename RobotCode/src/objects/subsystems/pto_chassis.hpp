@@ -6,7 +6,10 @@
 
 #include "main.h"
 
+#include "../motors/Mailbox.hpp"
 #include "../motors/Motor.hpp"
+#include "../motors/MotorGroup.hpp"
+#include "../motors/RelayTuner.hpp"
 #include "../sensors/Sensors.hpp"
 #include "../../Configuration.hpp"
 #include "chassis.hpp"
@@ -57,6 +60,8 @@ class PTOChassis
         static Motor* l_front;
         static Motor* l_extra;
 
+        static MotorGroup *drive;  // extra motors are disabled in the group while the pto runs the rings
+
         static pros::ADIDigitalOut* pto;
 
         static Encoder* left_encoder;
@@ -74,6 +79,7 @@ class PTOChassis
         static pid okapi_sdrive_gains;
         static pid heading_gains;
         static pid turn_gains;
+        static Mailbox<relay_result> turn_tuning;
 
         static double get_angle_to_turn(double x, double y, int explicit_direction=1);
         static double get_angle_to_turn(double theta);
@@ -83,6 +89,7 @@ class PTOChassis
         static void t_profiled_straight_drive(chassis_params args);
         static void t_turn(chassis_params args);
         static void t_move_to_waypoint(chassis_params args, waypoint point);
+        static void t_tune_turn(chassis_params args);
 
         static double wheel_diameter;
         static double width;
@@ -116,6 +123,23 @@ class PTOChassis
         void set_heading_gains(pid new_gains);
         void set_turn_gains(pid new_gains);
 
+        /**
+         * @param: relay_params params -> amplitude is the turn velocity in rpm, hysteresis is in degrees
+         * @param: bool asynch -> return right away instead of waiting for the test to finish
+         * @return: int -> uid of the command
+         *
+         * @see: RelayTuner.hpp
+         *
+         * oscillates the chassis around its current heading with a relay test
+         * and replaces the turn gains with the result if params.apply is set
+         */
+        int tune_turn(relay_params params={}, bool asynch=false);
+
+        /**
+         * @return: relay_result -> result of the last turn tuning, cycles is 0 if it failed or never ran
+         */
+        relay_result get_turn_tuning();
+
 
 
         static void pto_move_voltage(int r_voltage, int l_voltage);